@@ -46,6 +46,15 @@ GST_DEBUG_CATEGORY_STATIC (gst_ciscdemux_debug);
 #define DRM_TYPE_BASIC "ENCRYPTED_BASIC_HLS"
 #define INVALID_PTS  -1
 #define BUFFER_SIZE 65536
+/* Default high watermarks of the src pad queues; downloads resume
+   once a queue drains below half of them */
+#define QUEUE_MAX_BYTES (8 * 1024 * 1024)
+#define QUEUE_MAX_TIME (4 * GST_SECOND)
+/* Shortest time between two position reports, used while data is
+   flowing; otherwise the position is reported every
+   SRC_PTS_NOTIFY_INTERVAL seconds while playing, and not at all
+   while paused */
+#define PTS_NOTIFY_MIN_MSECS 500
 /* Convert from GStreamer time to MPEG time. */
 #define GSTTIME_TO_MPEGTIME(time) (((time) * 9) / (GST_MSECOND/10))
 
@@ -60,9 +69,17 @@ enum
 {
    PROP_0,
    PROP_SILENT,
-   PROP_AUDIO_LANGUAGE
+   PROP_AUDIO_LANGUAGE,
+   PROP_MAX_QUEUE_BYTES,
+   PROP_MAX_QUEUE_TIME,
+   PROP_DECRYPT,
+   PROP_PARALLEL_CONNECTIONS
 };
 
+/* Stream number (plus one) of the last buffer each libhls downloader
+   thread sent, so hlsPlayer_getBuffer() knows whose queue to check */
+static GPrivate gStreamKey = G_PRIVATE_INIT(NULL);
+
 /* the capabilities of the inputs and outputs.
 *
 * describe the real formats here.
@@ -114,6 +131,8 @@ static gboolean cisco_hls_close(Gstciscdemux *demux);
 static gboolean cisco_hls_finalize(Gstciscdemux *demux);
 static gboolean gst_cisco_hls_seek (Gstciscdemux *demux, GstEvent *event);
 static void * getCurrentPTSNotify(void *data);
+static void gst_ciscdemux_pts_set_playing(Gstciscdemux *demux, gboolean bPlaying);
+static void gst_ciscdemux_pts_data_pushed(Gstciscdemux *demux);
 static gboolean gst_ciscdemux_get_caps( Gstciscdemux *demux,
 												srcBufferMetadata_t *metadata,
                                        			GstBuffer *buf,
@@ -122,10 +141,31 @@ static gboolean gst_ciscdemux_flush(Gstciscdemux *demux, GstPad *srcpad);
 static gboolean gst_ciscdemux_disable_main_stream_audio(Gstciscdemux *demux);
 static gboolean gst_ciscdemux_set_video_master(Gstciscdemux *demux);
 static gboolean gst_ciscdemux_set_audio_thresholds(Gstciscdemux *demux);
-static gboolean gst_ciscdemux_send_eos(GstPad *srcpad);
+static gboolean gst_ciscdemux_send_eos(Gstciscdemux *demux, GstPad *srcpad);
 static gboolean gst_ciscdemux_send_low_delay_videomask_event(Gstciscdemux *demux, gboolean enable);
 static gboolean gst_ciscdemux_send_event_to_all_srcpads(Gstciscdemux *demux, GstEvent *event);
 static gboolean gst_ciscdemux_send_flush_to_all_srcpads(Gstciscdemux *demux);
+static tMemoryStruct *gst_ciscdemux_mem_get(Gstciscdemux *demux);
+static void gst_ciscdemux_mem_put(Gstciscdemux *demux, tMemoryStruct *pmem);
+static void gst_ciscdemux_mem_free_all(Gstciscdemux *demux);
+static srcStatus_t gst_ciscdemux_push_buffer(Gstciscdemux *demux, GstBuffer *buf, srcBufferMetadata_t *metadata);
+static void gst_ciscdemux_queue_init_all(Gstciscdemux *demux, guint numStreams);
+static void gst_ciscdemux_queue_start(Gstciscdemux *demux, guint streamNum, GstPad *pad);
+static gboolean gst_ciscdemux_queue_push(Gstciscdemux *demux, GstPad *pad, GstMiniObject *item);
+static gboolean gst_ciscdemux_queue_is_full(Gstciscdemux *demux, gint streamNum);
+static tPadQueue *gst_ciscdemux_queue_for_pad(Gstciscdemux *demux, GstPad *pad);
+static void gst_ciscdemux_queue_clear(tPadQueue *queue);
+static gboolean gst_ciscdemux_queue_start_task(tPadQueue *queue);
+static void gst_ciscdemux_queue_stop_all(Gstciscdemux *demux);
+static void gst_ciscdemux_queue_free_all(Gstciscdemux *demux);
+#if GST_CHECK_VERSION(1,0,0)
+static gboolean gst_ciscdemux_src_activate_mode(GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active);
+#else
+static gboolean gst_ciscdemux_src_activate_push(GstPad *pad, gboolean active);
+#endif
+#if GST_CHECK_VERSION(1,0,0)
+static void gst_ciscdemux_negotiate_pool(Gstciscdemux *demux, GstCaps *caps);
+#endif
 /* GObject vmethod implementations */
 
 /* These global variables must be removed*/
@@ -353,6 +393,26 @@ gst_ciscdemux_class_init (GstciscdemuxClass * klass)
       g_param_spec_string ("audio-language", "Audio language ISO code",
           "Sets audio language", NULL, G_PARAM_READWRITE));
 
+   g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_BYTES,
+      g_param_spec_uint ("max-queue-bytes", "Max queue bytes",
+          "Data queued per src pad before downloads are held back (resumed at half)",
+          1, G_MAXUINT, QUEUE_MAX_BYTES, G_PARAM_READWRITE));
+
+   g_object_class_install_property (gobject_class, PROP_MAX_QUEUE_TIME,
+      g_param_spec_uint64 ("max-queue-time", "Max queue time",
+          "Media (ns) queued per src pad before downloads are held back (resumed at half)",
+          1, G_MAXUINT64, QUEUE_MAX_TIME, G_PARAM_READWRITE));
+
+   g_object_class_install_property (gobject_class, PROP_DECRYPT,
+      g_param_spec_boolean ("decrypt", "Decrypt",
+          "Decrypt AES-128 segments in the HLS plugin instead of downstream (applied when the stream is opened)",
+          FALSE, G_PARAM_READWRITE));
+
+   g_object_class_install_property (gobject_class, PROP_PARALLEL_CONNECTIONS,
+      g_param_spec_uint ("parallel-connections", "Parallel connections",
+          "Connections a large segment is downloaded over, as byte ranges fetched in parallel (applied when the stream is opened)",
+          1, SRC_MAX_PARALLEL_CONNECTIONS, 1, G_PARAM_READWRITE));
+
    gstelement_class->change_state = GST_DEBUG_FUNCPTR(gst_cscohlsdemuxer_change_state);
 
 #if GST_CHECK_VERSION(1,0,0)
@@ -401,6 +461,13 @@ gst_ciscdemux_init (Gstciscdemux * demux, GstciscdemuxClass * gclass)
 
    gst_pad_set_link_function(demux->srcpad, GST_DEBUG_FUNCPTR (gst_ciscdemux_src_link));
 
+#if GST_CHECK_VERSION(1,0,0)
+   gst_pad_set_activatemode_function(demux->srcpad, GST_DEBUG_FUNCPTR (gst_ciscdemux_src_activate_mode));
+#else
+   gst_pad_set_activatepush_function(demux->srcpad, GST_DEBUG_FUNCPTR (gst_ciscdemux_src_activate_push));
+#endif
+   gst_pad_set_element_private (demux->srcpad, demux);
+
    /* now enable the pads*/
    gst_element_add_pad (GST_ELEMENT (demux), demux->sinkpad);
    gst_element_add_pad (GST_ELEMENT (demux), demux->srcpad);
@@ -410,6 +477,8 @@ gst_ciscdemux_init (Gstciscdemux * demux, GstciscdemuxClass * gclass)
    demux->srcpad_discrete = NULL;
    demux->numSrcPadsActive = 0;
    demux->bKillPTSThread = FALSE;
+   demux->bPTSPlaying = FALSE;
+   demux->bPTSDataFlowing = FALSE;
    demux->playerEvtCb = NULL;
    demux->downstream_peer_pad = NULL;
    demux->uri = NULL;
@@ -421,8 +490,21 @@ gst_ciscdemux_init (Gstciscdemux * demux, GstciscdemuxClass * gclass)
    demux->drmType = NULL;
    demux->defaultAudioLangISOCode[0] = '\0';
 
+   demux->padQueue = NULL;
+   demux->numPadQueues = 0;
+   demux->maxQueueBytes = QUEUE_MAX_BYTES;
+   demux->maxQueueTime = QUEUE_MAX_TIME;
+   demux->bDecrypt = FALSE;
+   demux->parallelConnections = 1;
+   demux->pFreeMem = NULL;
+#if GST_CHECK_VERSION(1,0,0)
+   demux->pool = NULL;
+   demux->poolBufferSize = 0;
+#endif
+
    g_mutex_init(&demux->PTSMutex);
    g_cond_init(&demux->PTSThreadCond);
+   g_mutex_init(&demux->memMutex);
 }
 
 static void
@@ -467,6 +549,18 @@ gst_ciscdemux_set_property (GObject * object, guint prop_id,
              }
              break;
           }
+       case PROP_MAX_QUEUE_BYTES:
+          demux->maxQueueBytes = g_value_get_uint (value);
+          break;
+       case PROP_MAX_QUEUE_TIME:
+          demux->maxQueueTime = g_value_get_uint64 (value);
+          break;
+       case PROP_DECRYPT:
+          demux->bDecrypt = g_value_get_boolean (value);
+          break;
+       case PROP_PARALLEL_CONNECTIONS:
+          demux->parallelConnections = g_value_get_uint (value);
+          break;
        default:
           G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
           break;
@@ -510,6 +604,18 @@ gst_ciscdemux_get_property (GObject * object, guint prop_id,
 
              break;
           }
+       case PROP_MAX_QUEUE_BYTES:
+          g_value_set_uint (value, demux->maxQueueBytes);
+          break;
+       case PROP_MAX_QUEUE_TIME:
+          g_value_set_uint64 (value, demux->maxQueueTime);
+          break;
+       case PROP_DECRYPT:
+          g_value_set_boolean (value, demux->bDecrypt);
+          break;
+       case PROP_PARALLEL_CONNECTIONS:
+          g_value_set_uint (value, demux->parallelConnections);
+          break;
        default:
           G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
           break;
@@ -1095,7 +1201,8 @@ const char *strHLSEvent [] =
    "SRC_PLUGIN_BOF             ",
    "SRC_PLUGIN_BOS             ",
    "SRC_PLUGIN_EOF             ",
-   "SRC_PLUGIN_EOS            "
+   "SRC_PLUGIN_EOS             ",
+   "SRC_PLUGIN_STARTUP_COMPLETE"
 };
 
 void hlsPlayer_pluginEvtCallback(void* pHandle, srcPluginEvt_t* pEvt)
@@ -1119,13 +1226,30 @@ void hlsPlayer_pluginEvtCallback(void* pHandle, srcPluginEvt_t* pEvt)
 
 
          GST_INFO("Received boundary event(BOS/BOF/EOF/EOS)");
-         gst_ciscdemux_send_eos(demux->srcpad);
+         gst_ciscdemux_send_eos(demux, demux->srcpad);
 
          for(ii = 0; ii < demux->numSrcPadsActive - 1; ii++)
          {
-            gst_ciscdemux_send_eos(demux->srcpad_discrete[ii]);
+            gst_ciscdemux_send_eos(demux, demux->srcpad_discrete[ii]);
          }
          break;
+      case SRC_PLUGIN_STARTUP_COMPLETE:
+      {
+         srcPluginStartup_t *pStartup = (srcPluginStartup_t *)pEvt->pData;
+
+         GST_INFO("startup (ms): variant %.1f media %.1f audio %.1f key %.1f "
+                  "first byte %.1f first buffer %.1f playing %.1f",
+                  pStartup->phaseTime[SRC_STARTUP_VARIANT_PLAYLIST],
+                  pStartup->phaseTime[SRC_STARTUP_MEDIA_PLAYLIST],
+                  pStartup->phaseTime[SRC_STARTUP_AUDIO_PLAYLIST],
+                  pStartup->phaseTime[SRC_STARTUP_KEY],
+                  pStartup->phaseTime[SRC_STARTUP_FIRST_BYTE],
+                  pStartup->phaseTime[SRC_STARTUP_FIRST_BUFFER],
+                  pStartup->phaseTime[SRC_STARTUP_PLAYING]);
+         break;
+      }
+      default:
+         break;
    }
    return;
 }
@@ -1196,23 +1320,61 @@ srcStatus_t hlsPlayer_getBuffer(void* pHandle, char** buffer, int* size, void **
       }
       */
 
+      // Hold the calling downloader back while its stream's queue is
+      // full; libhls backs off and asks again
+      if (TRUE == gst_ciscdemux_queue_is_full(demux, GPOINTER_TO_INT(g_private_get(&gStreamKey)) - 1))
+      {
+         *ppPrivate = NULL;
+         *buffer = NULL;
+         *size = 0;
+         break;
+      }
+
       // we need to rate limit a bit
-      pmem = (tMemoryStruct*) g_malloc(sizeof(tMemoryStruct));
+      pmem = gst_ciscdemux_mem_get(demux);
       if (G_UNLIKELY (pmem == NULL))
       {
          GST_ERROR("Error getting pmem structure\n");
          return SRC_ERROR;
       }
 
-      //TODO Make this buffer the size of the pipeline buffer
 #if GST_CHECK_VERSION(1,0,0)
-      pmem->buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+      // Take a buffer from the negotiated pool if there is one free.
+      // Never wait for downstream to release one, the plugin would stall
+      // the download; fall back to a plain allocation instead. This also
+      // covers the buffers sent before the caps (and pool) are known.
+      g_mutex_lock(&demux->memMutex);
+      if (NULL != demux->pool)
+      {
+         GstBufferPoolAcquireParams params;
+
+         memset(&params, 0, sizeof(params));
+         params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+         if (GST_FLOW_OK == gst_buffer_pool_acquire_buffer(demux->pool, &pmem->buf, &params))
+         {
+            // sendBuffer() trimmed it to the data of its last use
+            if (gst_buffer_get_size(pmem->buf) != demux->poolBufferSize)
+            {
+               gst_buffer_set_size(pmem->buf, demux->poolBufferSize);
+            }
+         }
+         else
+         {
+            pmem->buf = NULL;
+         }
+      }
+      g_mutex_unlock(&demux->memMutex);
+
+      if (NULL == pmem->buf)
+      {
+         pmem->buf = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+      }
 #else
       pmem->buf = gst_buffer_try_new_and_alloc(BUFFER_SIZE);
 #endif
       if (G_UNLIKELY (pmem->buf == NULL))
       {
-         g_free (pmem);
+         gst_ciscdemux_mem_put(demux, pmem);
          GST_ERROR("Error getting GstBuffer\n");
          return SRC_ERROR;
       }
@@ -1225,7 +1387,7 @@ srcStatus_t hlsPlayer_getBuffer(void* pHandle, char** buffer, int* size, void **
       if (gst_buffer_map (pmem->buf, &pmem->info, GST_MAP_WRITE) == FALSE)
       {
          gst_buffer_unref(pmem->buf);
-         g_free (pmem);
+         gst_ciscdemux_mem_put(demux, pmem);
          GST_ERROR("Error mapping GstBuffer\n");
          return SRC_ERROR;
       }
@@ -1252,9 +1414,6 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
    srcStatus_t status = SRC_ERROR;
    tMemoryStruct *pmem = NULL;
    GstBuffer *buf = NULL;
-   GstEvent*event= NULL;
-   GstPad *srcpad = NULL;
-   gchar *pad_name = NULL;
 
    // send it downstream first we need to see if we need to set the capabilities
    Gstciscdemux *demux = (Gstciscdemux*) pHandle;
@@ -1273,6 +1432,106 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
          break;
       }
 
+      if (pPrivate == NULL)
+      {
+         GST_ERROR("Warning %s pPrivate is NULL\n", __FUNCTION__);
+         break;
+      }
+      pmem = (tMemoryStruct*)pPrivate;
+
+#if GST_CHECK_VERSION(1,0,0)
+      gst_buffer_unmap (pmem->buf, &pmem->info);
+#endif
+
+      pmem->size = size; // this is the ACTUAL data amount written to the buffer, the size of the actual
+      // buffer is still the original 4096 bytes
+
+      buf = pmem->buf;
+#if GST_CHECK_VERSION(1,0,0)
+      gst_buffer_set_size (buf, size);
+#else
+      GST_BUFFER_SIZE (buf) = size;
+#endif
+
+      // we don't need the pPrivate anymore
+      gst_ciscdemux_mem_put(demux, pmem);
+      pmem = NULL;
+
+      status = gst_ciscdemux_push_buffer(demux, buf, metadata);
+
+   }while(0);
+
+   return status;
+}
+
+#if GST_CHECK_VERSION(1,0,0)
+srcStatus_t hlsPlayer_lendBuffer(void* pHandle, char* buffer, int* size, srcBufferMetadata_t* metadata,
+                                 srcBufferRelease_t release, void *pReleaseData)
+{
+   srcStatus_t status = SRC_ERROR;
+   GstBuffer *buf = NULL;
+   GstMemory *mem = NULL;
+   Gstciscdemux *demux = (Gstciscdemux*) pHandle;
+
+   do
+   {
+      if((NULL == buffer) || (NULL == size) || (NULL == release))
+      {
+         GST_ERROR("%s() invalid parameter\n", __FUNCTION__);
+         break;
+      }
+
+      if((NULL == demux) || (NULL == metadata))
+      {
+         GST_ERROR("%s() demux or metadata is NULL\n", __FUNCTION__);
+         release(pReleaseData);
+         break;
+      }
+
+      // No room, libhls keeps the data and backs off
+      if (TRUE == gst_ciscdemux_queue_is_full(demux, metadata->streamNum))
+      {
+         *size = 0;
+         status = SRC_SUCCESS;
+         break;
+      }
+
+      // Wrap the plugin's own memory, the plugin gets it back through
+      // release() once the last reference downstream is dropped
+      mem = gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, buffer, *size, 0, *size,
+                                   pReleaseData, (GDestroyNotify)release);
+      if (G_UNLIKELY (mem == NULL))
+      {
+         GST_ERROR("Error wrapping lent buffer\n");
+         release(pReleaseData);
+         break;
+      }
+
+      buf = gst_buffer_new();
+      gst_buffer_append_memory(buf, mem);
+      GST_BUFFER_OFFSET(buf) = 0;
+
+      // From here on the buffer owns the lent memory whatever happens
+      status = gst_ciscdemux_push_buffer(demux, buf, metadata);
+
+   }while(0);
+
+   return status;
+}
+#endif
+
+/* Stamps a filled buffer, sets up the src pad it belongs to if this is
+ * the first buffer of its stream and pushes it. Takes ownership of buf.
+ */
+static srcStatus_t gst_ciscdemux_push_buffer(Gstciscdemux *demux, GstBuffer *buf, srcBufferMetadata_t *metadata)
+{
+   srcStatus_t status = SRC_ERROR;
+   GstEvent*event= NULL;
+   GstPad *srcpad = NULL;
+   gchar *pad_name = NULL;
+
+   do
+   {
       if((NULL == demux->srcpad_discrete) && (metadata->totalNumStreams > 1))
       {
          demux->srcpad_discrete = (GstPad **)g_malloc((metadata->totalNumStreams - 1) * sizeof(GstPad *));
@@ -1285,47 +1544,32 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
          memset(demux->inputStreamCap, 0, sizeof(GstCaps *) * metadata->totalNumStreams);
       }
 
-      if (pPrivate == NULL)
+      if(NULL == demux->padQueue)
       {
-         GST_ERROR("Warning %s pPrivate is NULL\n", __FUNCTION__);
-         break;
+         gst_ciscdemux_queue_init_all(demux, metadata->totalNumStreams);
       }
-      pmem = (tMemoryStruct*)pPrivate;
 
-#if GST_CHECK_VERSION(1,0,0)
-      gst_buffer_unmap (pmem->buf, &pmem->info);
-#endif
+      g_private_set(&gStreamKey, GINT_TO_POINTER(metadata->streamNum + 1));
 
-      pmem->size = size; // this is the ACTUAL data amount written to the buffer, the size of the actual
-      // buffer is still the original 4096 bytes
-
-      buf = pmem->buf;
       if (metadata->pts > INVALID_PTS)
       {
          demux->bufferPts = metadata->pts;
 #if GST_CHECK_VERSION(1,0,0)
-      gst_buffer_set_size (buf, size);
-      GST_BUFFER_PTS (buf) = (demux->bufferPts * GST_MSECOND) / 90;
+         GST_BUFFER_PTS (buf) = (demux->bufferPts * GST_MSECOND) / 90;
 #else
-      GST_BUFFER_SIZE (buf) = size;
-      GST_BUFFER_TIMESTAMP (buf) = (demux->bufferPts * GST_MSECOND) / 90;
+         GST_BUFFER_TIMESTAMP (buf) = (demux->bufferPts * GST_MSECOND) / 90;
 #endif
       }
       else
       {
 #if GST_CHECK_VERSION(1,0,0)
-         gst_buffer_set_size (buf, size);
          GST_BUFFER_PTS(buf) = GST_CLOCK_TIME_NONE;
          GST_BUFFER_DTS(buf) = GST_CLOCK_TIME_NONE;
 #else
-         GST_BUFFER_SIZE (buf) = size;
          GST_BUFFER_TIMESTAMP (buf) =0;
 #endif
       }
 
-      // we don't need the pPrivate anymore
-      g_free (pmem);
-
       if((metadata->streamNum > SRC_STREAM_NUM_MAIN) && (NULL == demux->srcpad_discrete[metadata->streamNum - 1]))
       {
          if(TRUE != gst_ciscdemux_get_caps(demux, metadata, buf, &demux->inputStreamCap[metadata->streamNum]))
@@ -1343,7 +1587,13 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
 
 #if GST_CHECK_VERSION(1,0,0)
          gst_pad_use_fixed_caps(demux->srcpad_discrete[metadata->streamNum -1]);
+         gst_pad_set_activatemode_function(demux->srcpad_discrete[metadata->streamNum - 1],
+                                           GST_DEBUG_FUNCPTR (gst_ciscdemux_src_activate_mode));
+#else
+         gst_pad_set_activatepush_function(demux->srcpad_discrete[metadata->streamNum - 1],
+                                           GST_DEBUG_FUNCPTR (gst_ciscdemux_src_activate_push));
 #endif
+         gst_pad_set_element_private (demux->srcpad_discrete[metadata->streamNum - 1], demux);
          if(FALSE == gst_pad_set_active (demux->srcpad_discrete[metadata->streamNum - 1], TRUE))
          {
             GST_WARNING_OBJECT(demux,"I was not able to set the discrete(%d) src pad to active\n!",
@@ -1358,6 +1608,8 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
 
          gst_element_add_pad (GST_ELEMENT_CAST (demux), demux->srcpad_discrete[metadata->streamNum - 1]);
 
+         gst_ciscdemux_queue_start(demux, metadata->streamNum, demux->srcpad_discrete[metadata->streamNum - 1]);
+
          demux->numSrcPadsActive++;
          if(metadata->totalNumStreams == demux->numSrcPadsActive)
          {
@@ -1394,9 +1646,17 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
          {
             GST_WARNING_OBJECT(demux, "I was not able to set caps on the main src pad for some reason\n");
          }
+#if GST_CHECK_VERSION(1,0,0)
+         else
+         {
+            gst_ciscdemux_negotiate_pool(demux, demux->inputStreamCap[metadata->streamNum]);
+         }
+#endif
 
          demux->capsSet = 1;
 
+         gst_ciscdemux_queue_start(demux, SRC_STREAM_NUM_MAIN, demux->srcpad);
+
          demux->numSrcPadsActive++;
          if(metadata->totalNumStreams == demux->numSrcPadsActive)
          {
@@ -1448,7 +1708,7 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
             if (event == NULL) { GST_ERROR("Error no event to send\n");}
 
             GST_INFO_OBJECT(demux, "Sending the encryption key information downstream\n");
-            if (gst_pad_push_event(srcpad, event)== FALSE)
+            if (gst_ciscdemux_queue_push(demux, srcpad, GST_MINI_OBJECT_CAST(event))== FALSE)
             {
                GST_WARNING(" Error sending the encyption key down stream\n");
             }
@@ -1484,17 +1744,24 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
         if (NULL != segmentEvent)
         {
            GST_WARNING("[cischlsdemux] sending segment event downstream for timestamp %"G_GINT64_FORMAT"...\n", demux->seekpos);
-           if (gst_pad_push_event (demux->srcpad, segmentEvent) != TRUE)
+           if (gst_ciscdemux_queue_push (demux, demux->srcpad, GST_MINI_OBJECT_CAST(segmentEvent)) != TRUE)
               GST_WARNING("[cischlsdemux] sending segment event downstream failed!");
         }
         demux->newSegment = FALSE;
      }
 
-      gst_pad_push(srcpad, buf);
+      // Queued for the pad's task, which owns it from here on
+      gst_ciscdemux_queue_push(demux, srcpad, GST_MINI_OBJECT_CAST(buf));
+      buf = NULL;
       status = SRC_SUCCESS;
 
    }while(0);
 
+   if (NULL != buf)
+   {
+      gst_buffer_unref(buf);
+   }
+
    return status;
 }
 
@@ -1712,6 +1979,11 @@ static gboolean cisco_hls_open (Gstciscdemux *demux, char *pPlaylistUri)
    gboolean bError = FALSE;
    srcPluginSetData_t setData = {};
    int minBitrate = 0;
+   int bDecrypt = 0;
+   int numConnections = 1;
+#if GST_CHECK_VERSION(1,0,0)
+   srcPlayerLendBuffer_t lendBuffer = hlsPlayer_lendBuffer;
+#endif
 
    do
    {
@@ -1786,6 +2058,47 @@ static gboolean cisco_hls_open (Gstciscdemux *demux, char *pPlaylistUri)
          }
       }
 
+#if GST_CHECK_VERSION(1,0,0)
+      /* Take segment data straight from the plugin's memory */
+      setData.setCode = SRC_PLUGIN_SET_LEND_BUFFER;
+      setData.pData = &lendBuffer;
+      stat = demux->HLS_pluginTable.set( pSession->pSessionID, &setData, &errTable );
+      if(stat)
+      {
+         /* Not fatal -- the plugin copies into buffers from getBuffer() instead */
+         GST_WARNING( "%s: Error %d while enabling buffer lending in the HLS plugin: %s",
+               __FUNCTION__, errTable.errCode, errTable.errMsg);
+      }
+#endif
+
+      if(TRUE == demux->bDecrypt)
+      {
+         bDecrypt = 1;
+         setData.setCode = SRC_PLUGIN_SET_DECRYPTION;
+         setData.pData = &bDecrypt;
+         stat = demux->HLS_pluginTable.set( pSession->pSessionID, &setData, &errTable );
+         if(stat)
+         {
+            /* Not fatal -- encrypted segments still get a decryption event */
+            GST_WARNING( "%s: Error %d while enabling decryption in the HLS plugin: %s",
+                  __FUNCTION__, errTable.errCode, errTable.errMsg);
+         }
+      }
+
+      if(demux->parallelConnections > 1)
+      {
+         numConnections = demux->parallelConnections;
+         setData.setCode = SRC_PLUGIN_SET_PARALLEL_CONNECTIONS;
+         setData.pData = &numConnections;
+         stat = demux->HLS_pluginTable.set( pSession->pSessionID, &setData, &errTable );
+         if(stat)
+         {
+            /* Not fatal -- segments are downloaded over one connection */
+            GST_WARNING( "%s: Error %d while setting %d parallel connections in the HLS plugin: %s",
+                  __FUNCTION__, errTable.errCode, numConnections, errTable.errMsg);
+         }
+      }
+
       /* prepare */
       stat = demux->HLS_pluginTable.prepare(pSession->pSessionID, &errTable );
       if(stat)
@@ -1827,6 +2140,8 @@ static gboolean cisco_hls_start(Gstciscdemux *demux)
       demux->speed = 1.0;
    }
 
+   gst_ciscdemux_pts_set_playing(demux, TRUE);
+
    return TRUE;
 }
 
@@ -1858,6 +2173,8 @@ static gboolean cisco_hls_pause(Gstciscdemux *demux)
       demux->speed = 0.0;
    }
 
+   gst_ciscdemux_pts_set_playing(demux, FALSE);
+
    return TRUE;
 }
 
@@ -1892,6 +2209,9 @@ static gboolean cisco_hls_close(Gstciscdemux *demux)
    }
    GST_DEBUG("Timestamp when hls close returns : %llu\n", (unsigned long long)time(NULL));
 
+   // Nothing is queued any more now that the plugin is closed
+   gst_ciscdemux_queue_stop_all(demux);
+
    if (demux->pCscoHlsSession)
    {
       g_free(demux->pCscoHlsSession);
@@ -1947,12 +2267,506 @@ static gboolean cisco_hls_finalize(Gstciscdemux *demux)
       g_free(demux->srcpad_discrete);
       demux->srcpad_discrete = NULL;
    }
+   gst_ciscdemux_queue_free_all(demux);
+   gst_ciscdemux_mem_free_all(demux);
    g_mutex_clear(&demux->PTSMutex);
    g_cond_clear(&demux->PTSThreadCond);
+   g_mutex_clear(&demux->memMutex);
 
    return TRUE;
 }
 
+/* Size of the data of a queued item, 0 for events */
+static guint64 gst_ciscdemux_queue_item_size(GstMiniObject *item)
+{
+   if (!GST_IS_BUFFER(item))
+   {
+      return 0;
+   }
+#if GST_CHECK_VERSION(1,0,0)
+   return gst_buffer_get_size(GST_BUFFER_CAST(item));
+#else
+   return GST_BUFFER_SIZE(GST_BUFFER_CAST(item));
+#endif
+}
+
+/* Timestamp of a queued item, GST_CLOCK_TIME_NONE for events */
+static GstClockTime gst_ciscdemux_queue_item_time(GstMiniObject *item)
+{
+   if (!GST_IS_BUFFER(item))
+   {
+      return GST_CLOCK_TIME_NONE;
+   }
+   return GST_BUFFER_TIMESTAMP(GST_BUFFER_CAST(item));
+}
+
+/* TRUE if the queue is over 1/divisor of its watermarks. The time level
+ * comes from the buffer timestamps, which libhls only provides at some
+ * segment starts, so the byte level is what usually applies.
+ * Called with queue->lock held.
+ */
+static gboolean gst_ciscdemux_queue_is_over(tPadQueue *queue, guint divisor)
+{
+   GstClockTime level = 0;
+
+   if (GST_CLOCK_TIME_IS_VALID(queue->inTime) && GST_CLOCK_TIME_IS_VALID(queue->outTime) &&
+       (queue->inTime > queue->outTime))
+   {
+      level = queue->inTime - queue->outTime;
+   }
+
+   return (queue->bytes >= (queue->demux->maxQueueBytes / divisor)) ||
+          (level >= (queue->demux->maxQueueTime / divisor));
+}
+
+/* Drops everything queued. Called with queue->lock held. */
+static void gst_ciscdemux_queue_clear(tPadQueue *queue)
+{
+   GstMiniObject *item = NULL;
+
+   while (NULL != (item = (GstMiniObject *)g_queue_pop_head(&queue->items)))
+   {
+      gst_mini_object_unref(item);
+   }
+
+   queue->bytes = 0;
+   queue->inTime = GST_CLOCK_TIME_NONE;
+   queue->outTime = GST_CLOCK_TIME_NONE;
+   queue->bFull = FALSE;
+}
+
+static tPadQueue *gst_ciscdemux_queue_for_pad(Gstciscdemux *demux, GstPad *pad)
+{
+   guint ii = 0;
+
+   for (ii = 0; ii < demux->numPadQueues; ii++)
+   {
+      if ((NULL != pad) && (demux->padQueue[ii].pad == pad))
+      {
+         return &demux->padQueue[ii];
+      }
+   }
+
+   return NULL;
+}
+
+/* Task function of a src pad, pushes the queue's contents downstream */
+static void gst_ciscdemux_queue_loop(gpointer data)
+{
+   tPadQueue *queue = (tPadQueue *)data;
+   GstMiniObject *item = NULL;
+   GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+   GstFlowReturn ret = GST_FLOW_OK;
+
+   g_mutex_lock(&queue->lock);
+   while ((TRUE != queue->bFlushing) && g_queue_is_empty(&queue->items))
+   {
+      g_cond_wait(&queue->cond, &queue->lock);
+   }
+
+   if (TRUE == queue->bFlushing)
+   {
+      g_mutex_unlock(&queue->lock);
+      gst_pad_pause_task(queue->pad);
+      return;
+   }
+
+   item = (GstMiniObject *)g_queue_pop_head(&queue->items);
+   queue->bytes -= gst_ciscdemux_queue_item_size(item);
+   timestamp = gst_ciscdemux_queue_item_time(item);
+   if (GST_CLOCK_TIME_IS_VALID(timestamp))
+   {
+      queue->outTime = timestamp;
+   }
+
+   if ((TRUE == queue->bFull) && (TRUE != gst_ciscdemux_queue_is_over(queue, 2)))
+   {
+      GST_DEBUG_OBJECT(queue->pad, "Queue under low watermark (%" G_GUINT64_FORMAT " bytes)", queue->bytes);
+      queue->bFull = FALSE;
+   }
+   g_mutex_unlock(&queue->lock);
+
+   if (GST_IS_BUFFER(item))
+   {
+      ret = gst_pad_push(queue->pad, GST_BUFFER_CAST(item));
+      if (GST_FLOW_OK == ret)
+      {
+         gst_ciscdemux_pts_data_pushed(queue->demux);
+      }
+#if GST_CHECK_VERSION(1,0,0)
+      else if (GST_FLOW_FLUSHING != ret)
+#else
+      else if (GST_FLOW_WRONG_STATE != ret)
+#endif
+      {
+         GST_WARNING_OBJECT(queue->pad, "Pushing buffer returned %s", gst_flow_get_name(ret));
+      }
+   }
+   else if (FALSE == gst_pad_push_event(queue->pad, GST_EVENT_CAST(item)))
+   {
+      GST_WARNING_OBJECT(queue->pad, "Error pushing queued event downstream");
+   }
+}
+
+static gboolean gst_ciscdemux_queue_start_task(tPadQueue *queue)
+{
+#if GST_CHECK_VERSION(1,0,0)
+   return gst_pad_start_task(queue->pad, (GstTaskFunction)gst_ciscdemux_queue_loop, queue, NULL);
+#else
+   return gst_pad_start_task(queue->pad, (GstTaskFunction)gst_ciscdemux_queue_loop, queue);
+#endif
+}
+
+/* Stops a queue's task and drops what it still holds; the queue can be
+ * restarted with gst_ciscdemux_queue_start_task()
+ */
+static void gst_ciscdemux_queue_stop(tPadQueue *queue)
+{
+   if (NULL == queue->pad)
+   {
+      return;
+   }
+
+   g_mutex_lock(&queue->lock);
+   queue->bFlushing = TRUE;
+   g_cond_signal(&queue->cond);
+   g_mutex_unlock(&queue->lock);
+
+   gst_pad_stop_task(queue->pad);
+
+   g_mutex_lock(&queue->lock);
+   gst_ciscdemux_queue_clear(queue);
+   g_mutex_unlock(&queue->lock);
+}
+
+/* Sets up a queue for each stream; their tasks start with
+ * gst_ciscdemux_queue_start() once the pads exist
+ */
+static void gst_ciscdemux_queue_init_all(Gstciscdemux *demux, guint numStreams)
+{
+   tPadQueue *queue = NULL;
+   guint ii = 0;
+
+   demux->padQueue = (tPadQueue *)g_malloc0(numStreams * sizeof(tPadQueue));
+   for (ii = 0; ii < numStreams; ii++)
+   {
+      queue = &demux->padQueue[ii];
+      queue->demux = demux;
+      g_queue_init(&queue->items);
+      queue->inTime = GST_CLOCK_TIME_NONE;
+      queue->outTime = GST_CLOCK_TIME_NONE;
+      g_mutex_init(&queue->lock);
+      g_cond_init(&queue->cond);
+   }
+   demux->numPadQueues = numStreams;
+}
+
+static void gst_ciscdemux_queue_start(Gstciscdemux *demux, guint streamNum, GstPad *pad)
+{
+   tPadQueue *queue = NULL;
+
+   if (streamNum >= demux->numPadQueues)
+   {
+      return;
+   }
+
+   queue = &demux->padQueue[streamNum];
+   g_mutex_lock(&queue->lock);
+   queue->bFlushing = FALSE;
+   g_mutex_unlock(&queue->lock);
+   queue->pad = pad;
+
+   if (FALSE == gst_ciscdemux_queue_start_task(queue))
+   {
+      // Without a task the pad is pushed to directly, as before
+      GST_WARNING_OBJECT(pad, "Unable to start the src pad task, pushing from the download thread\n");
+      queue->pad = NULL;
+   }
+}
+
+/* Queues a buffer or serialized event for a src pad, taking ownership
+ * of it. Pads without a queue are pushed to directly.
+ */
+static gboolean gst_ciscdemux_queue_push(Gstciscdemux *demux, GstPad *pad, GstMiniObject *item)
+{
+   tPadQueue *queue = gst_ciscdemux_queue_for_pad(demux, pad);
+   GstClockTime timestamp = GST_CLOCK_TIME_NONE;
+
+   if (NULL == queue)
+   {
+      if (GST_IS_BUFFER(item))
+      {
+         return (GST_FLOW_OK == gst_pad_push(pad, GST_BUFFER_CAST(item)));
+      }
+      return gst_pad_push_event(pad, GST_EVENT_CAST(item));
+   }
+
+   g_mutex_lock(&queue->lock);
+   queue->bytes += gst_ciscdemux_queue_item_size(item);
+   timestamp = gst_ciscdemux_queue_item_time(item);
+   if (GST_CLOCK_TIME_IS_VALID(timestamp))
+   {
+      queue->inTime = timestamp;
+   }
+   g_queue_push_tail(&queue->items, item);
+
+   if ((TRUE != queue->bFull) && (TRUE == gst_ciscdemux_queue_is_over(queue, 1)))
+   {
+      GST_DEBUG_OBJECT(pad, "Queue over high watermark (%" G_GUINT64_FORMAT " bytes), holding downloads back", queue->bytes);
+      queue->bFull = TRUE;
+   }
+
+   g_cond_signal(&queue->cond);
+   g_mutex_unlock(&queue->lock);
+
+   return TRUE;
+}
+
+/* TRUE while the queue of a stream is too full to take more data */
+static gboolean gst_ciscdemux_queue_is_full(Gstciscdemux *demux, gint streamNum)
+{
+   tPadQueue *queue = NULL;
+   gboolean bFull = FALSE;
+
+   if ((streamNum < 0) || (streamNum >= (gint)demux->numPadQueues))
+   {
+      return FALSE;
+   }
+
+   queue = &demux->padQueue[streamNum];
+   g_mutex_lock(&queue->lock);
+   bFull = queue->bFull;
+   g_mutex_unlock(&queue->lock);
+
+   return bFull;
+}
+
+static void gst_ciscdemux_queue_stop_all(Gstciscdemux *demux)
+{
+   guint ii = 0;
+
+   for (ii = 0; ii < demux->numPadQueues; ii++)
+   {
+      gst_ciscdemux_queue_stop(&demux->padQueue[ii]);
+   }
+}
+
+static void gst_ciscdemux_queue_free_all(Gstciscdemux *demux)
+{
+   guint ii = 0;
+
+   gst_ciscdemux_queue_stop_all(demux);
+
+   for (ii = 0; ii < demux->numPadQueues; ii++)
+   {
+      g_mutex_clear(&demux->padQueue[ii].lock);
+      g_cond_clear(&demux->padQueue[ii].cond);
+   }
+
+   g_free(demux->padQueue);
+   demux->padQueue = NULL;
+   demux->numPadQueues = 0;
+}
+
+/* Starts and stops the task of a src pad with its activation */
+static gboolean gst_ciscdemux_src_activate(GstPad *pad, gboolean active)
+{
+   Gstciscdemux *demux = (Gstciscdemux *)gst_pad_get_element_private(pad);
+   tPadQueue *queue = NULL;
+   gboolean ret = TRUE;
+
+   if (NULL != demux)
+   {
+      queue = gst_ciscdemux_queue_for_pad(demux, pad);
+   }
+
+   if (NULL != queue)
+   {
+      if (TRUE == active)
+      {
+         g_mutex_lock(&queue->lock);
+         queue->bFlushing = FALSE;
+         g_mutex_unlock(&queue->lock);
+         ret = gst_ciscdemux_queue_start_task(queue);
+      }
+      else
+      {
+         gst_ciscdemux_queue_stop(queue);
+      }
+   }
+
+   return ret;
+}
+
+#if GST_CHECK_VERSION(1,0,0)
+static gboolean gst_ciscdemux_src_activate_mode(GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active)
+{
+   if (GST_PAD_MODE_PUSH != mode)
+   {
+      return FALSE;
+   }
+
+   return gst_ciscdemux_src_activate(pad, active);
+}
+#else
+static gboolean gst_ciscdemux_src_activate_push(GstPad *pad, gboolean active)
+{
+   return gst_ciscdemux_src_activate(pad, active);
+}
+#endif
+
+/* Returns a buffer wrapper for hlsPlayer_getBuffer(), reusing one
+ * from the free list when there is one
+ */
+static tMemoryStruct *gst_ciscdemux_mem_get(Gstciscdemux *demux)
+{
+   tMemoryStruct *pmem = NULL;
+
+   g_mutex_lock(&demux->memMutex);
+   pmem = demux->pFreeMem;
+   if (NULL != pmem)
+   {
+      demux->pFreeMem = pmem->pNext;
+   }
+   g_mutex_unlock(&demux->memMutex);
+
+   if (NULL == pmem)
+   {
+      pmem = (tMemoryStruct*) g_malloc(sizeof(tMemoryStruct));
+   }
+
+   if (NULL != pmem)
+   {
+      memset(pmem, 0, sizeof(tMemoryStruct));
+   }
+
+   return pmem;
+}
+
+/* Puts a wrapper back on the free list; the GstBuffer it carried must
+ * already have been pushed or unreffed
+ */
+static void gst_ciscdemux_mem_put(Gstciscdemux *demux, tMemoryStruct *pmem)
+{
+   g_mutex_lock(&demux->memMutex);
+   pmem->buf = NULL;
+   pmem->bInUse = FALSE;
+   pmem->pNext = demux->pFreeMem;
+   demux->pFreeMem = pmem;
+   g_mutex_unlock(&demux->memMutex);
+}
+
+/* Frees the wrapper free list and releases the buffer pool. Buffers
+ * still held downstream are freed when they come back to the inactive
+ * pool.
+ */
+static void gst_ciscdemux_mem_free_all(Gstciscdemux *demux)
+{
+   tMemoryStruct *pmem = NULL;
+
+   g_mutex_lock(&demux->memMutex);
+   while (NULL != demux->pFreeMem)
+   {
+      pmem = demux->pFreeMem;
+      demux->pFreeMem = pmem->pNext;
+      g_free(pmem);
+   }
+#if GST_CHECK_VERSION(1,0,0)
+   if (NULL != demux->pool)
+   {
+      gst_buffer_pool_set_active(demux->pool, FALSE);
+      gst_object_unref(demux->pool);
+      demux->pool = NULL;
+      demux->poolBufferSize = 0;
+   }
+#endif
+   g_mutex_unlock(&demux->memMutex);
+}
+
+#if GST_CHECK_VERSION(1,0,0)
+/* Runs the ALLOCATION query on the main src pad and sets up the pool
+ * hlsPlayer_getBuffer() takes its buffers from. The pool, buffer size
+ * and buffer counts are the ones downstream proposes; if it proposes
+ * none we use a plain pool of BUFFER_SIZE buffers. There is one pool
+ * for the element since the plugin does not say which stream a buffer
+ * is for when it asks for one.
+ */
+static void gst_ciscdemux_negotiate_pool(Gstciscdemux *demux, GstCaps *caps)
+{
+   GstQuery *query = NULL;
+   GstBufferPool *pool = NULL;
+   GstAllocator *allocator = NULL;
+   GstAllocationParams params;
+   GstStructure *config = NULL;
+   guint size = 0;
+   guint min = 0;
+   guint max = 0;
+
+   do
+   {
+      gst_allocation_params_init(&params);
+
+      query = gst_query_new_allocation(caps, TRUE);
+      if (TRUE == gst_pad_peer_query(demux->srcpad, query))
+      {
+         if (gst_query_get_n_allocation_pools(query) > 0)
+         {
+            gst_query_parse_nth_allocation_pool(query, 0, &pool, &size, &min, &max);
+         }
+         if (gst_query_get_n_allocation_params(query) > 0)
+         {
+            gst_query_parse_nth_allocation_param(query, 0, &allocator, &params);
+         }
+      }
+      else
+      {
+         GST_DEBUG_OBJECT(demux, "Downstream did not answer the allocation query\n");
+      }
+      gst_query_unref(query);
+
+      if (NULL == pool)
+      {
+         pool = gst_buffer_pool_new();
+      }
+      if (0 == size)
+      {
+         size = BUFFER_SIZE;
+      }
+
+      config = gst_buffer_pool_get_config(pool);
+      gst_buffer_pool_config_set_params(config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator(config, allocator, &params);
+      if (FALSE == gst_buffer_pool_set_config(pool, config))
+      {
+         GST_WARNING_OBJECT(demux, "Buffer pool rejected its configuration, not using a pool\n");
+         gst_object_unref(pool);
+         break;
+      }
+
+      if (FALSE == gst_buffer_pool_set_active(pool, TRUE))
+      {
+         GST_WARNING_OBJECT(demux, "Unable to activate the buffer pool, not using a pool\n");
+         gst_object_unref(pool);
+         break;
+      }
+
+      GST_INFO_OBJECT(demux, "Using buffer pool %" GST_PTR_FORMAT " of %u byte buffers (min %u, max %u)\n",
+                      pool, size, min, max);
+
+      g_mutex_lock(&demux->memMutex);
+      demux->pool = pool;
+      demux->poolBufferSize = size;
+      g_mutex_unlock(&demux->memMutex);
+
+   }while (0);
+
+   if (NULL != allocator)
+   {
+      gst_object_unref(allocator);
+   }
+}
+#endif
+
 static GstClockTime gst_cisco_hls_get_duration (Gstciscdemux *demux)
 {
    srcPluginGetData_t getData;
@@ -2121,6 +2935,13 @@ static gboolean platform_getPTS(Gstciscdemux *demux, gint64 *in_pts_90khz)
 
    return bGotPTS;
 }
+/* Reports the play position to libhls, which derives the buffer level
+ * its bitrate decisions are based on from it. Rather than polling at a
+ * fixed rate, the thread sleeps while paused, reports every
+ * PTS_NOTIFY_MIN_MSECS while the src pad tasks are pushing data (the
+ * buffer level is changing) and every SRC_PTS_NOTIFY_INTERVAL seconds
+ * otherwise.
+ */
 static void * getCurrentPTSNotify(void *data)
 {
    gboolean        rc;
@@ -2128,7 +2949,9 @@ static void * getCurrentPTSNotify(void *data)
    gint64          pts_90khz = 0;
    Gstciscdemux    *demux = (Gstciscdemux *)data;
    srcPlayerEvt_t  ptsEvent = {SRC_PLAYER_LAST_PTS, NULL};
-   GTimeVal        ts = {0, 0};
+   gint64          lastReport = 0;
+   gint64          deadline = 0;
+   gboolean        bKill = FALSE;
 
    GST_LOG("%s() >>>>\n", __FUNCTION__);
 
@@ -2149,22 +2972,43 @@ static void * getCurrentPTSNotify(void *data)
       {
          g_mutex_lock(&demux->PTSMutex);
 
-         if(TRUE == demux->bKillPTSThread)
+         while(TRUE != demux->bKillPTSThread)
          {
-            g_mutex_unlock(&demux->PTSMutex);
-            break;
+            if(TRUE != demux->bPTSPlaying)
+            {
+               /* Nothing to report until we play again */
+               g_cond_wait(&demux->PTSThreadCond, &demux->PTSMutex);
+               continue;
+            }
+
+            if(TRUE == demux->bPTSDataFlowing)
+            {
+               deadline = lastReport + (PTS_NOTIFY_MIN_MSECS * G_TIME_SPAN_MILLISECOND);
+            }
+            else
+            {
+               deadline = lastReport + (SRC_PTS_NOTIFY_INTERVAL * G_TIME_SPAN_SECOND);
+            }
+
+            if(g_get_monotonic_time() >= deadline)
+            {
+               break;
+            }
+
+            g_cond_wait_until(&demux->PTSThreadCond, &demux->PTSMutex, deadline);
          }
 
-         ts.tv_sec = time(NULL) + SRC_PTS_NOTIFY_INTERVAL;
-         g_cond_timed_wait(&demux->PTSThreadCond, &demux->PTSMutex, &ts);
+         bKill = demux->bKillPTSThread;
+         demux->bPTSDataFlowing = FALSE;
+
+         g_mutex_unlock(&demux->PTSMutex);
 
-         if(TRUE == demux->bKillPTSThread)
+         if(TRUE == bKill)
          {
-            g_mutex_unlock(&demux->PTSMutex);
             break;
          }
 
-         g_mutex_unlock(&demux->PTSMutex);
+         lastReport = g_get_monotonic_time();
 
          if(NULL == demux->downstream_peer_pad)
          {
@@ -2196,6 +3040,30 @@ static void * getCurrentPTSNotify(void *data)
    return NULL;
 }
 
+/* Starts or stops position reporting with the playback state */
+static void gst_ciscdemux_pts_set_playing(Gstciscdemux *demux, gboolean bPlaying)
+{
+   g_mutex_lock(&demux->PTSMutex);
+   if (demux->bPTSPlaying != bPlaying)
+   {
+      demux->bPTSPlaying = bPlaying;
+      g_cond_signal(&demux->PTSThreadCond);
+   }
+   g_mutex_unlock(&demux->PTSMutex);
+}
+
+/* Called by the src pad tasks for every buffer they get downstream */
+static void gst_ciscdemux_pts_data_pushed(Gstciscdemux *demux)
+{
+   g_mutex_lock(&demux->PTSMutex);
+   if (TRUE != demux->bPTSDataFlowing)
+   {
+      demux->bPTSDataFlowing = TRUE;
+      g_cond_signal(&demux->PTSThreadCond);
+   }
+   g_mutex_unlock(&demux->PTSMutex);
+}
+
 static gboolean gst_ciscdemux_get_caps( Gstciscdemux *demux,
 												srcBufferMetadata_t *metadata,
 		                                        GstBuffer *buf,
@@ -2277,6 +3145,8 @@ static gboolean gst_ciscdemux_get_caps( Gstciscdemux *demux,
 static gboolean gst_ciscdemux_flush(Gstciscdemux *demux, GstPad *srcpad)
 {
    GstEvent *event;
+   GstEvent *stopEvent = NULL;
+   tPadQueue *queue = NULL;
    gboolean ret = FALSE;
 
    do
@@ -2293,22 +3163,52 @@ static gboolean gst_ciscdemux_flush(Gstciscdemux *demux, GstPad *srcpad)
          break;
       }
 
-      GST_LOG("cisco demux sending flush start downstream...\n");
-      gst_pad_push_event (srcpad, event);
-
 #if GST_CHECK_VERSION(1,0,0)
-      event = gst_event_new_flush_stop (TRUE); //rms changed from FALSE
+      stopEvent = gst_event_new_flush_stop (TRUE); //rms changed from FALSE
 #else
-      event = gst_event_new_flush_stop ();
+      stopEvent = gst_event_new_flush_stop ();
 #endif
-      if (event == NULL)
+      if (stopEvent == NULL)
       {
+         gst_event_unref(event);
          break;
       }
 
-      GST_LOG("cisco demux sending flush stop downstream...\n");
+      // Drop what is queued and keep the pad's task from pushing more
+      queue = gst_ciscdemux_queue_for_pad(demux, srcpad);
+      if (NULL != queue)
+      {
+         g_mutex_lock(&queue->lock);
+         queue->bFlushing = TRUE;
+         gst_ciscdemux_queue_clear(queue);
+         g_cond_signal(&queue->cond);
+         g_mutex_unlock(&queue->lock);
+      }
+
+      GST_LOG("cisco demux sending flush start downstream...\n");
       gst_pad_push_event (srcpad, event);
 
+      if (NULL != queue)
+      {
+         // The flush start unblocks the task if it was pushing, wait
+         // for it to pause
+         GST_PAD_STREAM_LOCK (srcpad);
+      }
+
+      GST_LOG("cisco demux sending flush stop downstream...\n");
+      gst_pad_push_event (srcpad, stopEvent);
+
+      if (NULL != queue)
+      {
+         g_mutex_lock(&queue->lock);
+         gst_ciscdemux_queue_clear(queue);
+         queue->bFlushing = FALSE;
+         g_mutex_unlock(&queue->lock);
+         GST_PAD_STREAM_UNLOCK (srcpad);
+
+         gst_ciscdemux_queue_start_task(queue);
+      }
+
       ret = TRUE;
    }while(0);
 
@@ -2340,7 +3240,7 @@ static gboolean gst_ciscdemux_disable_main_stream_audio(Gstciscdemux *demux)
 
       GST_INFO("Sending disable-audio-stream event downstream\n");
 
-      if (gst_pad_push_event(demux->srcpad, event)== FALSE)
+      if (gst_ciscdemux_queue_push(demux, demux->srcpad, GST_MINI_OBJECT_CAST(event))== FALSE)
       {
          GST_ERROR(" Error sending audio-stream event down stream\n");
          break;
@@ -2377,7 +3277,7 @@ static gboolean gst_ciscdemux_set_video_master(Gstciscdemux *demux)
 
       GST_INFO("Sending set-video-master event downstream\n");
 
-      if (gst_pad_push_event(demux->srcpad, event)== FALSE)
+      if (gst_ciscdemux_queue_push(demux, demux->srcpad, GST_MINI_OBJECT_CAST(event))== FALSE)
       {
          GST_ERROR(" Error sending set-video-master event downstream\n");
          break;
@@ -2418,7 +3318,7 @@ static gboolean gst_ciscdemux_set_audio_thresholds( Gstciscdemux *demux )
 
       GST_INFO("Sending set-audio-thresholds event downstream\n");
 
-      if (gst_pad_push_event(demux->srcpad, event)== FALSE)
+      if (gst_ciscdemux_queue_push(demux, demux->srcpad, GST_MINI_OBJECT_CAST(event))== FALSE)
       {
          GST_ERROR("Error sending set-audio-thresholds event downstream\n");
          break;
@@ -2430,7 +3330,7 @@ static gboolean gst_ciscdemux_set_audio_thresholds( Gstciscdemux *demux )
    return ret;
 }
 
-static gboolean gst_ciscdemux_send_eos(GstPad *srcpad)
+static gboolean gst_ciscdemux_send_eos(Gstciscdemux *demux, GstPad *srcpad)
 {
    gboolean ret = TRUE;
    GstEvent *event = NULL;
@@ -2438,7 +3338,7 @@ static gboolean gst_ciscdemux_send_eos(GstPad *srcpad)
    if (srcpad != NULL)
    {
       event = gst_event_new_eos();
-      if (gst_pad_push_event (srcpad, event) == FALSE)
+      if (gst_ciscdemux_queue_push (demux, srcpad, GST_MINI_OBJECT_CAST(event)) == FALSE)
       {
          GST_WARNING("Error sending the eos event down stream\n");
       }
@@ -2528,7 +3428,7 @@ static gboolean gst_ciscdemux_send_event_to_all_srcpads(Gstciscdemux *demux, Gst
    for(ii = 0; ii < demux->numSrcPadsActive - 1; ii++)
    {
       gst_event_ref(event);
-      ret = gst_pad_push_event(demux->srcpad_discrete[ii], event);
+      ret = gst_ciscdemux_queue_push(demux, demux->srcpad_discrete[ii], GST_MINI_OBJECT_CAST(event));
       if(TRUE != ret)
       {
          GST_ERROR("Error sending event : %s\n", GST_EVENT_TYPE_NAME(event));
@@ -2536,10 +3436,10 @@ static gboolean gst_ciscdemux_send_event_to_all_srcpads(Gstciscdemux *demux, Gst
       }
    }
 
-   ret = gst_pad_push_event(demux->srcpad, event);
+   ret = gst_ciscdemux_queue_push(demux, demux->srcpad, GST_MINI_OBJECT_CAST(event));
    if(TRUE != ret)
    {
-      GST_ERROR("Error sending event : %s\n", GST_EVENT_TYPE_NAME(event));
+      GST_ERROR("Error sending event\n");
       break;
    }
 
@@ -44,7 +44,7 @@ G_BEGIN_DECLS
 
 typedef struct _Gstciscdemux      Gstciscdemux;
 typedef struct _GstciscdemuxClass GstciscdemuxClass;
-typedef struct
+typedef struct _tMemoryStruct
 {
    GstBuffer *buf ;
 #if GST_CHECK_VERSION(1,0,0)
@@ -53,9 +53,29 @@ typedef struct
    unsigned char *memory;
    size_t   size;
    int      bInUse;
+   /* Next wrapper on the element's free list */
+   struct _tMemoryStruct *pNext;
 
 }tMemoryStruct;
 
+/* Streaming queue in front of one src pad. The libhls downloader
+ * threads only ever append to it; the pad's own task pushes its
+ * contents downstream, so a blocked decoder never blocks a download.
+ */
+typedef struct
+{
+   GstPad         *pad;         /* NULL until the pad has been created */
+   Gstciscdemux   *demux;
+   GQueue         items;        /* GstBuffers and serialized GstEvents */
+   guint64        bytes;        /* Buffer data queued */
+   GstClockTime   inTime;       /* Timestamp of the newest timestamped buffer queued */
+   GstClockTime   outTime;      /* Timestamp of the last timestamped buffer pushed */
+   gboolean       bFull;        /* Went over the high watermark and not yet back under the low one */
+   gboolean       bFlushing;    /* Task must not push, queue is being flushed or stopped */
+   GMutex         lock;         /* Protects everything above but pad and demux */
+   GCond          cond;         /* Signalled when items are added or bFlushing is set */
+}tPadQueue;
+
 typedef struct
 {
    int bInUse;
@@ -95,6 +115,8 @@ struct _Gstciscdemux
   GCond           PTSThreadCond;
   GMutex          PTSMutex;
   gboolean        bKillPTSThread;
+  gboolean        bPTSPlaying;      /* PTS thread only reports while playing */
+  gboolean        bPTSDataFlowing;  /* A buffer went downstream since the last report */
   gboolean        bGetPTSThreadRunning;
   gfloat          speed;
   guint           numSrcPadsActive;
@@ -103,6 +125,22 @@ struct _Gstciscdemux
   gint64          seekpos;
   gboolean        newSegment;
   gchar           defaultAudioLangISOCode[ISO_LANG_CODE_LEN + 1];
+  gboolean        bDecrypt;
+  guint           parallelConnections;
+
+  /* Streaming queues, indexed by stream number like inputStreamCap */
+  tPadQueue       *padQueue;
+  guint           numPadQueues;
+  guint           maxQueueBytes;
+  guint64         maxQueueTime;
+
+  /* Buffers handed to the HLS plugin; memMutex protects everything below */
+  GMutex          memMutex;
+  tMemoryStruct   *pFreeMem;
+#if GST_CHECK_VERSION(1,0,0)
+  GstBufferPool   *pool;
+  guint           poolBufferSize;
+#endif
 };
 
 struct _GstciscdemuxClass
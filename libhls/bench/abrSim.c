@@ -0,0 +1,749 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file abrSim.c @date October 19, 2026
+ *
+ * Offline trace-replay simulator for the bitrate adaptation logic.
+ *
+ * A throughput trace (recorded or synthetic) is replayed against a
+ * simple player model: segments of segmentDuration seconds are
+ * downloaded back to back at the trace throughput, the buffer drains
+ * in real time once playback has started, and downloading pauses
+ * while the buffer is full.  The strategy picks the bitrate of every
+ * segment.  "adaptech" is the real abrClientGetNewBitrate() from
+ * adaptech.c, running on a simulated clock; the others are
+ * alternatives to compare it against.  New strategies only need an
+ * entry in abrSimStrategies[].
+ *
+ * Traces are text, one sample per line:
+ *
+ *   <seconds> <kbit/s>      throughput for the next <seconds>
+ *
+ * or JSON lines from SRC_PLUGIN_SET_TRACE_DUMP / HLS_TRACE_FILE, in
+ * which case the throughput of every segment download is held until
+ * the next one starts.  The trace loops if it is shorter than the
+ * simulated session.
+ *
+ * Results are written one per line as "strategy metric value unit".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <getopt.h>
+#include <time.h>
+
+#include "hlsTypes.h"
+#include "adaptech.h"
+
+/* Maximum number of variants */
+#define ABR_SIM_MAX_BITRATES 16
+
+/* Maximum number of samples in a trace */
+#define ABR_SIM_MAX_TRACE_SAMPLES 65536
+
+/* The simulated CLOCK_MONOTONIC starts here so that 0 still means "not set" */
+#define ABR_SIM_CLOCK_BASE 1000
+
+/* Length of each sample of the "random" synthetic trace, in seconds */
+#define ABR_SIM_RANDOM_SAMPLE_SECS 1
+
+/*! One sample of a throughput trace */
+typedef struct {
+    double duration;                /*!< Seconds */
+    double throughput;              /*!< bps */
+} abrSimSample_t;
+
+/*! Throughput over time */
+typedef struct {
+    abrSimSample_t* pSamples;
+    int numSamples;
+    double length;                  /*!< Sum of the sample durations, in seconds */
+} abrSimTrace_t;
+
+/*! Simulation input and state */
+typedef struct {
+    /* Input */
+    int bitrates[ABR_SIM_MAX_BITRATES];
+    int numBitrates;
+    double segmentDuration;         /*!< Seconds */
+    int numSegments;
+    double maxBuffer;               /*!< Downloading pauses above this many seconds buffered */
+    double rtt;                     /*!< Seconds of request latency added to every download */
+    abrSimTrace_t* pTrace;
+    int bVerbose;                   /*!< Print every segment */
+    FILE* fpResults;
+
+    /* Player model */
+    double now;                     /*!< Seconds since the session started */
+    double buffered;                /*!< Seconds buffered */
+    int bPlaying;                   /*!< Playback has started */
+    int bStalled;                   /*!< Buffer ran dry and no segment has arrived since */
+    int curIndex;                   /*!< Bitrate index of the last segment, -1 before the first */
+    float lastRate;                 /*!< Throughput of the last download, in bps */
+    float avgRate;                  /*!< Average throughput, in bps */
+    struct timespec lastIncrease;   /*!< Passed to abrClientGetNewBitrate() */
+    struct timespec playbackStart;  /*!< Passed to abrClientGetNewBitrate() */
+
+    /* QoE */
+    double startupDelay;            /*!< Seconds from start to the first segment being playable */
+    double stallTime;               /*!< Seconds spent with an empty buffer after startup */
+    int numStalls;
+    int numSwitches;
+    double bitrateSum;              /*!< Sum of the bitrates of all segments */
+} abrSim_t;
+
+/*! Picks the bitrate index of the next segment */
+typedef int (*abrSimStrategyFunc_t)(abrSim_t* pSim);
+
+/*! A bitrate adaptation strategy */
+typedef struct {
+    const char* pName;
+    abrSimStrategyFunc_t pFunc;
+} abrSimStrategy_t;
+
+/* The simulated time, read by adaptech.c through abrSimClock() */
+static double abrSimNow = 0;
+
+static int abrSimClock(struct timespec* pNow)
+{
+    double now = ABR_SIM_CLOCK_BASE + abrSimNow;
+
+    pNow->tv_sec = (time_t)now;
+    pNow->tv_nsec = (long)((now - pNow->tv_sec) * 1000000000);
+
+    return 0;
+}
+
+/**
+ * The real thing.
+ */
+static int strategyAdaptech(abrSim_t* pSim)
+{
+    int currentBitrate = (pSim->curIndex >= 0) ? pSim->bitrates[pSim->curIndex] : pSim->bitrates[0];
+
+    return abrClientGetNewBitrate(pSim->lastRate, pSim->avgRate, (float)(pSim->buffered),
+                                  pSim->numBitrates, pSim->bitrates, currentBitrate, 0, INT_MAX,
+                                  &(pSim->lastIncrease), &(pSim->playbackStart));
+}
+
+/**
+ * Highest bitrate under slackFactor times the average throughput,
+ * ignoring the buffer.
+ */
+static int strategyRate(abrSim_t* pSim)
+{
+    abrClientParams_t params;
+    int i = 0;
+
+    abrClientGetParams(&params);
+
+    for(i = pSim->numBitrates - 1; i > 0; i--)
+    {
+        if(pSim->bitrates[i] <= params.slackFactor * pSim->avgRate)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+/**
+ * Buffer based: lowest bitrate below lowBufferLevel, highest above
+ * normalBufferLevel and linear in between, ignoring throughput.
+ */
+static int strategyBuffer(abrSim_t* pSim)
+{
+    abrClientParams_t params;
+    double fraction = 0;
+
+    abrClientGetParams(&params);
+
+    if(pSim->buffered <= params.lowBufferLevel)
+    {
+        return 0;
+    }
+    if(pSim->buffered >= params.normalBufferLevel)
+    {
+        return pSim->numBitrates - 1;
+    }
+
+    fraction = (pSim->buffered - params.lowBufferLevel) / (params.normalBufferLevel - params.lowBufferLevel);
+
+    return (int)(fraction * (pSim->numBitrates - 1));
+}
+
+static abrSimStrategy_t abrSimStrategies[] = {
+    { "adaptech", strategyAdaptech },
+    { "rate", strategyRate },
+    { "buffer", strategyBuffer },
+};
+
+#define ABR_SIM_NUM_STRATEGIES (sizeof(abrSimStrategies) / sizeof(abrSimStrategies[0]))
+
+/**
+ * Appends a sample to a trace.
+ */
+static hlsStatus_t traceAdd(abrSimTrace_t* pTrace, double duration, double throughput)
+{
+    if((duration <= 0) || (throughput < 0) || (pTrace->numSamples >= ABR_SIM_MAX_TRACE_SAMPLES))
+    {
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pTrace->pSamples[pTrace->numSamples].duration = duration;
+    pTrace->pSamples[pTrace->numSamples].throughput = throughput;
+    pTrace->numSamples++;
+    pTrace->length += duration;
+
+    return HLS_OK;
+}
+
+/**
+ * Returns the number following "\"<pName>\":" in a JSON line, or -1.
+ */
+static double jsonNumber(const char* pLine, const char* pName)
+{
+    char key[32];
+    const char* pValue = NULL;
+
+    snprintf(key, sizeof(key), "\"%s\":", pName);
+
+    pValue = strstr(pLine, key);
+    if(pValue == NULL)
+    {
+        return -1;
+    }
+
+    return atof(pValue + strlen(key));
+}
+
+/**
+ * Reads a trace file (see the top of this file for the formats).
+ */
+static hlsStatus_t traceLoad(const char* pPath, abrSimTrace_t* pTrace)
+{
+    hlsStatus_t rval = HLS_OK;
+    FILE* fp = NULL;
+    char line[512];
+    double duration = 0;
+    double throughput = 0;
+    double start = 0;
+    double lastStart = -1;
+    double lastThroughput = 0;
+    double lastTotal = 0;
+    int lineNumber = 0;
+
+    do
+    {
+        fp = fopen(pPath, "r");
+        if(fp == NULL)
+        {
+            perror(pPath);
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        while(fgets(line, sizeof(line), fp) != NULL)
+        {
+            lineNumber++;
+
+            if(line[0] == '{')
+            {
+                /* Only segment downloads say anything about the throughput */
+                if((strstr(line, "\"type\":\"segment\"") == NULL) ||
+                   (jsonNumber(line, "result") != HLS_OK) ||
+                   (jsonNumber(line, "total_us") <= 0))
+                {
+                    continue;
+                }
+
+                start = jsonNumber(line, "start_us") / 1000000;
+                throughput = jsonNumber(line, "bytes") * 8 / (jsonNumber(line, "total_us") / 1000000);
+
+                if((lastStart >= 0) && (start > lastStart))
+                {
+                    rval = traceAdd(pTrace, start - lastStart, lastThroughput);
+                }
+
+                lastStart = start;
+                lastThroughput = throughput;
+                lastTotal = jsonNumber(line, "total_us") / 1000000;
+            }
+            else if((line[0] == '#') || (strspn(line, " \t\r\n") == strlen(line)))
+            {
+                continue;
+            }
+            else if(sscanf(line, "%lf %lf", &duration, &throughput) == 2)
+            {
+                rval = traceAdd(pTrace, duration, throughput * 1000);
+            }
+            else
+            {
+                rval = HLS_INVALID_PARAMETER;
+            }
+
+            if(rval != HLS_OK)
+            {
+                fprintf(stderr, "%s:%d: bad or too many samples\n", pPath, lineNumber);
+                break;
+            }
+        }
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        /* The last download of a recorded trace lasts as long as it took */
+        if(lastStart >= 0)
+        {
+            rval = traceAdd(pTrace, lastTotal, lastThroughput);
+            if(rval != HLS_OK)
+            {
+                break;
+            }
+        }
+
+    } while(0);
+
+    if(fp != NULL)
+    {
+        fclose(fp);
+    }
+
+    return rval;
+}
+
+/**
+ * Builds a synthetic trace from a spec:
+ *
+ *   constant:<kbit/s>
+ *   step:<kbit/s>:<kbit/s>:<seconds>    alternates every <seconds>
+ *   random:<kbit/s>:<seconds>           random walk around <kbit/s>
+ */
+static hlsStatus_t traceGenerate(const char* pSpec, abrSimTrace_t* pTrace)
+{
+    hlsStatus_t rval = HLS_OK;
+    unsigned int seed = 1;
+    double rate1 = 0;
+    double rate2 = 0;
+    double seconds = 0;
+    double rate = 0;
+    int i = 0;
+
+    if(sscanf(pSpec, "constant:%lf", &rate1) == 1)
+    {
+        rval = traceAdd(pTrace, 1, rate1 * 1000);
+    }
+    else if(sscanf(pSpec, "step:%lf:%lf:%lf", &rate1, &rate2, &seconds) == 3)
+    {
+        rval = traceAdd(pTrace, seconds, rate1 * 1000);
+        if(rval == HLS_OK)
+        {
+            rval = traceAdd(pTrace, seconds, rate2 * 1000);
+        }
+    }
+    else if(sscanf(pSpec, "random:%lf:%lf", &rate1, &seconds) == 2)
+    {
+        rate = rate1;
+        for(i = 0; (rval == HLS_OK) && (i < seconds / ABR_SIM_RANDOM_SAMPLE_SECS); i++)
+        {
+            /* Multiply by 0.7 to 1.4 each step, staying within 10% and 300% of the mean */
+            rate *= 0.7 + (0.7 * rand_r(&seed) / RAND_MAX);
+            if(rate < rate1 / 10)
+            {
+                rate = rate1 / 10;
+            }
+            else if(rate > rate1 * 3)
+            {
+                rate = rate1 * 3;
+            }
+            rval = traceAdd(pTrace, ABR_SIM_RANDOM_SAMPLE_SECS, rate * 1000);
+        }
+    }
+    else
+    {
+        rval = HLS_INVALID_PARAMETER;
+    }
+
+    return rval;
+}
+
+/**
+ * Returns how long it takes to transfer numBits starting at time
+ * start, following the (looping) trace.
+ */
+static double traceTransferTime(abrSimTrace_t* pTrace, double start, double numBits)
+{
+    double offset = 0;
+    double elapsed = 0;
+    double left = 0;
+    double bits = 0;
+    int i = 0;
+
+    /* Find the sample we start in */
+    offset = start - ((long)(start / pTrace->length) * pTrace->length);
+    for(i = 0; (i < pTrace->numSamples - 1) && (offset >= pTrace->pSamples[i].duration); i++)
+    {
+        offset -= pTrace->pSamples[i].duration;
+    }
+
+    while(1)
+    {
+        left = pTrace->pSamples[i].duration - offset;
+        bits = pTrace->pSamples[i].throughput * left;
+
+        if(bits >= numBits)
+        {
+            return elapsed + (numBits / pTrace->pSamples[i].throughput);
+        }
+
+        numBits -= bits;
+        elapsed += left;
+        offset = 0;
+        i = (i + 1) % pTrace->numSamples;
+    }
+}
+
+/**
+ * Lets time pass, draining the buffer if playback has started.
+ */
+static void simAdvance(abrSim_t* pSim, double seconds)
+{
+    if(pSim->bPlaying)
+    {
+        if(pSim->buffered >= seconds)
+        {
+            pSim->buffered -= seconds;
+        }
+        else
+        {
+            if(!pSim->bStalled)
+            {
+                pSim->bStalled = 1;
+                pSim->numStalls++;
+            }
+            pSim->stallTime += seconds - pSim->buffered;
+            pSim->buffered = 0;
+        }
+    }
+
+    pSim->now += seconds;
+    abrSimNow = pSim->now;
+}
+
+/**
+ * Plays one session with the given strategy and writes its QoE.
+ */
+static hlsStatus_t simRun(abrSim_t* pSim, abrSimStrategy_t* pStrategy)
+{
+    double downloadTime = 0;
+    double numBits = 0;
+    int index = 0;
+    int i = 0;
+
+    pSim->now = 0;
+    pSim->buffered = 0;
+    pSim->bPlaying = 0;
+    pSim->bStalled = 0;
+    pSim->curIndex = -1;
+    pSim->lastRate = 0;
+    pSim->avgRate = 0;
+    memset(&(pSim->lastIncrease), 0, sizeof(struct timespec));
+    memset(&(pSim->playbackStart), 0, sizeof(struct timespec));
+    pSim->startupDelay = 0;
+    pSim->stallTime = 0;
+    pSim->numStalls = 0;
+    pSim->numSwitches = 0;
+    pSim->bitrateSum = 0;
+    abrSimNow = 0;
+
+    for(i = 0; i < pSim->numSegments; i++)
+    {
+        /* Wait for room in the buffer */
+        if(pSim->buffered + pSim->segmentDuration > pSim->maxBuffer)
+        {
+            simAdvance(pSim, pSim->buffered + pSim->segmentDuration - pSim->maxBuffer);
+        }
+
+        index = pStrategy->pFunc(pSim);
+        if((index < 0) || (index >= pSim->numBitrates))
+        {
+            fprintf(stderr, "%s picked bad index %d at segment %d\n", pStrategy->pName, index, i);
+            return HLS_ERROR;
+        }
+
+        numBits = (double)(pSim->bitrates[index]) * pSim->segmentDuration;
+        downloadTime = pSim->rtt + traceTransferTime(pSim->pTrace, pSim->now + pSim->rtt, numBits);
+        simAdvance(pSim, downloadTime);
+
+        /* Same bookkeeping as the downloader */
+        pSim->lastRate = numBits / downloadTime;
+        if(pSim->avgRate == 0)
+        {
+            pSim->avgRate = pSim->lastRate;
+        }
+        else
+        {
+            pSim->avgRate = abrClientAddThroughputToAvg(pSim->lastRate, pSim->avgRate);
+        }
+
+        pSim->buffered += pSim->segmentDuration;
+        pSim->bStalled = 0;
+
+        if(!pSim->bPlaying)
+        {
+            pSim->bPlaying = 1;
+            pSim->startupDelay = pSim->now;
+            abrSimClock(&(pSim->playbackStart));
+        }
+
+        if((pSim->curIndex >= 0) && (index != pSim->curIndex))
+        {
+            pSim->numSwitches++;
+        }
+        pSim->curIndex = index;
+        pSim->bitrateSum += pSim->bitrates[index];
+
+        if(pSim->bVerbose)
+        {
+            fprintf(pSim->fpResults, "%-12s segment %d t=%.2fs bitrate=%d download=%.3fs throughput=%.0f avg=%.0f buffered=%.2fs\n",
+                    pStrategy->pName, i, pSim->now, pSim->bitrates[index], downloadTime,
+                    pSim->lastRate, pSim->avgRate, pSim->buffered);
+        }
+    }
+
+    fprintf(pSim->fpResults, "%-12s %-28s %12.3f %s\n", pStrategy->pName, "avg_bitrate", pSim->bitrateSum / pSim->numSegments / 1000, "kbit/s");
+    fprintf(pSim->fpResults, "%-12s %-28s %12.3f %s\n", pStrategy->pName, "switches", (double)(pSim->numSwitches), "");
+    fprintf(pSim->fpResults, "%-12s %-28s %12.3f %s\n", pStrategy->pName, "stalls", (double)(pSim->numStalls), "");
+    fprintf(pSim->fpResults, "%-12s %-28s %12.3f %s\n", pStrategy->pName, "stall_time", pSim->stallTime, "s");
+    fprintf(pSim->fpResults, "%-12s %-28s %12.3f %s\n", pStrategy->pName, "startup_delay", pSim->startupDelay, "s");
+    fflush(pSim->fpResults);
+
+    return HLS_OK;
+}
+
+static hlsStatus_t parseBitrates(char* pList, abrSim_t* pSim)
+{
+    char* pToken = NULL;
+    char* pSave = NULL;
+
+    pSim->numBitrates = 0;
+
+    for(pToken = strtok_r(pList, ",", &pSave); pToken != NULL; pToken = strtok_r(NULL, ",", &pSave))
+    {
+        if((pSim->numBitrates >= ABR_SIM_MAX_BITRATES) || (atoi(pToken) <= 0) ||
+           ((pSim->numBitrates > 0) && (atoi(pToken) <= pSim->bitrates[pSim->numBitrates - 1])))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+        pSim->bitrates[pSim->numBitrates++] = atoi(pToken);
+    }
+
+    return (pSim->numBitrates > 0) ? HLS_OK : HLS_INVALID_PARAMETER;
+}
+
+static void usage(const char* pName)
+{
+    fprintf(stderr,
+            "usage: %s [options] (-f <trace> | -g <spec>)\n"
+            "  -f <file>       throughput trace, \"<seconds> <kbit/s>\" lines or a JSON trace dump\n"
+            "  -g <spec>       synthetic trace: constant:<kbit/s>, step:<kbit/s>:<kbit/s>:<seconds>\n"
+            "                  or random:<kbit/s>:<seconds>\n"
+            "  -s <strategy>   adaptech, rate, buffer or all (default all)\n"
+            "  -b <bitrates>   comma separated ascending variant bitrates in bps (default 800000,2000000,4000000)\n"
+            "  -t <seconds>    segment duration (default 10)\n"
+            "  -c <segments>   session length in segments (default 60)\n"
+            "  -B <seconds>    buffer size (default 30)\n"
+            "  -R <msecs>      request latency (default 50)\n"
+            "  -S <factor>     adaptech slack factor\n"
+            "  -W <weight>     adaptech average weight\n"
+            "  -L <seconds>    adaptech low buffer level\n"
+            "  -N <seconds>    adaptech normal buffer level\n"
+            "  -U <seconds>    adaptech can-switch-up threshold\n"
+            "  -v              print every segment\n"
+            "  -o <file>       write results to file instead of stderr\n",
+            pName);
+}
+
+int main(int argc, char** argv)
+{
+    abrSim_t sim;
+    abrSimTrace_t trace;
+    abrClientParams_t params;
+    const char* pStrategy = "all";
+    const char* pTraceFile = NULL;
+    const char* pTraceSpec = NULL;
+    char defaultBitrates[] = "800000,2000000,4000000";
+    int bFound = 0;
+    int option = 0;
+    int rval = 0;
+    unsigned int i = 0;
+    int j = 0;
+
+    memset(&sim, 0, sizeof(sim));
+    memset(&trace, 0, sizeof(trace));
+    sim.fpResults = stderr;
+    sim.segmentDuration = 10;
+    sim.numSegments = 60;
+    sim.maxBuffer = 30;
+    sim.rtt = 0.05;
+    sim.pTrace = &trace;
+    parseBitrates(defaultBitrates, &sim);
+
+    abrClientGetParams(&params);
+
+    while((option = getopt(argc, argv, "f:g:s:b:t:c:B:R:S:W:L:N:U:vo:h")) != -1)
+    {
+        switch(option)
+        {
+            case 'f':
+                pTraceFile = optarg;
+                break;
+            case 'g':
+                pTraceSpec = optarg;
+                break;
+            case 's':
+                pStrategy = optarg;
+                break;
+            case 'b':
+                if(parseBitrates(optarg, &sim) != HLS_OK)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't':
+                sim.segmentDuration = atof(optarg);
+                break;
+            case 'c':
+                sim.numSegments = atoi(optarg);
+                break;
+            case 'B':
+                sim.maxBuffer = atof(optarg);
+                break;
+            case 'R':
+                sim.rtt = atof(optarg) / 1000;
+                break;
+            case 'S':
+                params.slackFactor = atof(optarg);
+                break;
+            case 'W':
+                params.avgWeight = atof(optarg);
+                break;
+            case 'L':
+                params.lowBufferLevel = atoi(optarg);
+                break;
+            case 'N':
+                params.normalBufferLevel = atoi(optarg);
+                break;
+            case 'U':
+                params.canSwitchUpThreshold = atoi(optarg);
+                break;
+            case 'v':
+                sim.bVerbose = 1;
+                break;
+            case 'o':
+                sim.fpResults = fopen(optarg, "w");
+                if(sim.fpResults == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if(((pTraceFile == NULL) == (pTraceSpec == NULL)) ||
+       (sim.segmentDuration <= 0) || (sim.numSegments <= 0) || (sim.maxBuffer < sim.segmentDuration) ||
+       (sim.rtt < 0) || (params.lowBufferLevel >= params.normalBufferLevel))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    trace.pSamples = malloc(ABR_SIM_MAX_TRACE_SAMPLES * sizeof(abrSimSample_t));
+    if(trace.pSamples == NULL)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    do
+    {
+        if(((pTraceFile != NULL) && (traceLoad(pTraceFile, &trace) != HLS_OK)) ||
+           ((pTraceSpec != NULL) && (traceGenerate(pTraceSpec, &trace) != HLS_OK)))
+        {
+            fprintf(stderr, "couldn't load trace %s\n", (pTraceFile != NULL) ? pTraceFile : pTraceSpec);
+            rval = 1;
+            break;
+        }
+
+        /* An all zero trace would never finish a download */
+        for(j = 0; (j < trace.numSamples) && (trace.pSamples[j].throughput == 0); j++);
+        if(j == trace.numSamples)
+        {
+            fprintf(stderr, "trace has no throughput\n");
+            rval = 1;
+            break;
+        }
+
+        abrClientSetParams(&params);
+        abrClientSetClock(abrSimClock);
+
+        for(i = 0; i < ABR_SIM_NUM_STRATEGIES; i++)
+        {
+            if((strcmp(pStrategy, "all") == 0) || (strcmp(pStrategy, abrSimStrategies[i].pName) == 0))
+            {
+                bFound = 1;
+                if(simRun(&sim, &(abrSimStrategies[i])) != HLS_OK)
+                {
+                    rval = 1;
+                }
+            }
+        }
+
+        abrClientSetClock(NULL);
+
+        if(!bFound)
+        {
+            usage(argv[0]);
+            rval = 1;
+        }
+
+    } while(0);
+
+    free(trace.pSamples);
+
+    if(sim.fpResults != stderr)
+    {
+        fclose(sim.fpResults);
+    }
+
+    return rval;
+}
@@ -0,0 +1,910 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file benchOrigin.c @date October 19, 2026
+ *
+ * Embedded HTTP/1.1 origin serving synthetic VOD and live content to
+ * the benchmarks.
+ *
+ * Each connection gets its own thread and is kept alive until the
+ * client closes it, like a CDN edge would.  Nothing is stored: the
+ * playlists are formatted and the TS packets generated on request,
+ * so any byte range of any segment can be served and the origin costs
+ * little CPU next to the plugin it is feeding.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <errno.h>
+#include <unistd.h>
+#include <math.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "benchOrigin.h"
+
+#include "hlsClock.h"
+
+#include "debug.h"
+
+#define TS_PACKET_SIZE 188
+
+/* Size of the buffer requests are read into; larger requests are rejected */
+#define ORIGIN_REQUEST_SIZE 4096
+
+/* Size of the buffer responses are sent from */
+#define ORIGIN_SEND_SIZE (64*1024)
+
+/* How often idle connections check whether the origin is stopping */
+#define ORIGIN_POLL_MSECS 200
+
+struct benchOrigin_t_ {
+    benchOriginConfig_t config;     /*!< Content being served */
+    int listenFd;                   /*!< Listening socket */
+    int port;                       /*!< Port listenFd is bound to */
+    pthread_t acceptThread;         /*!< Thread accepting connections */
+    pthread_mutex_t mutex;          /*!< Protects the fields below */
+    pthread_cond_t cond;            /*!< Signalled when a connection thread exits */
+    int numConnections;             /*!< Number of live connection threads */
+    int bStop;                      /*!< Set when the origin is being stopped */
+    struct timespec startTime;      /*!< Time the live playlists started sliding */
+    benchOriginCounters_t counters; /*!< Requests served so far */
+};
+
+/*! Argument of a connection thread */
+typedef struct {
+    benchOrigin_t* pOrigin;
+    int fd;
+} originConnection_t;
+
+/**
+ * MPEG-2 CRC32 used by PSI sections.
+ */
+static uint32_t crc32Mpeg(const unsigned char* pData, int length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    int i = 0;
+    int bit = 0;
+
+    for(i = 0; i < length; i++)
+    {
+        crc ^= ((uint32_t)pData[i]) << 24;
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04C11DB7) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * Writes a PSI section (PAT or PMT) into a TS packet.
+ *
+ * @param pPacket - TS_PACKET_SIZE bytes to fill
+ * @param pid - PID of the section
+ * @param pSection - section from table_id up to, but not
+ *                 including, the CRC
+ * @param length - bytes in pSection
+ */
+static void writeSection(unsigned char* pPacket, int pid, const unsigned char* pSection, int length)
+{
+    uint32_t crc = 0;
+
+    memset(pPacket, 0xFF, TS_PACKET_SIZE);
+
+    pPacket[0] = 0x47;
+    pPacket[1] = 0x40 | ((pid >> 8) & 0x1F);
+    pPacket[2] = pid & 0xFF;
+    pPacket[3] = 0x10;
+    pPacket[4] = 0x00; /* pointer field */
+
+    memcpy(pPacket + 5, pSection, length);
+
+    crc = crc32Mpeg(pSection, length);
+    pPacket[5 + length] = (crc >> 24) & 0xFF;
+    pPacket[6 + length] = (crc >> 16) & 0xFF;
+    pPacket[7 + length] = (crc >> 8) & 0xFF;
+    pPacket[8 + length] = crc & 0xFF;
+}
+
+/**
+ * Returns the number of TS packets in every segment of a variant.
+ */
+static long segmentPackets(benchOrigin_t* pOrigin, int bitrate)
+{
+    long numPackets = (long)ceil((double)bitrate * pOrigin->config.segmentDuration / 8 / TS_PACKET_SIZE);
+
+    /* PAT, PMT and at least one PES packet */
+    return (numPackets < 3) ? 3 : numPackets;
+}
+
+/**
+ * Generates TS packet number index of segment sequence of a
+ * variant.  Packet 0 is the PAT, packet 1 the PMT and the rest
+ * carry a single PES stream with a PTS every
+ * BENCH_ORIGIN_PES_INTERVAL_MS of media.
+ *
+ * @param pOrigin - origin
+ * @param numPackets - packets in the segment
+ * @param sequence - media sequence number of the segment
+ * @param index - packet to generate
+ * @param pPacket - TS_PACKET_SIZE bytes to fill
+ */
+static void generatePacket(benchOrigin_t* pOrigin, long numPackets, int sequence, long index, unsigned char* pPacket)
+{
+    static const unsigned char pat[] = { 0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                                         0x00, 0x01, 0xF0, 0x00 };
+    static const unsigned char pmt[] = { 0x02, 0xB0, 0x12, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                                         0xE0 | (BENCH_ORIGIN_VIDEO_PID >> 8), BENCH_ORIGIN_VIDEO_PID & 0xFF, 0xF0, 0x00,
+                                         0x1B, 0xE0 | (BENCH_ORIGIN_VIDEO_PID >> 8), BENCH_ORIGIN_VIDEO_PID & 0xFF, 0xF0, 0x00 };
+
+    long pesInterval = 0;
+    long pesIndex = 0;
+    long long pts = 0;
+
+    if(index == 0)
+    {
+        writeSection(pPacket, 0x0000, pat, sizeof(pat));
+        return;
+    }
+
+    if(index == 1)
+    {
+        writeSection(pPacket, 0x1000, pmt, sizeof(pmt));
+        return;
+    }
+
+    index -= 2;
+
+    pesInterval = (long)((numPackets - 2) * BENCH_ORIGIN_PES_INTERVAL_MS / (pOrigin->config.segmentDuration * 1000));
+    if(pesInterval < 1)
+    {
+        pesInterval = 1;
+    }
+    pesIndex = index / pesInterval;
+
+    memset(pPacket, 0xA5, TS_PACKET_SIZE);
+
+    pPacket[0] = 0x47;
+    pPacket[1] = (BENCH_ORIGIN_VIDEO_PID >> 8) & 0x1F;
+    pPacket[2] = BENCH_ORIGIN_VIDEO_PID & 0xFF;
+    pPacket[3] = 0x10 | (index & 0x0F);
+
+    if((index % pesInterval) == 0)
+    {
+        pts = BENCH_ORIGIN_PTS_BASE +
+              (long long)(sequence * pOrigin->config.segmentDuration * 90000) +
+              (pesIndex * BENCH_ORIGIN_PES_INTERVAL_MS * 90);
+
+        /* payload_unit_start_indicator, then a PES header carrying only a PTS */
+        pPacket[1] |= 0x40;
+        pPacket[4] = 0x00;
+        pPacket[5] = 0x00;
+        pPacket[6] = 0x01;
+        pPacket[7] = 0xE0;
+        pPacket[8] = 0x00;
+        pPacket[9] = 0x00;
+        pPacket[10] = 0x80;
+        pPacket[11] = 0x80;
+        pPacket[12] = 0x05;
+        pPacket[13] = 0x21 | ((pts >> 29) & 0x0E);
+        pPacket[14] = (pts >> 22) & 0xFF;
+        pPacket[15] = 0x01 | ((pts >> 14) & 0xFE);
+        pPacket[16] = (pts >> 7) & 0xFF;
+        pPacket[17] = 0x01 | ((pts << 1) & 0xFE);
+    }
+}
+
+/**
+ * Returns the number of live segments published so far.
+ */
+static int liveSegmentsAvailable(benchOrigin_t* pOrigin)
+{
+    struct timespec now;
+    double elapsed = 0;
+
+    hlsClock_now(&now);
+    elapsed = (now.tv_sec - pOrigin->startTime.tv_sec) + ((now.tv_nsec - pOrigin->startTime.tv_nsec) / 1000000000.0);
+
+    return pOrigin->config.liveWindow + (int)(elapsed / pOrigin->config.segmentDuration);
+}
+
+/**
+ * Returns TRUE if bitrate is one of the configured variants.
+ */
+static int isVariant(benchOrigin_t* pOrigin, int bitrate)
+{
+    int i = 0;
+
+    for(i = 0; i < pOrigin->config.numVariants; i++)
+    {
+        if(pOrigin->config.bitrates[i] == bitrate)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Sends all of a buffer.
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t sendAll(int fd, const char* pData, size_t length)
+{
+    ssize_t sent = 0;
+
+    while(length > 0)
+    {
+        sent = send(fd, pData, length, MSG_NOSIGNAL);
+        if(sent < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return HLS_ERROR;
+        }
+        pData += sent;
+        length -= sent;
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Sends a response with no body.
+ */
+static hlsStatus_t sendStatus(benchOrigin_t* pOrigin, int fd, int code, const char* pReason)
+{
+    char header[256];
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    pOrigin->counters.numErrors++;
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n", code, pReason);
+
+    return sendAll(fd, header, strlen(header));
+}
+
+/**
+ * Sends a playlist.
+ */
+static hlsStatus_t sendPlaylist(benchOrigin_t* pOrigin, int fd, const char* pBody, int bLive)
+{
+    hlsStatus_t rval = HLS_OK;
+    char header[256];
+    size_t length = strlen(pBody);
+
+    snprintf(header, sizeof(header),
+             "HTTP/1.1 200 OK\r\nContent-Type: application/vnd.apple.mpegurl\r\nContent-Length: %lu\r\n%sConnection: keep-alive\r\n\r\n",
+             (unsigned long)length, bLive ? "Cache-Control: no-cache\r\n" : "");
+
+    rval = sendAll(fd, header, strlen(header));
+    if(rval == HLS_OK)
+    {
+        rval = sendAll(fd, pBody, length);
+    }
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    pOrigin->counters.numPlaylists++;
+    pOrigin->counters.bytesServed += length;
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    return rval;
+}
+
+/**
+ * Formats the variant playlist, or the media playlist of one
+ * variant.  The caller must free the returned string.
+ *
+ * @param pOrigin - origin
+ * @param bLive - TRUE for the live playlists
+ * @param bitrate - variant to list, or 0 for the variant
+ *                playlist
+ *
+ * @return char* - playlist, or NULL on malloc failure
+ */
+static char* formatPlaylist(benchOrigin_t* pOrigin, int bLive, int bitrate)
+{
+    char* pBody = NULL;
+    size_t size = 0;
+    size_t used = 0;
+    int first = 0;
+    int last = 0;
+    int i = 0;
+
+    size = 256 + (64 * (pOrigin->config.numVariants + pOrigin->config.numSegments + pOrigin->config.liveWindow));
+    pBody = malloc(size);
+    if(pBody == NULL)
+    {
+        return NULL;
+    }
+
+    used = snprintf(pBody, size, "#EXTM3U\n");
+
+    if(bitrate == 0)
+    {
+        for(i = 0; i < pOrigin->config.numVariants; i++)
+        {
+            used += snprintf(pBody + used, size - used, "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%d\n%d/index.m3u8\n",
+                             pOrigin->config.bitrates[i], pOrigin->config.bitrates[i]);
+        }
+        return pBody;
+    }
+
+    if(bLive)
+    {
+        last = liveSegmentsAvailable(pOrigin);
+        first = last - pOrigin->config.liveWindow;
+    }
+    else
+    {
+        first = 0;
+        last = pOrigin->config.numSegments;
+    }
+
+    used += snprintf(pBody + used, size - used, "#EXT-X-VERSION:3\n#EXT-X-TARGETDURATION:%d\n#EXT-X-MEDIA-SEQUENCE:%d\n",
+                     (int)ceil(pOrigin->config.segmentDuration), first);
+
+    for(i = first; i < last; i++)
+    {
+        used += snprintf(pBody + used, size - used, "#EXTINF:%.3f,\n%d.ts\n", pOrigin->config.segmentDuration, i);
+    }
+
+    if(!bLive)
+    {
+        used += snprintf(pBody + used, size - used, "#EXT-X-ENDLIST\n");
+    }
+
+    return pBody;
+}
+
+/**
+ * Sends the requested byte range of a segment.
+ *
+ * @param pOrigin - origin
+ * @param fd - connection
+ * @param bitrate - variant
+ * @param sequence - media sequence number of the segment
+ * @param pRange - value of the Range header, or NULL
+ */
+static hlsStatus_t sendSegment(benchOrigin_t* pOrigin, int fd, int bitrate, int sequence, const char* pRange)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    char header[256];
+    unsigned char packet[TS_PACKET_SIZE];
+    char* pBuffer = NULL;
+    size_t used = 0;
+
+    long numPackets = segmentPackets(pOrigin, bitrate);
+    long long total = (long long)numPackets * TS_PACKET_SIZE;
+    long long start = 0;
+    long long end = total - 1;
+    long long offset = 0;
+    long index = 0;
+    long skip = 0;
+    long count = 0;
+
+    if(pRange != NULL)
+    {
+        if(sscanf(pRange, "bytes=%lld-%lld", &start, &end) < 1)
+        {
+            return sendStatus(pOrigin, fd, 400, "Bad Request");
+        }
+        if(end >= total)
+        {
+            end = total - 1;
+        }
+        if((start < 0) || (start > end))
+        {
+            return sendStatus(pOrigin, fd, 416, "Range Not Satisfiable");
+        }
+
+        snprintf(header, sizeof(header),
+                 "HTTP/1.1 206 Partial Content\r\nContent-Type: video/mp2t\r\nContent-Length: %lld\r\n"
+                 "Content-Range: bytes %lld-%lld/%lld\r\nConnection: keep-alive\r\n\r\n",
+                 end - start + 1, start, end, total);
+    }
+    else
+    {
+        snprintf(header, sizeof(header),
+                 "HTTP/1.1 200 OK\r\nContent-Type: video/mp2t\r\nContent-Length: %lld\r\n"
+                 "Accept-Ranges: bytes\r\nConnection: keep-alive\r\n\r\n",
+                 total);
+    }
+
+    pBuffer = malloc(ORIGIN_SEND_SIZE);
+    if(pBuffer == NULL)
+    {
+        ERROR("malloc error");
+        return HLS_MEMORY_ERROR;
+    }
+
+    do
+    {
+        rval = sendAll(fd, header, strlen(header));
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        offset = start;
+        while(offset <= end)
+        {
+            index = offset / TS_PACKET_SIZE;
+            skip = offset % TS_PACKET_SIZE;
+            count = TS_PACKET_SIZE - skip;
+            if(count > end - offset + 1)
+            {
+                count = end - offset + 1;
+            }
+
+            generatePacket(pOrigin, numPackets, sequence, index, packet);
+
+            if(used + count > ORIGIN_SEND_SIZE)
+            {
+                rval = sendAll(fd, pBuffer, used);
+                if(rval != HLS_OK)
+                {
+                    break;
+                }
+                used = 0;
+            }
+
+            memcpy(pBuffer + used, packet + skip, count);
+            used += count;
+            offset += count;
+        }
+
+        if((rval == HLS_OK) && (used > 0))
+        {
+            rval = sendAll(fd, pBuffer, used);
+        }
+
+    } while(0);
+
+    free(pBuffer);
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    pOrigin->counters.numSegments++;
+    pOrigin->counters.bytesServed += offset - start;
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    return rval;
+}
+
+/**
+ * Serves one request.
+ *
+ * @param pOrigin - origin
+ * @param fd - connection
+ * @param pRequest - NUL terminated request line and headers
+ *
+ * @return #hlsStatus_t - HLS_OK to keep the connection open
+ */
+static hlsStatus_t serveRequest(benchOrigin_t* pOrigin, int fd, char* pRequest)
+{
+    char method[8];
+    char path[256];
+    char kind[8];
+    char* pRange = NULL;
+    char* pLine = NULL;
+    char* pBody = NULL;
+    int bitrate = 0;
+    int sequence = 0;
+    int bLive = 0;
+    int numFields = 0;
+    hlsStatus_t rval = HLS_OK;
+
+    kind[0] = '\0';
+
+    if(sscanf(pRequest, "%7s %255s", method, path) != 2)
+    {
+        sendStatus(pOrigin, fd, 400, "Bad Request");
+        return HLS_ERROR;
+    }
+
+    /* Header names are case insensitive */
+    for(pLine = strchr(pRequest, '\n'); pLine != NULL; pLine = strchr(pLine + 1, '\n'))
+    {
+        if(strncasecmp(pLine + 1, "Range:", 6) == 0)
+        {
+            pRange = pLine + 7;
+            while(*pRange == ' ')
+            {
+                pRange++;
+            }
+        }
+    }
+
+    if(strcmp(method, "GET") != 0)
+    {
+        return sendStatus(pOrigin, fd, 405, "Method Not Allowed");
+    }
+
+    numFields = sscanf(path, "/%7[a-z]/%d/%d.ts", kind, &bitrate, &sequence);
+    bLive = (strcmp(kind, "live") == 0);
+    if((numFields < 1) || (!bLive && (strcmp(kind, "vod") != 0)))
+    {
+        return sendStatus(pOrigin, fd, 404, "Not Found");
+    }
+
+    if((numFields == 1) && (strcmp(path + strlen(kind) + 1, "/master.m3u8") == 0))
+    {
+        bitrate = 0;
+    }
+    else if((numFields == 2) && isVariant(pOrigin, bitrate) && (strstr(path, "/index.m3u8") != NULL))
+    {
+        /* Media playlist */
+    }
+    else if((numFields == 3) && isVariant(pOrigin, bitrate) && (sequence >= 0) &&
+            (sequence < (bLive ? liveSegmentsAvailable(pOrigin) : pOrigin->config.numSegments)))
+    {
+        return sendSegment(pOrigin, fd, bitrate, sequence, pRange);
+    }
+    else
+    {
+        return sendStatus(pOrigin, fd, 404, "Not Found");
+    }
+
+    pBody = formatPlaylist(pOrigin, bLive, bitrate);
+    if(pBody == NULL)
+    {
+        ERROR("malloc error");
+        sendStatus(pOrigin, fd, 500, "Internal Server Error");
+        return HLS_MEMORY_ERROR;
+    }
+
+    rval = sendPlaylist(pOrigin, fd, pBody, bLive);
+
+    free(pBody);
+
+    return rval;
+}
+
+/**
+ * Connection thread: serves requests until the client closes the
+ * connection or the origin is stopped.
+ */
+static void* connectionThread(void* pArg)
+{
+    originConnection_t* pConnection = (originConnection_t*)pArg;
+    benchOrigin_t* pOrigin = pConnection->pOrigin;
+    int fd = pConnection->fd;
+
+    char request[ORIGIN_REQUEST_SIZE];
+    size_t used = 0;
+    ssize_t received = 0;
+    char* pEnd = NULL;
+    size_t length = 0;
+    int bStop = 0;
+
+    free(pConnection);
+
+    while(!bStop)
+    {
+        pthread_mutex_lock(&(pOrigin->mutex));
+        bStop = pOrigin->bStop;
+        pthread_mutex_unlock(&(pOrigin->mutex));
+
+        request[used] = '\0';
+        pEnd = strstr(request, "\r\n\r\n");
+        if(pEnd == NULL)
+        {
+            if(used >= sizeof(request) - 1)
+            {
+                sendStatus(pOrigin, fd, 431, "Request Header Fields Too Large");
+                break;
+            }
+
+            received = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+            if(received == 0)
+            {
+                break;
+            }
+            if(received < 0)
+            {
+                if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+                {
+                    continue;
+                }
+                break;
+            }
+            used += received;
+            continue;
+        }
+
+        /* Serve the request, then keep anything the client sent after it */
+        *pEnd = '\0';
+        length = (pEnd + 4) - request;
+
+        if(serveRequest(pOrigin, fd, request) != HLS_OK)
+        {
+            break;
+        }
+
+        memmove(request, request + length, used - length);
+        used -= length;
+    }
+
+    close(fd);
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    pOrigin->numConnections--;
+    pthread_cond_signal(&(pOrigin->cond));
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    return NULL;
+}
+
+/**
+ * Accept thread: starts a connection thread per client.
+ */
+static void* acceptThread(void* pArg)
+{
+    benchOrigin_t* pOrigin = (benchOrigin_t*)pArg;
+    originConnection_t* pConnection = NULL;
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct timeval timeout;
+    int noDelay = 1;
+    int fd = -1;
+    int bStop = 0;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    timeout.tv_sec = 0;
+    timeout.tv_usec = ORIGIN_POLL_MSECS * 1000;
+
+    while(!bStop)
+    {
+        fd = accept(pOrigin->listenFd, NULL, NULL);
+
+        pthread_mutex_lock(&(pOrigin->mutex));
+        bStop = pOrigin->bStop;
+        pthread_mutex_unlock(&(pOrigin->mutex));
+
+        if(fd < 0)
+        {
+            continue;
+        }
+        if(bStop)
+        {
+            close(fd);
+            break;
+        }
+
+        /* Wake up periodically so idle keep-alive connections notice a stop */
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        /* Headers and bodies go out in separate writes; don't let Nagle hold
+           them for a delayed ACK, which a sped-up clock (-x) would magnify */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        pConnection = malloc(sizeof(originConnection_t));
+        if(pConnection == NULL)
+        {
+            ERROR("malloc error");
+            close(fd);
+            continue;
+        }
+        pConnection->pOrigin = pOrigin;
+        pConnection->fd = fd;
+
+        pthread_mutex_lock(&(pOrigin->mutex));
+        pOrigin->numConnections++;
+        pthread_mutex_unlock(&(pOrigin->mutex));
+
+        if(pthread_create(&thread, &attr, connectionThread, pConnection) != 0)
+        {
+            ERROR("failed to create connection thread");
+            close(fd);
+            free(pConnection);
+
+            pthread_mutex_lock(&(pOrigin->mutex));
+            pOrigin->numConnections--;
+            pthread_mutex_unlock(&(pOrigin->mutex));
+        }
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return NULL;
+}
+
+/**
+ * Starts an origin on an ephemeral port of 127.0.0.1.
+ *
+ * @param pConfig - content to serve
+ * @param ppOrigin - will point to the new origin; stop it with
+ *                 benchOrigin_stop()
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t benchOrigin_start(benchOriginConfig_t* pConfig, benchOrigin_t** ppOrigin)
+{
+    hlsStatus_t rval = HLS_OK;
+    benchOrigin_t* pOrigin = NULL;
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    if((pConfig == NULL) || (ppOrigin == NULL) ||
+       (pConfig->numVariants <= 0) || (pConfig->numVariants > BENCH_ORIGIN_MAX_VARIANTS) ||
+       (pConfig->segmentDuration <= 0) || (pConfig->numSegments <= 0) || (pConfig->liveWindow <= 0))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        pOrigin = calloc(1, sizeof(benchOrigin_t));
+        if(pOrigin == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        pOrigin->config = *pConfig;
+        pthread_mutex_init(&(pOrigin->mutex), NULL);
+        pthread_cond_init(&(pOrigin->cond), NULL);
+        hlsClock_now(&(pOrigin->startTime));
+
+        pOrigin->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if(pOrigin->listenFd < 0)
+        {
+            ERROR("socket() failed -- %s", strerror(errno));
+            rval = HLS_ERROR;
+            break;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        if((bind(pOrigin->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+           (listen(pOrigin->listenFd, 128) != 0) ||
+           (getsockname(pOrigin->listenFd, (struct sockaddr*)&addr, &addrLen) != 0))
+        {
+            ERROR("failed to listen on the loopback interface -- %s", strerror(errno));
+            rval = HLS_ERROR;
+            break;
+        }
+
+        pOrigin->port = ntohs(addr.sin_port);
+
+        if(pthread_create(&(pOrigin->acceptThread), NULL, acceptThread, pOrigin) != 0)
+        {
+            ERROR("failed to create accept thread");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        DEBUG(DBG_INFO, "origin listening on port %d", pOrigin->port);
+
+    } while(0);
+
+    if(rval != HLS_OK)
+    {
+        if(pOrigin != NULL)
+        {
+            if(pOrigin->listenFd > 0)
+            {
+                close(pOrigin->listenFd);
+            }
+            pthread_cond_destroy(&(pOrigin->cond));
+            pthread_mutex_destroy(&(pOrigin->mutex));
+            free(pOrigin);
+        }
+        pOrigin = NULL;
+    }
+
+    *ppOrigin = pOrigin;
+
+    return rval;
+}
+
+/**
+ * Stops an origin, closing all connections, and frees it.
+ *
+ * @param pOrigin - origin started with benchOrigin_start()
+ */
+void benchOrigin_stop(benchOrigin_t* pOrigin)
+{
+    if(pOrigin == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    pOrigin->bStop = 1;
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    /* Unblock accept() */
+    shutdown(pOrigin->listenFd, SHUT_RDWR);
+    pthread_join(pOrigin->acceptThread, NULL);
+    close(pOrigin->listenFd);
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    while(pOrigin->numConnections > 0)
+    {
+        pthread_cond_wait(&(pOrigin->cond), &(pOrigin->mutex));
+    }
+    pthread_mutex_unlock(&(pOrigin->mutex));
+
+    pthread_cond_destroy(&(pOrigin->cond));
+    pthread_mutex_destroy(&(pOrigin->mutex));
+    free(pOrigin);
+}
+
+/**
+ * Returns the port an origin is listening on.
+ */
+int benchOrigin_getPort(benchOrigin_t* pOrigin)
+{
+    return (pOrigin != NULL) ? pOrigin->port : 0;
+}
+
+/**
+ * Returns the requests an origin has served so far.
+ *
+ * @param pOrigin - origin
+ * @param pCounters - will receive the counters
+ */
+void benchOrigin_getCounters(benchOrigin_t* pOrigin, benchOriginCounters_t* pCounters)
+{
+    if((pOrigin == NULL) || (pCounters == NULL))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pOrigin->mutex));
+    *pCounters = pOrigin->counters;
+    pthread_mutex_unlock(&(pOrigin->mutex));
+}
+
+#ifdef __cplusplus
+}
+#endif
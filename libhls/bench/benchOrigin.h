@@ -0,0 +1,87 @@
+#ifndef BENCHORIGIN_H
+#define BENCHORIGIN_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file benchOrigin.h @date October 19, 2026
+ *
+ * Embedded HTTP origin used by the benchmarks.
+ *
+ * Serves synthetic content from 127.0.0.1 on an ephemeral port:
+ *
+ *   /vod/master.m3u8 and /live/master.m3u8 -- variant playlists
+ *   /{vod,live}/<bitrate>/index.m3u8       -- media playlists
+ *   /{vod,live}/<bitrate>/<sequence>.ts    -- MPEG-TS segments
+ *
+ * Segments are sized to match their variant bitrate and carry a PES
+ * header with a PTS every BENCH_ORIGIN_PES_INTERVAL_MS of media, so a
+ * player can tell how much media it has been given.  The live
+ * playlists slide forward in real time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+#define BENCH_ORIGIN_MAX_VARIANTS 8         /*!< Maximum number of variants served */
+#define BENCH_ORIGIN_PES_INTERVAL_MS 100    /*!< Media time between PES headers in a segment */
+#define BENCH_ORIGIN_VIDEO_PID 0x100        /*!< PID carrying the PES stream */
+#define BENCH_ORIGIN_PTS_BASE 90000ll       /*!< PTS of the first segment */
+
+/*! \struct benchOriginConfig_t
+ * Content served by the origin
+ */
+typedef struct {
+    int numVariants;                            /*!< Number of entries in bitrates */
+    int bitrates[BENCH_ORIGIN_MAX_VARIANTS];    /*!< Variant bitrates, in bps */
+    float segmentDuration;                      /*!< Duration of every segment, in seconds */
+    int numSegments;                            /*!< Number of segments in the VOD playlists */
+    int liveWindow;                             /*!< Number of segments in the live playlists */
+} benchOriginConfig_t;
+
+/*! \struct benchOriginCounters_t
+ * Requests served by the origin
+ */
+typedef struct {
+    unsigned int numPlaylists;      /*!< Playlist requests served */
+    unsigned int numSegments;       /*!< Segment requests served */
+    unsigned int numErrors;         /*!< Requests answered with an error */
+    unsigned long long bytesServed; /*!< Response body bytes sent */
+} benchOriginCounters_t;
+
+typedef struct benchOrigin_t_ benchOrigin_t;
+
+hlsStatus_t benchOrigin_start(benchOriginConfig_t* pConfig, benchOrigin_t** ppOrigin);
+void benchOrigin_stop(benchOrigin_t* pOrigin);
+
+int benchOrigin_getPort(benchOrigin_t* pOrigin);
+void benchOrigin_getCounters(benchOrigin_t* pOrigin, benchOriginCounters_t* pCounters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,836 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file benchPlayer.c @date October 19, 2026
+ *
+ * Stub srcPlayerFunc_t implementation for the benchmarks.
+ *
+ * The TS packets handed over by the plugin are scanned for PES
+ * headers to learn how much media has been delivered.  A single clock
+ * thread advances the play position of every paced player and reports
+ * it to the plugin, so that the number of threads does not grow with
+ * the number of sessions being benchmarked.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "benchPlayer.h"
+
+#include "hlsClock.h"
+
+#include "debug.h"
+
+#define TS_PACKET_SIZE 188
+
+struct benchPlayer_t_ {
+    pthread_mutex_t mutex;              /*!< Protects the fields below */
+    pthread_cond_t cond;                /*!< Signalled on the first buffer and on EOF */
+    int bPaced;                         /*!< TRUE to play media out in real time */
+    srcPlayerMode_t mode;               /*!< Mode set by the plugin */
+    playerEvtCallback_t evtCallback;    /*!< Plugin callback registered with registerCB() */
+    srcSessionId_t sessionId;           /*!< Session to report to; NULL while detached */
+    unsigned char carry[TS_PACKET_SIZE];/*!< Partial TS packet left over from the last buffer */
+    int carryLength;                    /*!< Bytes in carry */
+    int bHavePts;                       /*!< TRUE once a PTS was seen since the last flush */
+    long long firstPts;                 /*!< First PTS seen since the last flush */
+    long long maxPts;                   /*!< Largest PTS seen since the last flush */
+    long long playPts;                  /*!< Current play position */
+    int bClockRunning;                  /*!< TRUE while playPts is advancing */
+    int bStalled;                       /*!< TRUE while playPts is held back by maxPts */
+    double lastTick;                    /*!< benchPlayer_now() of the last clock tick */
+    benchPlayerCounters_t counters;     /*!< Exported counters */
+    struct benchPlayer_t_* pNext;       /*!< Next player in the clock list */
+};
+
+/*! Players driven by the clock thread */
+static pthread_mutex_t clockMutex = PTHREAD_MUTEX_INITIALIZER;
+static benchPlayer_t* pClockPlayers = NULL;
+static pthread_t clockThread;
+static int bClockStop = 0;
+
+/**
+ * Returns the library clock (hlsClock_now()) time in seconds.
+ */
+double benchPlayer_now(void)
+{
+    struct timespec now;
+
+    hlsClock_now(&now);
+
+    return now.tv_sec + (now.tv_nsec / 1000000000.0);
+}
+
+/**
+ * Picks the PTS out of a TS packet that starts a PES packet.
+ * Assumes pPlayer->mutex is held.
+ */
+static void scanPacket(benchPlayer_t* pPlayer, const unsigned char* pPacket)
+{
+    int offset = 4;
+    long long pts = 0;
+
+    /* Only interested in payload units that start here */
+    if(!(pPacket[1] & 0x40) || !(pPacket[3] & 0x10))
+    {
+        return;
+    }
+
+    if(pPacket[3] & 0x20)
+    {
+        offset += 1 + pPacket[4];
+    }
+
+    if((offset + 14 > TS_PACKET_SIZE) ||
+       (pPacket[offset] != 0x00) || (pPacket[offset + 1] != 0x00) || (pPacket[offset + 2] != 0x01) ||
+       !(pPacket[offset + 7] & 0x80))
+    {
+        return;
+    }
+
+    pts = (((long long)(pPacket[offset + 9] & 0x0E)) << 29) |
+          (((long long)pPacket[offset + 10]) << 22) |
+          (((long long)(pPacket[offset + 11] & 0xFE)) << 14) |
+          (((long long)pPacket[offset + 12]) << 7) |
+          (((long long)pPacket[offset + 13]) >> 1);
+
+    if(!(pPlayer->bHavePts))
+    {
+        pPlayer->bHavePts = 1;
+        pPlayer->firstPts = pts;
+        pPlayer->maxPts = pts;
+        pPlayer->playPts = pts;
+    }
+    else if(pts > pPlayer->maxPts)
+    {
+        pPlayer->maxPts = pts;
+    }
+}
+
+/**
+ * Scans a buffer of TS packets, carrying partial packets over to
+ * the next buffer.  Assumes pPlayer->mutex is held.
+ */
+static void scanBuffer(benchPlayer_t* pPlayer, const unsigned char* pData, int size)
+{
+    int i = 0;
+    int count = 0;
+
+    if(pPlayer->carryLength > 0)
+    {
+        count = TS_PACKET_SIZE - pPlayer->carryLength;
+        if(count > size)
+        {
+            count = size;
+        }
+        memcpy(pPlayer->carry + pPlayer->carryLength, pData, count);
+        pPlayer->carryLength += count;
+        i = count;
+
+        if(pPlayer->carryLength < TS_PACKET_SIZE)
+        {
+            return;
+        }
+
+        if(pPlayer->carry[0] == 0x47)
+        {
+            scanPacket(pPlayer, pPlayer->carry);
+        }
+        pPlayer->carryLength = 0;
+    }
+
+    while(i + TS_PACKET_SIZE <= size)
+    {
+        if(pData[i] != 0x47)
+        {
+            /* Lost sync -- look for the next sync byte */
+            i++;
+            continue;
+        }
+        scanPacket(pPlayer, pData + i);
+        i += TS_PACKET_SIZE;
+    }
+
+    if(i < size)
+    {
+        memcpy(pPlayer->carry, pData + i, size - i);
+        pPlayer->carryLength = size - i;
+    }
+}
+
+/**
+ * Advances the play position of one player.  Assumes
+ * pPlayer->mutex is held.
+ *
+ * @return int - TRUE if the position should be reported
+ */
+static int tickPlayer(benchPlayer_t* pPlayer, double now)
+{
+    long long pts = 0;
+    double elapsed = now - pPlayer->lastTick;
+    int bReport = 0;
+
+    pPlayer->lastTick = now;
+
+    if(!(pPlayer->bHavePts))
+    {
+        return 0;
+    }
+
+    if(!(pPlayer->bPaced))
+    {
+        /* Everything is "played" as soon as it arrives */
+        pPlayer->counters.playTime += (pPlayer->maxPts - pPlayer->playPts) / 90000.0;
+        pPlayer->playPts = pPlayer->maxPts;
+        return 1;
+    }
+
+    if(pPlayer->mode != SRC_PLAYER_MODE_NORMAL)
+    {
+        pPlayer->bClockRunning = 0;
+        return 0;
+    }
+
+    if(!(pPlayer->bClockRunning))
+    {
+        pPlayer->bClockRunning = 1;
+        return 1;
+    }
+
+    pts = pPlayer->playPts + (long long)(elapsed * 90000);
+    if(pts > pPlayer->maxPts)
+    {
+        /* Ran dry -- running out at EOF is the end of the content */
+        if(!(pPlayer->counters.bEOF))
+        {
+            if(!(pPlayer->bStalled))
+            {
+                pPlayer->counters.numStalls++;
+                pPlayer->bStalled = 1;
+            }
+            pPlayer->counters.stallTime += (pts - pPlayer->maxPts) / 90000.0;
+        }
+        pts = pPlayer->maxPts;
+    }
+    else
+    {
+        pPlayer->bStalled = 0;
+    }
+
+    if(pts != pPlayer->playPts)
+    {
+        pPlayer->counters.playTime += (pts - pPlayer->playPts) / 90000.0;
+        pPlayer->playPts = pts;
+        bReport = 1;
+    }
+
+    return bReport;
+}
+
+/**
+ * Clock thread: advances every player and reports the new
+ * positions to the plugin.
+ */
+static void* clockThreadFunc(void* pArg)
+{
+    benchPlayer_t* pPlayer = NULL;
+    srcPlayerEvt_t event;
+    long long pts = 0;
+    int bReport = 0;
+    struct timespec delay;
+
+    (void)pArg;
+
+    delay.tv_sec = 0;
+    delay.tv_nsec = BENCH_PLAYER_TICK_MSECS * 1000000;
+
+    pthread_mutex_lock(&clockMutex);
+
+    while(!bClockStop)
+    {
+        /* The callbacks are made with clockMutex held, so that once
+           benchPlayer_detach() returns no more are in flight */
+        for(pPlayer = pClockPlayers; pPlayer != NULL; pPlayer = pPlayer->pNext)
+        {
+            pthread_mutex_lock(&(pPlayer->mutex));
+            bReport = tickPlayer(pPlayer, benchPlayer_now()) &&
+                      (pPlayer->sessionId != NULL) && (pPlayer->evtCallback != NULL);
+            pts = pPlayer->playPts;
+            pthread_mutex_unlock(&(pPlayer->mutex));
+
+            if(bReport)
+            {
+                event.evtCode = SRC_PLAYER_LAST_PTS;
+                event.pData = &pts;
+                pPlayer->evtCallback(pPlayer->sessionId, &event);
+            }
+        }
+
+        pthread_mutex_unlock(&clockMutex);
+        nanosleep(&delay, NULL);
+        pthread_mutex_lock(&clockMutex);
+    }
+
+    pthread_mutex_unlock(&clockMutex);
+
+    return NULL;
+}
+
+static srcStatus_t playerRegisterCB(void* pHandle, playerEvtCallback_t evtCb)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    if(pPlayer == NULL)
+    {
+        return SRC_ERROR;
+    }
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+    pPlayer->evtCallback = evtCb;
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return SRC_SUCCESS;
+}
+
+/**
+ * Returns TRUE if a paced player is far enough ahead of its play
+ * position that it should not take more media.
+ */
+static int isFull(benchPlayer_t* pPlayer)
+{
+    int bFull = 0;
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+    bFull = pPlayer->bPaced && pPlayer->bHavePts &&
+            ((pPlayer->maxPts - pPlayer->playPts) > (BENCH_PLAYER_MAX_AHEAD_SECS * 90000ll));
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return bFull;
+}
+
+/**
+ * Takes in size bytes of media handed over by the plugin.
+ */
+static void consumeBuffer(benchPlayer_t* pPlayer, const char* pBuffer, int size)
+{
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    scanBuffer(pPlayer, (const unsigned char*)pBuffer, size);
+
+    pPlayer->counters.bytes += size;
+    pPlayer->counters.numBuffers++;
+    if(pPlayer->counters.firstBufferTime == 0)
+    {
+        pPlayer->counters.firstBufferTime = benchPlayer_now();
+        pthread_cond_broadcast(&(pPlayer->cond));
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+}
+
+static srcStatus_t playerGetBuffer(void* pHandle, char** ppBuffer, int* pSize, void** ppPrivate)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+    int bFull = 0;
+
+    if((pPlayer == NULL) || (ppBuffer == NULL) || (pSize == NULL))
+    {
+        return SRC_ERROR;
+    }
+
+    bFull = isFull(pPlayer);
+
+    *ppBuffer = NULL;
+    *pSize = 0;
+    if(ppPrivate != NULL)
+    {
+        *ppPrivate = NULL;
+    }
+
+    if(!bFull)
+    {
+        *ppBuffer = malloc(BENCH_PLAYER_BUFFER_SIZE);
+        if(*ppBuffer == NULL)
+        {
+            ERROR("malloc error");
+            return SRC_ERROR;
+        }
+        *pSize = BENCH_PLAYER_BUFFER_SIZE;
+    }
+
+    return SRC_SUCCESS;
+}
+
+static srcStatus_t playerSendBuffer(void* pHandle, char* pBuffer, int size, srcBufferMetadata_t* pMetadata, void* pPrivate)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    (void)pMetadata;
+    (void)pPrivate;
+
+    if(pPlayer == NULL)
+    {
+        free(pBuffer);
+        return SRC_ERROR;
+    }
+
+    if((pBuffer != NULL) && (size > 0))
+    {
+        consumeBuffer(pPlayer, pBuffer, size);
+    }
+
+    free(pBuffer);
+
+    return SRC_SUCCESS;
+}
+
+/**
+ * #srcPlayerLendBuffer_t of the stub players, registered on a
+ * session with SRC_PLUGIN_SET_LEND_BUFFER to take the plugin's own
+ * buffers instead of copying into ours.
+ */
+srcStatus_t benchPlayer_lendBuffer(void* pHandle, char* pBuffer, int* pSize, srcBufferMetadata_t* pMetadata,
+                                   srcBufferRelease_t release, void* pReleaseData)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    (void)pMetadata;
+
+    if((pPlayer == NULL) || (pSize == NULL))
+    {
+        release(pReleaseData);
+        return SRC_ERROR;
+    }
+
+    if(isFull(pPlayer))
+    {
+        *pSize = 0;
+        return SRC_SUCCESS;
+    }
+
+    if((pBuffer != NULL) && (*pSize > 0))
+    {
+        consumeBuffer(pPlayer, pBuffer, *pSize);
+    }
+
+    release(pReleaseData);
+
+    return SRC_SUCCESS;
+}
+
+static srcStatus_t playerSet(void* pHandle, srcPlayerSetData_t* pSetData)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    if((pPlayer == NULL) || (pSetData == NULL))
+    {
+        return SRC_ERROR;
+    }
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    switch(pSetData->setCode)
+    {
+        case SRC_PLAYER_SET_BUFFER_FLUSH:
+            pPlayer->counters.numFlushes++;
+            pPlayer->counters.firstBufferTime = 0;
+            pPlayer->counters.bEOF = 0;
+            pPlayer->carryLength = 0;
+            pPlayer->bHavePts = 0;
+            pPlayer->bClockRunning = 0;
+            pPlayer->bStalled = 0;
+            break;
+        case SRC_PLAYER_SET_MODE:
+            if(pSetData->pData != NULL)
+            {
+                pPlayer->mode = *((srcPlayerMode_t*)(pSetData->pData));
+            }
+            break;
+        default:
+            break;
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return SRC_SUCCESS;
+}
+
+static srcStatus_t playerGet(void* pHandle, srcPlayerGetData_t* pGetData)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+    srcStatus_t rval = SRC_SUCCESS;
+
+    if((pPlayer == NULL) || (pGetData == NULL) || (pGetData->pData == NULL))
+    {
+        return SRC_ERROR;
+    }
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    switch(pGetData->getCode)
+    {
+        case SRC_PLAYER_GET_FIFO_DATA:
+            ((fifoData_t*)(pGetData->pData))->fifoSize = 1;
+            ((fifoData_t*)(pGetData->pData))->fifoDepth = 0;
+            break;
+        case SRC_PLAYER_GET_LAST_PTS:
+            *((uint64_t*)(pGetData->pData)) = pPlayer->playPts;
+            break;
+        case SRC_PLAYER_GET_POSITION:
+            *((int*)(pGetData->pData)) = (int)(pPlayer->counters.playTime * 1000);
+            break;
+        default:
+            rval = SRC_ERROR;
+            break;
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return rval;
+}
+
+/**
+ * Fills in a player function table backed by the stub players.
+ * Every session must be opened with a #benchPlayer_t as its
+ * player handle.
+ *
+ * @param pTable - table to fill in
+ */
+void benchPlayer_getFuncTable(srcPlayerFunc_t* pTable)
+{
+    memset(pTable, 0, sizeof(srcPlayerFunc_t));
+
+    pTable->registerCB = playerRegisterCB;
+    pTable->getBuffer = playerGetBuffer;
+    pTable->sendBuffer = playerSendBuffer;
+    pTable->set = playerSet;
+    pTable->get = playerGet;
+}
+
+/**
+ * Plugin event callback to register with the plugin; pHandle is
+ * the #benchPlayer_t the session was opened with.
+ */
+void benchPlayer_pluginEvtCallback(void* pHandle, srcPluginEvt_t* pEvt)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    if((pPlayer == NULL) || (pEvt == NULL))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    switch(pEvt->eventCode)
+    {
+        case SRC_PLUGIN_SWITCHED_BITRATE:
+            pPlayer->counters.numBitrateSwitches++;
+            if(pEvt->pData != NULL)
+            {
+                pPlayer->counters.currentBitrate = *((int*)(pEvt->pData));
+            }
+            break;
+        case SRC_PLUGIN_EOF:
+        case SRC_PLUGIN_EOS:
+            pPlayer->counters.bEOF = 1;
+            pthread_cond_broadcast(&(pPlayer->cond));
+            break;
+        default:
+            break;
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+}
+
+/**
+ * Plugin error callback to register with the plugin.
+ */
+void benchPlayer_pluginErrCallback(void* pHandle, srcPluginErr_t* pErr)
+{
+    benchPlayer_t* pPlayer = (benchPlayer_t*)pHandle;
+
+    if(pPlayer == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+    pPlayer->counters.numErrors++;
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    if(pErr != NULL)
+    {
+        DEBUG(DBG_WARN, "player %p got plugin error %d: %s", pPlayer, pErr->errCode, pErr->errMsg);
+    }
+}
+
+/**
+ * Creates a stub player and adds it to the clock.
+ *
+ * @param bPaced - TRUE to play media out in real time, FALSE to
+ *               consume it as fast as the plugin delivers it
+ * @param ppPlayer - will point to the new player
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t benchPlayer_create(int bPaced, benchPlayer_t** ppPlayer)
+{
+    hlsStatus_t rval = HLS_OK;
+    benchPlayer_t* pPlayer = NULL;
+    pthread_condattr_t condAttr;
+
+    if(ppPlayer == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        pPlayer = calloc(1, sizeof(benchPlayer_t));
+        if(pPlayer == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        pPlayer->bPaced = bPaced;
+        pPlayer->mode = SRC_PLAYER_MODE_NORMAL;
+        pPlayer->lastTick = benchPlayer_now();
+
+        pthread_mutex_init(&(pPlayer->mutex), NULL);
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+        pthread_cond_init(&(pPlayer->cond), &condAttr);
+        pthread_condattr_destroy(&condAttr);
+
+        pthread_mutex_lock(&clockMutex);
+
+        /* The first player starts the clock */
+        if(pClockPlayers == NULL)
+        {
+            bClockStop = 0;
+            if(pthread_create(&clockThread, NULL, clockThreadFunc, NULL) != 0)
+            {
+                pthread_mutex_unlock(&clockMutex);
+                ERROR("failed to create clock thread");
+                rval = HLS_ERROR;
+                break;
+            }
+        }
+
+        pPlayer->pNext = pClockPlayers;
+        pClockPlayers = pPlayer;
+
+        pthread_mutex_unlock(&clockMutex);
+
+    } while(0);
+
+    if(rval != HLS_OK)
+    {
+        if(pPlayer != NULL)
+        {
+            pthread_cond_destroy(&(pPlayer->cond));
+            pthread_mutex_destroy(&(pPlayer->mutex));
+            free(pPlayer);
+        }
+        pPlayer = NULL;
+    }
+
+    *ppPlayer = pPlayer;
+
+    return rval;
+}
+
+/**
+ * Removes a player from the clock and frees it.  The session it
+ * was opened with must already be closed.
+ */
+void benchPlayer_destroy(benchPlayer_t* pPlayer)
+{
+    benchPlayer_t** ppNode = NULL;
+    int bStopClock = 0;
+
+    if(pPlayer == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&clockMutex);
+
+    for(ppNode = &pClockPlayers; *ppNode != NULL; ppNode = &((*ppNode)->pNext))
+    {
+        if(*ppNode == pPlayer)
+        {
+            *ppNode = pPlayer->pNext;
+            break;
+        }
+    }
+
+    /* The last player stops the clock */
+    if(pClockPlayers == NULL)
+    {
+        bClockStop = 1;
+        bStopClock = 1;
+    }
+
+    pthread_mutex_unlock(&clockMutex);
+
+    if(bStopClock)
+    {
+        pthread_join(clockThread, NULL);
+    }
+
+    pthread_cond_destroy(&(pPlayer->cond));
+    pthread_mutex_destroy(&(pPlayer->mutex));
+    free(pPlayer);
+}
+
+/**
+ * Starts reporting the play position to a session.
+ *
+ * @param pPlayer - player the session was opened with
+ * @param sessionId - session returned by the plugin's open()
+ */
+void benchPlayer_attach(benchPlayer_t* pPlayer, srcSessionId_t sessionId)
+{
+    pthread_mutex_lock(&clockMutex);
+    pthread_mutex_lock(&(pPlayer->mutex));
+    pPlayer->sessionId = sessionId;
+    pthread_mutex_unlock(&(pPlayer->mutex));
+    pthread_mutex_unlock(&clockMutex);
+}
+
+/**
+ * Stops reporting the play position.  Once this returns no more
+ * callbacks are made, so the session can be closed.
+ */
+void benchPlayer_detach(benchPlayer_t* pPlayer)
+{
+    benchPlayer_attach(pPlayer, NULL);
+}
+
+/**
+ * Returns what a player has seen so far.
+ */
+void benchPlayer_getCounters(benchPlayer_t* pPlayer, benchPlayerCounters_t* pCounters)
+{
+    pthread_mutex_lock(&(pPlayer->mutex));
+    *pCounters = pPlayer->counters;
+    pCounters->bufferAhead = pPlayer->bHavePts ? ((pPlayer->maxPts - pPlayer->playPts) / 90000.0) : 0;
+    pthread_mutex_unlock(&(pPlayer->mutex));
+}
+
+/**
+ * Computes the absolute hlsClock_now() deadline timeoutMsecs
+ * from now.
+ */
+static void deadline(struct timespec* pDeadline, int timeoutMsecs)
+{
+    hlsClock_now(pDeadline);
+
+    pDeadline->tv_sec += timeoutMsecs / 1000;
+    pDeadline->tv_nsec += (timeoutMsecs % 1000) * 1000000l;
+    if(pDeadline->tv_nsec >= 1000000000l)
+    {
+        pDeadline->tv_sec++;
+        pDeadline->tv_nsec -= 1000000000l;
+    }
+}
+
+/**
+ * Waits for the first buffer since the player was created or
+ * last flushed.
+ *
+ * @param pPlayer - player
+ * @param timeoutMsecs - how long to wait
+ * @param pTime - will receive the benchPlayer_now() time at
+ *              which the buffer arrived
+ *
+ * @return #hlsStatus_t - HLS_ERROR if no buffer arrived in time
+ */
+hlsStatus_t benchPlayer_waitFirstBuffer(benchPlayer_t* pPlayer, int timeoutMsecs, double* pTime)
+{
+    hlsStatus_t rval = HLS_OK;
+    struct timespec wakeTime;
+
+    deadline(&wakeTime, timeoutMsecs);
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    while((pPlayer->counters.firstBufferTime == 0) && (rval == HLS_OK))
+    {
+        if(hlsClock_timedWait(&(pPlayer->cond), &(pPlayer->mutex), &wakeTime) != 0)
+        {
+            rval = (pPlayer->counters.firstBufferTime == 0) ? HLS_ERROR : HLS_OK;
+        }
+    }
+
+    if(pTime != NULL)
+    {
+        *pTime = pPlayer->counters.firstBufferTime;
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return rval;
+}
+
+/**
+ * Waits for the plugin to signal the end of the content.
+ *
+ * @return #hlsStatus_t - HLS_ERROR if it did not in time
+ */
+hlsStatus_t benchPlayer_waitEOF(benchPlayer_t* pPlayer, int timeoutMsecs)
+{
+    hlsStatus_t rval = HLS_OK;
+    struct timespec wakeTime;
+
+    deadline(&wakeTime, timeoutMsecs);
+
+    pthread_mutex_lock(&(pPlayer->mutex));
+
+    while(!(pPlayer->counters.bEOF) && (rval == HLS_OK))
+    {
+        if(hlsClock_timedWait(&(pPlayer->cond), &(pPlayer->mutex), &wakeTime) != 0)
+        {
+            rval = pPlayer->counters.bEOF ? HLS_OK : HLS_ERROR;
+        }
+    }
+
+    pthread_mutex_unlock(&(pPlayer->mutex));
+
+    return rval;
+}
+
+#ifdef __cplusplus
+}
+#endif
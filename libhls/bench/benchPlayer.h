@@ -0,0 +1,92 @@
+#ifndef BENCHPLAYER_H
+#define BENCHPLAYER_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file benchPlayer.h @date October 19, 2026
+ *
+ * Stub player used by the benchmarks.
+ *
+ * Implements srcPlayerFunc_t by consuming buffers and reading the PTS
+ * values out of the TS packets it is given.  A paced player plays that
+ * media out in real time and reports its play position back to the
+ * plugin as SRC_PLAYER_LAST_PTS events, withholding buffers once it is
+ * BENCH_PLAYER_MAX_AHEAD_SECS ahead, the same back-pressure a real
+ * decoder applies.  An unpaced player consumes everything immediately.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+#include "sourcePlugin.h"
+
+#define BENCH_PLAYER_BUFFER_SIZE (64*1024)  /*!< Size of the buffers handed to the plugin */
+#define BENCH_PLAYER_MAX_AHEAD_SECS 30      /*!< Media a paced player will accept ahead of its play position */
+#define BENCH_PLAYER_TICK_MSECS 20          /*!< Period of the play clock */
+
+/*! \struct benchPlayerCounters_t
+ * What a stub player has seen so far
+ */
+typedef struct {
+    unsigned long long bytes;           /*!< Bytes received */
+    unsigned int numBuffers;            /*!< Non-empty buffers received */
+    unsigned int numFlushes;            /*!< SRC_PLAYER_SET_BUFFER_FLUSH requests */
+    unsigned int numStalls;             /*!< Times a paced player ran out of media before EOF */
+    double stallTime;                   /*!< Time spent stalled, in seconds */
+    double playTime;                    /*!< Media played out, in seconds */
+    double bufferAhead;                 /*!< Media received but not played yet, in seconds */
+    unsigned int numBitrateSwitches;    /*!< SRC_PLUGIN_SWITCHED_BITRATE events */
+    int currentBitrate;                 /*!< Bitrate of the last SRC_PLUGIN_SWITCHED_BITRATE event */
+    unsigned int numErrors;             /*!< Asynchronous plugin errors */
+    int bEOF;                           /*!< TRUE once SRC_PLUGIN_EOF or SRC_PLUGIN_EOS arrived */
+    double firstBufferTime;             /*!< benchPlayer_now() of the first buffer since creation or the last flush; 0 if none */
+} benchPlayerCounters_t;
+
+typedef struct benchPlayer_t_ benchPlayer_t;
+
+double benchPlayer_now(void);
+
+void benchPlayer_getFuncTable(srcPlayerFunc_t* pTable);
+srcStatus_t benchPlayer_lendBuffer(void* pHandle, char* pBuffer, int* pSize, srcBufferMetadata_t* pMetadata,
+                                   srcBufferRelease_t release, void* pReleaseData);
+void benchPlayer_pluginEvtCallback(void* pHandle, srcPluginEvt_t* pEvt);
+void benchPlayer_pluginErrCallback(void* pHandle, srcPluginErr_t* pErr);
+
+hlsStatus_t benchPlayer_create(int bPaced, benchPlayer_t** ppPlayer);
+void benchPlayer_destroy(benchPlayer_t* pPlayer);
+
+void benchPlayer_attach(benchPlayer_t* pPlayer, srcSessionId_t sessionId);
+void benchPlayer_detach(benchPlayer_t* pPlayer);
+
+void benchPlayer_getCounters(benchPlayer_t* pPlayer, benchPlayerCounters_t* pCounters);
+hlsStatus_t benchPlayer_waitFirstBuffer(benchPlayer_t* pPlayer, int timeoutMsecs, double* pTime);
+hlsStatus_t benchPlayer_waitEOF(benchPlayer_t* pPlayer, int timeoutMsecs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1183 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file benchShaper.c @date October 19, 2026
+ *
+ * Network shaping HTTP proxy for reproducible ABR, retry and stall
+ * tests (see benchShaper.h for the scenario file format).
+ *
+ * Each client connection gets its own thread.  Requests are read off
+ * it one at a time; a request matching an error rule is answered
+ * directly, anything else is forwarded over a new upstream connection
+ * after the scenario RTT and the response is relayed back in chunks
+ * paced by the shared link.  Keep-alive is preserved towards the
+ * client as long as the upstream response has a Content-Length.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fnmatch.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "benchShaper.h"
+
+#include "hlsClock.h"
+
+#include "debug.h"
+
+/* Size of the buffers requests and response headers are read into */
+#define SHAPER_HEADER_SIZE 4096
+
+/* Size of the chunks response bodies are paced and relayed in */
+#define SHAPER_CHUNK_SIZE (16*1024)
+
+/* How often idle connections check whether the proxy is stopping */
+#define SHAPER_POLL_MSECS 200
+
+/* Longest line in a scenario file */
+#define SHAPER_LINE_SIZE 512
+
+struct benchShaper_t_ {
+    benchShaperScenario_t scenario;         /*!< What to do */
+    int upstreamPort;                       /*!< Port of the origin on 127.0.0.1 */
+    int listenFd;                           /*!< Listening socket */
+    int port;                               /*!< Port listenFd is bound to */
+    pthread_t acceptThread;                 /*!< Thread accepting connections */
+    pthread_mutex_t mutex;                  /*!< Protects the fields below */
+    pthread_cond_t cond;                    /*!< Signalled when a connection thread exits */
+    int numConnections;                     /*!< Number of live connection threads */
+    int bStop;                              /*!< Set when the proxy is being stopped */
+    struct timespec startTime;              /*!< Time 0 of the scenario */
+    double linkFree;                        /*!< Scenario time at which the link is next idle */
+    int ruleCount[BENCH_SHAPER_MAX_RULES];  /*!< Times each rule has been applied */
+    benchShaperCounters_t counters;         /*!< What we've done so far */
+};
+
+/*! Argument of a connection thread */
+typedef struct {
+    benchShaper_t* pShaper;
+    int fd;
+} shaperConnection_t;
+
+/*! Faults picked for one request */
+typedef struct {
+    benchShaperRule_t* pError;
+    benchShaperRule_t* pReset;
+    benchShaperRule_t* pStall;
+} shaperFaults_t;
+
+/*
+ * Scenario files
+ */
+
+static hlsStatus_t parseRuleOptions(char* pSave, benchShaperRule_t* pRule)
+{
+    char* pToken = NULL;
+    char* pValue = NULL;
+
+    while((pToken = strtok_r(NULL, " \t\r\n", &pSave)) != NULL)
+    {
+        pValue = strtok_r(NULL, " \t\r\n", &pSave);
+        if(pValue == NULL)
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+
+        if(strcmp(pToken, "count") == 0)
+        {
+            pRule->maxCount = atoi(pValue);
+        }
+        else if(strcmp(pToken, "from") == 0)
+        {
+            pRule->fromTime = atof(pValue);
+        }
+        else if(strcmp(pToken, "until") == 0)
+        {
+            pRule->untilTime = atof(pValue);
+        }
+        else
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Parses one non-empty, non-comment scenario line.
+ */
+static hlsStatus_t parseScenarioLine(char* pLine, benchShaperScenario_t* pScenario)
+{
+    benchShaperRule_t* pRule = NULL;
+    benchShaperExpect_t* pExpect = NULL;
+    char* pSave = NULL;
+    char* pKeyword = NULL;
+    char* pArgs[3] = { NULL, NULL, NULL };
+    int numArgs = 0;
+    int numRequired = 0;
+    int i = 0;
+
+    pKeyword = strtok_r(pLine, " \t\r\n", &pSave);
+
+    if((strcmp(pKeyword, "bandwidth") == 0) || (strcmp(pKeyword, "expect") == 0))
+    {
+        numRequired = (pKeyword[0] == 'b') ? 2 : 3;
+    }
+    else if((strcmp(pKeyword, "error") == 0) || (strcmp(pKeyword, "reset") == 0))
+    {
+        numRequired = 2;
+    }
+    else if(strcmp(pKeyword, "stall") == 0)
+    {
+        numRequired = 3;
+    }
+    else if((strcmp(pKeyword, "loop") == 0) || (strcmp(pKeyword, "rtt") == 0) ||
+            (strcmp(pKeyword, "content") == 0) || (strcmp(pKeyword, "duration") == 0) ||
+            (strcmp(pKeyword, "speed") == 0))
+    {
+        numRequired = 1;
+    }
+    else
+    {
+        return HLS_INVALID_PARAMETER;
+    }
+
+    for(numArgs = 0; numArgs < numRequired; numArgs++)
+    {
+        pArgs[numArgs] = strtok_r(NULL, " \t\r\n", &pSave);
+        if(pArgs[numArgs] == NULL)
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+    }
+
+    if(strcmp(pKeyword, "bandwidth") == 0)
+    {
+        if((pScenario->numSteps >= BENCH_SHAPER_MAX_STEPS) || (atof(pArgs[0]) < 0) || (atof(pArgs[1]) < 0))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+
+        /* Keep the schedule sorted */
+        for(i = pScenario->numSteps; (i > 0) && (pScenario->steps[i - 1].startTime > atof(pArgs[0])); i--)
+        {
+            pScenario->steps[i] = pScenario->steps[i - 1];
+        }
+        pScenario->steps[i].startTime = atof(pArgs[0]);
+        pScenario->steps[i].rate = (int)(atof(pArgs[1]) * 1000);
+        pScenario->numSteps++;
+    }
+    else if(strcmp(pKeyword, "loop") == 0)
+    {
+        pScenario->loopTime = atof(pArgs[0]);
+    }
+    else if(strcmp(pKeyword, "rtt") == 0)
+    {
+        pScenario->rttMsecs = atoi(pArgs[0]);
+    }
+    else if(strcmp(pKeyword, "content") == 0)
+    {
+        if((strcmp(pArgs[0], "vod") != 0) && (strcmp(pArgs[0], "live") != 0))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+        pScenario->bLive = (strcmp(pArgs[0], "live") == 0);
+    }
+    else if(strcmp(pKeyword, "duration") == 0)
+    {
+        pScenario->duration = atoi(pArgs[0]);
+    }
+    else if(strcmp(pKeyword, "speed") == 0)
+    {
+        if((atof(pArgs[0]) <= 0) || (atof(pArgs[0]) > HLS_CLOCK_MAX_SCALE))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+        pScenario->speed = atof(pArgs[0]);
+    }
+    else if(strcmp(pKeyword, "expect") == 0)
+    {
+        if((pScenario->numExpects >= BENCH_SHAPER_MAX_EXPECTS) ||
+           (strlen(pArgs[0]) >= BENCH_SHAPER_METRIC_SIZE) ||
+           ((strcmp(pArgs[1], "<") != 0) && (strcmp(pArgs[1], "<=") != 0) && (strcmp(pArgs[1], "==") != 0) &&
+            (strcmp(pArgs[1], ">=") != 0) && (strcmp(pArgs[1], ">") != 0)))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+
+        pExpect = &(pScenario->expects[pScenario->numExpects++]);
+        strcpy(pExpect->metric, pArgs[0]);
+        strcpy(pExpect->op, pArgs[1]);
+        pExpect->value = atof(pArgs[2]);
+    }
+    else
+    {
+        if((pScenario->numRules >= BENCH_SHAPER_MAX_RULES) || (strlen(pArgs[0]) >= BENCH_SHAPER_PATTERN_SIZE))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+
+        pRule = &(pScenario->rules[pScenario->numRules++]);
+        memset(pRule, 0, sizeof(benchShaperRule_t));
+        strcpy(pRule->pattern, pArgs[0]);
+
+        switch(pKeyword[0])
+        {
+            case 'e':
+                pRule->action = BENCH_SHAPER_ERROR;
+                pRule->status = atoi(pArgs[1]);
+                if((pRule->status < 100) || (pRule->status > 599))
+                {
+                    return HLS_INVALID_PARAMETER;
+                }
+                break;
+            case 'r':
+                pRule->action = BENCH_SHAPER_RESET;
+                pRule->afterBytes = atol(pArgs[1]);
+                break;
+            default:
+                pRule->action = BENCH_SHAPER_STALL;
+                pRule->afterBytes = atol(pArgs[1]);
+                pRule->stallMsecs = atoi(pArgs[2]);
+                break;
+        }
+
+        return parseRuleOptions(pSave, pRule);
+    }
+
+    /* Nothing may follow the other keywords */
+    return (strtok_r(NULL, " \t\r\n", &pSave) == NULL) ? HLS_OK : HLS_INVALID_PARAMETER;
+}
+
+/**
+ * Reads a scenario file.
+ *
+ * @param pPath - scenario file
+ * @param pScenario - will receive the scenario
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t benchShaper_load(const char* pPath, benchShaperScenario_t* pScenario)
+{
+    hlsStatus_t rval = HLS_OK;
+    FILE* fp = NULL;
+    char line[SHAPER_LINE_SIZE];
+    char* pStart = NULL;
+    int lineNumber = 0;
+    int bHaveBandwidth = 0;
+    int i = 0;
+
+    if((pPath == NULL) || (pScenario == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    memset(pScenario, 0, sizeof(benchShaperScenario_t));
+
+    do
+    {
+        fp = fopen(pPath, "r");
+        if(fp == NULL)
+        {
+            ERROR("fopen() failed on file %s -- %s", pPath, strerror(errno));
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        while(fgets(line, sizeof(line), fp) != NULL)
+        {
+            lineNumber++;
+
+            pStart = line + strspn(line, " \t");
+            if((*pStart == '#') || (*pStart == '\0') || (*pStart == '\r') || (*pStart == '\n'))
+            {
+                continue;
+            }
+
+            rval = parseScenarioLine(pStart, pScenario);
+            if(rval != HLS_OK)
+            {
+                ERROR("%s:%d: invalid scenario line", pPath, lineNumber);
+                break;
+            }
+        }
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        /* The link has to come up at some point, or nothing would ever finish */
+        for(i = 0; i < pScenario->numSteps; i++)
+        {
+            bHaveBandwidth |= (pScenario->steps[i].rate > 0);
+        }
+        if((pScenario->numSteps > 0) && !bHaveBandwidth)
+        {
+            ERROR("%s: bandwidth is never above 0", pPath);
+            rval = HLS_INVALID_PARAMETER;
+            break;
+        }
+        if((pScenario->numSteps > 0) && (pScenario->loopTime > 0) &&
+           (pScenario->steps[pScenario->numSteps - 1].startTime >= pScenario->loopTime))
+        {
+            ERROR("%s: loop is shorter than the bandwidth schedule", pPath);
+            rval = HLS_INVALID_PARAMETER;
+            break;
+        }
+
+    } while(0);
+
+    if(fp != NULL)
+    {
+        fclose(fp);
+    }
+
+    return rval;
+}
+
+/**
+ * Checks a value against an expectation.
+ *
+ * @return TRUE if the expectation holds
+ */
+int benchShaper_check(benchShaperExpect_t* pExpect, double value)
+{
+    if(strcmp(pExpect->op, "<") == 0)
+    {
+        return value < pExpect->value;
+    }
+    if(strcmp(pExpect->op, "<=") == 0)
+    {
+        return value <= pExpect->value;
+    }
+    if(strcmp(pExpect->op, "==") == 0)
+    {
+        return value == pExpect->value;
+    }
+    if(strcmp(pExpect->op, ">=") == 0)
+    {
+        return value >= pExpect->value;
+    }
+    return value > pExpect->value;
+}
+
+/*
+ * Link model
+ */
+
+static double shaperTime(benchShaper_t* pShaper)
+{
+    struct timespec now;
+
+    hlsClock_now(&now);
+
+    return (now.tv_sec - pShaper->startTime.tv_sec) + ((now.tv_nsec - pShaper->startTime.tv_nsec) / 1000000000.0);
+}
+
+static void sleepUntil(benchShaper_t* pShaper, double time)
+{
+    double delay = time - shaperTime(pShaper);
+
+    if(delay > 0)
+    {
+        hlsClock_sleep((long)(delay * 1000000));
+    }
+}
+
+/**
+ * Returns the link rate at a scenario time, and the time the next
+ * step starts (or a negative value if there is none).
+ */
+static int linkRate(benchShaper_t* pShaper, double time, double* pNextStep)
+{
+    benchShaperScenario_t* pScenario = &(pShaper->scenario);
+    double base = 0;
+    int rate = 0;
+    int i = 0;
+
+    *pNextStep = -1;
+
+    if(pScenario->numSteps == 0)
+    {
+        return 0;
+    }
+
+    if(pScenario->loopTime > 0)
+    {
+        base = (long)(time / pScenario->loopTime) * pScenario->loopTime;
+        time -= base;
+    }
+
+    /* Before the first step the link runs at the first step's rate */
+    rate = pScenario->steps[0].rate;
+    for(i = 0; (i < pScenario->numSteps) && (pScenario->steps[i].startTime <= time); i++)
+    {
+        rate = pScenario->steps[i].rate;
+    }
+
+    if(i < pScenario->numSteps)
+    {
+        *pNextStep = base + pScenario->steps[i].startTime;
+    }
+    else if(pScenario->loopTime > 0)
+    {
+        *pNextStep = base + pScenario->loopTime;
+    }
+
+    return rate;
+}
+
+/**
+ * Reserves the link for a chunk of numBytes and waits until it has
+ * gone out.  With no schedule the link is unlimited.
+ */
+static void linkSend(benchShaper_t* pShaper, size_t numBytes)
+{
+    double start = 0;
+    double nextStep = 0;
+    double finish = 0;
+    int rate = 0;
+
+    if(pShaper->scenario.numSteps == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pShaper->mutex));
+
+    start = shaperTime(pShaper);
+    if(pShaper->linkFree > start)
+    {
+        start = pShaper->linkFree;
+    }
+
+    /* Wait out any outage */
+    while((rate = linkRate(pShaper, start, &nextStep)) == 0)
+    {
+        start = nextStep;
+    }
+
+    finish = start + ((numBytes * 8.0) / rate);
+    pShaper->linkFree = finish;
+
+    pthread_mutex_unlock(&(pShaper->mutex));
+
+    sleepUntil(pShaper, finish);
+}
+
+/*
+ * Proxying
+ */
+
+/**
+ * Sends all of a buffer.
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t sendAll(int fd, const char* pData, size_t length)
+{
+    ssize_t sent = 0;
+
+    while(length > 0)
+    {
+        sent = send(fd, pData, length, MSG_NOSIGNAL);
+        if(sent < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return HLS_ERROR;
+        }
+        pData += sent;
+        length -= sent;
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Closes a socket with a TCP reset rather than a FIN.
+ */
+static void resetConnection(int fd)
+{
+    struct linger linger;
+
+    linger.l_onoff = 1;
+    linger.l_linger = 0;
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+    close(fd);
+}
+
+/**
+ * Picks the first applicable rule of each kind for a request path
+ * and counts it as applied.
+ */
+static void pickFaults(benchShaper_t* pShaper, const char* pPath, shaperFaults_t* pFaults)
+{
+    benchShaperRule_t* pRule = NULL;
+    benchShaperRule_t** ppSlot = NULL;
+    double now = shaperTime(pShaper);
+    int i = 0;
+
+    memset(pFaults, 0, sizeof(shaperFaults_t));
+
+    pthread_mutex_lock(&(pShaper->mutex));
+
+    for(i = 0; i < pShaper->scenario.numRules; i++)
+    {
+        pRule = &(pShaper->scenario.rules[i]);
+
+        switch(pRule->action)
+        {
+            case BENCH_SHAPER_ERROR:
+                ppSlot = &(pFaults->pError);
+                break;
+            case BENCH_SHAPER_RESET:
+                ppSlot = &(pFaults->pReset);
+                break;
+            default:
+                ppSlot = &(pFaults->pStall);
+                break;
+        }
+
+        if((*ppSlot != NULL) ||
+           ((pRule->maxCount > 0) && (pShaper->ruleCount[i] >= pRule->maxCount)) ||
+           (now < pRule->fromTime) ||
+           ((pRule->untilTime > 0) && (now >= pRule->untilTime)) ||
+           (fnmatch(pRule->pattern, pPath, 0) != 0))
+        {
+            continue;
+        }
+
+        *ppSlot = pRule;
+        pShaper->ruleCount[i]++;
+    }
+
+    if(pFaults->pError != NULL)
+    {
+        pShaper->counters.numErrors++;
+    }
+
+    pthread_mutex_unlock(&(pShaper->mutex));
+}
+
+/**
+ * Opens a connection to the upstream origin.
+ *
+ * @return socket, or -1 on error
+ */
+static int connectUpstream(benchShaper_t* pShaper)
+{
+    struct sockaddr_in addr;
+    int noDelay = 1;
+    int fd = -1;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0)
+    {
+        ERROR("socket() failed -- %s", strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(pShaper->upstreamPort);
+
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        ERROR("connect() to port %d failed -- %s", pShaper->upstreamPort, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+    return fd;
+}
+
+/**
+ * Forwards one request and relays the response, applying the faults
+ * picked for it.
+ *
+ * @return HLS_OK if the client connection can carry another request
+ */
+static hlsStatus_t relayRequest(benchShaper_t* pShaper, int clientFd, const char* pRequest, size_t requestLength,
+                                shaperFaults_t* pFaults)
+{
+    hlsStatus_t rval = HLS_OK;
+    char* pBuffer = NULL;
+    char* pEnd = NULL;
+    char* pLength = NULL;
+    size_t used = 0;
+    size_t headerLength = 0;
+    size_t chunk = 0;
+    ssize_t received = 0;
+    long contentLength = -1;
+    long sent = 0;
+    int upstreamFd = -1;
+    int bStalled = 0;
+
+    do
+    {
+        pBuffer = malloc(SHAPER_CHUNK_SIZE);
+        if(pBuffer == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        if(pShaper->scenario.rttMsecs > 0)
+        {
+            hlsClock_sleep(pShaper->scenario.rttMsecs * 1000);
+        }
+
+        upstreamFd = connectUpstream(pShaper);
+        if(upstreamFd < 0)
+        {
+            rval = HLS_ERROR;
+            break;
+        }
+
+        rval = sendAll(upstreamFd, pRequest, requestLength);
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        /* Read the response header */
+        while(used < SHAPER_HEADER_SIZE - 1)
+        {
+            received = recv(upstreamFd, pBuffer + used, SHAPER_HEADER_SIZE - 1 - used, 0);
+            if(received <= 0)
+            {
+                break;
+            }
+            used += received;
+            pBuffer[used] = '\0';
+
+            pEnd = strstr(pBuffer, "\r\n\r\n");
+            if(pEnd != NULL)
+            {
+                break;
+            }
+        }
+        if(pEnd == NULL)
+        {
+            ERROR("bad or missing response header from upstream");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        headerLength = (pEnd + 4) - pBuffer;
+
+        for(pLength = strstr(pBuffer, "\r\n"); (pLength != NULL) && (pLength < pEnd); pLength = strstr(pLength + 2, "\r\n"))
+        {
+            if(strncasecmp(pLength + 2, "Content-Length:", strlen("Content-Length:")) == 0)
+            {
+                contentLength = atol(pLength + 2 + strlen("Content-Length:"));
+                break;
+            }
+        }
+
+        rval = sendAll(clientFd, pBuffer, headerLength);
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        /* Relay the body, starting with whatever came in with the header */
+        used -= headerLength;
+        memmove(pBuffer, pBuffer + headerLength, used);
+
+        while((contentLength < 0) || (sent < contentLength))
+        {
+            if(used == 0)
+            {
+                chunk = SHAPER_CHUNK_SIZE;
+                if((contentLength >= 0) && ((long)chunk > contentLength - sent))
+                {
+                    chunk = contentLength - sent;
+                }
+
+                received = recv(upstreamFd, pBuffer, chunk, 0);
+                if(received <= 0)
+                {
+                    break;
+                }
+                used = received;
+            }
+
+            /* Stop at the stall or reset point, if it falls within this chunk */
+            chunk = used;
+            if((pFaults->pStall != NULL) && !bStalled && (sent + (long)chunk > pFaults->pStall->afterBytes))
+            {
+                chunk = (pFaults->pStall->afterBytes > sent) ? pFaults->pStall->afterBytes - sent : 0;
+            }
+            if((pFaults->pReset != NULL) && (sent + (long)chunk > pFaults->pReset->afterBytes))
+            {
+                chunk = (pFaults->pReset->afterBytes > sent) ? pFaults->pReset->afterBytes - sent : 0;
+            }
+
+            if(chunk > 0)
+            {
+                linkSend(pShaper, chunk);
+
+                rval = sendAll(clientFd, pBuffer, chunk);
+                if(rval != HLS_OK)
+                {
+                    break;
+                }
+
+                sent += chunk;
+                used -= chunk;
+                memmove(pBuffer, pBuffer + chunk, used);
+
+                pthread_mutex_lock(&(pShaper->mutex));
+                pShaper->counters.bytesRelayed += chunk;
+                pthread_mutex_unlock(&(pShaper->mutex));
+            }
+
+            if((pFaults->pReset != NULL) && (sent >= pFaults->pReset->afterBytes))
+            {
+                DEBUG(DBG_INFO, "resetting connection after %ld bytes", sent);
+
+                pthread_mutex_lock(&(pShaper->mutex));
+                pShaper->counters.numResets++;
+                pthread_mutex_unlock(&(pShaper->mutex));
+
+                rval = HLS_CANCELLED;
+                break;
+            }
+
+            if((pFaults->pStall != NULL) && !bStalled && (sent >= pFaults->pStall->afterBytes))
+            {
+                DEBUG(DBG_INFO, "stalling for %d ms after %ld bytes", pFaults->pStall->stallMsecs, sent);
+
+                pthread_mutex_lock(&(pShaper->mutex));
+                pShaper->counters.numStalls++;
+                pthread_mutex_unlock(&(pShaper->mutex));
+
+                hlsClock_sleep(pFaults->pStall->stallMsecs * 1000);
+                bStalled = 1;
+            }
+        }
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        /* Without a length the end of the body is the end of the connection */
+        if((contentLength < 0) || (sent < contentLength))
+        {
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    if(upstreamFd >= 0)
+    {
+        close(upstreamFd);
+    }
+
+    free(pBuffer);
+
+    return rval;
+}
+
+/**
+ * Handles one request off a client connection.
+ *
+ * @return HLS_OK if the client connection can carry another request
+ */
+static hlsStatus_t serveRequest(benchShaper_t* pShaper, int fd, const char* pRequest, size_t length)
+{
+    shaperFaults_t faults;
+    char method[16];
+    char path[1024];
+    char response[256];
+
+    pthread_mutex_lock(&(pShaper->mutex));
+    pShaper->counters.numRequests++;
+    pthread_mutex_unlock(&(pShaper->mutex));
+
+    if(sscanf(pRequest, "%15s %1023s", method, path) != 2)
+    {
+        return HLS_ERROR;
+    }
+
+    pickFaults(pShaper, path, &faults);
+
+    if(faults.pError != NULL)
+    {
+        DEBUG(DBG_INFO, "answering %s with %d", path, faults.pError->status);
+
+        if(pShaper->scenario.rttMsecs > 0)
+        {
+            hlsClock_sleep(pShaper->scenario.rttMsecs * 1000);
+        }
+
+        snprintf(response, sizeof(response),
+                 "HTTP/1.1 %d Injected\r\nContent-Length: 0\r\nConnection: keep-alive\r\n\r\n", faults.pError->status);
+
+        return sendAll(fd, response, strlen(response));
+    }
+
+    return relayRequest(pShaper, fd, pRequest, length, &faults);
+}
+
+/**
+ * Connection thread: proxies requests until the client closes the
+ * connection, a fault ends it or the proxy is stopped.
+ */
+static void* connectionThread(void* pArg)
+{
+    shaperConnection_t* pConnection = (shaperConnection_t*)pArg;
+    benchShaper_t* pShaper = pConnection->pShaper;
+    int fd = pConnection->fd;
+
+    hlsStatus_t status = HLS_OK;
+    char request[SHAPER_HEADER_SIZE];
+    size_t used = 0;
+    ssize_t received = 0;
+    char* pEnd = NULL;
+    size_t length = 0;
+    int bStop = 0;
+
+    free(pConnection);
+
+    while(!bStop)
+    {
+        pthread_mutex_lock(&(pShaper->mutex));
+        bStop = pShaper->bStop;
+        pthread_mutex_unlock(&(pShaper->mutex));
+
+        request[used] = '\0';
+        pEnd = strstr(request, "\r\n\r\n");
+        if(pEnd == NULL)
+        {
+            if(used >= sizeof(request) - 1)
+            {
+                status = HLS_ERROR;
+                break;
+            }
+
+            received = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+            if(received == 0)
+            {
+                break;
+            }
+            if(received < 0)
+            {
+                if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR))
+                {
+                    continue;
+                }
+                break;
+            }
+            used += received;
+            continue;
+        }
+
+        /* Forward the request, then keep anything the client sent after it */
+        length = (pEnd + 4) - request;
+
+        status = serveRequest(pShaper, fd, request, length);
+        if(status != HLS_OK)
+        {
+            break;
+        }
+
+        memmove(request, request + length, used - length);
+        used -= length;
+    }
+
+    if(status == HLS_CANCELLED)
+    {
+        resetConnection(fd);
+    }
+    else
+    {
+        close(fd);
+    }
+
+    pthread_mutex_lock(&(pShaper->mutex));
+    pShaper->numConnections--;
+    pthread_cond_signal(&(pShaper->cond));
+    pthread_mutex_unlock(&(pShaper->mutex));
+
+    return NULL;
+}
+
+/**
+ * Accept thread: starts a connection thread per client.
+ */
+static void* acceptThread(void* pArg)
+{
+    benchShaper_t* pShaper = (benchShaper_t*)pArg;
+    shaperConnection_t* pConnection = NULL;
+    pthread_t thread;
+    pthread_attr_t attr;
+    struct timeval timeout;
+    int noDelay = 1;
+    int fd = -1;
+    int bStop = 0;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    timeout.tv_sec = 0;
+    timeout.tv_usec = SHAPER_POLL_MSECS * 1000;
+
+    while(!bStop)
+    {
+        fd = accept(pShaper->listenFd, NULL, NULL);
+
+        pthread_mutex_lock(&(pShaper->mutex));
+        bStop = pShaper->bStop;
+        pthread_mutex_unlock(&(pShaper->mutex));
+
+        if(fd < 0)
+        {
+            continue;
+        }
+        if(bStop)
+        {
+            close(fd);
+            break;
+        }
+
+        /* Wake up periodically so idle keep-alive connections notice a stop */
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        /* Headers and bodies go out in separate writes; don't let Nagle hold
+           them for a delayed ACK, which a sped-up clock (-x) would magnify */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        pConnection = malloc(sizeof(shaperConnection_t));
+        if(pConnection == NULL)
+        {
+            ERROR("malloc error");
+            close(fd);
+            continue;
+        }
+        pConnection->pShaper = pShaper;
+        pConnection->fd = fd;
+
+        pthread_mutex_lock(&(pShaper->mutex));
+        pShaper->numConnections++;
+        pthread_mutex_unlock(&(pShaper->mutex));
+
+        if(pthread_create(&thread, &attr, connectionThread, pConnection) != 0)
+        {
+            ERROR("failed to create connection thread");
+            close(fd);
+            free(pConnection);
+
+            pthread_mutex_lock(&(pShaper->mutex));
+            pShaper->numConnections--;
+            pthread_mutex_unlock(&(pShaper->mutex));
+        }
+    }
+
+    pthread_attr_destroy(&attr);
+
+    return NULL;
+}
+
+/**
+ * Starts a proxy on an ephemeral port of 127.0.0.1.  Scenario time
+ * starts now.
+ *
+ * @param pScenario - scenario to apply
+ * @param upstreamPort - port of the origin on 127.0.0.1
+ * @param ppShaper - will point to the new proxy; stop it with
+ *                 benchShaper_stop()
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t benchShaper_start(benchShaperScenario_t* pScenario, int upstreamPort, benchShaper_t** ppShaper)
+{
+    hlsStatus_t rval = HLS_OK;
+    benchShaper_t* pShaper = NULL;
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    if((pScenario == NULL) || (ppShaper == NULL) || (upstreamPort <= 0))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        pShaper = calloc(1, sizeof(benchShaper_t));
+        if(pShaper == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        pShaper->scenario = *pScenario;
+        pShaper->upstreamPort = upstreamPort;
+        pthread_mutex_init(&(pShaper->mutex), NULL);
+        pthread_cond_init(&(pShaper->cond), NULL);
+        hlsClock_now(&(pShaper->startTime));
+
+        pShaper->listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        if(pShaper->listenFd < 0)
+        {
+            ERROR("socket() failed -- %s", strerror(errno));
+            rval = HLS_ERROR;
+            break;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        if((bind(pShaper->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) ||
+           (listen(pShaper->listenFd, 128) != 0) ||
+           (getsockname(pShaper->listenFd, (struct sockaddr*)&addr, &addrLen) != 0))
+        {
+            ERROR("failed to listen on the loopback interface -- %s", strerror(errno));
+            rval = HLS_ERROR;
+            break;
+        }
+
+        pShaper->port = ntohs(addr.sin_port);
+
+        if(pthread_create(&(pShaper->acceptThread), NULL, acceptThread, pShaper) != 0)
+        {
+            ERROR("failed to create accept thread");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        DEBUG(DBG_INFO, "shaper listening on port %d, forwarding to %d", pShaper->port, upstreamPort);
+
+    } while(0);
+
+    if(rval != HLS_OK)
+    {
+        if(pShaper != NULL)
+        {
+            if(pShaper->listenFd > 0)
+            {
+                close(pShaper->listenFd);
+            }
+            pthread_cond_destroy(&(pShaper->cond));
+            pthread_mutex_destroy(&(pShaper->mutex));
+            free(pShaper);
+        }
+        pShaper = NULL;
+    }
+
+    *ppShaper = pShaper;
+
+    return rval;
+}
+
+/**
+ * Stops a proxy, closing all connections, and frees it.
+ *
+ * @param pShaper - proxy started with benchShaper_start()
+ */
+void benchShaper_stop(benchShaper_t* pShaper)
+{
+    if(pShaper == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pShaper->mutex));
+    pShaper->bStop = 1;
+    pthread_mutex_unlock(&(pShaper->mutex));
+
+    /* Unblock accept() */
+    shutdown(pShaper->listenFd, SHUT_RDWR);
+    pthread_join(pShaper->acceptThread, NULL);
+    close(pShaper->listenFd);
+
+    pthread_mutex_lock(&(pShaper->mutex));
+    while(pShaper->numConnections > 0)
+    {
+        pthread_cond_wait(&(pShaper->cond), &(pShaper->mutex));
+    }
+    pthread_mutex_unlock(&(pShaper->mutex));
+
+    pthread_cond_destroy(&(pShaper->cond));
+    pthread_mutex_destroy(&(pShaper->mutex));
+    free(pShaper);
+}
+
+/**
+ * Returns the port a proxy is listening on.
+ */
+int benchShaper_getPort(benchShaper_t* pShaper)
+{
+    return (pShaper != NULL) ? pShaper->port : 0;
+}
+
+/**
+ * Returns what a proxy has done so far.
+ *
+ * @param pShaper - proxy
+ * @param pCounters - will receive the counters
+ */
+void benchShaper_getCounters(benchShaper_t* pShaper, benchShaperCounters_t* pCounters)
+{
+    if((pShaper == NULL) || (pCounters == NULL))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pShaper->mutex));
+    *pCounters = pShaper->counters;
+    pthread_mutex_unlock(&(pShaper->mutex));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+#ifndef BENCHSHAPER_H
+#define BENCHSHAPER_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file benchShaper.h @date October 19, 2026
+ *
+ * Network shaping HTTP proxy used by the benchmarks.
+ *
+ * Sits between the plugin and the benchmark origin on an ephemeral
+ * port of 127.0.0.1 and applies a scenario read from a file:
+ *
+ *   # comment
+ *   bandwidth <seconds> <kbit/s>     link rate from <seconds> on (0 is an outage)
+ *   loop <seconds>                   repeat the bandwidth schedule
+ *   rtt <msecs>                      delay added before every request
+ *   content vod|live                 what the benchmark should play
+ *   duration <seconds>               how long the benchmark should play it
+ *   speed <factor>                   run the library clock <factor> times
+ *                                    faster than real time (see hlsClock.h);
+ *                                    all times in the file are session time
+ *   error <pattern> <status> [opts]  answer matching requests with <status>
+ *   reset <pattern> <bytes> [opts]   reset the connection after <bytes> of body
+ *   stall <pattern> <bytes> <msecs> [opts]
+ *                                    pause for <msecs> after <bytes> of body
+ *   expect <metric> <op> <value>     check a result of the run (op is
+ *                                    <, <=, ==, >= or >)
+ *
+ * Patterns are fnmatch() patterns matched against the request path,
+ * e.g. "*.ts" or "/live/800000/seg*".  Rule options are "count <n>"
+ * (apply to the first <n> matches only), "from <seconds>" and
+ * "until <seconds>" (apply only within that part of the run).
+ *
+ * The bandwidth is that of one link shared by all connections.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+#define BENCH_SHAPER_MAX_STEPS 64           /*!< Maximum number of bandwidth steps */
+#define BENCH_SHAPER_MAX_RULES 32           /*!< Maximum number of error/reset/stall rules */
+#define BENCH_SHAPER_MAX_EXPECTS 16         /*!< Maximum number of expectations */
+#define BENCH_SHAPER_PATTERN_SIZE 128       /*!< Size of a rule pattern, including the '\0' */
+#define BENCH_SHAPER_METRIC_SIZE 32         /*!< Size of an expectation metric name, including the '\0' */
+
+/*! What a rule does to the requests it matches */
+typedef enum {
+    BENCH_SHAPER_ERROR,     /*!< Answer with an HTTP error instead of forwarding */
+    BENCH_SHAPER_RESET,     /*!< Reset the connection part way through the body */
+    BENCH_SHAPER_STALL      /*!< Pause part way through the body */
+} benchShaperAction_t;
+
+/*! \struct benchShaperStep_t
+ * One step of the bandwidth schedule
+ */
+typedef struct {
+    float startTime;                /*!< Seconds since the proxy started */
+    int rate;                       /*!< Link rate in bps, 0 for an outage */
+} benchShaperStep_t;
+
+/*! \struct benchShaperRule_t
+ * Fault injected into matching requests
+ */
+typedef struct {
+    benchShaperAction_t action;
+    char pattern[BENCH_SHAPER_PATTERN_SIZE];    /*!< fnmatch() pattern on the request path */
+    int status;                                 /*!< HTTP status for BENCH_SHAPER_ERROR */
+    long afterBytes;                            /*!< Body bytes sent before a reset or stall */
+    int stallMsecs;                             /*!< Length of a stall */
+    int maxCount;                               /*!< Matches to apply the rule to, 0 for all */
+    float fromTime;                             /*!< Apply from this many seconds on */
+    float untilTime;                            /*!< Apply until this many seconds, 0 for ever */
+} benchShaperRule_t;
+
+/*! \struct benchShaperExpect_t
+ * Check on the result of a run, "<metric> <op> <value>"
+ */
+typedef struct {
+    char metric[BENCH_SHAPER_METRIC_SIZE];
+    char op[3];
+    double value;
+} benchShaperExpect_t;
+
+/*! \struct benchShaperScenario_t
+ * Contents of a scenario file
+ */
+typedef struct {
+    int numSteps;
+    benchShaperStep_t steps[BENCH_SHAPER_MAX_STEPS];   /*!< Sorted by startTime */
+    float loopTime;                                     /*!< Schedule period in seconds, 0 to hold the last step */
+    int rttMsecs;
+    int numRules;
+    benchShaperRule_t rules[BENCH_SHAPER_MAX_RULES];
+    int numExpects;
+    benchShaperExpect_t expects[BENCH_SHAPER_MAX_EXPECTS];
+    int bLive;                                          /*!< Play live content rather than VOD */
+    int duration;                                       /*!< Seconds to play, 0 for the benchmark default */
+    float speed;                                        /*!< Library clock speed-up, 0 for the benchmark default */
+} benchShaperScenario_t;
+
+/*! \struct benchShaperCounters_t
+ * What a proxy has done so far
+ */
+typedef struct {
+    unsigned int numRequests;       /*!< Requests received */
+    unsigned int numErrors;         /*!< Requests answered with an injected error */
+    unsigned int numResets;         /*!< Responses cut short by a reset */
+    unsigned int numStalls;         /*!< Responses paused part way through */
+    unsigned long long bytesRelayed;/*!< Response body bytes relayed */
+} benchShaperCounters_t;
+
+typedef struct benchShaper_t_ benchShaper_t;
+
+hlsStatus_t benchShaper_load(const char* pPath, benchShaperScenario_t* pScenario);
+int benchShaper_check(benchShaperExpect_t* pExpect, double value);
+
+hlsStatus_t benchShaper_start(benchShaperScenario_t* pScenario, int upstreamPort, benchShaper_t** ppShaper);
+void benchShaper_stop(benchShaper_t* pShaper);
+
+int benchShaper_getPort(benchShaper_t* pShaper);
+void benchShaper_getCounters(benchShaper_t* pShaper, benchShaperCounters_t* pCounters);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,1078 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsBench.c @date October 19, 2026
+ *
+ * End-to-end benchmarks of the HLS plugin.
+ *
+ * The plugin is loaded through srcPluginLoad() with the stub player
+ * of benchPlayer.c and pointed at the embedded origin of
+ * benchOrigin.c, so every number comes from the same code path a real
+ * player uses, with no network or decoder in the way.  Scenarios:
+ *
+ *   ttfb       - open to first buffer, VOD and live, with the startup
+ *                timeline up to the playlists and the first segment byte
+ *   throughput - VOD delivered as fast as the plugin can, to EOF
+ *   cpu        - process CPU per real-time live session
+ *   seek       - SRC_PLUGIN_SET_POSITION to first buffer after the flush
+ *   scale      - many real-time live sessions over a long period, sampling
+ *                CPU, RSS, file descriptors, threads and playlist lock
+ *                waits to catch leaks and scaling regressions
+ *   shaped     - one real-time session through the shaping proxy of
+ *                benchShaper.c, applying the scenario file given with
+ *                -p and checking its expectations; only run with -p
+ *
+ * With -x, or a "speed" line in the shaping scenario, the library clock
+ * (hlsClock.h) and with it the origin, proxy and stub players run that
+ * many times faster than real time.  Reload, ABR and resume timers then
+ * fire at the accelerated rate, so hours of live playback can be
+ * replayed in minutes.  All reported times are session time; CPU
+ * figures are not meaningful in that mode.
+ *
+ * Results are written one per line as "scenario metric value unit".
+ * The exit status is 2 if a shaped scenario expectation failed.
+ * CPU figures include the origin and the stub players, which do very
+ * little work next to the plugin.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <dirent.h>
+
+#include "hlsPlugin.h"
+#include "hlsClock.h"
+
+#include "benchOrigin.h"
+#include "benchPlayer.h"
+#include "benchShaper.h"
+
+#include "debug.h"
+
+/* How long to wait for the first buffer of a session.  Startup is bound
+   by real transfers, so keep the wall-clock limit when running sped up */
+#define BENCH_FIRST_BUFFER_TIMEOUT_MSECS ((int)(20000 * hlsClock_getScale()))
+
+/* How long to wait for a VOD session to reach EOF */
+#define BENCH_EOF_TIMEOUT_MSECS 300000
+
+/* How long to let a session play between seeks */
+#define BENCH_SEEK_SETTLE_MSECS 1000
+
+/* Maximum number of samples or sessions in a scenario */
+#define BENCH_MAX_SAMPLES 256
+
+/*! Benchmark run state */
+typedef struct {
+    benchOriginConfig_t originConfig;   /*!< Content served by the origin */
+    benchOrigin_t* pOrigin;             /*!< The origin */
+    srcPluginFunc_t plugin;             /*!< Plugin function table */
+    srcPlayerFunc_t player;             /*!< Stub player function table */
+    FILE* fpResults;                    /*!< Where results are written */
+    int numRuns;                        /*!< Samples per measurement */
+    int numSessions;                    /*!< Concurrent sessions for the cpu scenario */
+    int duration;                       /*!< Length of the cpu scenario, in seconds */
+    int scaleDuration;                  /*!< Length of the scale scenario, in seconds */
+    int sampleInterval;                 /*!< Time between scale samples, in seconds */
+    int churnInterval;                  /*!< Time between scale session restarts, in seconds; 0 for none */
+    benchShaperScenario_t shaperScenario; /*!< Scenario of the shaped run */
+    benchShaper_t* pShaper;             /*!< Proxy sessions go through, if running */
+    int numFailures;                    /*!< Expectations that did not hold */
+    int bLend;                          /*!< Have sessions lend their buffers to the player */
+} benchContext_t;
+
+/*! One plugin session and its stub player */
+typedef struct {
+    benchPlayer_t* pPlayer;
+    srcSessionId_t sessionId;
+    double openTime;                    /*!< benchPlayer_now() when the session was opened */
+} benchSession_t;
+
+/**
+ * Writes one result line.
+ */
+static void report(benchContext_t* pContext, const char* pScenario, const char* pMetric, double value, const char* pUnit)
+{
+    fprintf(pContext->fpResults, "%-12s %-28s %12.3f %s\n", pScenario, pMetric, value, pUnit);
+    fflush(pContext->fpResults);
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Writes the median, minimum and maximum of a set of samples.
+ */
+static void reportSamples(benchContext_t* pContext, const char* pScenario, const char* pMetric,
+                          double* pSamples, int numSamples, const char* pUnit)
+{
+    char name[64];
+
+    if(numSamples <= 0)
+    {
+        snprintf(name, sizeof(name), "%s_failed", pMetric);
+        report(pContext, pScenario, name, 1, "");
+        return;
+    }
+
+    qsort(pSamples, numSamples, sizeof(double), compareDoubles);
+
+    snprintf(name, sizeof(name), "%s_median", pMetric);
+    report(pContext, pScenario, name, pSamples[numSamples / 2], pUnit);
+    snprintf(name, sizeof(name), "%s_min", pMetric);
+    report(pContext, pScenario, name, pSamples[0], pUnit);
+    snprintf(name, sizeof(name), "%s_max", pMetric);
+    report(pContext, pScenario, name, pSamples[numSamples - 1], pUnit);
+}
+
+/**
+ * Returns the CPU time used by the process so far, in seconds.
+ */
+static double cpuTime(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return usage.ru_utime.tv_sec + (usage.ru_utime.tv_usec / 1000000.0) +
+           usage.ru_stime.tv_sec + (usage.ru_stime.tv_usec / 1000000.0);
+}
+
+/**
+ * Opens a session on the origin's VOD or live content and starts
+ * it playing.
+ *
+ * @param pContext - benchmark state
+ * @param bLive - TRUE for the live content
+ * @param bPaced - TRUE to play the media out in real time
+ * @param pSession - session to start
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t sessionStart(benchContext_t* pContext, int bLive, int bPaced, benchSession_t* pSession)
+{
+    hlsStatus_t rval = HLS_OK;
+    srcPluginErr_t error;
+    srcPluginSetData_t setData;
+    srcPlayerLendBuffer_t lendBuffer = benchPlayer_lendBuffer;
+    char url[128];
+    float speed = 1.0;
+
+    memset(pSession, 0, sizeof(benchSession_t));
+
+    do
+    {
+        rval = benchPlayer_create(bPaced, &(pSession->pPlayer));
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        snprintf(url, sizeof(url), "http://127.0.0.1:%d/%s/master.m3u8",
+                 (pContext->pShaper != NULL) ? benchShaper_getPort(pContext->pShaper) : benchOrigin_getPort(pContext->pOrigin),
+                 bLive ? "live" : "vod");
+
+        pSession->openTime = benchPlayer_now();
+
+        if(pContext->plugin.open(&(pSession->sessionId), pSession->pPlayer, &error) != SRC_SUCCESS)
+        {
+            ERROR("open failed: %s", error.errMsg);
+            rval = HLS_ERROR;
+            break;
+        }
+
+        benchPlayer_attach(pSession->pPlayer, pSession->sessionId);
+
+        setData.setCode = SRC_PLUGIN_SET_DATA_SOURCE;
+        setData.pData = url;
+        if(pContext->plugin.set(pSession->sessionId, &setData, &error) != SRC_SUCCESS)
+        {
+            ERROR("set data source failed: %s", error.errMsg);
+            rval = HLS_ERROR;
+            break;
+        }
+
+        if(pContext->bLend)
+        {
+            setData.setCode = SRC_PLUGIN_SET_LEND_BUFFER;
+            setData.pData = &lendBuffer;
+            if(pContext->plugin.set(pSession->sessionId, &setData, &error) != SRC_SUCCESS)
+            {
+                ERROR("set lend buffer failed: %s", error.errMsg);
+                rval = HLS_ERROR;
+                break;
+            }
+        }
+
+        if(pContext->plugin.prepare(pSession->sessionId, &error) != SRC_SUCCESS)
+        {
+            ERROR("prepare failed: %s", error.errMsg);
+            rval = HLS_ERROR;
+            break;
+        }
+
+        setData.setCode = SRC_PLUGIN_SET_SPEED;
+        setData.pData = &speed;
+        if(pContext->plugin.set(pSession->sessionId, &setData, &error) != SRC_SUCCESS)
+        {
+            ERROR("set speed failed: %s", error.errMsg);
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Closes a session started with sessionStart().  Safe to call on
+ * a session that failed to start.
+ */
+static void sessionStop(benchContext_t* pContext, benchSession_t* pSession)
+{
+    srcPluginErr_t error;
+
+    if(pSession->pPlayer == NULL)
+    {
+        return;
+    }
+
+    benchPlayer_detach(pSession->pPlayer);
+
+    if(pSession->sessionId != NULL)
+    {
+        pContext->plugin.close(pSession->sessionId, &error);
+        pSession->sessionId = NULL;
+    }
+
+    benchPlayer_destroy(pSession->pPlayer);
+    pSession->pPlayer = NULL;
+}
+
+/**
+ * Time from open() to the first buffer, for VOD and for live, and
+ * the time from setting the data source to the playlists being
+ * parsed and to the first segment byte (SRC_PLUGIN_GET_STATS
+ * startup timeline).
+ */
+static void scenarioTTFB(benchContext_t* pContext)
+{
+    benchSession_t session;
+    srcPluginGetData_t getData;
+    srcPluginStats_t stats;
+    srcPluginErr_t error;
+    double samples[BENCH_MAX_SAMPLES];
+    double playlistSamples[BENCH_MAX_SAMPLES];
+    double firstByteSamples[BENCH_MAX_SAMPLES];
+    double firstBufferTime = 0;
+    int numSamples = 0;
+    int numPhaseSamples = 0;
+    int bLive = 0;
+    int i = 0;
+
+    for(bLive = 0; bLive <= 1; bLive++)
+    {
+        numSamples = 0;
+        numPhaseSamples = 0;
+
+        for(i = 0; i < pContext->numRuns; i++)
+        {
+            if((sessionStart(pContext, bLive, 1, &session) == HLS_OK) &&
+               (benchPlayer_waitFirstBuffer(session.pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, &firstBufferTime) == HLS_OK))
+            {
+                samples[numSamples++] = (firstBufferTime - session.openTime) * 1000;
+
+                getData.getCode = SRC_PLUGIN_GET_STATS;
+                getData.pData = &stats;
+                if((pContext->plugin.get(session.sessionId, &getData, &error) == SRC_SUCCESS) &&
+                   (stats.startup.phaseTime[SRC_STARTUP_MEDIA_PLAYLIST] >= 0) &&
+                   (stats.startup.phaseTime[SRC_STARTUP_FIRST_BYTE] >= 0))
+                {
+                    playlistSamples[numPhaseSamples] = stats.startup.phaseTime[SRC_STARTUP_MEDIA_PLAYLIST];
+                    if(stats.startup.phaseTime[SRC_STARTUP_AUDIO_PLAYLIST] > playlistSamples[numPhaseSamples])
+                    {
+                        playlistSamples[numPhaseSamples] = stats.startup.phaseTime[SRC_STARTUP_AUDIO_PLAYLIST];
+                    }
+                    firstByteSamples[numPhaseSamples] = stats.startup.phaseTime[SRC_STARTUP_FIRST_BYTE];
+                    numPhaseSamples++;
+                }
+            }
+            sessionStop(pContext, &session);
+        }
+
+        reportSamples(pContext, "ttfb", bLive ? "live_first_buffer" : "vod_first_buffer", samples, numSamples, "ms");
+        reportSamples(pContext, "ttfb", bLive ? "live_playlists" : "vod_playlists", playlistSamples, numPhaseSamples, "ms");
+        reportSamples(pContext, "ttfb", bLive ? "live_first_byte" : "vod_first_byte", firstByteSamples, numPhaseSamples, "ms");
+    }
+}
+
+/**
+ * Throughput of a VOD session whose player consumes everything
+ * immediately, from open() to EOF.
+ */
+static void scenarioThroughput(benchContext_t* pContext)
+{
+    benchSession_t session;
+    benchPlayerCounters_t counters;
+    benchOriginCounters_t before;
+    benchOriginCounters_t after;
+    double mbps[BENCH_MAX_SAMPLES];
+    double segments[BENCH_MAX_SAMPLES];
+    double elapsed = 0;
+    int numSamples = 0;
+    int i = 0;
+
+    for(i = 0; i < pContext->numRuns; i++)
+    {
+        benchOrigin_getCounters(pContext->pOrigin, &before);
+
+        if((sessionStart(pContext, 0, 0, &session) == HLS_OK) &&
+           (benchPlayer_waitEOF(session.pPlayer, BENCH_EOF_TIMEOUT_MSECS) == HLS_OK))
+        {
+            elapsed = benchPlayer_now() - session.openTime;
+            benchPlayer_getCounters(session.pPlayer, &counters);
+            benchOrigin_getCounters(pContext->pOrigin, &after);
+
+            mbps[numSamples] = (counters.bytes * 8.0) / elapsed / 1000000;
+            segments[numSamples] = (after.numSegments - before.numSegments) / elapsed;
+            numSamples++;
+        }
+        sessionStop(pContext, &session);
+    }
+
+    reportSamples(pContext, "throughput", "delivered", mbps, numSamples, "Mbit/s");
+    reportSamples(pContext, "throughput", "segments", segments, numSamples, "segments/s");
+}
+
+/**
+ * CPU used per concurrent real-time live session.
+ */
+static void scenarioCPU(benchContext_t* pContext)
+{
+    benchSession_t sessions[BENCH_MAX_SAMPLES];
+    benchPlayerCounters_t counters;
+    double startCpu = 0;
+    double startTime = 0;
+    double elapsed = 0;
+    double played = 0;
+    unsigned int numStalls = 0;
+    int numSessions = pContext->numSessions;
+    int numStarted = 0;
+    int i = 0;
+
+    if(numSessions > BENCH_MAX_SAMPLES)
+    {
+        numSessions = BENCH_MAX_SAMPLES;
+    }
+
+    for(i = 0; i < numSessions; i++)
+    {
+        if(sessionStart(pContext, 1, 1, &(sessions[i])) != HLS_OK)
+        {
+            sessionStop(pContext, &(sessions[i]));
+            break;
+        }
+        numStarted++;
+    }
+
+    /* Measure steady state only */
+    for(i = 0; i < numStarted; i++)
+    {
+        benchPlayer_waitFirstBuffer(sessions[i].pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, NULL);
+    }
+
+    startCpu = cpuTime();
+    startTime = benchPlayer_now();
+
+    hlsClock_sleep(pContext->duration * 1000000l);
+
+    elapsed = benchPlayer_now() - startTime;
+
+    report(pContext, "cpu", "sessions", numStarted, "");
+    if(numStarted > 0)
+    {
+        report(pContext, "cpu", "per_session", ((cpuTime() - startCpu) / elapsed / numStarted) * 100, "% of a core");
+    }
+
+    for(i = 0; i < numStarted; i++)
+    {
+        benchPlayer_getCounters(sessions[i].pPlayer, &counters);
+        numStalls += counters.numStalls;
+        played += counters.playTime;
+        sessionStop(pContext, &(sessions[i]));
+    }
+
+    report(pContext, "cpu", "stalls", numStalls, "");
+    report(pContext, "cpu", "media_played", played, "s");
+}
+
+/**
+ * Time from SRC_PLUGIN_SET_POSITION to the first buffer after the
+ * flush, at random VOD positions.
+ */
+static void scenarioSeek(benchContext_t* pContext)
+{
+    benchSession_t session;
+    srcPluginSetData_t setData;
+    srcPluginErr_t error;
+    double samples[BENCH_MAX_SAMPLES];
+    double seekTime = 0;
+    double firstBufferTime = 0;
+    float position = 0;
+    float duration = pContext->originConfig.numSegments * pContext->originConfig.segmentDuration;
+    int numSamples = 0;
+    int i = 0;
+
+    /* Same positions on every run */
+    srand(1);
+
+    do
+    {
+        if((sessionStart(pContext, 0, 1, &session) != HLS_OK) ||
+           (benchPlayer_waitFirstBuffer(session.pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, NULL) != HLS_OK))
+        {
+            break;
+        }
+
+        for(i = 0; i < pContext->numRuns; i++)
+        {
+            hlsClock_sleep(BENCH_SEEK_SETTLE_MSECS * 1000);
+
+            /* Stay clear of the end so that every seek has data to deliver */
+            position = ((float)rand() / RAND_MAX) * (duration * 0.8f) * 1000;
+
+            setData.setCode = SRC_PLUGIN_SET_POSITION;
+            setData.pData = &position;
+
+            seekTime = benchPlayer_now();
+            if(pContext->plugin.set(session.sessionId, &setData, &error) != SRC_SUCCESS)
+            {
+                ERROR("seek to %f ms failed: %s", position, error.errMsg);
+                continue;
+            }
+
+            /* The flush clears the first buffer time, so anything older is from before the seek */
+            while(benchPlayer_waitFirstBuffer(session.pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, &firstBufferTime) == HLS_OK)
+            {
+                if(firstBufferTime >= seekTime)
+                {
+                    samples[numSamples++] = (firstBufferTime - seekTime) * 1000;
+                    break;
+                }
+                hlsClock_sleep(1000);
+                if(benchPlayer_now() - seekTime > BENCH_FIRST_BUFFER_TIMEOUT_MSECS / 1000.0)
+                {
+                    break;
+                }
+            }
+        }
+
+    } while(0);
+
+    sessionStop(pContext, &session);
+
+    reportSamples(pContext, "seek", "first_buffer", samples, numSamples, "ms");
+}
+
+/*! Process resource usage at one point in time */
+typedef struct {
+    double time;            /*!< benchPlayer_now() */
+    double cpu;             /*!< cpuTime() */
+    long rssKB;             /*!< Resident set size, in kB */
+    int numFds;             /*!< Open file descriptors */
+    int numThreads;         /*!< Threads in the process */
+} processSample_t;
+
+/**
+ * Samples the resource usage of this process from /proc.
+ */
+static void sampleProcess(processSample_t* pSample)
+{
+    FILE* fp = NULL;
+    DIR* pDir = NULL;
+    struct dirent* pEntry = NULL;
+    char line[128];
+    long pages = 0;
+
+    memset(pSample, 0, sizeof(processSample_t));
+
+    pSample->time = benchPlayer_now();
+    pSample->cpu = cpuTime();
+
+    fp = fopen("/proc/self/statm", "r");
+    if(fp != NULL)
+    {
+        if(fscanf(fp, "%*d %ld", &pages) == 1)
+        {
+            pSample->rssKB = pages * (sysconf(_SC_PAGESIZE) / 1024);
+        }
+        fclose(fp);
+    }
+
+    fp = fopen("/proc/self/status", "r");
+    if(fp != NULL)
+    {
+        while(fgets(line, sizeof(line), fp) != NULL)
+        {
+            if(sscanf(line, "Threads: %d", &(pSample->numThreads)) == 1)
+            {
+                break;
+            }
+        }
+        fclose(fp);
+    }
+
+    pDir = opendir("/proc/self/fd");
+    if(pDir != NULL)
+    {
+        while((pEntry = readdir(pDir)) != NULL)
+        {
+            if(pEntry->d_name[0] != '.')
+            {
+                pSample->numFds++;
+            }
+        }
+        closedir(pDir);
+
+        /* Don't count the descriptor used to read the directory */
+        pSample->numFds--;
+    }
+}
+
+/**
+ * Many real-time live sessions over a long period.  Samples the
+ * process every sampleInterval seconds and, if churnInterval is
+ * set, restarts one session (round robin) every churnInterval
+ * seconds so that the open and close paths are soaked too.
+ */
+static void scenarioScale(benchContext_t* pContext)
+{
+    benchSession_t sessions[BENCH_MAX_SAMPLES];
+    benchPlayerCounters_t counters;
+    srcPluginStats_t stats;
+    srcPluginGetData_t getData;
+    srcPluginErr_t error;
+    processSample_t first;
+    processSample_t last;
+    processSample_t sample;
+    double nextSample = 0;
+    double nextChurn = 0;
+    double lockWait = 0;
+    double lockWaitMax = 0;
+    unsigned int numLockWaits = 0;
+    unsigned int numStalls = 0;
+    unsigned int numErrors = 0;
+    unsigned int numRestarts = 0;
+    unsigned int numFailures = 0;
+    int numSessions = pContext->numSessions;
+    int churnIndex = 0;
+    int i = 0;
+
+    if(numSessions > BENCH_MAX_SAMPLES)
+    {
+        numSessions = BENCH_MAX_SAMPLES;
+    }
+
+    for(i = 0; i < numSessions; i++)
+    {
+        if(sessionStart(pContext, 1, 1, &(sessions[i])) != HLS_OK)
+        {
+            numFailures++;
+        }
+    }
+
+    for(i = 0; i < numSessions; i++)
+    {
+        if(sessions[i].pPlayer != NULL)
+        {
+            benchPlayer_waitFirstBuffer(sessions[i].pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, NULL);
+        }
+    }
+
+    sampleProcess(&first);
+    last = first;
+    nextSample = first.time + pContext->sampleInterval;
+    nextChurn = first.time + pContext->churnInterval;
+
+    while(last.time - first.time < pContext->scaleDuration)
+    {
+        hlsClock_sleep(1000000);
+
+        if(pContext->churnInterval && (benchPlayer_now() >= nextChurn))
+        {
+            sessionStop(pContext, &(sessions[churnIndex]));
+            if(sessionStart(pContext, 1, 1, &(sessions[churnIndex])) != HLS_OK)
+            {
+                numFailures++;
+            }
+            numRestarts++;
+            churnIndex = (churnIndex + 1) % numSessions;
+            nextChurn += pContext->churnInterval;
+        }
+
+        if(benchPlayer_now() < nextSample)
+        {
+            continue;
+        }
+
+        sampleProcess(&sample);
+
+        numLockWaits = 0;
+        lockWait = 0;
+        lockWaitMax = 0;
+        numStalls = 0;
+        numErrors = 0;
+
+        for(i = 0; i < numSessions; i++)
+        {
+            if(sessions[i].sessionId == NULL)
+            {
+                continue;
+            }
+
+            benchPlayer_getCounters(sessions[i].pPlayer, &counters);
+            numStalls += counters.numStalls;
+            numErrors += counters.numErrors;
+
+            getData.getCode = SRC_PLUGIN_GET_STATS;
+            getData.pData = &stats;
+            if(pContext->plugin.get(sessions[i].sessionId, &getData, &error) == SRC_SUCCESS)
+            {
+                numLockWaits += stats.playlistLockWait.numSamples;
+                lockWait += stats.playlistLockWait.sum;
+                if(stats.playlistLockWait.max > lockWaitMax)
+                {
+                    lockWaitMax = stats.playlistLockWait.max;
+                }
+            }
+        }
+
+        fprintf(pContext->fpResults,
+                "%-12s t=%.0fs cpu=%.3f%%/session rss=%ldkB fds=%d threads=%d lock_waits=%u lock_wait=%.1fms lock_wait_max=%.1fms stalls=%u errors=%u\n",
+                "scale", sample.time - first.time,
+                ((sample.cpu - last.cpu) / (sample.time - last.time) / numSessions) * 100,
+                sample.rssKB, sample.numFds, sample.numThreads,
+                numLockWaits, lockWait, lockWaitMax, numStalls, numErrors);
+        fflush(pContext->fpResults);
+
+        last = sample;
+        nextSample += pContext->sampleInterval;
+    }
+
+    for(i = 0; i < numSessions; i++)
+    {
+        sessionStop(pContext, &(sessions[i]));
+    }
+
+    report(pContext, "scale", "sessions", numSessions, "");
+    report(pContext, "scale", "per_session_cpu", ((last.cpu - first.cpu) / (last.time - first.time) / numSessions) * 100, "% of a core");
+    report(pContext, "scale", "rss_growth", last.rssKB - first.rssKB, "kB");
+    report(pContext, "scale", "fd_growth", last.numFds - first.numFds, "");
+    report(pContext, "scale", "thread_growth", last.numThreads - first.numThreads, "");
+    report(pContext, "scale", "lock_wait_max", lockWaitMax, "ms");
+    report(pContext, "scale", "restarts", numRestarts, "");
+    report(pContext, "scale", "start_failures", numFailures, "");
+}
+
+/*! A result of the shaped scenario that expectations can refer to */
+typedef struct {
+    const char* pName;
+    double value;
+    const char* pUnit;
+} shapedMetric_t;
+
+/**
+ * One real-time session through the shaping proxy.  Plays for the
+ * scenario duration (or to EOF), reports what the player, plugin and
+ * proxy saw, then checks the scenario expectations against it.
+ */
+static void scenarioShaped(benchContext_t* pContext)
+{
+    benchShaperScenario_t* pScenario = &(pContext->shaperScenario);
+    benchSession_t session;
+    benchPlayerCounters_t counters;
+    benchShaperCounters_t shaperCounters;
+    srcPluginStats_t stats;
+    srcPluginGetData_t getData;
+    srcPluginErr_t error;
+    shapedMetric_t metrics[16];
+    double firstBufferTime = 0;
+    double startTime = 0;
+    int duration = (pScenario->duration > 0) ? pScenario->duration : pContext->duration;
+    int numMetrics = 0;
+    int bPassed = 0;
+    int i = 0;
+    int j = 0;
+
+    memset(&counters, 0, sizeof(counters));
+    memset(&stats, 0, sizeof(stats));
+
+    if(benchShaper_start(pScenario, benchOrigin_getPort(pContext->pOrigin), &(pContext->pShaper)) != HLS_OK)
+    {
+        report(pContext, "shaped", "start_failed", 1, "");
+        pContext->numFailures++;
+        return;
+    }
+
+    if(sessionStart(pContext, pScenario->bLive, 1, &session) == HLS_OK)
+    {
+        if(benchPlayer_waitFirstBuffer(session.pPlayer, BENCH_FIRST_BUFFER_TIMEOUT_MSECS, &firstBufferTime) != HLS_OK)
+        {
+            firstBufferTime = 0;
+        }
+
+        startTime = benchPlayer_now();
+        do
+        {
+            hlsClock_sleep(1000000);
+            benchPlayer_getCounters(session.pPlayer, &counters);
+        } while(!counters.bEOF && (benchPlayer_now() - startTime < duration));
+
+        getData.getCode = SRC_PLUGIN_GET_STATS;
+        getData.pData = &stats;
+        pContext->plugin.get(session.sessionId, &getData, &error);
+    }
+    sessionStop(pContext, &session);
+
+    benchShaper_getCounters(pContext->pShaper, &shaperCounters);
+    benchShaper_stop(pContext->pShaper);
+    pContext->pShaper = NULL;
+
+    metrics[numMetrics].pName = "first_buffer";
+    metrics[numMetrics].value = (firstBufferTime > 0) ? (firstBufferTime - session.openTime) * 1000 : -1;
+    metrics[numMetrics++].pUnit = "ms";
+    metrics[numMetrics].pName = "play_time";
+    metrics[numMetrics].value = counters.playTime;
+    metrics[numMetrics++].pUnit = "s";
+    metrics[numMetrics].pName = "stalls";
+    metrics[numMetrics].value = counters.numStalls;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "stall_time";
+    metrics[numMetrics].value = counters.stallTime;
+    metrics[numMetrics++].pUnit = "s";
+    metrics[numMetrics].pName = "switches";
+    metrics[numMetrics].value = counters.numBitrateSwitches;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "final_bitrate";
+    metrics[numMetrics].value = counters.currentBitrate;
+    metrics[numMetrics++].pUnit = "bps";
+    metrics[numMetrics].pName = "errors";
+    metrics[numMetrics].value = counters.numErrors;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "eof";
+    metrics[numMetrics].value = counters.bEOF;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "segments";
+    metrics[numMetrics].value = stats.numSegments;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "segment_retries";
+    metrics[numMetrics].value = stats.numSegmentRetries;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "segment_errors";
+    metrics[numMetrics].value = stats.numSegmentErrors;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "playlist_reloads";
+    metrics[numMetrics].value = stats.numPlaylistReloads;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "injected_errors";
+    metrics[numMetrics].value = shaperCounters.numErrors;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "injected_resets";
+    metrics[numMetrics].value = shaperCounters.numResets;
+    metrics[numMetrics++].pUnit = "";
+    metrics[numMetrics].pName = "injected_stalls";
+    metrics[numMetrics].value = shaperCounters.numStalls;
+    metrics[numMetrics++].pUnit = "";
+
+    for(i = 0; i < numMetrics; i++)
+    {
+        report(pContext, "shaped", metrics[i].pName, metrics[i].value, metrics[i].pUnit);
+    }
+
+    for(i = 0; i < pScenario->numExpects; i++)
+    {
+        for(j = 0; (j < numMetrics) && (strcmp(metrics[j].pName, pScenario->expects[i].metric) != 0); j++);
+
+        bPassed = (j < numMetrics) && benchShaper_check(&(pScenario->expects[i]), metrics[j].value);
+        if(!bPassed)
+        {
+            pContext->numFailures++;
+        }
+
+        fprintf(pContext->fpResults, "%-12s expect %s %s %g: %s\n", "shaped",
+                pScenario->expects[i].metric, pScenario->expects[i].op, pScenario->expects[i].value,
+                (j == numMetrics) ? "UNKNOWN METRIC" : (bPassed ? "ok" : "FAILED"));
+        fflush(pContext->fpResults);
+    }
+}
+
+/**
+ * Parses a comma separated list of bitrates into the origin
+ * configuration.
+ */
+static hlsStatus_t parseBitrates(char* pList, benchOriginConfig_t* pConfig)
+{
+    char* pToken = NULL;
+    char* pSave = NULL;
+
+    pConfig->numVariants = 0;
+
+    for(pToken = strtok_r(pList, ",", &pSave); pToken != NULL; pToken = strtok_r(NULL, ",", &pSave))
+    {
+        if((pConfig->numVariants >= BENCH_ORIGIN_MAX_VARIANTS) || (atoi(pToken) <= 0))
+        {
+            return HLS_INVALID_PARAMETER;
+        }
+        pConfig->bitrates[pConfig->numVariants++] = atoi(pToken);
+    }
+
+    return (pConfig->numVariants > 0) ? HLS_OK : HLS_INVALID_PARAMETER;
+}
+
+static void usage(const char* pName)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -s <scenario>   ttfb, throughput, cpu, seek, scale, shaped or all (default all)\n"
+            "  -r <runs>       samples per measurement (default 5)\n"
+            "  -n <sessions>   concurrent sessions for cpu (default 4)\n"
+            "  -d <seconds>    length of cpu, and of shaped unless the scenario says (default 20)\n"
+            "  -D <seconds>    length of scale (default 60)\n"
+            "  -i <seconds>    time between scale samples (default 10)\n"
+            "  -k <seconds>    restart a scale session every so often (default 0, never)\n"
+            "  -b <bitrates>   comma separated variant bitrates in bps (default 800000,2000000,4000000)\n"
+            "  -t <seconds>    segment duration (default 2)\n"
+            "  -c <segments>   VOD length in segments (default 60)\n"
+            "  -w <segments>   live window in segments (default 6)\n"
+            "  -p <file>       shaping scenario file (see benchShaper.h); enables shaped\n"
+            "  -x <factor>     run the library clock this many times faster than real time\n"
+            "  -z              have the plugin lend its download buffers to the player\n"
+            "                  instead of copying them (SRC_PLUGIN_SET_LEND_BUFFER)\n"
+            "  -o <file>       write results to file instead of stderr\n",
+            pName);
+}
+
+int main(int argc, char** argv)
+{
+    benchContext_t context;
+    srcPluginErr_t error;
+    const char* pScenario = "all";
+    char defaultBitrates[] = "800000,2000000,4000000";
+    char maxSessions[16];
+    const char* pShaperFile = NULL;
+    double speed = 0;
+    int bAll = 0;
+    int option = 0;
+    int rval = 0;
+
+    memset(&context, 0, sizeof(context));
+    context.fpResults = stderr;
+    context.numRuns = 5;
+    context.numSessions = 4;
+    context.duration = 20;
+    context.scaleDuration = 60;
+    context.sampleInterval = 10;
+    context.originConfig.segmentDuration = 2;
+    context.originConfig.numSegments = 60;
+    context.originConfig.liveWindow = 6;
+    parseBitrates(defaultBitrates, &(context.originConfig));
+
+    while((option = getopt(argc, argv, "s:r:n:d:D:i:k:b:t:c:w:p:x:zo:h")) != -1)
+    {
+        switch(option)
+        {
+            case 's':
+                pScenario = optarg;
+                break;
+            case 'r':
+                context.numRuns = atoi(optarg);
+                break;
+            case 'n':
+                context.numSessions = atoi(optarg);
+                break;
+            case 'd':
+                context.duration = atoi(optarg);
+                break;
+            case 'D':
+                context.scaleDuration = atoi(optarg);
+                break;
+            case 'i':
+                context.sampleInterval = atoi(optarg);
+                break;
+            case 'k':
+                context.churnInterval = atoi(optarg);
+                break;
+            case 'b':
+                if(parseBitrates(optarg, &(context.originConfig)) != HLS_OK)
+                {
+                    usage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 't':
+                context.originConfig.segmentDuration = atof(optarg);
+                break;
+            case 'c':
+                context.originConfig.numSegments = atoi(optarg);
+                break;
+            case 'w':
+                context.originConfig.liveWindow = atoi(optarg);
+                break;
+            case 'p':
+                pShaperFile = optarg;
+                break;
+            case 'x':
+                speed = atof(optarg);
+                break;
+            case 'z':
+                context.bLend = 1;
+                break;
+            case 'o':
+                context.fpResults = fopen(optarg, "w");
+                if(context.fpResults == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if((context.numRuns <= 0) || (context.numRuns > BENCH_MAX_SAMPLES) ||
+       (context.numSessions <= 0) || (context.duration <= 0) ||
+       (context.scaleDuration <= 0) || (context.sampleInterval <= 0) || (context.churnInterval < 0) ||
+       (speed < 0) || (speed > HLS_CLOCK_MAX_SCALE))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(pShaperFile != NULL)
+    {
+        if(benchShaper_load(pShaperFile, &(context.shaperScenario)) != HLS_OK)
+        {
+            fprintf(stderr, "bad scenario file %s\n", pShaperFile);
+            return 1;
+        }
+    }
+    else if(strcmp(pScenario, "shaped") == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Everything runs in session time from here on, including the origin's live window */
+    if(speed == 0)
+    {
+        speed = context.shaperScenario.speed;
+    }
+    if((speed > 0) && (hlsClock_setScale(speed) != HLS_OK))
+    {
+        return 1;
+    }
+
+    bAll = (strcmp(pScenario, "all") == 0);
+
+    /* Make room for the cpu sessions, unless the caller sized the table */
+    if(context.numSessions > MAX_SESSIONS)
+    {
+        snprintf(maxSessions, sizeof(maxSessions), "%d", context.numSessions);
+        setenv("HLS_MAX_SESSIONS", maxSessions, 0);
+    }
+
+    do
+    {
+        if(benchOrigin_start(&(context.originConfig), &(context.pOrigin)) != HLS_OK)
+        {
+            rval = 1;
+            break;
+        }
+
+        benchPlayer_getFuncTable(&(context.player));
+
+        if((srcPluginLoad(&(context.plugin), &(context.player), &error) != SRC_SUCCESS) ||
+           (context.plugin.initialize(&error) != SRC_SUCCESS) ||
+           (context.plugin.registerCB(benchPlayer_pluginEvtCallback, benchPlayer_pluginErrCallback, &error) != SRC_SUCCESS))
+        {
+            ERROR("failed to start plugin: %s", error.errMsg);
+            rval = 1;
+            break;
+        }
+
+        if(bAll || (strcmp(pScenario, "ttfb") == 0))
+        {
+            scenarioTTFB(&context);
+        }
+        if(bAll || (strcmp(pScenario, "throughput") == 0))
+        {
+            scenarioThroughput(&context);
+        }
+        if(bAll || (strcmp(pScenario, "cpu") == 0))
+        {
+            scenarioCPU(&context);
+        }
+        if(bAll || (strcmp(pScenario, "seek") == 0))
+        {
+            scenarioSeek(&context);
+        }
+        if(bAll || (strcmp(pScenario, "scale") == 0))
+        {
+            scenarioScale(&context);
+        }
+        if((pShaperFile != NULL) && (bAll || (strcmp(pScenario, "shaped") == 0)))
+        {
+            scenarioShaped(&context);
+        }
+
+        context.plugin.finalize(&error);
+        srcPluginUnload(&error);
+
+    } while(0);
+
+    benchOrigin_stop(context.pOrigin);
+
+    if(context.fpResults != stderr)
+    {
+        fclose(context.fpResults);
+    }
+
+    if((rval == 0) && (context.numFailures > 0))
+    {
+        rval = 2;
+    }
+
+    return rval;
+}
@@ -0,0 +1,684 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file parseBench.c @date October 19, 2026
+ *
+ * Playlist parser micro-benchmarks.
+ *
+ * Generates m3u8 corpora of different shapes and sizes under a
+ * corpus directory and times m3u8ParsePlaylist() on them through
+ * file:// URLs:
+ *
+ *   variant  - first parse of variant playlists with many renditions
+ *              and EXT-X-MEDIA audio groups
+ *   media    - first parse of media playlists from 10 to 100k
+ *              segments, clear and with byte ranges, rotating keys,
+ *              PROGRAM-DATE-TIME and discontinuities
+ *   reload   - the update path (m3u8UpdateMediaPlaylist()) on a live
+ *              window that moves on by one segment per reload
+ *
+ * Each measurement is the median of several runs and is reported as
+ * ns per playlist line and heap allocations per segment (or per
+ * rendition for variant playlists).  The time includes fetching the
+ * file:// URL into LOCAL_PATH and whatever the build's DBG_LEVEL
+ * logs, as every real parse does; redirect stdout to keep the log off
+ * the terminal.
+ *
+ * Allocations are counted by interposing malloc() and friends.
+ * libcurl is given uncounted allocators so that only the parser's
+ * own allocations show up.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <getopt.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+#include "hlsTypes.h"
+#include "hlsSession.h"
+#include "hlsSessionUtils.h"
+#include "m3u8ParseUtils.h"
+
+/* Maximum number of runs per measurement */
+#define PARSE_BENCH_MAX_RUNS 64
+
+/* Segments between key rotations in the "keys" corpus */
+#define PARSE_BENCH_KEY_INTERVAL 10
+
+/* Segments between discontinuities in the "discontinuity" corpus */
+#define PARSE_BENCH_DISCONTINUITY_INTERVAL 50
+
+/* Audio renditions in every variant playlist */
+#define PARSE_BENCH_NUM_AUDIO 4
+
+/*! A media playlist to generate */
+typedef struct {
+    const char* pName;
+    int bByteRange;                 /*!< Segments are ranges of one file */
+    int bKeys;                      /*!< New EXT-X-KEY every PARSE_BENCH_KEY_INTERVAL segments */
+    int bDateTime;                  /*!< EXT-X-PROGRAM-DATE-TIME on every segment */
+    int bDiscontinuities;           /*!< EXT-X-DISCONTINUITY every PARSE_BENCH_DISCONTINUITY_INTERVAL segments */
+} parseBenchCorpus_t;
+
+/*! Benchmark run state */
+typedef struct {
+    hlsSession_t* pSession;         /*!< Session the parser runs on */
+    char corpusDir[PATH_MAX];       /*!< Absolute path of the corpus directory */
+    FILE* fpResults;                /*!< Where results are written */
+    int numRuns;                    /*!< Samples per measurement */
+    int maxSegments;                /*!< Largest media playlist */
+} parseBenchContext_t;
+
+static parseBenchCorpus_t parseBenchCorpora[] = {
+    { "clear", 0, 0, 0, 0 },
+    { "byterange", 1, 0, 0, 0 },
+    { "keys", 0, 1, 0, 0 },
+    { "datetime", 0, 0, 1, 0 },
+    { "discont", 0, 0, 0, 1 },
+    { "mixed", 1, 1, 1, 1 },
+};
+
+#define PARSE_BENCH_NUM_CORPORA (sizeof(parseBenchCorpora) / sizeof(parseBenchCorpora[0]))
+
+/*
+ * Allocation counting
+ */
+
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static volatile int bCountAllocs = 0;
+static unsigned long numAllocs = 0;
+
+void* malloc(size_t size)
+{
+    if(bCountAllocs)
+    {
+        __sync_fetch_and_add(&numAllocs, 1);
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size)
+{
+    if(bCountAllocs)
+    {
+        __sync_fetch_and_add(&numAllocs, 1);
+    }
+    return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    if(bCountAllocs)
+    {
+        __sync_fetch_and_add(&numAllocs, 1);
+    }
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+static char* uncountedStrdup(const char* pString)
+{
+    char* pCopy = __libc_malloc(strlen(pString) + 1);
+
+    if(pCopy != NULL)
+    {
+        strcpy(pCopy, pString);
+    }
+
+    return pCopy;
+}
+
+/*
+ * Corpus generation
+ */
+
+/**
+ * Writes a media playlist of numSegments segments starting at
+ * firstSeq and returns its number of lines, or -1 on error.
+ */
+static int writeMediaPlaylist(const char* pPath, parseBenchCorpus_t* pCorpus, int firstSeq, int numSegments, int bEndList)
+{
+    FILE* fp = NULL;
+    int numLines = 0;
+    int seq = 0;
+    long offset = 0;
+
+    fp = fopen(pPath, "w");
+    if(fp == NULL)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    numLines += fprintf(fp, "#EXTM3U\n") > 0;
+    numLines += fprintf(fp, "#EXT-X-VERSION:%d\n", pCorpus->bByteRange ? 4 : 3) > 0;
+    numLines += fprintf(fp, "#EXT-X-TARGETDURATION:10\n") > 0;
+    numLines += fprintf(fp, "#EXT-X-MEDIA-SEQUENCE:%d\n", firstSeq) > 0;
+
+    for(seq = firstSeq; seq < firstSeq + numSegments; seq++)
+    {
+        if(pCorpus->bKeys && ((seq % PARSE_BENCH_KEY_INTERVAL) == 0))
+        {
+            numLines += fprintf(fp, "#EXT-X-KEY:METHOD=AES-128,URI=\"key%d.bin\",IV=0x%032x\n",
+                                seq / PARSE_BENCH_KEY_INTERVAL, seq) > 0;
+        }
+        if(pCorpus->bDiscontinuities && (seq != firstSeq) && ((seq % PARSE_BENCH_DISCONTINUITY_INTERVAL) == 0))
+        {
+            numLines += fprintf(fp, "#EXT-X-DISCONTINUITY\n") > 0;
+        }
+        if(pCorpus->bDateTime)
+        {
+            numLines += fprintf(fp, "#EXT-X-PROGRAM-DATE-TIME:2026-10-19T%02d:%02d:%02d.000Z\n",
+                                (seq / 360) % 24, (seq / 6) % 60, (seq * 10) % 60) > 0;
+        }
+        numLines += fprintf(fp, "#EXTINF:10.010,\n") > 0;
+        if(pCorpus->bByteRange)
+        {
+            offset = (long)seq * 1253376;
+            numLines += fprintf(fp, "#EXT-X-BYTERANGE:1253376@%ld\n", offset) > 0;
+            numLines += fprintf(fp, "media.ts\n") > 0;
+        }
+        else
+        {
+            numLines += fprintf(fp, "segment%d.ts\n", seq) > 0;
+        }
+    }
+
+    if(bEndList)
+    {
+        numLines += fprintf(fp, "#EXT-X-ENDLIST\n") > 0;
+    }
+
+    if(fclose(fp) != 0)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    return numLines;
+}
+
+/**
+ * Writes a variant playlist with numVariants renditions sharing one
+ * group of PARSE_BENCH_NUM_AUDIO audio renditions and returns its
+ * number of lines, or -1 on error.
+ */
+static int writeVariantPlaylist(const char* pPath, int numVariants)
+{
+    static const char* languages[PARSE_BENCH_NUM_AUDIO] = { "eng", "fra", "deu", "spa" };
+    FILE* fp = NULL;
+    int numLines = 0;
+    int i = 0;
+
+    fp = fopen(pPath, "w");
+    if(fp == NULL)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    numLines += fprintf(fp, "#EXTM3U\n") > 0;
+    numLines += fprintf(fp, "#EXT-X-VERSION:4\n") > 0;
+
+    for(i = 0; i < PARSE_BENCH_NUM_AUDIO; i++)
+    {
+        numLines += fprintf(fp, "#EXT-X-MEDIA:TYPE=AUDIO,GROUP-ID=\"aac\",LANGUAGE=\"%s\",NAME=\"Audio %d\",DEFAULT=%s,AUTOSELECT=YES,URI=\"audio/%s/index.m3u8\"\n",
+                            languages[i], i, (i == 0) ? "YES" : "NO", languages[i]) > 0;
+    }
+
+    for(i = 0; i < numVariants; i++)
+    {
+        numLines += fprintf(fp, "#EXT-X-STREAM-INF:PROGRAM-ID=1,BANDWIDTH=%d,RESOLUTION=%dx%d,CODECS=\"avc1.64001f,mp4a.40.2\",AUDIO=\"aac\"\n",
+                            200000 + (i * 150000), 320 + (i * 16), 180 + (i * 9)) > 0;
+        numLines += fprintf(fp, "video/%d/index.m3u8\n", i) > 0;
+    }
+
+    if(fclose(fp) != 0)
+    {
+        perror(pPath);
+        return -1;
+    }
+
+    return numLines;
+}
+
+/*
+ * Measurement
+ */
+
+/**
+ * Writes one result line.
+ */
+static void report(parseBenchContext_t* pContext, const char* pScenario, const char* pMetric, double value, const char* pUnit)
+{
+    fprintf(pContext->fpResults, "%-12s %-28s %12.3f %s\n", pScenario, pMetric, value, pUnit);
+    fflush(pContext->fpResults);
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1000000000.0);
+}
+
+/**
+ * Runs m3u8ParsePlaylist() once on pPlaylist, counting the time and
+ * allocations it takes.
+ */
+static hlsStatus_t timeParse(parseBenchContext_t* pContext, hlsPlaylist_t* pPlaylist, double* pTime, unsigned long* pNumAllocs)
+{
+    hlsStatus_t rval = HLS_OK;
+    double start = 0;
+
+    numAllocs = 0;
+    bCountAllocs = 1;
+    start = now();
+
+    rval = m3u8ParsePlaylist(pPlaylist, pContext->pSession);
+
+    *pTime = now() - start;
+    bCountAllocs = 0;
+    *pNumAllocs = numAllocs;
+
+    return rval;
+}
+
+/**
+ * Returns a new, never parsed playlist pointing at pFile in the
+ * corpus directory.
+ */
+static hlsPlaylist_t* newPlaylist(parseBenchContext_t* pContext, const char* pFile)
+{
+    hlsPlaylist_t* pPlaylist = NULL;
+    char url[PATH_MAX + 16];
+
+    if(snprintf(url, sizeof(url), "file://%s/%s", pContext->corpusDir, pFile) >= (int)sizeof(url))
+    {
+        fprintf(stderr, "path of %s in %s is too long\n", pFile, pContext->corpusDir);
+        return NULL;
+    }
+
+    pPlaylist = newHlsPlaylist();
+    if(pPlaylist != NULL)
+    {
+        pPlaylist->playlistURL = strdup(url);
+        if(pPlaylist->playlistURL == NULL)
+        {
+            freePlaylist(pPlaylist);
+            pPlaylist = NULL;
+        }
+    }
+
+    return pPlaylist;
+}
+
+/**
+ * First parse of pFile, numRuns times.  Reports the medians under
+ * <pScenario> <pName>_*, with allocations divided by numItems.
+ */
+static void measureFirstParse(parseBenchContext_t* pContext, const char* pScenario, const char* pName,
+                              const char* pFile, int numLines, int numItems, const char* pItem)
+{
+    hlsPlaylist_t* pPlaylist = NULL;
+    double times[PARSE_BENCH_MAX_RUNS];
+    double allocs[PARSE_BENCH_MAX_RUNS];
+    unsigned long runAllocs = 0;
+    char metric[64];
+    char unit[32];
+    int numSamples = 0;
+    int i = 0;
+
+    for(i = 0; i < pContext->numRuns; i++)
+    {
+        pPlaylist = newPlaylist(pContext, pFile);
+        if(pPlaylist == NULL)
+        {
+            break;
+        }
+
+        if(timeParse(pContext, pPlaylist, &(times[numSamples]), &runAllocs) == HLS_OK)
+        {
+            allocs[numSamples++] = runAllocs;
+        }
+
+        freePlaylist(pPlaylist);
+    }
+
+    if(numSamples == 0)
+    {
+        snprintf(metric, sizeof(metric), "%s_failed", pName);
+        report(pContext, pScenario, metric, 1, "");
+        return;
+    }
+
+    qsort(times, numSamples, sizeof(double), compareDoubles);
+    qsort(allocs, numSamples, sizeof(double), compareDoubles);
+
+    snprintf(metric, sizeof(metric), "%s_ns_per_line", pName);
+    report(pContext, pScenario, metric, times[numSamples / 2] * 1000000000 / numLines, "ns");
+    snprintf(metric, sizeof(metric), "%s_allocs", pName);
+    snprintf(unit, sizeof(unit), "allocs/%s", pItem);
+    report(pContext, pScenario, metric, allocs[numSamples / 2] / numItems, unit);
+    snprintf(metric, sizeof(metric), "%s_total", pName);
+    report(pContext, pScenario, metric, times[numSamples / 2] * 1000, "ms");
+}
+
+/**
+ * First parse of variant playlists of 4 to 256 renditions.
+ */
+static void benchVariant(parseBenchContext_t* pContext)
+{
+    char file[64];
+    char name[32];
+    char path[PATH_MAX + 64];
+    int numVariants = 0;
+    int numLines = 0;
+
+    for(numVariants = 4; numVariants <= 256; numVariants *= 4)
+    {
+        snprintf(file, sizeof(file), "variant_%d.m3u8", numVariants);
+        snprintf(path, sizeof(path), "%s/%s", pContext->corpusDir, file);
+        snprintf(name, sizeof(name), "renditions_%d", numVariants);
+
+        numLines = writeVariantPlaylist(path, numVariants);
+        if(numLines > 0)
+        {
+            measureFirstParse(pContext, "variant", name, file, numLines,
+                              numVariants + PARSE_BENCH_NUM_AUDIO, "rendition");
+        }
+    }
+}
+
+/**
+ * First parse of VOD media playlists: every corpus at 1000
+ * segments, and the clear corpus from 10 to maxSegments.
+ */
+static void benchMedia(parseBenchContext_t* pContext)
+{
+    char file[64];
+    char name[32];
+    char path[PATH_MAX + 64];
+    int numSegments = 0;
+    int numLines = 0;
+    unsigned int i = 0;
+
+    for(i = 0; i < PARSE_BENCH_NUM_CORPORA; i++)
+    {
+        for(numSegments = 10; numSegments <= pContext->maxSegments; numSegments *= 10)
+        {
+            if((i != 0) && (numSegments != 1000))
+            {
+                continue;
+            }
+
+            snprintf(file, sizeof(file), "%s_%d.m3u8", parseBenchCorpora[i].pName, numSegments);
+            snprintf(path, sizeof(path), "%s/%s", pContext->corpusDir, file);
+            snprintf(name, sizeof(name), "%s_%d", parseBenchCorpora[i].pName, numSegments);
+
+            numLines = writeMediaPlaylist(path, &(parseBenchCorpora[i]), 0, numSegments, 1);
+            if(numLines > 0)
+            {
+                measureFirstParse(pContext, "media", name, file, numLines, numSegments, "segment");
+            }
+        }
+    }
+}
+
+/**
+ * Reloads of live windows of 10 to 10000 segments (capped at
+ * maxSegments).  Each reload sees one new segment at the end of the
+ * window and loses one at the start.
+ */
+static void benchReload(parseBenchContext_t* pContext)
+{
+    hlsPlaylist_t* pPlaylist = NULL;
+    double times[PARSE_BENCH_MAX_RUNS];
+    double allocs[PARSE_BENCH_MAX_RUNS];
+    double runTime = 0;
+    unsigned long runAllocs = 0;
+    char file[64];
+    char metric[64];
+    char path[PATH_MAX + 64];
+    int windowSize = 0;
+    int numLines = 0;
+    int numSamples = 0;
+    int i = 0;
+
+    for(windowSize = 10; (windowSize <= 10000) && (windowSize <= pContext->maxSegments); windowSize *= 10)
+    {
+        snprintf(file, sizeof(file), "live_%d.m3u8", windowSize);
+        snprintf(path, sizeof(path), "%s/%s", pContext->corpusDir, file);
+
+        numSamples = 0;
+
+        do
+        {
+            if(writeMediaPlaylist(path, &(parseBenchCorpora[0]), 0, windowSize, 0) <= 0)
+            {
+                break;
+            }
+
+            pPlaylist = newPlaylist(pContext, file);
+            if(pPlaylist == NULL)
+            {
+                break;
+            }
+
+            if(timeParse(pContext, pPlaylist, &runTime, &runAllocs) != HLS_OK)
+            {
+                break;
+            }
+
+            for(i = 1; i <= pContext->numRuns; i++)
+            {
+                numLines = writeMediaPlaylist(path, &(parseBenchCorpora[0]), i, windowSize, 0);
+                if(numLines <= 0)
+                {
+                    break;
+                }
+
+                /* Make sure we take the update path */
+                if(pPlaylist->nextReloadTime.tv_nsec == 0)
+                {
+                    pPlaylist->nextReloadTime.tv_nsec = 1;
+                }
+
+                if(timeParse(pContext, pPlaylist, &runTime, &runAllocs) != HLS_OK)
+                {
+                    break;
+                }
+
+                times[numSamples] = runTime;
+                allocs[numSamples] = runAllocs;
+                numSamples++;
+            }
+
+        } while(0);
+
+        freePlaylist(pPlaylist);
+        pPlaylist = NULL;
+
+        if(numSamples == 0)
+        {
+            snprintf(metric, sizeof(metric), "window_%d_failed", windowSize);
+            report(pContext, "reload", metric, 1, "");
+            continue;
+        }
+
+        qsort(times, numSamples, sizeof(double), compareDoubles);
+        qsort(allocs, numSamples, sizeof(double), compareDoubles);
+
+        snprintf(metric, sizeof(metric), "window_%d_ns_per_line", windowSize);
+        report(pContext, "reload", metric, times[numSamples / 2] * 1000000000 / numLines, "ns");
+        snprintf(metric, sizeof(metric), "window_%d_allocs", windowSize);
+        report(pContext, "reload", metric, allocs[numSamples / 2] / windowSize, "allocs/segment");
+        snprintf(metric, sizeof(metric), "window_%d_total", windowSize);
+        report(pContext, "reload", metric, times[numSamples / 2] * 1000, "ms");
+    }
+}
+
+static void usage(const char* pName)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -s <scenario>   variant, media, reload or all (default all)\n"
+            "  -r <runs>       samples per measurement (default 5, at most %d)\n"
+            "  -m <segments>   largest media playlist (default 100000)\n"
+            "  -d <dir>        corpus directory (default parse-corpus)\n"
+            "  -o <file>       write results to file instead of stderr\n",
+            pName, PARSE_BENCH_MAX_RUNS);
+}
+
+int main(int argc, char** argv)
+{
+    parseBenchContext_t context;
+    const char* pScenario = "all";
+    const char* pCorpusDir = "parse-corpus";
+    int bAll = 0;
+    int option = 0;
+    int rval = 0;
+
+    memset(&context, 0, sizeof(context));
+    context.fpResults = stderr;
+    context.numRuns = 5;
+    context.maxSegments = 100000;
+
+    while((option = getopt(argc, argv, "s:r:m:d:o:h")) != -1)
+    {
+        switch(option)
+        {
+            case 's':
+                pScenario = optarg;
+                break;
+            case 'r':
+                context.numRuns = atoi(optarg);
+                break;
+            case 'm':
+                context.maxSegments = atoi(optarg);
+                break;
+            case 'd':
+                pCorpusDir = optarg;
+                break;
+            case 'o':
+                context.fpResults = fopen(optarg, "w");
+                if(context.fpResults == NULL)
+                {
+                    perror(optarg);
+                    return 1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if((context.numRuns <= 0) || (context.numRuns > PARSE_BENCH_MAX_RUNS) || (context.maxSegments < 10))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    bAll = (strcmp(pScenario, "all") == 0);
+
+    do
+    {
+        if((mkdir(pCorpusDir, S_IRWXU) != 0) && (errno != EEXIST))
+        {
+            perror(pCorpusDir);
+            rval = 1;
+            break;
+        }
+        if(realpath(pCorpusDir, context.corpusDir) == NULL)
+        {
+            perror(pCorpusDir);
+            rval = 1;
+            break;
+        }
+
+        /* Keep libcurl's allocations out of the counts */
+        if(curl_global_init_mem(CURL_GLOBAL_ALL, __libc_malloc, __libc_free, __libc_realloc,
+                                uncountedStrdup, __libc_calloc) != CURLE_OK)
+        {
+            fprintf(stderr, "curl_global_init_mem() failed\n");
+            rval = 1;
+            break;
+        }
+
+        /* The session only supplies the cURL handle and locks */
+        if(hlsSession_init(&(context.pSession), &context) != HLS_OK)
+        {
+            fprintf(stderr, "hlsSession_init() failed\n");
+            rval = 1;
+            break;
+        }
+
+        if(bAll || (strcmp(pScenario, "variant") == 0))
+        {
+            benchVariant(&context);
+        }
+        if(bAll || (strcmp(pScenario, "media") == 0))
+        {
+            benchMedia(&context);
+        }
+        if(bAll || (strcmp(pScenario, "reload") == 0))
+        {
+            benchReload(&context);
+        }
+
+        hlsSession_term(context.pSession);
+
+    } while(0);
+
+    curl_global_cleanup();
+
+    if(context.fpResults != stderr)
+    {
+        fclose(context.fpResults);
+    }
+
+    return rval;
+}
@@ -36,6 +36,7 @@ extern "C" {
 #include <stdio.h>
 
 #include "adaptech.h"
+#include "hlsClock.h"
 #include "debug.h"
 
 #define SEC(X) (X.tv_sec)
@@ -59,11 +60,57 @@ extern "C" {
                                    // the Adaptec research paper used 0.8; however we adjusted it down to 0.5 due to increased
                                    // segment size (we use 10 second segments, vs. the 3 second segments in the example player)
 
+static int abrClientDefaultClock(struct timespec* pNow);
+
+/* Tuning in use; starts out as the values above */
+static abrClientParams_t abrParams = {
+    SLACKFACTOR,
+    AVG_WEIGHT,
+    LOW_BUFF_LVL,
+    NORMAL_BUFF_LVL,
+    CAN_SWITCH_UP_THRESHOLD,
+    RAMPUPTHRESHOLD
+};
+
+/* Source of "now" for the ramp-up and can-switch-up timers */
+static abrClientClockFunc_t abrClock = abrClientDefaultClock;
+
+static int abrClientDefaultClock(struct timespec* pNow)
+{
+    return hlsClock_now(pNow);
+}
+
+// Replaces the clock used for the ramp-up and can-switch-up timers, so that the
+// algorithm can be driven in simulated time.  NULL restores the library clock.
+void abrClientSetClock(abrClientClockFunc_t pClockFunc)
+{
+    abrClock = (pClockFunc != NULL) ? pClockFunc : abrClientDefaultClock;
+}
+
+// Returns the tuning currently in use.
+void abrClientGetParams(abrClientParams_t* pParams)
+{
+    if(pParams != NULL)
+    {
+        *pParams = abrParams;
+    }
+}
+
+// Replaces the tuning.  These are process-wide and not locked, so only change them
+// while no session is running (i.e. from a simulator or before the first open).
+void abrClientSetParams(const abrClientParams_t* pParams)
+{
+    if(pParams != NULL)
+    {
+        abrParams = *pParams;
+    }
+}
+
 // Returns the average segment download rate after adding the specified single download rate to the average.
 // The formula used here is an exponentially weighted moving average as specified in the Adaptech algorithm.
 float abrClientAddThroughputToAvg(float lastSegmentDldRate, float avgSegmentDldRate)
 {
-    return ((1 - AVG_WEIGHT) * lastSegmentDldRate) + (AVG_WEIGHT * avgSegmentDldRate);
+    return ((1 - abrParams.avgWeight) * lastSegmentDldRate) + (abrParams.avgWeight * avgSegmentDldRate);
 }
 
 //Returns the index of the maximum nominal bitrate that is smaller than the avail-bw
@@ -227,7 +274,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
     uiCurBitrateIndex = abrClientGetIndexFromBitrate(currentBitrate, bitratesSize, bitrates);
 
     //Calculate time since playback started
-    clock_gettime(CLOCK_MONOTONIC, &nowTime);
+    abrClock(&nowTime);
     //DEBUG(DBG_INFO, "!!!!!!!!!!!!!!!!!SEC %ld, SECPTR %ld", SEC(nowTime), SECPTR(startTimeStamp));
     playbackTime = (float)(SEC(nowTime) - SECPTR(startTimeStamp));
     //DEBUG(DBG_INFO, "!!!!!!!!!!!!!!!!!Float of playbackTime: %f", playbackTime);
@@ -238,18 +285,18 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
     DEBUG(DBG_NOISE, "avgFragThroughput = %f ", avgFragmentThroughput);
     DEBUG(DBG_NOISE, "bufferLength = %f ", bufferLength);
     DEBUG(DBG_NOISE, "curBitrateIndex = %d ", uiCurBitrateIndex);
-    DEBUG(DBG_NOISE, "Are we within Ramp-up period? = %s", (playbackTime < RAMPUPTHRESHOLD) ? "TRUE" : "FALSE");
+    DEBUG(DBG_NOISE, "Are we within Ramp-up period? = %s", (playbackTime < abrParams.rampUpThreshold) ? "TRUE" : "FALSE");
     DEBUG(DBG_NOISE, "################################");
 
     /* Latest Version Logic */
 
-    if(bufferLength >= NORMAL_BUFF_LVL) //if theta2 < Beta(t) < Betamax then:
+    if(bufferLength >= abrParams.normalBufferLevel) //if theta2 < Beta(t) < Betamax then:
     {
         // Write phi2 into candidateBitrateIndex.  phi1 based on avgFragmentThroughput.
-        candidateBitrateIndex = abrClientGetBitrateIndex((SLACKFACTOR * avgFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
+        candidateBitrateIndex = abrClientGetBitrateIndex((abrParams.slackFactor * avgFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
         DEBUG(DBG_INFO, "current max possible bitrate based on average throughput: %d ", bitrates[candidateBitrateIndex]);
 
-        DEBUG(DBG_INFO, "bufferLength %f >= %d", bufferLength, NORMAL_BUFF_LVL);
+        DEBUG(DBG_INFO, "bufferLength %f >= %d", bufferLength, abrParams.normalBufferLevel);
         if(candidateBitrateIndex <= uiCurBitrateIndex) // phi2 <= phicur
         {
             proposedIndex = uiCurBitrateIndex; //Do nothing
@@ -258,9 +305,9 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
         else // phi2 > phicur
         {
             // Write phi1 into candidateBitrateIndex (Overwriting phi2) phi1 based on lastFragmentThroughput.
-            candidateBitrateIndex = abrClientGetBitrateIndex((SLACKFACTOR * lastFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
+            candidateBitrateIndex = abrClientGetBitrateIndex((abrParams.slackFactor * lastFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
             //Calculate time since last bitrate increase
-            clock_gettime(CLOCK_MONOTONIC, &nowTime);
+            abrClock(&nowTime);
             //DEBUG(DBG_INFO, "!!!!!!!!!!!!!!!!!nowTimeSec: %ld prevIncSec: %ld", nowTime.tv_sec, previousIncreaseTimeStamp->tv_sec);
             //DEBUG(DBG_INFO, "!!!!!!!!!!!!!!!!!SEC %ld, SECPTR %ld", SEC(nowTime), SECPTR(previousIncreaseTimeStamp));
             prevIncTime = (float)(SEC(nowTime) - SECPTR(previousIncreaseTimeStamp));
@@ -275,7 +322,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
                 // and a LOT of bandwidth, we can pull down a LOT video at a low bit rate in 15 seconds (or whatever CAN_SWITCH_UP_THRESHOLD happens to be).
                 // So we decided to allow the bitrate to "ramp up" in (theta2 < Beta(t) < Betamax) even if it hasn't been CAN_SWITCH_UP_THRESHOLD amount of time
                 // since the last profile switch up.
-                if ((prevIncTime >= CAN_SWITCH_UP_THRESHOLD) || (playbackTime < RAMPUPTHRESHOLD))
+                if ((prevIncTime >= abrParams.canSwitchUpThreshold) || (playbackTime < abrParams.rampUpThreshold))
                 {
                     if (bitrates[uiCurBitrateIndex + 1] > rateMax)
                     {
@@ -290,7 +337,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
                     else
                     {
                         proposedIndex = uiCurBitrateIndex + 1;
-                        clock_gettime(CLOCK_MONOTONIC, previousIncreaseTimeStamp);
+                        abrClock(previousIncreaseTimeStamp);
                         DEBUG(DBG_INFO, "move up to %d", bitrates[proposedIndex]);
                     }
                 }
@@ -308,13 +355,13 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
             }
         }
     }
-    else if(bufferLength < NORMAL_BUFF_LVL && bufferLength >= LOW_BUFF_LVL) // else if theta1 < Beta(t) < theta2 then:
+    else if(bufferLength < abrParams.normalBufferLevel && bufferLength >= abrParams.lowBufferLevel) // else if theta1 < Beta(t) < theta2 then:
     {
           // Write phi1 into candidateBitrateIndex.  phi1 based on lastFragmentThroughput.
-          candidateBitrateIndex = abrClientGetBitrateIndex((SLACKFACTOR * lastFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
+          candidateBitrateIndex = abrClientGetBitrateIndex((abrParams.slackFactor * lastFragmentThroughput), rateMin, rateMax, bitratesSize, bitrates);
           DEBUG(DBG_INFO, "current max possible bitrate based on instantaneous throughput: %d ", bitrates[candidateBitrateIndex]);
 
-          DEBUG(DBG_INFO, "bufferLength %f >= %d and < %d", bufferLength, LOW_BUFF_LVL, NORMAL_BUFF_LVL);
+          DEBUG(DBG_INFO, "bufferLength %f >= %d and < %d", bufferLength, abrParams.lowBufferLevel, abrParams.normalBufferLevel);
 
           // On a channel change, our hope is that we'll fall into this if statment (theta1 < Beta(t) < theta2) after
           // downloading just one segment.  For example, if theta1 is 5 seconds and we've downloaded 1 segment
@@ -323,7 +370,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
           // (i.e. - move to a higher bitrate) and get to our optimal bitrate as quickly as possible when on a high b/w network.
 
 #if 0 // Remove this for now.  Leave Adaptech as-is until we see real reasons to start monkeying with it.
-          if((candidateBitrateIndex == 0) && ((bitrates[0]/(SLACKFACTOR * lastFragmentThroughput)) >= 2))
+          if((candidateBitrateIndex == 0) && ((bitrates[0]/(abrParams.slackFactor * lastFragmentThroughput)) >= 2))
           {
               proposedIndex = abrClientGetAboveMinBitrate(rateMin, rateMax, bitratesSize, bitrates);
               DEBUG(DBG_INFO, "Available bandwidth is 50 percent or less of lowest bitrate... PANIC MODE to lowest index within range which is %d!", proposedIndex);
@@ -362,7 +409,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
               else
               {
                   proposedIndex = uiCurBitrateIndex + 1;
-                  clock_gettime(CLOCK_MONOTONIC, previousIncreaseTimeStamp);
+                  abrClock(previousIncreaseTimeStamp);
                   DEBUG(DBG_INFO, "move up to %d", bitrates[proposedIndex]);
               }
           }
@@ -375,7 +422,7 @@ int abrClientGetNewBitrate(float lastFragmentThroughput, float avgFragmentThroug
     else // else if Beta(t) < theta1 then:
     {
         // panic mode (lowest bitrate NOW since we are below LOW_BUFF_LVL)
-        DEBUG(DBG_INFO, "bufferLength %f < %d", bufferLength, LOW_BUFF_LVL);
+        DEBUG(DBG_INFO, "bufferLength %f < %d", bufferLength, abrParams.lowBufferLevel);
         proposedIndex = abrClientGetAboveMinBitrate(rateMin, rateMax, bitratesSize, bitrates);
         DEBUG(DBG_INFO, "PANIC MODE! (Not enough buffer!) -- move to lowest bitrate %d", bitrates[proposedIndex]);
     }
@@ -40,6 +40,8 @@ extern "C" {
 #include <curl/easy.h>
 
 #include "curlUtils.h"
+#include "hlsClock.h"
+#include "hlsProbes.h"
 #include "debug.h"
 
 /**
@@ -204,6 +206,57 @@ hlsStatus_t curlTerm(CURL* pCurl)
     return rval;
 }
 
+/**
+ * Writes data to the targets of a split transfer, see
+ * customFwrite().  Called with pHandle->pFileMutex held.
+ *
+ * @param pBuffer - data to write
+ * @param length - number of bytes in pBuffer
+ * @param pHandle - download handle with pSplit set
+ *
+ * @return TRUE if all of the data was written, FALSE otherwise
+ */
+static int splitFwrite(char* pBuffer, size_t length, downloadHandle_t* pHandle)
+{
+    size_t chunk = 0;
+
+    while(length > 0)
+    {
+        if(pHandle->fpTarget == NULL)
+        {
+            ERROR("%d bytes received past the end of the transfer", (int)length);
+            return 0;
+        }
+
+        chunk = length;
+        if(chunk > (size_t)(pHandle->splitRemaining))
+        {
+            chunk = pHandle->splitRemaining;
+        }
+
+        if(fwrite(pBuffer, 1, chunk, pHandle->fpTarget) != chunk)
+        {
+            return 0;
+        }
+
+        pBuffer += chunk;
+        length -= chunk;
+        pHandle->splitRemaining -= chunk;
+
+        /* Move on as soon as a target is complete, rather than when the
+           next data arrives, so that its reader sees the end promptly */
+        if(pHandle->splitRemaining == 0)
+        {
+            if(pHandle->pSplit(pHandle->pSplitArg, pHandle) != HLS_OK)
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+
 /**
  * Custom write function for use with cURL.
  *
@@ -215,6 +268,13 @@ hlsStatus_t curlTerm(CURL* pCurl)
  * If pData->pFileMutex is non-NULL, the function will lock the
  * mutex before accessing pData->fpTarget.
  *
+ * If pData->pDecrypt is non-NULL, the data is decrypted before it
+ * is written.
+ *
+ * If pData->pSplit is non-NULL, only pData->splitRemaining bytes
+ * go to pData->fpTarget, after which pData->pSplit moves the
+ * handle on to the next target.
+ *
  * If pData->pbAbortDownload is non-NULL, the function will
  * immediately return a -1 to stop the cURL transfer when
  *  pbAbortDownload is TRUE.
@@ -234,7 +294,7 @@ static size_t customFwrite(char* pBuffer, size_t size, size_t nmemb, void* pData
 
     downloadHandle_t* pHandle = (downloadHandle_t*)pData;
 
-    if((pBuffer == NULL) || (pHandle == NULL) || (pHandle->fpTarget == NULL))
+    if((pBuffer == NULL) || (pHandle == NULL) || ((pHandle->fpTarget == NULL) && (pHandle->pSplit == NULL)))
     {
         ERROR("invalid parameter");
         return -1;
@@ -251,6 +311,20 @@ static size_t customFwrite(char* pBuffer, size_t size, size_t nmemb, void* pData
         }
     }
 
+    /* A server that ignores the Range header sends the whole resource,
+       which mustn't land where the range was meant to go */
+    if(pHandle->bRangeRequired && !pHandle->bGotFirstByte)
+    {
+        long respondCode = 0;
+
+        curl_easy_getinfo(pHandle->pCurl, CURLINFO_RESPONSE_CODE, &respondCode);
+        if(respondCode != 206)
+        {
+            ERROR("server answered range request with HTTP respond code: %ld", respondCode);
+            return -1;
+        }
+    }
+
     /* If the download handle contains a mutex, lock it before attempting
        the write. */
     if(pHandle->pFileMutex != NULL)
@@ -260,7 +334,28 @@ static size_t customFwrite(char* pBuffer, size_t size, size_t nmemb, void* pData
 
     DEBUG(DBG_NOISE, "writing %d bytes", (int)(size*nmemb));
 
-    rval = fwrite(pBuffer, size, nmemb, pHandle->fpTarget);
+    if(!pHandle->bGotFirstByte)
+    {
+        pHandle->bGotFirstByte = 1;
+        HLS_PROBE(first_byte, pHandle->pTraceSession, pHandle->traceType, pHandle->traceBitrate);
+    }
+
+    if(pHandle->pSplit != NULL)
+    {
+        rval = splitFwrite(pBuffer, size*nmemb, pHandle) ? nmemb : 0;
+    }
+    else if(pHandle->pDecrypt != NULL)
+    {
+        /* The cipher may hold back part of the data, so report it all as
+           written unless decryption failed */
+        rval = (hlsDecrypt_write(pHandle->pDecrypt, pBuffer, size*nmemb, pHandle->fpTarget) == HLS_OK) ? nmemb : 0;
+    }
+    else
+    {
+        rval = fwrite(pBuffer, size, nmemb, pHandle->fpTarget);
+    }
+
+    pHandle->bytesReceived += rval*size;
 
     /* If the download handle contains a mutex, unlock it */
     if(pHandle->pFileMutex != NULL)
@@ -299,6 +394,7 @@ hlsStatus_t curlDownloadFile(CURL* pCurl, char* URL, downloadHandle_t* pHandle,
     char *tempString = NULL;
     double tempDouble;
     long respondCode;
+    int bPerformed = 0;
 
     if((pCurl == NULL) || (URL == NULL) || (pHandle == NULL) || (pHandle->fpTarget == NULL))
     {
@@ -306,6 +402,9 @@ hlsStatus_t curlDownloadFile(CURL* pCurl, char* URL, downloadHandle_t* pHandle,
         return HLS_INVALID_PARAMETER;
     }
 
+    pHandle->bGotFirstByte = 0;
+    pHandle->pCurl = pCurl;
+
     do
     {
         /* Set the URL */
@@ -395,6 +494,7 @@ hlsStatus_t curlDownloadFile(CURL* pCurl, char* URL, downloadHandle_t* pHandle,
 
         /* Execute libcurl */
         curlResult = curl_easy_perform(pCurl);
+        bPerformed = 1;
         if( CURLE_OK != curlResult )
         {
             if((pHandle->pbAbortDownload) && *(pHandle->pbAbortDownload))
@@ -434,6 +534,12 @@ hlsStatus_t curlDownloadFile(CURL* pCurl, char* URL, downloadHandle_t* pHandle,
 
     } while (0);
 
+    /* Record every attempt, successful or not */
+    if(bPerformed && (pHandle->traceType != HLS_TRACE_NONE))
+    {
+        traceCurlTransfer(pCurl, pHandle->traceType, pHandle->pTraceSession, pHandle->traceBitrate, rval);
+    }
+
     return rval;
 }
 
@@ -515,8 +621,9 @@ hlsStatus_t getCurlTransferInfo(CURL* pCurl, char** ppRedirectURL, float* pThrou
 
             *pThroughput = tempDouble;
 
-            /* Convert from Bps to bps */
+            /* Convert from Bps to bps, per second of (possibly accelerated) session time */
             *pThroughput *= 8;
+            *pThroughput /= hlsClock_getScale();
 
             DEBUG(DBG_INFO,"throughput: %5.2f Bps = %5.2f bps", tempDouble, *pThroughput);
         }
@@ -541,6 +648,149 @@ hlsStatus_t getCurlTransferInfo(CURL* pCurl, char** ppRedirectURL, float* pThrou
     return rval;
 }
 
+/**
+ * Retrieves the time to first byte and total time of the last
+ * transfer performed by the cURL handle pCurl.
+ *
+ * @param pCurl - cURL handle to retireve information about
+ * @param pStartTransferTime - will receive the time from the
+ *                           start of the transfer until the
+ *                           first byte was received, in seconds
+ * @param pTotalTime - will receive the total time of the
+ *                   transfer, in seconds
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t getCurlTransferTimes(CURL* pCurl, float* pStartTransferTime, float* pTotalTime)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    CURLcode curlResult;
+
+    double tempDouble;
+
+    if((pCurl == NULL) || (pStartTransferTime == NULL) || (pTotalTime == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        curlResult = curl_easy_getinfo(pCurl, CURLINFO_STARTTRANSFER_TIME, &tempDouble);
+        if( CURLE_OK != curlResult )
+        {
+            rval = HLS_ERROR;
+            ERROR("Failed to set curl_easy_getinfo() with CURLINFO_STARTTRANSFER_TIME; Error %d: %s", curlResult, curl_easy_strerror(curlResult) );
+            break;
+        }
+
+        *pStartTransferTime = tempDouble;
+
+        curlResult = curl_easy_getinfo(pCurl, CURLINFO_TOTAL_TIME, &tempDouble);
+        if( CURLE_OK != curlResult )
+        {
+            rval = HLS_ERROR;
+            ERROR("Failed to set curl_easy_getinfo() with CURLINFO_TOTAL_TIME; Error %d: %s", curlResult, curl_easy_strerror(curlResult) );
+            break;
+        }
+
+        *pTotalTime = tempDouble;
+
+        /* Report both in session time */
+        *pStartTransferTime *= hlsClock_getScale();
+        *pTotalTime *= hlsClock_getScale();
+
+        DEBUG(DBG_NOISE,"transfer times: ttfb %5.3f s, total %5.3f s", *pStartTransferTime, *pTotalTime);
+
+    } while (0);
+
+    return rval;
+}
+
+/**
+ * Converts a CURLINFO_*_TIME value to whole microseconds.
+ *
+ * @param pCurl - cURL handle to retrieve the time from
+ * @param info - CURLINFO_*_TIME to retrieve
+ *
+ * @return uint32_t - time in microseconds; 0 if unavailable
+ */
+static uint32_t getCurlTimeUs(CURL* pCurl, CURLINFO info)
+{
+    double tempDouble = 0;
+
+    if((curl_easy_getinfo(pCurl, info, &tempDouble) != CURLE_OK) || (tempDouble < 0))
+    {
+        return 0;
+    }
+
+    return (uint32_t)(tempDouble * 1000000);
+}
+
+/**
+ * Adds the last transfer performed by the cURL handle pCurl to
+ * the transfer trace: the DNS, connect, TLS, pretransfer, first
+ * byte and total times, the HTTP status and the size.
+ *
+ * @param pCurl - cURL handle to retrieve information about
+ * @param type - kind of transfer
+ * @param pSession - session the transfer belongs to; can be NULL
+ * @param bitrate - variant bitrate, or 0 if not applicable
+ * @param result - #hlsStatus_t of the transfer
+ */
+void traceCurlTransfer(CURL* pCurl, hlsTraceType_t type, void* pSession, int bitrate, hlsStatus_t result)
+{
+    hlsTraceRecord_t record;
+    struct timespec now;
+    curl_off_t tempOff = 0;
+    long tempLong = 0;
+
+    if(pCurl == NULL)
+    {
+        return;
+    }
+
+    memset(&record, 0, sizeof(record));
+
+    record.type = type;
+    if(pSession != NULL)
+    {
+        record.session = (uint64_t)(uintptr_t)(((hlsSession_t*)pSession)->sessionId);
+    }
+    record.bitrate = bitrate;
+    record.result = result;
+
+    if(curl_easy_getinfo(pCurl, CURLINFO_RESPONSE_CODE, &tempLong) == CURLE_OK)
+    {
+        record.httpStatus = tempLong;
+    }
+
+    if((curl_easy_getinfo(pCurl, CURLINFO_SIZE_DOWNLOAD_T, &tempOff) == CURLE_OK) && (tempOff > 0))
+    {
+        record.bytes = tempOff;
+    }
+
+    record.nameLookupTime = getCurlTimeUs(pCurl, CURLINFO_NAMELOOKUP_TIME);
+    record.connectTime = getCurlTimeUs(pCurl, CURLINFO_CONNECT_TIME);
+    record.appConnectTime = getCurlTimeUs(pCurl, CURLINFO_APPCONNECT_TIME);
+    record.preTransferTime = getCurlTimeUs(pCurl, CURLINFO_PRETRANSFER_TIME);
+    record.startTransferTime = getCurlTimeUs(pCurl, CURLINFO_STARTTRANSFER_TIME);
+    record.totalTime = getCurlTimeUs(pCurl, CURLINFO_TOTAL_TIME);
+
+    /* We are called right after the transfer, so back out its duration */
+    if(clock_gettime(CLOCK_REALTIME, &now) == 0)
+    {
+        record.startTime = ((uint64_t)now.tv_sec * 1000000) + (now.tv_nsec / 1000);
+        if(record.startTime > record.totalTime)
+        {
+            record.startTime -= record.totalTime;
+        }
+    }
+
+    hlsTrace_add(&record);
+}
+
 /**
  * Generates a base URL from a content URI
  * For example, it turns:
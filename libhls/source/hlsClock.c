@@ -0,0 +1,237 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsClock.c @date October 19, 2026
+ *
+ * Scaled virtual clock.
+ *
+ * Virtual time is a linear function of CLOCK_MONOTONIC:
+ *
+ *   virtual = virtBase + (monotonic - realBase) * scale
+ *
+ * Changing the scale re-anchors both bases at the current instant, so
+ * virtual time stays continuous and never goes backwards.  With the
+ * default scale of 1 and zero bases it is CLOCK_MONOTONIC itself.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdint.h>
+
+#include "hlsClock.h"
+
+#include "debug.h"
+
+#define NSECS_PER_SEC 1000000000ll
+
+/*! Current mapping from CLOCK_MONOTONIC to virtual time.  It is only
+   changed while no session is running, so readers don't lock it. */
+static struct {
+    double scale;       /*!< Virtual seconds per CLOCK_MONOTONIC second */
+    int64_t realBase;   /*!< CLOCK_MONOTONIC anchor, in nanoseconds */
+    int64_t virtBase;   /*!< Virtual time at realBase, in nanoseconds */
+} theClock = { 1.0, 0, 0 };
+
+/**
+ * @param pTime - time to convert
+ *
+ * @return int64_t - pTime in nanoseconds
+ */
+static int64_t toNsecs(const struct timespec* pTime)
+{
+    return ((int64_t)pTime->tv_sec * NSECS_PER_SEC) + pTime->tv_nsec;
+}
+
+/**
+ * @param nsecs - time in nanoseconds; negative values are clamped to 0
+ * @param pTime - receives the converted time
+ */
+static void fromNsecs(int64_t nsecs, struct timespec* pTime)
+{
+    if(nsecs < 0)
+    {
+        nsecs = 0;
+    }
+    pTime->tv_sec = nsecs / NSECS_PER_SEC;
+    pTime->tv_nsec = nsecs % NSECS_PER_SEC;
+}
+
+/**
+ * @param realNsecs - CLOCK_MONOTONIC time in nanoseconds
+ *
+ * @return int64_t - corresponding virtual time in nanoseconds
+ */
+static int64_t realToVirtual(int64_t realNsecs)
+{
+    if(theClock.scale == 1.0)
+    {
+        return theClock.virtBase + (realNsecs - theClock.realBase);
+    }
+    return theClock.virtBase + (int64_t)((double)(realNsecs - theClock.realBase) * theClock.scale);
+}
+
+/**
+ * @param virtNsecs - virtual time in nanoseconds
+ *
+ * @return int64_t - corresponding CLOCK_MONOTONIC time in nanoseconds
+ */
+static int64_t virtualToReal(int64_t virtNsecs)
+{
+    if(theClock.scale == 1.0)
+    {
+        return theClock.realBase + (virtNsecs - theClock.virtBase);
+    }
+    return theClock.realBase + (int64_t)((double)(virtNsecs - theClock.virtBase) / theClock.scale);
+}
+
+/**
+ * Sets how fast virtual time runs relative to CLOCK_MONOTONIC.
+ *
+ * The mapping is process-wide and not locked, so only change it
+ * while no session is running.
+ *
+ * @param scale - speed-up factor; 1 is real time
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsClock_setScale(double scale)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    struct timespec now;
+    int64_t realNsecs = 0;
+
+    do
+    {
+        if((scale <= 0) || (scale > HLS_CLOCK_MAX_SCALE))
+        {
+            ERROR("invalid clock scale %f", scale);
+            rval = HLS_INVALID_PARAMETER;
+            break;
+        }
+
+        if(clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+        {
+            ERROR("failed to get current time");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        realNsecs = toNsecs(&now);
+
+        theClock.virtBase = realToVirtual(realNsecs);
+        theClock.realBase = realNsecs;
+        theClock.scale = scale;
+
+        DEBUG(DBG_INFO, "clock scale set to %.2f", scale);
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * @return double - current speed-up factor; 1 is real time
+ */
+double hlsClock_getScale(void)
+{
+    return theClock.scale;
+}
+
+/**
+ * Gets the current (virtual) time.  Drop-in replacement for
+ * clock_gettime(CLOCK_MONOTONIC, pNow).
+ *
+ * @param pNow - receives the current time
+ *
+ * @return int - 0 on success, -1 on failure
+ */
+int hlsClock_now(struct timespec* pNow)
+{
+    struct timespec real;
+
+    if(pNow == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if(clock_gettime(CLOCK_MONOTONIC, &real) != 0)
+    {
+        return -1;
+    }
+
+    fromNsecs(realToVirtual(toNsecs(&real)), pNow);
+
+    return 0;
+}
+
+/**
+ * Waits on a condition until signalled or until an absolute virtual
+ * time.  Drop-in replacement for PTHREAD_COND_TIMEDWAIT on a condition
+ * using CLOCK_MONOTONIC.
+ *
+ * @param pCond - condition to wait on
+ * @param pMutex - mutex held by the caller
+ * @param pWakeTime - absolute virtual time to wake up at
+ *
+ * @return int - 0 if signalled, ETIMEDOUT or another pthread error
+ */
+int hlsClock_timedWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex, const struct timespec* pWakeTime)
+{
+    struct timespec realWakeTime;
+
+    fromNsecs(virtualToReal(toNsecs(pWakeTime)), &realWakeTime);
+
+    return PTHREAD_COND_TIMEDWAIT(pCond, pMutex, &realWakeTime);
+}
+
+/**
+ * Sleeps for a number of virtual microseconds.
+ *
+ * @param usecs - time to sleep
+ */
+void hlsClock_sleep(long usecs)
+{
+    struct timespec delay;
+    int64_t nsecs = 0;
+
+    if(usecs <= 0)
+    {
+        return;
+    }
+
+    nsecs = (int64_t)((double)usecs * 1000 / theClock.scale);
+    fromNsecs(nsecs, &delay);
+
+    while((nanosleep(&delay, &delay) != 0) && (errno == EINTR))
+    {
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,261 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsDecrypt.c @date October 19, 2026
+ *
+ * In-library AES-128-CBC segment decryption (see hlsDecrypt.h).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hlsDecrypt.h"
+
+#include "debug.h"
+
+#ifdef ENABLE_DECRYPTION
+
+#include <openssl/evp.h>
+
+/**
+ * @return TRUE if the library was built with decryption support
+ */
+int hlsDecrypt_isSupported(void)
+{
+    return 1;
+}
+
+/**
+ * Starts decrypting a segment.  hlsDecrypt_term() MUST be called
+ * once the segment is done with, whatever this returns.
+ *
+ * @param pDecrypt - decryption state to set up
+ * @param pKey - HLS_DECRYPT_KEY_SIZE byte key
+ * @param pIV - HLS_DECRYPT_KEY_SIZE byte initialization vector
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsDecrypt_init(hlsDecrypt_t* pDecrypt, const char* pKey, const char* pIV)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if((pDecrypt == NULL) || (pKey == NULL) || (pIV == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    memset(pDecrypt, 0, sizeof(*pDecrypt));
+
+    do
+    {
+        pDecrypt->pOut = (unsigned char*)malloc(HLS_DECRYPT_CHUNK_SIZE + EVP_MAX_BLOCK_LENGTH);
+        if(pDecrypt->pOut == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        pDecrypt->pCtx = EVP_CIPHER_CTX_new();
+        if(pDecrypt->pCtx == NULL)
+        {
+            ERROR("EVP_CIPHER_CTX_new() failed");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        /* Padding is left on: the cipher holds back the last block until
+           EVP_DecryptFinal_ex() checks and strips the padding */
+        if(EVP_DecryptInit_ex((EVP_CIPHER_CTX*)pDecrypt->pCtx, EVP_aes_128_cbc(), NULL,
+                              (const unsigned char*)pKey, (const unsigned char*)pIV) != 1)
+        {
+            ERROR("EVP_DecryptInit_ex() failed");
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Decrypts the next bytes of a segment and writes the clear data
+ * to fpTarget.  Up to one block is held back until the next call
+ * or hlsDecrypt_finish().
+ *
+ * @param pDecrypt - decryption state
+ * @param pData - encrypted data
+ * @param size - bytes at pData
+ * @param fpTarget - file to write the clear data to
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsDecrypt_write(hlsDecrypt_t* pDecrypt, const char* pData, size_t size, FILE* fpTarget)
+{
+    hlsStatus_t rval = HLS_OK;
+    int chunk = 0;
+    int outLength = 0;
+
+    if((pDecrypt == NULL) || (pDecrypt->pCtx == NULL) || (pData == NULL) || (fpTarget == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    while(size > 0)
+    {
+        chunk = (size > HLS_DECRYPT_CHUNK_SIZE) ? HLS_DECRYPT_CHUNK_SIZE : (int)size;
+
+        if(EVP_DecryptUpdate((EVP_CIPHER_CTX*)pDecrypt->pCtx, pDecrypt->pOut, &outLength,
+                             (const unsigned char*)pData, chunk) != 1)
+        {
+            ERROR("EVP_DecryptUpdate() failed");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        if((outLength > 0) && (fwrite(pDecrypt->pOut, 1, outLength, fpTarget) != (size_t)outLength))
+        {
+            ERROR("fwrite() failed");
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        pDecrypt->bytesIn += chunk;
+        pData += chunk;
+        size -= chunk;
+    }
+
+    return rval;
+}
+
+/**
+ * Checks the padding of the last block and writes what is left
+ * of it to fpTarget.
+ *
+ * @param pDecrypt - decryption state
+ * @param fpTarget - file to write the clear data to
+ *
+ * @return #hlsStatus_t - HLS_ERROR if the segment was not a
+ *         whole number of blocks or its padding was bad (wrong key
+ *         or IV)
+ */
+hlsStatus_t hlsDecrypt_finish(hlsDecrypt_t* pDecrypt, FILE* fpTarget)
+{
+    int outLength = 0;
+
+    if((pDecrypt == NULL) || (pDecrypt->pCtx == NULL) || (fpTarget == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    if(EVP_DecryptFinal_ex((EVP_CIPHER_CTX*)pDecrypt->pCtx, pDecrypt->pOut, &outLength) != 1)
+    {
+        ERROR("bad padding after %ld encrypted bytes -- wrong key or IV?", pDecrypt->bytesIn);
+        return HLS_ERROR;
+    }
+
+    if((outLength > 0) && (fwrite(pDecrypt->pOut, 1, outLength, fpTarget) != (size_t)outLength))
+    {
+        ERROR("fwrite() failed");
+        return HLS_FILE_ERROR;
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Frees the decryption state of a segment.
+ *
+ * @param pDecrypt - decryption state set up by hlsDecrypt_init()
+ */
+void hlsDecrypt_term(hlsDecrypt_t* pDecrypt)
+{
+    if(pDecrypt == NULL)
+    {
+        return;
+    }
+
+    EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)pDecrypt->pCtx);
+    pDecrypt->pCtx = NULL;
+
+    free(pDecrypt->pOut);
+    pDecrypt->pOut = NULL;
+}
+
+#else /* ENABLE_DECRYPTION */
+
+int hlsDecrypt_isSupported(void)
+{
+    return 0;
+}
+
+hlsStatus_t hlsDecrypt_init(hlsDecrypt_t* pDecrypt, const char* pKey, const char* pIV)
+{
+    (void)pKey;
+    (void)pIV;
+
+    if(pDecrypt != NULL)
+    {
+        memset(pDecrypt, 0, sizeof(*pDecrypt));
+    }
+
+    ERROR("built without --enable-decryption");
+    return HLS_UNSUPPORTED;
+}
+
+hlsStatus_t hlsDecrypt_write(hlsDecrypt_t* pDecrypt, const char* pData, size_t size, FILE* fpTarget)
+{
+    (void)pDecrypt;
+    (void)pData;
+    (void)size;
+    (void)fpTarget;
+
+    return HLS_UNSUPPORTED;
+}
+
+hlsStatus_t hlsDecrypt_finish(hlsDecrypt_t* pDecrypt, FILE* fpTarget)
+{
+    (void)pDecrypt;
+    (void)fpTarget;
+
+    return HLS_UNSUPPORTED;
+}
+
+void hlsDecrypt_term(hlsDecrypt_t* pDecrypt)
+{
+    (void)pDecrypt;
+}
+
+#endif /* ENABLE_DECRYPTION */
+
+#ifdef __cplusplus
+}
+#endif
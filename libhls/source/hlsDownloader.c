@@ -49,6 +49,9 @@ extern "C" {
 #include "debug.h"
 #include "adaptech.h"
 #include "curlUtils.h"
+#include "hlsClock.h"
+#include "hlsLockStats.h"
+#include "hlsProbes.h"
 
 /* Loop duration in seconds */
 #define DOWNLOADER_LOOP_SECS 1
@@ -73,7 +76,7 @@ static hlsStatus_t hlsDownloaderSleep(hlsSession_t* pSession, unsigned int sleep
 
    do {
       /* Get current time */
-      if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+      if(hlsClock_now(&wakeTime) != 0)
       {
          ERROR("failed to get current time");
          rval = HLS_ERROR;
@@ -99,7 +102,7 @@ static hlsStatus_t hlsDownloaderSleep(hlsSession_t* pSession, unsigned int sleep
       wakeTime.tv_nsec = (wakeTime.tv_nsec + nsec) % 1000000000;
 
       /* Wait until wakeTime */
-      pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
+      pthread_status = hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
 
       /* Unlock the downloader wake mutex */
       if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
@@ -161,7 +164,7 @@ static hlsStatus_t hlsDwnldThreadsSync(hlsSession_t *pSession,
       mainSegPFE = -1;
 
       /* Find the position of the main playlist segment downloader */
-      pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+      playlistReadLock(pSession);
 
       if((NULL != pSession->pCurrentPlaylist) &&
          (NULL != pSession->pCurrentPlaylist->pMediaData) &&
@@ -173,12 +176,12 @@ static hlsStatus_t hlsDwnldThreadsSync(hlsSession_t *pSession,
          if(status != HLS_OK)
          {
             ERROR("problem getting main playlist segment position");
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
          }
       }
 
-      pthread_rwlock_unlock(&(pSession->playlistRWLock));
+      playlistUnlock(pSession);
 
       if(-1 != mainSegPFE)
       {
@@ -232,6 +235,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
     playbackControllerSignal_t* pSignal = NULL;
     struct timespec oldLastBitrateChange;
     srcPlayerMode_t playerMode;
+    double span = 0;
 
 
 
@@ -265,7 +269,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
             }
 
             /* Get current time */
-            if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+            if(hlsClock_now(&wakeTime) != 0)
             {
                 ERROR("failed to get current time");
                 status = HLS_ERROR;
@@ -273,7 +277,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
             }
 
             /* Get playlist READ lock */
-            pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+            playlistReadLock(pSession);
 
             /* Get the current playlist */
             pMediaPlaylist = pSession->pCurrentPlaylist;
@@ -284,7 +288,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 ERROR("invalid playlist for playback");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -295,7 +299,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
             {
                 ERROR("failed to find next segment");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -308,7 +312,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 {
                     ERROR("failed to make local segment copy");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -318,7 +322,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 {
                     ERROR("error creating full URL");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
                 // here is the segment, if it's encrypted we need to attach
@@ -333,7 +337,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 pSegment = NULL;
 
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
 
                 /* Determine the player mode based on speed */
                 if(pSession->speed == 0.0)
@@ -363,16 +367,32 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 /* timeBuffered is also updated whenever we process a PTS
                    in the playerEvtCallback -- block those callbacks while
                    we update it here */
-                pthread_mutex_lock(&(pSession->playerEvtMutex));
+                HLS_MUTEX_LOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 
                 /* Increment our buffer count */
                 pSession->timeBuffered += pSegmentCopy->duration;
 
+                /* EXTINF durations are often rounded -- once we know where this
+                   segment starts, swap the previous segment's EXTINF duration for
+                   its real PTS span.  Spans that don't look like one segment
+                   (discontinuities, PTS resets) are left alone. */
+                if((pSegmentCopy->firstPts != INVALID_PTS) && (pSession->lastSegmentPts != -1ll) &&
+                   !pSegmentCopy->bDiscontinuity)
+                {
+                    span = ptsToSeconds((pSegmentCopy->firstPts - pSession->lastSegmentPts + PTS_LIMIT) % PTS_LIMIT);
+                    if((span > 0) && (span < 2 * pSession->lastSegmentDuration))
+                    {
+                        pSession->timeBuffered += span - pSession->lastSegmentDuration;
+                    }
+                }
+                pSession->lastSegmentPts = pSegmentCopy->firstPts;
+                pSession->lastSegmentDuration = pSegmentCopy->duration;
+
                 /* Unblock the playerEvtCallback */
-                pthread_mutex_unlock(&(pSession->playerEvtMutex));
+                HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 
                 /* Get playlist WRITE lock */
-                pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+                playlistWriteLock(pSession);
 
                 // Check if we want to switch bitrate, if we have > 1 variant
                 if(pSession->pPlaylist->type == PL_VARIANT)
@@ -396,6 +416,11 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                         }
                         else
                         {
+                            HLS_PROBE(abr_decision, pSession, pMediaPlaylist->pMediaData->bitrate,
+                                      pSession->pCurrentProgram->pAvailableBitrates[proposedBitrateIndex],
+                                      (int)(pSession->timeBuffered * 1000),
+                                      (int)(pSession->lastSegmentDldRate / 1000), (int)(pSession->avgSegmentDldRate / 1000));
+
                             status = changeBitrate(pSession, pSession->pCurrentProgram->pAvailableBitrates[proposedBitrateIndex]);
                             if(status != HLS_OK)
                             {
@@ -417,7 +442,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                                 {
                                     ERROR("failed to change bitrate");
                                     /* Release playlist lock */
-                                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                                    playlistUnlock(pSession);
                                     break;
                                 }
                             }
@@ -428,7 +453,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                         ERROR("current program malformed or invalid");
                         status = HLS_ERROR;
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
                 }
@@ -438,7 +463,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 }
 
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
             }
             else
             {
@@ -448,7 +473,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                     ERROR("failed to get first segment");
                     status = HLS_ERROR;
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -456,7 +481,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 if(pSession->pCurrentPlaylist->pMediaData->bHaveCompletePlaylist) /* VoD stream */
                 {
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
 
                     /* If we didn't get a segment we've hit EOF */
                     DEBUG(DBG_NOISE,"EOF -- no more segments in VoD playlist");
@@ -498,7 +523,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                 else /* LIVE stream */
                 {
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
 
                     /* If we didn't get a segment we've hit EOS */
                     DEBUG(DBG_NOISE,"EOS -- no more segments in live playlist");
@@ -520,7 +545,7 @@ hlsStatus_t hlsSegmentDownloadLoop(hlsSession_t* pSession)
                     DEBUG(DBG_NOISE,"sleeping %d seconds until %d", (int)DOWNLOADER_LOOP_SECS, (int)wakeTime.tv_sec);
 
                     /* Wait until wakeTime */
-                    pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
+                    pthread_status = hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
 
                     /* Unlock the downloader wake mutex */
                     if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
@@ -601,7 +626,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
         }
 
         /* Get current time as initial wakeTime */
-        if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+        if(hlsClock_now(&wakeTime) != 0)
         {
             ERROR("failed to get current time");
             status = HLS_ERROR;
@@ -619,7 +644,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
             }
 
             /* Get playlist READ lock */
-            pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+            playlistReadLock(pSession);
 
             /* Get the current playlist */
             pMediaPlaylist = pSession->pCurrentPlaylist;
@@ -630,7 +655,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                 ERROR("invalid playlist for playback");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -640,7 +665,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
             {
                 ERROR("failed to find next I-Frame");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -653,7 +678,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                 {
                     ERROR("failed to make local segment copy");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -663,7 +688,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                 {
                     ERROR("error creating full URL");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -679,7 +704,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                         ERROR("NULL parent node");
                         status = HLS_ERROR;
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
@@ -696,7 +721,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                             ERROR("empty segment node");
                             status = HLS_ERROR;
                             /* Release playlist lock */
-                            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                            playlistUnlock(pSession);
                             break;
                         }
 
@@ -716,7 +741,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                 pSegment = NULL;
 
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
 
                 status = downloadAndPushSegment(pSession, pSegmentCopy, wakeTime, SRC_PLAYER_MODE_LOW_DELAY,
                                                 SRC_STREAM_NUM_MAIN);
@@ -738,7 +763,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                    to wait before displaying the next frame) */
 
                 /* Get current time */
-                if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+                if(hlsClock_now(&wakeTime) != 0)
                 {
                     ERROR("failed to get current time");
                     status = HLS_ERROR;
@@ -762,7 +787,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                 }
 
                 /* Get playlist WRITE lock */
-                pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+                playlistWriteLock(pSession);
 
                 /* Since the I-frames are displayed as soon as we send them to the player, update our
                    current positionFromEnd here, instead of relying on PTS callbacks */
@@ -796,7 +821,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                             {
                                 ERROR("failed to change bitrate");
                                 /* Release playlist lock */
-                                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                                playlistUnlock(pSession);
                                 break;
                             }
                         }
@@ -806,7 +831,7 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
                         ERROR("current program malformed or invalid");
                         status = HLS_ERROR;
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
                 }
@@ -817,12 +842,12 @@ hlsStatus_t hlsIFrameDownloadLoop(hlsSession_t* pSession)
 #endif
 
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
             }
             else
             {
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
 
                 /* If we aren't playing then we never even got the first I-frame, so quit */
                 if(pSession->state != HLS_PLAYING)
@@ -913,6 +938,9 @@ void hlsDownloaderThread(hlsSession_t* pSession)
         status = hlsIFrameDownloadLoop(pSession);
     }
 
+    /* Don't leave a range request running past the downloader */
+    cancelRangeRun(pSession);
+
     pSession->downloaderStatus = status;
 
     if((status != HLS_OK) && (status != HLS_CANCELLED))
@@ -1005,7 +1033,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
          }
 
          /* Get current time */
-         if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+         if(hlsClock_now(&wakeTime) != 0)
          {
             ERROR("failed to get current time");
             status = HLS_ERROR;
@@ -1013,7 +1041,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
          }
 
          /* Get playlist READ lock */
-         pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+         playlistReadLock(pSession);
 
          /* Get the next segment */
          status = getNextSegment(pMediaPlaylist, &pSegment);
@@ -1021,7 +1049,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
          {
             ERROR("failed to find next segment");
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
          }
 
@@ -1034,7 +1062,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
             {
                ERROR("failed to make local segment copy");
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
 
@@ -1044,7 +1072,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
             {
                ERROR("error creating full URL");
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
 
@@ -1052,7 +1080,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
             pSegment = NULL;
 
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
 
             /* Determine the player mode based on speed */
             if(pSession->speed == 0.0)
@@ -1094,14 +1122,14 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
                ERROR("failed to get first segment");
                status = HLS_ERROR;
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
 
             if(!pMediaPlaylist->pMediaData->bHaveCompletePlaylist) /* Live stream */
             {
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
 
                /* If we didn't get a segment we've hit EOS */
                DEBUG(DBG_NOISE,"EOS -- no more segments in live playlist");
@@ -1123,7 +1151,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
                DEBUG(DBG_NOISE,"sleeping %d seconds until %d", (int)DOWNLOADER_LOOP_SECS, (int)wakeTime.tv_sec);
 
                /* Wait until wakeTime */
-               pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
+               pthread_status = hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
 
                /* Unlock the downloader wake mutex */
                if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
@@ -1144,7 +1172,7 @@ hlsStatus_t hlsGrpSegDwnldLoop(hlsSession_t* pSession,
             else /* VOD stream */
             {
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
 
                DEBUG(DBG_INFO,"EOF(VOD) - Media Group %s download loop", pSession->pCurrentGroup[mediaGroupIdx]->groupID);
 
@@ -37,6 +37,7 @@ extern "C" {
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
+#include <sys/mman.h>
 
 #include "hlsPlayerInterface.h"
 #include "hlsSessionUtils.h"
@@ -48,6 +49,15 @@ extern "C" {
 #include "llUtils.h"
 #include "curlUtils.h"
 #include "hlsDownloaderUtils.h"
+#include "hlsWorkerPool.h"
+#include "hlsClock.h"
+#include "hlsLockStats.h"
+#include "hlsStats.h"
+#include "hlsProbes.h"
+#include "hlsTsScan.h"
+#include "hlsTsFilter.h"
+#include "hlsDecrypt.h"
+#include "hlsKeyCache.h"
 #include "debug.h"
 
 /* Number of seconds to wait for a buffer from the player */
@@ -56,13 +66,35 @@ extern "C" {
 /* Number of seconds to wait for more data to be downloaded */
 #define DATA_WAIT_MSECS (10)
 
+/* Bytes of the segment file lent to the player at a time when it
+   registered a srcPlayerLendBuffer_t (multiple of 16 so that
+   encrypted content stays block aligned) */
+#define LEND_BUFFER_SIZE (64*1024)
+
+/* Most segments one byte-range request covers, and most bytes it
+   fetches beyond the first segment, which bounds how far ahead of the
+   player it can run */
+#define RANGE_RUN_MAX_SEGMENTS 4
+#define RANGE_RUN_MAX_BYTES (16*1024*1024)
+
+/* Smallest range a segment is split into when it is downloaded over
+   several connections */
+#define PARALLEL_MIN_PART_BYTES (512*1024)
+
+#ifdef MAP_POPULATE
+#define LEND_MAP_FLAGS MAP_POPULATE
+#else
+#define LEND_MAP_FLAGS 0
+#endif
+
 /* Local types */
 
 /*! \struct asyncDlDesc_t
- * Structure for asyncSegmentDownloadThread() function
+ * Structure for asyncSegmentDownloadTask() function
  */
 typedef struct
 {
+    hlsTask_t task;                 /*!< Worker pool task running the download */
     hlsSession_t* pSession;         /*!< The session handle to operate on */
     hlsSegment_t* pSegment;         /*!< Pointer to the segment we want to download */
     int* pbDownloadComplete;        /*!< Pointer to flag which will be set to TRUE once the download completes */
@@ -71,10 +103,103 @@ typedef struct
     hlsStatus_t* pDownloadStatus;   /*!< Pointer to #hlsStatus_t which will contain the thread's exit status */
     CURL* pCurl;                    /*!< Curl handle to use to download */
     pthread_mutex_t *curlMutex;     /*!< mutex to protect the curl handle */
+    srcLockId_t curlLock;           /*!< Which session lock curlMutex is, for the lock stats */
+    int bitrate;                    /*!< Bitrate of the variant the segment belongs to; 0 for media group streams */
+    int bDecrypt;                   /*!< TRUE to decrypt the segment as it is downloaded */
 } asyncDlDesc_t;
 
+/*! \struct lentChunk_t
+ * Part of a segment file mapped into memory and lent to the player
+ */
+typedef struct
+{
+    void* pMap;                     /*!< Start of the mapping */
+    size_t length;                  /*!< Length of the mapping */
+} lentChunk_t;
+
+/*! \struct rangePart_t
+ * One segment of a #hlsRangeRun_t
+ */
+typedef struct
+{
+    int seqNum;                     /*!< Segment sequence number */
+    long byteOffset;                /*!< Offset of the segment in the resource */
+    long byteLength;                /*!< Length of the segment */
+    char* filePath;                 /*!< Local file the segment is written to */
+    FILE* fpWrite;                  /*!< Open on filePath until the segment is complete */
+    int bDownloadComplete;          /*!< Set once all of the segment is in filePath */
+    long bytesDownloaded;           /*!< Size of the segment file, valid once bDownloadComplete is set */
+    hlsStatus_t downloadStatus;     /*!< Error that ended the request before the segment was complete */
+} rangePart_t;
+
+/*! \struct hlsRangeRun_t_
+ * Consecutive byte ranges of one resource fetched with a single
+ * request, which is split into per-segment files as it arrives.
+ * Each downloadAndPushSegment() call for one of the segments reads
+ * its file while the request carries on with the next ones.
+ */
+struct hlsRangeRun_t_
+{
+    hlsTask_t task;                 /*!< Worker pool task running the request */
+    hlsSession_t* pSession;         /*!< The session handle to operate on */
+    char* URL;                      /*!< Resource the segments are ranges of */
+    int bitrate;                    /*!< Bitrate of the variant the segments belong to */
+    int numParts;                   /*!< Number of segments covered */
+    rangePart_t parts[RANGE_RUN_MAX_SEGMENTS];
+    int writePart;                  /*!< Part the request is writing; only used by the task */
+    int nextPart;                   /*!< Part the next downloadAndPushSegment() call takes */
+    int bKill;                      /*!< Flag which will signal the task to terminate when it is TRUE */
+};
+
+/*! \struct parallelPart_t
+ * One byte range of a segment downloaded over several connections
+ */
+typedef struct
+{
+    hlsTask_t task;                 /*!< Worker pool task downloading the range */
+    hlsSession_t* pSession;         /*!< The session handle to operate on */
+    hlsSegment_t* pSegment;         /*!< Segment the range is part of */
+    CURL* pCurl;                    /*!< Curl handle to use to download */
+    pthread_mutex_t* curlMutex;     /*!< mutex to protect the curl handle; NULL if only this task uses it */
+    int index;                      /*!< Position of the range in the segment */
+    long offset;                    /*!< Offset of the range in the segment */
+    long length;                    /*!< Length of the range; 0 for the rest of the segment */
+    char* filePath;                 /*!< Segment file, shared by all of the ranges */
+    downloadHandle_t dlHandle;      /*!< dlHandle.bytesReceived is how much of the range is in the file */
+    int bDownloadComplete;          /*!< Set once all of the range is in the file */
+    hlsStatus_t downloadStatus;     /*!< Error that ended the download of the range */
+    float ttfb;                     /*!< Time to first byte of the range's last request */
+    float downloadTime;             /*!< Total time of the range's last request */
+} parallelPart_t;
+
+/*! \struct parallelDl_t
+ * Segment downloaded as byte ranges fetched in parallel, each
+ * written straight to its place in the segment file
+ */
+typedef struct
+{
+    int numParts;                   /*!< Number of ranges being downloaded */
+    parallelPart_t parts[SRC_MAX_PARALLEL_CONNECTIONS];
+} parallelDl_t;
+
 /* Local function prototypes */
-void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc);
+hlsTaskResult_t asyncSegmentDownloadTask(void* pArg, struct timespec* pNextRunTime);
+static hlsTaskResult_t asyncRangeRunTask(void* pArg, struct timespec* pNextRunTime);
+static hlsStatus_t startRangeRun(hlsSession_t* pSession, hlsSegment_t* pSegment, rangePart_t** ppPart);
+static rangePart_t* takeRangeRunPart(hlsSession_t* pSession, hlsSegment_t* pSegment);
+static void recordDownloadRate(hlsSession_t* pSession, float lastSegmentDldRate);
+static hlsStatus_t startParallelDownload(hlsSession_t* pSession, hlsSegment_t* pSegment, int bitrate,
+                                         char* filePath, int* pbKillThread, parallelDl_t* pParallel);
+static hlsStatus_t startSegmentDownload(hlsSession_t* pSession, hlsSegment_t* pSegment, int streamNum,
+                                        asyncDlDesc_t* pDesc, parallelDl_t* pParallel,
+                                        char** pFilePath, FILE** pfpRead);
+static void checkParallelDownload(parallelDl_t* pParallel, hlsStatus_t* pStatus, int* pbComplete, long* pBytes);
+static void stopParallelDownload(parallelDl_t* pParallel, int* pbKillThread);
+static void recordParallelRate(hlsSession_t* pSession, hlsSegment_t* pSegment, parallelDl_t* pParallel, long bytes);
+static hlsTaskResult_t asyncParallelPartTask(void* pArg, struct timespec* pNextRunTime);
+static hlsStatus_t mapSegmentChunk(FILE* fp, long offset, int size, lentChunk_t** ppChunk, char** ppData);
+static void releaseSegmentChunk(void* pReleaseData);
+static hlsStatus_t waitForPlayerBuffers(hlsSession_t* pSession, struct timespec* pWakeTime);
 
 /**
  * Assumes calling thread has AT LEAST playlist READ lock
@@ -865,6 +990,8 @@ hlsStatus_t changeCurrentPlaylist(hlsSession_t* pSession, hlsPlaylist_t* pNewMed
         /* Update pCurrentPlaylist */
         pSession->pCurrentPlaylist = pNewMediaPlaylist;
 
+        hlsStats_recordBitrateSwitch(&(pSession->stats));
+
         /* Signal player that we have switched bitrates */
         event.eventCode = SRC_PLUGIN_SWITCHED_BITRATE;
         event.pData = (long*)&(pSession->pCurrentPlaylist->pMediaData->bitrate);
@@ -954,10 +1081,242 @@ hlsStatus_t changeBitrate(hlsSession_t* pSession, int newBitrate)
     return rval;
 }
 
+/**
+ * Maps size bytes of a segment file starting at offset so that
+ * they can be lent to the player.
+ *
+ * The mapping stays valid after the file is closed and unlinked,
+ * and every download of a segment creates a new file (the previous
+ * one is unlinked when it is done), so the player may hold on to
+ * the data for as long as it needs.
+ *
+ * @param fp - segment file
+ * @param offset - offset of the data in the file
+ * @param size - number of bytes to map; they must already be in
+ *             the file
+ * @param ppChunk - set to the mapping, to be passed to
+ *                releaseSegmentChunk()
+ * @param ppData - set to the data at offset
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t mapSegmentChunk(FILE* fp, long offset, int size, lentChunk_t** ppChunk, char** ppData)
+{
+    hlsStatus_t rval = HLS_OK;
+    lentChunk_t* pChunk = NULL;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    long mapOffset = 0;
+
+    do
+    {
+        pChunk = malloc(sizeof(lentChunk_t));
+        if(pChunk == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        /* mmap() offsets must be page aligned */
+        mapOffset = offset - (offset % pageSize);
+        pChunk->length = size + (offset - mapOffset);
+
+        pChunk->pMap = mmap(NULL, pChunk->length, PROT_READ, MAP_SHARED | LEND_MAP_FLAGS, fileno(fp), mapOffset);
+        if(pChunk->pMap == MAP_FAILED)
+        {
+            ERROR("mmap() failed -- %s", strerror(errno));
+            free(pChunk);
+            pChunk = NULL;
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        *ppData = (char*)(pChunk->pMap) + (offset - mapOffset);
+
+    } while(0);
+
+    *ppChunk = pChunk;
+
+    return rval;
+}
+
+/**
+ * Unmaps a chunk mapped by mapSegmentChunk().  This is the
+ * #srcBufferRelease_t the player calls for lent buffers, from
+ * whatever thread drops the data.
+ *
+ * @param pReleaseData - the #lentChunk_t
+ */
+static void releaseSegmentChunk(void* pReleaseData)
+{
+    lentChunk_t* pChunk = (lentChunk_t*)pReleaseData;
+
+    if(pChunk != NULL)
+    {
+        if(munmap(pChunk->pMap, pChunk->length) != 0)
+        {
+            ERROR("munmap() failed -- %s", strerror(errno));
+        }
+        free(pChunk);
+    }
+}
+
+/**
+ * Backs off for BUFFER_WAIT_SECS after the player said it has no
+ * room for more data, or until the downloader is woken up.
+ *
+ * @param pSession - session we are operating on
+ * @param pWakeTime - current time; advanced to the end of the wait
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t waitForPlayerBuffers(hlsSession_t* pSession, struct timespec* pWakeTime)
+{
+    hlsStatus_t rval = HLS_OK;
+    int pthread_status = 0;
+
+    do
+    {
+        /* Lock the downloader wake mutex */
+        if(pthread_mutex_lock(&(pSession->downloaderWakeMutex)) != 0)
+        {
+            ERROR("failed to lock downloader wake mutex");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        /* Wait for LOOP_SECS before going again */
+        pWakeTime->tv_sec += BUFFER_WAIT_SECS;
+
+        DEBUG(DBG_NOISE,"sleeping %d seconds until %d", (int)BUFFER_WAIT_SECS, (int)pWakeTime->tv_sec);
+
+        /* Wait until wakeTime */
+        pthread_status = hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), pWakeTime);
+
+        /* Unlock the downloader wake mutex */
+        if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
+        {
+            ERROR("failed to unlock downloader wake mutex");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        /* If the timedwait call failed we need to bail */
+        if((pthread_status != ETIMEDOUT) && (pthread_status != 0))
+        {
+            ERROR("failed to timedwait on the downloader wake condition");
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Starts downloading a segment on its own, into its local file,
+ * either over one connection or, if it is large enough, as byte
+ * ranges fetched in parallel.
+ *
+ * @param pSession - session we are operating on
+ * @param pSegment - segment to download
+ * @param streamNum - stream the segment belongs to
+ * @param pDesc - download descriptor, with the result pointers,
+ *              pbKillThread and bDecrypt filled in; scheduled
+ *              unless pParallel->numParts is set
+ * @param pParallel - parallel download of the segment
+ * @param pFilePath - set to the segment file. CALLER MUST FREE.
+ * @param pfpRead - set to the segment file, opened for reading.
+ *                CALLER MUST CLOSE.
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t startSegmentDownload(hlsSession_t* pSession, hlsSegment_t* pSegment, int streamNum,
+                                        asyncDlDesc_t* pDesc, parallelDl_t* pParallel,
+                                        char** pFilePath, FILE** pfpRead)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    pParallel->numParts = 0;
+
+    do
+    {
+        /* Generate the local download path */
+        rval = getLocalPath(pSegment->URL, pFilePath, pSession->sessionName);
+        if(rval != HLS_OK)
+        {
+            ERROR("error generating local path");
+            break;
+        }
+
+        DEBUG(DBG_NOISE, "opening %s for reading", *pFilePath);
+
+        /* Though this thread will only read from the file, we open it for writing
+           and reading so that the file is created on the disk. */
+        *pfpRead = fopen(*pFilePath,"w+b");
+        if(*pfpRead == NULL)
+        {
+            ERROR("fopen() failed on file %s -- %s", *pFilePath, strerror(errno));
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        /* Populate the async download descriptor structure */
+        pDesc->pSession = pSession;
+        pDesc->pSegment = pSegment;
+        if(streamNum > SRC_STREAM_NUM_MAIN)
+        {
+           pDesc->pCurl = pSession->pMediaGroupCurl[streamNum - 1];
+           pDesc->curlMutex = &pSession->mediaGroupCurlMutex[streamNum - 1];
+           pDesc->curlLock = SRC_LOCK_MEDIA_GROUP_CURL;
+        }
+        else
+        {
+           pDesc->pCurl = pSession->pCurl;
+           pDesc->curlMutex = &pSession->curlMutex;
+           pDesc->curlLock = SRC_LOCK_CURL;
+           if((pSession->pCurrentPlaylist != NULL) && (pSession->pCurrentPlaylist->pMediaData != NULL))
+           {
+              pDesc->bitrate = pSession->pCurrentPlaylist->pMediaData->bitrate;
+           }
+        }
+
+        /* Large main stream segments may be split across several connections */
+        if((streamNum == SRC_STREAM_NUM_MAIN) && !pDesc->bDecrypt)
+        {
+            rval = startParallelDownload(pSession, pSegment, pDesc->bitrate, *pFilePath, pDesc->pbKillThread, pParallel);
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to start parallel download");
+                break;
+            }
+        }
+
+        if(pParallel->numParts == 0)
+        {
+            /* Hand the download off to the worker pool */
+            rval = hlsWorkerPool_schedule(&(pDesc->task), asyncSegmentDownloadTask, pDesc);
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to schedule file download task");
+                break;
+            }
+        }
+
+    } while(0);
+
+    return rval;
+}
+
 /**
  * This function downloads a segment and pushed the downloaded
  * data to the player as it becomes available.
  *
+ * If the player registered a #srcPlayerLendBuffer_t the data
+ * is lent to it straight out of the mapped segment file, otherwise
+ * it is read into buffers obtained with hlsPlayer_getBuffer().
+ *
  * If the download is interrupted by pSession->bKillDownloader
  * == TRUE, the function returns HLS_CANCELLED.
  *
@@ -980,7 +1339,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
 {
     hlsStatus_t rval = HLS_OK;
 
-    pthread_t asyncDlThread = 0;
+    int bAsyncDlScheduled = 0;
     asyncDlDesc_t desc;
     int bDownloadComplete = 0;
     long bytesDownloaded = 0;
@@ -997,6 +1356,9 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
 
     srcBufferMetadata_t bufferMeta;
 
+    srcPluginEvt_t event;
+    srcPluginStartup_t startup;
+
     struct timespec wakeTime;
 
     srcStatus_t status = SRC_SUCCESS;
@@ -1009,8 +1371,20 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
     long bytesRead = 0;
 
     void    *pPrivate;
+    int bLend = 0;
+    lentChunk_t* pChunk = NULL;
+    int lentSize = 0;
     char tag[128] = "";
     unsigned char *ptr = NULL;
+    hlsTsScan_t tsScan;
+    long scannedTo = 0;
+    int bTsPts = 0;
+    hlsTsFilter_t tsFilter;
+    int bFilter = 0;
+    int bDecrypt = 0;
+    int sendSize = 0;
+    rangePart_t* pPart = NULL;
+    parallelDl_t parallel;
 
     if((pSession == NULL) || (pSegment == NULL))
     {
@@ -1018,52 +1392,104 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
         return HLS_INVALID_PARAMETER;
     }
 
+    parallel.numParts = 0;
+
     do
     {
-        /* Generate the local download path */
-        rval = getLocalPath(pSegment->URL, &(filePath), pSession->sessionName);
-        if(rval != HLS_OK)
+#ifdef ENABLE_KEY_RETRIEVAL
+        /* The parser normally prefetched the key; this only waits if that
+           fetch is still in progress or has to be retried */
+        if((pSegment->encType != SRC_ENC_NONE) && (pSegment->keyURI != NULL))
         {
-            ERROR("error generating local path");
-            break;
+            rval = hlsKeyCache_get(pSession->pKeyCache, pSegment->keyURI, pSegment->key,
+                                   &(pSession->bKillDownloader));
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to get key for segment %s", pSegment->URL);
+                break;
+            }
         }
+#endif
 
-        DEBUG(DBG_NOISE, "opening %s for reading", filePath);
+        bLend = hlsPlayer_canLend(pSession);
 
-        /* Though this thread will only read from the file, we open it for writing
-           and reading so that the file is created on the disk. */
-        fpRead = fopen(filePath,"w+b");
-        if(fpRead == NULL)
+        /* If we decrypt the segment ourselves the player gets clear data */
+        bDecrypt = pSession->bDecrypt && (pSegment->encType == SRC_ENC_AES128_CBC);
+
+        /* The PID filter works on clear main stream data and squeezes packets
+           out in place, so it needs buffers of our own rather than lent ones */
+        bFilter = (streamNum == SRC_STREAM_NUM_MAIN) && (pSession->pidFilter != SRC_PID_FILTER_NONE) &&
+                  ((pSegment->encType == SRC_ENC_NONE) || bDecrypt);
+        if(bFilter)
         {
-            ERROR("fopen() failed on file %s -- %s", filePath, strerror(errno));
-            rval = HLS_FILE_ERROR;
-            break;
+            /* Audio groups are only added while main stream audio is disabled */
+            hlsTsFilter_init(&tsFilter, pSession->pidFilter, (pSession->currentGroupCount > 0),
+                             pSession->audioLanguageISOCode);
+            bLend = 0;
         }
 
-        /* Populate the async download descriptor structure */
-        desc.pSession = pSession;
-        desc.pSegment = pSegment;
+        /* Descriptor for downloading the segment on its own */
+        memset(&desc, 0, sizeof(desc));
         desc.pbDownloadComplete = &bDownloadComplete;
         desc.pBytesDownloaded = &bytesDownloaded;
         desc.pDownloadStatus = &dlStatus;
         desc.pbKillThread = &bKillThread;
-        if(streamNum > SRC_STREAM_NUM_MAIN)
+        desc.bDecrypt = bDecrypt;
+
+        /* Consecutive byte ranges of the main stream are fetched with one request */
+        if(streamNum == SRC_STREAM_NUM_MAIN)
         {
-           desc.pCurl = pSession->pMediaGroupCurl[streamNum - 1];
-           desc.curlMutex = &pSession->mediaGroupCurlMutex[streamNum - 1];
+            if(bDecrypt)
+            {
+                /* A run started before decryption was turned on holds ciphertext;
+                   this segment is downloaded and decrypted on its own */
+                cancelRangeRun(pSession);
+            }
+            else
+            {
+                pPart = takeRangeRunPart(pSession, pSegment);
+            }
+
+            if((pPart == NULL) && !bDecrypt)
+            {
+                rval = startRangeRun(pSession, pSegment, &pPart);
+                if(rval != HLS_OK)
+                {
+                    ERROR("failed to start range request");
+                    break;
+                }
+            }
         }
-        else
+
+        if(pPart != NULL)
         {
-           desc.pCurl = pSession->pCurl;
-           desc.curlMutex = &pSession->curlMutex;
-        }
+            /* The range request task creates the segment's file and writes it */
+            filePath = strdup(pPart->filePath);
+            if(filePath == NULL)
+            {
+                ERROR("malloc error");
+                rval = HLS_MEMORY_ERROR;
+                break;
+            }
+
+            DEBUG(DBG_NOISE, "opening %s for reading", filePath);
 
-        /* Kick off a separate thread to go off and do the download */
-        if(pthread_create(&(asyncDlThread), NULL, (void*)asyncSegmentDownloadThread, &desc))
+            fpRead = fopen(filePath, "rb");
+            if(fpRead == NULL)
+            {
+                ERROR("fopen() failed on file %s -- %s", filePath, strerror(errno));
+                rval = HLS_FILE_ERROR;
+                break;
+            }
+        }
+        else
         {
-            ERROR("failed to create file download thread");
-            rval = HLS_ERROR;
-            break;
+            rval = startSegmentDownload(pSession, pSegment, streamNum, &desc, &parallel, &filePath, &fpRead);
+            if(rval != HLS_OK)
+            {
+                break;
+            }
+            bAsyncDlScheduled = (parallel.numParts == 0);
         }
 
         /* Wait until waitTime to start pushing the data to the player */
@@ -1079,7 +1505,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
         DEBUG(DBG_NOISE,"waiting until: %f", ((waitTime.tv_sec)*1.0) + (waitTime.tv_nsec/1000000000.0));
 
         /* Wait until waitTime */
-        pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &waitTime);
+        pthread_status = hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &waitTime);
 
         /* Unlock the downloader wake mutex */
         if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
@@ -1098,7 +1524,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
         }
          // we now have the segment do some house keeping.
         /* Datafill buffer metadata struct */
-        bufferMeta.encType = pSegment->encType;
+        bufferMeta.encType = bDecrypt ? SRC_ENC_NONE : pSegment->encType;
         memcpy( bufferMeta.iv,pSegment->iv, 16);
         bufferMeta.keyURI = pSegment->keyURI;
         memcpy( bufferMeta.key,pSegment->key, 16);
@@ -1107,6 +1533,9 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
         bufferMeta.totalNumStreams = pSession->currentGroupCount + 1;
         bufferMeta.pts = INVALID_PTS;
 
+        hlsTsScan_init(&tsScan);
+        pSegment->firstPts = INVALID_PTS;
+
         /* Keep going as long as we don't hit an error */
         while(rval == HLS_OK)
         {
@@ -1118,16 +1547,83 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                 break;
             }
 
-            /* Check the download thread status */
+            /* Pick up the progress of the range request */
+            if(pPart != NULL)
+            {
+                dlStatus = pPart->downloadStatus;
+                bDownloadComplete = pPart->bDownloadComplete;
+                bytesDownloaded = pPart->bytesDownloaded;
+
+                if(dlStatus == HLS_UNSUPPORTED)
+                {
+                    /* The server ignored the range request -- download the segment on its
+                       own, picking up from what was read already, and stop coalescing
+                       byte ranges */
+                    DEBUG(DBG_WARN, "server doesn't support range requests, downloading byte ranges one at a time");
+                    pSession->bNoRangeRuns = 1;
+
+                    fclose(fpRead);
+                    fpRead = NULL;
+                    unlink(filePath);
+                    free(filePath);
+                    filePath = NULL;
+
+                    cancelRangeRun(pSession);
+                    pPart = NULL;
+
+                    dlStatus = HLS_OK;
+                    bDownloadComplete = 0;
+                    bytesDownloaded = 0;
+
+                    rval = startSegmentDownload(pSession, pSegment, streamNum, &desc, &parallel, &filePath, &fpRead);
+                    if(rval != HLS_OK)
+                    {
+                        break;
+                    }
+                    bAsyncDlScheduled = (parallel.numParts == 0);
+                    continue;
+                }
+            }
+
+            /* Pick up the progress of the parallel download */
+            if(parallel.numParts > 0)
+            {
+                checkParallelDownload(&parallel, &dlStatus, &bDownloadComplete, &bytesDownloaded);
+
+                if(dlStatus == HLS_UNSUPPORTED)
+                {
+                    /* The server ignored the range requests -- start over on one
+                       connection, and stay on one for the rest of the session */
+                    DEBUG(DBG_WARN, "server doesn't support range requests, downloading segments over one connection");
+                    pSession->numConnections = 1;
+
+                    stopParallelDownload(&parallel, &bKillThread);
+                    parallel.numParts = 0;
+                    bKillThread = 0;
+                    dlStatus = HLS_OK;
+                    bDownloadComplete = 0;
+
+                    rval = hlsWorkerPool_schedule(&(desc.task), asyncSegmentDownloadTask, &desc);
+                    if(rval != HLS_OK)
+                    {
+                        ERROR("failed to schedule file download task");
+                        break;
+                    }
+                    bAsyncDlScheduled = 1;
+                    continue;
+                }
+            }
+
+            /* Check the download task status */
             if(dlStatus != HLS_OK)
             {
-                ERROR("download thread reports error %d", dlStatus);
+                ERROR("download task reports error %d", dlStatus);
                 rval = dlStatus;
                 break;
             }
 
             /* Get current time */
-            if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+            if(hlsClock_now(&wakeTime) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -1135,12 +1631,17 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
             }
 
             /* Get a new buffer if we're not currently operating on one */
-            if(buffer == NULL)
+            if(bLend)
+            {
+                /* The buffer is mapped once we know the data is there */
+                bufferSize = LEND_BUFFER_SIZE;
+            }
+            else if(buffer == NULL)
             {
                 bufferSize = 0;
 
                 /* Get a buffer from the player */
-                status = hlsPlayer_getBuffer(pSession->pHandle, &buffer, &bufferSize, &pPrivate);
+                status = hlsPlayer_getBuffer(pSession, &buffer, &bufferSize, &pPrivate);
                 if(status != SRC_SUCCESS)
                 {
                     ERROR("failed to get buffer from player");
@@ -1161,10 +1662,25 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                     DEBUG(DBG_INFO, "bufferSize adjusted to %d because of encryption", bufferSize);
                 }
 
+                /* The PID filter needs whole TS packets */
+                if(bFilter && (bufferSize % HLS_TS_PACKET_SIZE != 0))
+                {
+                    if(bufferSize < HLS_TS_PACKET_SIZE)
+                    {
+                        DEBUG(DBG_WARN, "%d byte buffers are too small to filter, not filtering the rest of the segment", bufferSize);
+                        bFilter = 0;
+                    }
+                    else
+                    {
+                        bufferSize = bufferSize - (bufferSize % HLS_TS_PACKET_SIZE);
+                        DEBUG(DBG_NOISE, "bufferSize adjusted to %d for PID filtering", bufferSize);
+                    }
+                }
+
                 /* If the above results in a bufferSize of 0, just send it back empty */
                 if(bufferSize == 0)
                 {
-                    status = hlsPlayer_sendBuffer(pSession->pHandle, buffer, 0, &bufferMeta, pPrivate);
+                    status = hlsPlayer_sendBuffer(pSession, buffer, 0, &bufferMeta, pPrivate);
                     if(status != SRC_SUCCESS)
                     {
                         ERROR("failed to send buffer to player");
@@ -1182,13 +1698,14 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                     else
                     {
                         /* If the download is currently in progress, we need to find out the current size
-                           of the file. */
+                           of the file.  A parallel download fills the file out of order, so for it this
+                           is the data before the first gap. */
 
                         /* Move the pointer to the end of the file */
-                        if(fseek(fpRead, 0, SEEK_END) == 0)
+                        if((parallel.numParts > 0) || (fseek(fpRead, 0, SEEK_END) == 0))
                         {
                             /* Get the current byte offset */
-                            fileSize = ftell(fpRead);
+                            fileSize = (parallel.numParts > 0) ? bytesDownloaded : ftell(fpRead);
                             if(fileSize == -1)
                             {
                                 ERROR("ftell() failed on file %s -- %s", filePath, strerror(errno));
@@ -1223,7 +1740,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                                    DEBUG(DBG_NOISE, "wait for %d milliseconds until more data is downloaded", DATA_WAIT_MSECS);
                                    pthread_mutex_lock(&(pSession->downloaderWakeMutex));
 
-                                   PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
+                                   hlsClock_timedWait(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
 
                                    pthread_mutex_unlock(&(pSession->downloaderWakeMutex));
 
@@ -1240,16 +1757,39 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
 
                     }
 
-                    /* Seek to current read posiiton */
-                    if(fseek(fpRead, bytesRead, SEEK_SET) != 0)
+                    if(bLend)
                     {
-                        ERROR("fseek() failed on file %s -- %s", filePath, strerror(errno));
-                        rval = HLS_FILE_ERROR;
-                        break;
+                        /* A complete download may leave less than a full buffer */
+                        if(bufferSize > (fileSize - bytesRead))
+                        {
+                            bufferSize = fileSize - bytesRead;
+                        }
+
+                        readSize = 0;
+                        if(bufferSize > 0)
+                        {
+                            rval = mapSegmentChunk(fpRead, bytesRead, bufferSize, &pChunk, &buffer);
+                            if(rval != HLS_OK)
+                            {
+                                ERROR("failed to map %d bytes of %s", bufferSize, filePath);
+                                break;
+                            }
+                            readSize = bufferSize;
+                        }
                     }
+                    else
+                    {
+                        /* Seek to current read posiiton */
+                        if(fseek(fpRead, bytesRead, SEEK_SET) != 0)
+                        {
+                            ERROR("fseek() failed on file %s -- %s", filePath, strerror(errno));
+                            rval = HLS_FILE_ERROR;
+                            break;
+                        }
 
-                    /* Read from our input file */
-                    readSize = fread(buffer, 1, bufferSize, fpRead);
+                        /* Read from our input file */
+                        readSize = fread(buffer, 1, bufferSize, fpRead);
+                    }
 
                     DEBUG(DBG_NOISE,"read %d bytes -- wanted %d", readSize, bufferSize);
 
@@ -1287,8 +1827,59 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                        bufferMeta.bFirstBufferInSegment = 0;
                     }
 
-                    status = hlsPlayer_sendBuffer(pSession->pHandle, buffer, readSize, &bufferMeta, pPrivate);
-                    if(status != SRC_SUCCESS)
+                    /* Scan the TS headers of clear segments for timestamps.  After a
+                       back-off the same bytes are read again, so only scan new ones. */
+                    if((bufferMeta.encType == SRC_ENC_NONE) && (bytesRead + readSize > scannedTo))
+                    {
+                       hlsTsScan_feed(&tsScan, (unsigned char*)buffer + (scannedTo - bytesRead), bytesRead + readSize - scannedTo);
+                       scannedTo = bytesRead + readSize;
+
+                       /* Stamp the buffer the first PTS was found in, unless an ID3 tag already did */
+                       if((pSegment->firstPts == INVALID_PTS) && (tsScan.firstPts != INVALID_PTS))
+                       {
+                          pSegment->firstPts = tsScan.firstPts;
+                          if(bufferMeta.pts == INVALID_PTS)
+                          {
+                             bufferMeta.pts = tsScan.firstPts;
+                             bTsPts = 1;
+                          }
+                       }
+                    }
+
+                    if(bLend)
+                    {
+                        if(readSize > 0)
+                        {
+                            lentSize = readSize;
+                            status = hlsPlayer_lendBuffer(pSession, buffer, &lentSize, &bufferMeta, releaseSegmentChunk, pChunk);
+                            if((status == SRC_SUCCESS) && (lentSize == 0))
+                            {
+                                /* The player is full -- take the chunk back and try again later */
+                                DEBUG(DBG_INFO,"player has no room for lent buffer, back off for a second");
+                                releaseSegmentChunk(pChunk);
+                                pChunk = NULL;
+                                buffer = NULL;
+
+                                rval = waitForPlayerBuffers(pSession, &wakeTime);
+                                continue;
+                            }
+
+                            /* Whatever happened, the player owns the chunk now */
+                            pChunk = NULL;
+                            buffer = NULL;
+                        }
+                    }
+                    else
+                    {
+                        sendSize = readSize;
+                        if(bFilter)
+                        {
+                            sendSize = hlsTsFilter_apply(&tsFilter, (unsigned char*)buffer, readSize);
+                        }
+
+                        status = hlsPlayer_sendBuffer(pSession, buffer, sendSize, &bufferMeta, pPrivate);
+                    }
+                    if(status != SRC_SUCCESS)
                     {
                         ERROR("failed to send buffer to player");
                         rval = HLS_ERROR;
@@ -1311,7 +1902,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                     {
                        playerSetData.setCode = SRC_PLAYER_SET_MODE;
                        playerSetData.pData = &playerMode;
-                       if(hlsPlayer_set(pSession->pHandle, &playerSetData) != SRC_SUCCESS)
+                       if(hlsPlayer_set(pSession, &playerSetData) != SRC_SUCCESS)
                        {
                           ERROR("failed to set player mode to %d", playerMode);
                           status = HLS_ERROR;
@@ -1322,18 +1913,33 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                        pSession->state = HLS_PLAYING;
 
                        TIMESTAMP(DBG_INFO, "PLAYING");
+
+                       /* Report the startup timeline the first time we get here after setDataSource() */
+                       if(hlsStats_markStartup(&(pSession->stats), SRC_STARTUP_PLAYING, &startup))
+                       {
+                          event.eventCode = SRC_PLUGIN_STARTUP_COMPLETE;
+                          event.pData = &startup;
+                          hlsPlayer_pluginEvtCallback(pSession->pHandle, &event);
+                       }
                     }
 
                     /* Set playbackStart timestamp */
                     if(((float)(pSession->playbackStart.tv_sec)) == 0)
                     {
-                        clock_gettime(CLOCK_MONOTONIC, &(pSession->playbackStart));
+                        hlsClock_now(&(pSession->playbackStart));
                         DEBUG(DBG_INFO, "Set playback start stamp to: %f", (float)(pSession->playbackStart.tv_sec));
                     }
 
                     /* Release our reference to the buffer */
                     buffer = NULL;
 
+                    /* Only the buffer holding the first PES header carries its PTS */
+                    if(bTsPts)
+                    {
+                        bufferMeta.pts = INVALID_PTS;
+                        bTsPts = 0;
+                    }
+
                     /* Increment the total bytes read */
                     bytesRead += readSize;
 
@@ -1343,6 +1949,18 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                     if(bDownloadComplete && (bytesRead == bytesDownloaded))
                     {
                         DEBUG(DBG_INFO, "download complete");
+                        if(tsScan.numPackets > 0)
+                        {
+                            DEBUG(DBG_INFO, "segment %d: first PTS %lld, last PTS %lld, first PCR %lld, %u discontinuities, %u CC errors",
+                                  pSegment->seqNum, tsScan.firstPts, tsScan.lastPts, tsScan.firstPcr,
+                                  tsScan.numDiscontinuities, tsScan.numCCErrors);
+                        }
+                        if(bFilter)
+                        {
+                            DEBUG(DBG_INFO, "segment %d: PID filter dropped %ld of %ld bytes",
+                                  pSegment->seqNum, tsFilter.bytesDropped, bytesRead);
+                        }
+                        HLS_PROBE(segment_push, pSession, pSegment->seqNum, bytesRead);
                         break;
                     }
                 }
@@ -1363,37 +1981,7 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                 /* Release our reference to the buffer */
                 buffer = NULL;
 
-                /* Lock the downloader wake mutex */
-                if(pthread_mutex_lock(&(pSession->downloaderWakeMutex)) != 0)
-                {
-                    ERROR("failed to lock downloader wake mutex");
-                    rval = HLS_ERROR;
-                    break;
-                }
-
-                /* Wait for LOOP_SECS before going again */
-                wakeTime.tv_sec += BUFFER_WAIT_SECS;
-
-                DEBUG(DBG_NOISE,"sleeping %d seconds until %d", (int)BUFFER_WAIT_SECS, (int)wakeTime.tv_sec);
-
-                /* Wait until wakeTime */
-                pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->downloaderWakeCond), &(pSession->downloaderWakeMutex), &wakeTime);
-
-                /* Unlock the downloader wake mutex */
-                if(pthread_mutex_unlock(&(pSession->downloaderWakeMutex)) != 0)
-                {
-                    ERROR("failed to unlock downloader wake mutex");
-                    rval = HLS_ERROR;
-                    break;
-                }
-
-                /* If the timedwait call failed we need to bail */
-                if((pthread_status != ETIMEDOUT) && (pthread_status != 0))
-                {
-                    ERROR("failed to timedwait on the downloader wake condition");
-                    rval = HLS_ERROR;
-                    break;
-                }
+                rval = waitForPlayerBuffers(pSession, &wakeTime);
             }
         }
         if(rval != HLS_OK)
@@ -1403,21 +1991,47 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
 
     } while(0);
 
-    /* Tell async thread to stop, if it hasn't already. */
+    /* Tell async download to stop, if it hasn't already. */
     bKillThread = 1;
 
-    /* Swallow the async thread */
-    if(asyncDlThread != 0)
+    /* Wait for the async download to finish with desc */
+    if(bAsyncDlScheduled)
+    {
+        hlsWorkerPool_wait(&(desc.task));
+        bAsyncDlScheduled = 0;
+    }
+
+    /* Wait for the parallel download to finish with its ranges */
+    if(parallel.numParts > 0)
+    {
+        stopParallelDownload(&parallel, &bKillThread);
+
+        if(rval == HLS_OK)
+        {
+            recordParallelRate(pSession, pSegment, &parallel, bytesDownloaded);
+        }
+        else if((dlStatus != HLS_OK) && (dlStatus != HLS_CANCELLED))
+        {
+            hlsStats_recordSegmentError(&(pSession->stats));
+        }
+
+        HLS_PROBE(segment_complete, pSession, pSegment->seqNum, bytesDownloaded, rval);
+        parallel.numParts = 0;
+    }
+
+    /* Unmap a chunk that was mapped but never lent */
+    if(pChunk != NULL)
     {
-        pthread_join(asyncDlThread, NULL);
-        asyncDlThread = 0;
+        releaseSegmentChunk(pChunk);
+        pChunk = NULL;
+        buffer = NULL;
     }
 
     /* If for some reason we are still holding a buffer (say we errored in the main loop)
        then send it back empty to make sure we don't leak memory. */
     if(buffer != NULL)
     {
-        status = hlsPlayer_sendBuffer(pSession->pHandle, buffer, 0, &bufferMeta, pPrivate);
+        status = hlsPlayer_sendBuffer(pSession, buffer, 0, &bufferMeta, pPrivate);
         if(status != SRC_SUCCESS)
         {
             ERROR("failed to send buffer to player");
@@ -1448,20 +2062,34 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
     free(filePath);
     filePath = NULL;
 
+    /* Drop the range request once its last segment is done, or if we
+       are giving up part way through it */
+    if((pPart != NULL) && (pSession->pRangeRun != NULL) &&
+       ((rval != HLS_OK) || (pSession->pRangeRun->nextPart == pSession->pRangeRun->numParts)))
+    {
+        cancelRangeRun(pSession);
+    }
+
     return rval;
 }
 
 /**
- * Thread body which downloads a given segment using cURL.
+ * Worker pool task which downloads a given segment using cURL.
+ * Runs as a single step.
  *
  * If the download is stopped via pDesc->pbKillThread, the
- * thread will exit with pDesc->pDownloadStatus HLS_CANCELLED.
+ * task will finish with pDesc->pDownloadStatus HLS_CANCELLED.
+ *
+ * @param pArg - pointer to an #asyncDlDesc_t which gives all
+ *             the parameters used for the download
+ * @param pNextRunTime - unused
  *
- * @param pDesc - pointer to an #asyncDlDesc_t which gives all
- *              the parameters used for the download
+ * @return #hlsTaskResult_t
  */
-void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
+hlsTaskResult_t asyncSegmentDownloadTask(void* pArg, struct timespec* pNextRunTime)
 {
+    asyncDlDesc_t* pDesc = (asyncDlDesc_t*)pArg;
+
     hlsStatus_t status = HLS_OK;
 
     long skipBytes = 0l;
@@ -1471,9 +2099,13 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
     char* filePath = NULL;
     FILE* fpWrite = NULL;
     float lastSegmentDldRate = 0.0f;
+    float ttfb = 0.0f;
+    float downloadTime = 0.0f;
 
     downloadHandle_t dlHandle;
     srcPluginErr_t error;
+    hlsDecrypt_t decrypt;
+    int bDecryptInit = 0;
 
     if((pDesc == NULL) ||
        (pDesc->pSession == NULL) ||
@@ -1484,7 +2116,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
        (pDesc->pbKillThread == NULL))
     {
         ERROR("invalid parameter");
-        pthread_exit(NULL);
+        return HLS_TASK_DONE;
     }
 
     do
@@ -1515,13 +2147,35 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
         dlHandle.fpTarget = fpWrite;
         dlHandle.pFileMutex = NULL;
         dlHandle.pbAbortDownload = pDesc->pbKillThread;
+        dlHandle.traceType = HLS_TRACE_SEGMENT;
+        dlHandle.pTraceSession = pDesc->pSession;
+        dlHandle.traceBitrate = pDesc->bitrate;
+        dlHandle.pDecrypt = NULL;
+        dlHandle.pSplit = NULL;
+        dlHandle.bytesReceived = 0;
+        dlHandle.bRangeRequired = 0;
+
+        /* Decrypt on the way to the file, overlapped with the download */
+        if(pDesc->bDecrypt)
+        {
+            bDecryptInit = 1;
+            status = hlsDecrypt_init(&decrypt, pDesc->pSegment->key, pDesc->pSegment->iv);
+            if(status != HLS_OK)
+            {
+                ERROR("failed to set up segment decryption");
+                break;
+            }
+            dlHandle.pDecrypt = &decrypt;
+        }
+
+        HLS_PROBE(segment_start, pDesc->pSession, pDesc->pSegment->seqNum, pDesc->bitrate);
 
         /* Retry the download indefinitely */
         while(status == HLS_OK)
         {
             if(*(pDesc->pbKillThread))
             {
-                DEBUG(DBG_WARN, "segment download thread signalled to stop");
+                DEBUG(DBG_WARN, "segment download task signalled to stop");
                 status = HLS_CANCELLED;
                 break;
             }
@@ -1537,7 +2191,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
             }
 
             /* Lock cURL mutex */
-            pthread_mutex_lock(pDesc->curlMutex);
+            HLS_MUTEX_LOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
 
             /* Download segment */
             status = curlDownloadFile(pDesc->pCurl, pDesc->pSegment->URL, &dlHandle, dlOffset, dlLength);
@@ -1547,7 +2201,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
                 {
                     DEBUG(DBG_WARN, "download stopped");
                     /* Unlock cURL mutex */
-                    pthread_mutex_unlock(pDesc->curlMutex);
+                    HLS_MUTEX_UNLOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
                     break;
                 }
                 else if(status == HLS_DL_ERROR)
@@ -1558,7 +2212,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
                     status = HLS_OK;
 
                     /* Unlock cURL mutex */
-                    pthread_mutex_unlock(pDesc->curlMutex);
+                    HLS_MUTEX_UNLOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
 
                     /* Flush all data to disk */
                     if(fflush(fpWrite) != 0)
@@ -1578,9 +2232,11 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
                         break;
                     }
 
-                    skipBytes = *(pDesc->pBytesDownloaded);
+                    /* The file holds clear data, but the resume offset is in encrypted bytes */
+                    skipBytes = (dlHandle.pDecrypt != NULL) ? decrypt.bytesIn : *(pDesc->pBytesDownloaded);
 
                     DEBUG(DBG_WARN, "ran into a network problem after downloading %ld bytes, will attempt to resume download", skipBytes);
+                    hlsStats_recordSegmentRetry(&(pDesc->pSession->stats));
                     error.errCode = SRC_PLUGIN_ERR_NETWORK;
                     snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p network error during segment download -- will retry", pDesc->pSession));
                     hlsPlayer_pluginErrCallback(pDesc->pSession->pHandle, &error);
@@ -1589,7 +2245,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
                 {
                     ERROR("failed to download segment");
                     /* Unlock cURL mutex */
-                    pthread_mutex_unlock(pDesc->curlMutex);
+                    HLS_MUTEX_UNLOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
 
                     break;
                 }
@@ -1602,7 +2258,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
             }
 
             /* Sleep for a bit, then try again */
-            usleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
+            hlsClock_sleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
         }
         if(status != HLS_OK)
         {
@@ -1615,12 +2271,29 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
         {
             ERROR("failed to get segment download rate");
             /* Unlock cURL mutex */
-            pthread_mutex_unlock(pDesc->curlMutex);
+            HLS_MUTEX_UNLOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
             break;
         }
 
+        /* Get the transfer timing for the session stats */
+        if(getCurlTransferTimes(pDesc->pCurl, &ttfb, &downloadTime) == HLS_OK)
+        {
+            hlsStats_recordSegment(&(pDesc->pSession->stats), ttfb, downloadTime);
+        }
+
         /* Unlock cURL mutex */
-        pthread_mutex_unlock(pDesc->curlMutex);
+        HLS_MUTEX_UNLOCK(pDesc->pSession, pDesc->curlLock, pDesc->curlMutex);
+
+        /* Write out the last block, without its padding */
+        if(dlHandle.pDecrypt != NULL)
+        {
+            status = hlsDecrypt_finish(&decrypt, fpWrite);
+            if(status != HLS_OK)
+            {
+                ERROR("failed to decrypt %s", pDesc->pSegment->URL);
+                break;
+            }
+        }
 
         /* Flush all data to disk */
         if(fflush(fpWrite) != 0)
@@ -1653,19 +2326,7 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
 
         fpWrite = NULL;
 
-        pthread_mutex_lock(&(pDesc->pSession->dldRateMutex));
-        pDesc->pSession->lastSegmentDldRate = lastSegmentDldRate;
-
-        /* Add bitrate to exponentially weighted moving average for this session */
-        if(pDesc->pSession->avgSegmentDldRate == 0)
-        {
-            pDesc->pSession->avgSegmentDldRate = pDesc->pSession->lastSegmentDldRate;
-        }
-        else
-        {
-            pDesc->pSession->avgSegmentDldRate = abrClientAddThroughputToAvg(pDesc->pSession->lastSegmentDldRate, pDesc->pSession->avgSegmentDldRate);
-        }
-        pthread_mutex_unlock(&(pDesc->pSession->dldRateMutex));
+        recordDownloadRate(pDesc->pSession, lastSegmentDldRate);
 
         /* Signal download complete */
         *(pDesc->pbDownloadComplete) = 1;
@@ -1681,12 +2342,981 @@ void asyncSegmentDownloadThread(asyncDlDesc_t* pDesc)
         fpWrite = NULL;
     }
 
+    if(bDecryptInit)
+    {
+        hlsDecrypt_term(&decrypt);
+    }
+
     free(filePath);
     filePath = NULL;
 
+    if((status != HLS_OK) && (status != HLS_CANCELLED))
+    {
+        hlsStats_recordSegmentError(&(pDesc->pSession->stats));
+    }
+
+    HLS_PROBE(segment_complete, pDesc->pSession, pDesc->pSegment->seqNum, *(pDesc->pBytesDownloaded), status);
+
     *(pDesc->pDownloadStatus) = status;
 
-    pthread_exit(NULL);
+    (void)pNextRunTime;
+
+    return HLS_TASK_DONE;
+}
+
+/**
+ * Feeds the throughput of a completed download to the session's
+ * download rate average.
+ *
+ * @param pSession - session
+ * @param lastSegmentDldRate - throughput of the download
+ */
+static void recordDownloadRate(hlsSession_t* pSession, float lastSegmentDldRate)
+{
+    pthread_mutex_lock(&(pSession->dldRateMutex));
+    pSession->lastSegmentDldRate = lastSegmentDldRate;
+
+    /* Add bitrate to exponentially weighted moving average for this session */
+    if(pSession->avgSegmentDldRate == 0)
+    {
+        pSession->avgSegmentDldRate = pSession->lastSegmentDldRate;
+    }
+    else
+    {
+        pSession->avgSegmentDldRate = abrClientAddThroughputToAvg(pSession->lastSegmentDldRate, pSession->avgSegmentDldRate);
+    }
+    pthread_mutex_unlock(&(pSession->dldRateMutex));
+}
+
+/**
+ * Starts a range request for pSegment and the segments which
+ * follow it in the current playlist, if they are consecutive byte
+ * ranges of the same resource.
+ *
+ * Only done for complete playlists, where the segments ahead of
+ * us are the ones the downloader will ask for next, and not for
+ * segments we decrypt, which need a cipher per segment.
+ *
+ * Only called from the downloader thread.
+ *
+ * @param pSession - session
+ * @param pSegment - copy of the segment the downloader is about to
+ *                 push; the current playlist's
+ *                 pLastDownloadedSegmentNode
+ * @param ppPart - set to the part for pSegment if a request was
+ *               started, NULL otherwise
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t startRangeRun(hlsSession_t* pSession, hlsSegment_t* pSegment, rangePart_t** ppPart)
+{
+    hlsStatus_t rval = HLS_OK;
+    hlsRangeRun_t* pRun = NULL;
+    hlsPlaylist_t* pMediaPlaylist = NULL;
+    llNode_t* pNode = NULL;
+    hlsSegment_t* pFirst = NULL;
+    hlsSegment_t* pNext = NULL;
+    rangePart_t* pPart = NULL;
+    char* basePath = NULL;
+    long bytesAhead = 0;
+    int bScheduled = 0;
+    int ii = 0;
+
+    *ppPart = NULL;
+
+    if((pSegment->byteLength <= 0) || pSession->bNoRangeRuns)
+    {
+        return HLS_OK;
+    }
+
+    do
+    {
+        pRun = malloc(sizeof(hlsRangeRun_t));
+        if(pRun == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+        memset(pRun, 0, sizeof(hlsRangeRun_t));
+
+        pRun->pSession = pSession;
+        pRun->parts[0].seqNum = pSegment->seqNum;
+        pRun->parts[0].byteOffset = pSegment->byteOffset;
+        pRun->parts[0].byteLength = pSegment->byteLength;
+        pRun->numParts = 1;
+
+        /* Collect the following segments while they continue the range */
+        playlistReadLock(pSession);
+
+        pMediaPlaylist = pSession->pCurrentPlaylist;
+        if((pMediaPlaylist != NULL) && (pMediaPlaylist->type == PL_MEDIA) &&
+           (pMediaPlaylist->pMediaData != NULL) &&
+           pMediaPlaylist->pMediaData->bHaveCompletePlaylist &&
+           !pMediaPlaylist->pMediaData->bIframesOnly &&
+           (pMediaPlaylist->pMediaData->pLastDownloadedSegmentNode != NULL))
+        {
+            pRun->bitrate = pMediaPlaylist->pMediaData->bitrate;
+
+            pNode = pMediaPlaylist->pMediaData->pLastDownloadedSegmentNode;
+            pFirst = (hlsSegment_t*)(pNode->pData);
+
+            if((pFirst != NULL) && (pFirst->seqNum == pSegment->seqNum) &&
+               (pFirst->byteOffset == pSegment->byteOffset))
+            {
+                for(pNode = pNode->pNext; (pNode != NULL) && (pRun->numParts < RANGE_RUN_MAX_SEGMENTS); pNode = pNode->pNext)
+                {
+                    pNext = (hlsSegment_t*)(pNode->pData);
+                    pPart = &(pRun->parts[pRun->numParts - 1]);
+
+                    if((pNext == NULL) || (pNext->URL == NULL) || (pFirst->URL == NULL) ||
+                       (strcmp(pNext->URL, pFirst->URL) != 0) ||
+                       (pNext->byteLength <= 0) ||
+                       (pNext->byteOffset != pPart->byteOffset + pPart->byteLength) ||
+                       (pSession->bDecrypt && (pNext->encType == SRC_ENC_AES128_CBC)) ||
+                       (bytesAhead + pNext->byteLength > RANGE_RUN_MAX_BYTES))
+                    {
+                        break;
+                    }
+
+                    pRun->parts[pRun->numParts].seqNum = pNext->seqNum;
+                    pRun->parts[pRun->numParts].byteOffset = pNext->byteOffset;
+                    pRun->parts[pRun->numParts].byteLength = pNext->byteLength;
+                    pRun->numParts++;
+                    bytesAhead += pNext->byteLength;
+                }
+            }
+        }
+
+        playlistUnlock(pSession);
+
+        /* Nothing to coalesce -- download the segment on its own */
+        if(pRun->numParts < 2)
+        {
+            break;
+        }
+
+        /* The request gets a handle of its own, so that playlist downloads
+           on the session's handle don't wait for several segments */
+        if(pSession->pRangeRunCurl == NULL)
+        {
+            rval = curlInit(&(pSession->pRangeRunCurl));
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to initialize CURL handle for range requests");
+                break;
+            }
+        }
+
+        pRun->URL = strdup(pSegment->URL);
+        if(pRun->URL == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        rval = getLocalPath(pSegment->URL, &basePath, pSession->sessionName);
+        if(rval != HLS_OK)
+        {
+            ERROR("error generating local path");
+            break;
+        }
+
+        /* The segments share a URL, so give each its own file, created
+           up front so that the reader never truncates data already written */
+        for(ii = 0; ii < pRun->numParts; ii++)
+        {
+            pPart = &(pRun->parts[ii]);
+
+            pPart->filePath = malloc(strlen(basePath) + 32);
+            if(pPart->filePath == NULL)
+            {
+                ERROR("malloc error");
+                rval = HLS_MEMORY_ERROR;
+                break;
+            }
+            sprintf(pPart->filePath, "%s.%ld", basePath, pPart->byteOffset);
+
+            pPart->fpWrite = fopen(pPart->filePath, "wb");
+            if(pPart->fpWrite == NULL)
+            {
+                ERROR("fopen() failed on file %s -- %s", pPart->filePath, strerror(errno));
+                rval = HLS_FILE_ERROR;
+                break;
+            }
+        }
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        DEBUG(DBG_INFO, "fetching segments %d-%d with one request for bytes %ld-%ld of %s",
+              pRun->parts[0].seqNum, pRun->parts[pRun->numParts - 1].seqNum,
+              pRun->parts[0].byteOffset, pSegment->byteOffset + pSegment->byteLength + bytesAhead - 1,
+              pRun->URL);
+
+        rval = hlsWorkerPool_schedule(&(pRun->task), asyncRangeRunTask, pRun);
+        if(rval != HLS_OK)
+        {
+            ERROR("failed to schedule range request task");
+            break;
+        }
+        bScheduled = 1;
+
+        /* The caller takes the first part */
+        pRun->nextPart = 1;
+        pSession->pRangeRun = pRun;
+        *ppPart = &(pRun->parts[0]);
+
+    } while(0);
+
+    free(basePath);
+    basePath = NULL;
+
+    if(!bScheduled && (pRun != NULL))
+    {
+        for(ii = 0; ii < pRun->numParts; ii++)
+        {
+            if(pRun->parts[ii].fpWrite != NULL)
+            {
+                fclose(pRun->parts[ii].fpWrite);
+                unlink(pRun->parts[ii].filePath);
+            }
+            free(pRun->parts[ii].filePath);
+        }
+        free(pRun->URL);
+        free(pRun);
+    }
+
+    return rval;
+}
+
+/**
+ * Checks whether pSegment is the next segment of the session's
+ * range request.  If it is not, the request is no longer useful
+ * (the downloader switched variants, seeked, ...) and is cancelled.
+ *
+ * Only called from the downloader thread.
+ *
+ * @param pSession - session
+ * @param pSegment - copy of the segment the downloader is about to push
+ *
+ * @return the part for pSegment, or NULL
+ */
+static rangePart_t* takeRangeRunPart(hlsSession_t* pSession, hlsSegment_t* pSegment)
+{
+    hlsRangeRun_t* pRun = pSession->pRangeRun;
+    rangePart_t* pPart = NULL;
+
+    if(pRun == NULL)
+    {
+        return NULL;
+    }
+
+    if(pRun->nextPart < pRun->numParts)
+    {
+        pPart = &(pRun->parts[pRun->nextPart]);
+
+        if((pPart->seqNum == pSegment->seqNum) &&
+           (pPart->byteOffset == pSegment->byteOffset) &&
+           (pPart->byteLength == pSegment->byteLength) &&
+           (strcmp(pRun->URL, pSegment->URL) == 0))
+        {
+            pRun->nextPart++;
+            return pPart;
+        }
+    }
+
+    DEBUG(DBG_INFO, "segment %d does not continue the range request, cancelling it", pSegment->seqNum);
+    cancelRangeRun(pSession);
+
+    return NULL;
+}
+
+/**
+ * Stops the session's range request, if any, and frees it along
+ * with the files of the segments nobody has taken yet.
+ *
+ * Only called from the downloader thread, between segments.
+ *
+ * @param pSession - session
+ */
+void cancelRangeRun(hlsSession_t* pSession)
+{
+    hlsRangeRun_t* pRun = NULL;
+    int ii = 0;
+
+    if((pSession == NULL) || (pSession->pRangeRun == NULL))
+    {
+        return;
+    }
+
+    pRun = pSession->pRangeRun;
+    pSession->pRangeRun = NULL;
+
+    /* Tell the task to stop, if it hasn't already, and wait for it */
+    pRun->bKill = 1;
+    hlsWorkerPool_wait(&(pRun->task));
+
+    for(ii = 0; ii < pRun->numParts; ii++)
+    {
+        if(pRun->parts[ii].fpWrite != NULL)
+        {
+            fclose(pRun->parts[ii].fpWrite);
+            pRun->parts[ii].fpWrite = NULL;
+        }
+
+        /* Taken parts are deleted by their reader */
+        if(ii >= pRun->nextPart)
+        {
+            unlink(pRun->parts[ii].filePath);
+        }
+
+        free(pRun->parts[ii].filePath);
+        pRun->parts[ii].filePath = NULL;
+    }
+
+    free(pRun->URL);
+    free(pRun);
+}
+
+/**
+ * #downloadSplitFunc_t of a range request: closes the file of the
+ * segment just completed and moves the request on to the next one.
+ *
+ * @param pArg - the #hlsRangeRun_t
+ * @param pHandle - download handle of the request
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t splitRangeRun(void* pArg, downloadHandle_t* pHandle)
+{
+    hlsRangeRun_t* pRun = (hlsRangeRun_t*)pArg;
+    rangePart_t* pPart = &(pRun->parts[pRun->writePart]);
+
+    /* Closing flushes the data for the reader before it is told the segment is complete */
+    if(fclose(pPart->fpWrite) != 0)
+    {
+        ERROR("fclose() failed on file %s -- %s", pPart->filePath, strerror(errno));
+        pPart->fpWrite = NULL;
+        return HLS_FILE_ERROR;
+    }
+    pPart->fpWrite = NULL;
+
+    pPart->bytesDownloaded = pPart->byteLength;
+    pPart->bDownloadComplete = 1;
+
+    DEBUG(DBG_INFO, "segment %d complete, %ld bytes", pPart->seqNum, pPart->byteLength);
+
+    HLS_PROBE(segment_complete, pRun->pSession, pPart->seqNum, pPart->byteLength, HLS_OK);
+
+    pRun->writePart++;
+
+    if(pRun->writePart < pRun->numParts)
+    {
+        pPart = &(pRun->parts[pRun->writePart]);
+        pHandle->fpTarget = pPart->fpWrite;
+        pHandle->splitRemaining = pPart->byteLength;
+
+        HLS_PROBE(segment_start, pRun->pSession, pPart->seqNum, pRun->bitrate);
+    }
+    else
+    {
+        pHandle->fpTarget = NULL;
+        pHandle->splitRemaining = 0;
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Worker pool task which runs a range request on the session's
+ * pRangeRunCurl handle.  Runs as a single step.
+ *
+ * Interrupted transfers are resumed from the first byte not yet
+ * received.  If the request is stopped via hlsRangeRun_t::bKill,
+ * or fails, the parts not yet complete are given its status.  A
+ * server which answers with anything but 206 Partial Content fails
+ * them with HLS_UNSUPPORTED before any of its answer is written.
+ *
+ * @param pArg - pointer to the #hlsRangeRun_t
+ * @param pNextRunTime - unused
+ *
+ * @return #hlsTaskResult_t
+ */
+static hlsTaskResult_t asyncRangeRunTask(void* pArg, struct timespec* pNextRunTime)
+{
+    hlsRangeRun_t* pRun = (hlsRangeRun_t*)pArg;
+    hlsSession_t* pSession = pRun->pSession;
+    rangePart_t* pLast = &(pRun->parts[pRun->numParts - 1]);
+
+    hlsStatus_t status = HLS_OK;
+
+    long dlOffset = 0l;
+    long rangeEnd = pLast->byteOffset + pLast->byteLength;
+    long respondCode = 0;
+    float lastSegmentDldRate = 0.0f;
+    float ttfb = 0.0f;
+    float downloadTime = 0.0f;
+    int bHaveRate = 0;
+    int ii = 0;
+
+    downloadHandle_t dlHandle;
+    srcPluginErr_t error;
+
+    /* Populate download handle struct */
+    dlHandle.fpTarget = pRun->parts[0].fpWrite;
+    dlHandle.pFileMutex = NULL;
+    dlHandle.pbAbortDownload = &(pRun->bKill);
+    dlHandle.traceType = HLS_TRACE_SEGMENT;
+    dlHandle.pTraceSession = pSession;
+    dlHandle.traceBitrate = pRun->bitrate;
+    dlHandle.pDecrypt = NULL;
+    dlHandle.pSplit = splitRangeRun;
+    dlHandle.pSplitArg = pRun;
+    dlHandle.splitRemaining = pRun->parts[0].byteLength;
+    dlHandle.bytesReceived = 0;
+    dlHandle.bRangeRequired = 1;
+
+    HLS_PROBE(segment_start, pSession, pRun->parts[0].seqNum, pRun->bitrate);
+
+    /* Retry the download indefinitely */
+    while(status == HLS_OK)
+    {
+        if(pRun->bKill)
+        {
+            DEBUG(DBG_WARN, "range request task signalled to stop");
+            status = HLS_CANCELLED;
+            break;
+        }
+
+        /* Pick up from the first byte we don't have yet */
+        dlOffset = pRun->parts[pRun->writePart].byteOffset +
+                   pRun->parts[pRun->writePart].byteLength - dlHandle.splitRemaining;
+
+        status = curlDownloadFile(pSession->pRangeRunCurl, pRun->URL, &dlHandle, dlOffset, rangeEnd - dlOffset);
+
+        /* A server that ignores the Range header would have us split the
+           start of the resource into the segments' files */
+        respondCode = 0;
+        curl_easy_getinfo(pSession->pRangeRunCurl, CURLINFO_RESPONSE_CODE, &respondCode);
+        if(((status == HLS_OK) || (status == HLS_DL_ERROR)) &&
+           (respondCode >= 200) && (respondCode < 300) && (respondCode != 206))
+        {
+            ERROR("server ignored range request for %s", pRun->URL);
+            status = HLS_UNSUPPORTED;
+            break;
+        }
+
+        if((status == HLS_OK) && (pRun->writePart == pRun->numParts))
+        {
+            /* One request, so one throughput sample and one set of transfer times */
+            if(getCurlTransferInfo(pSession->pRangeRunCurl, NULL, &lastSegmentDldRate, NULL) == HLS_OK)
+            {
+                bHaveRate = 1;
+            }
+
+            if(getCurlTransferTimes(pSession->pRangeRunCurl, &ttfb, &downloadTime) == HLS_OK)
+            {
+                hlsStats_recordSegment(&(pSession->stats), ttfb, downloadTime);
+            }
+
+            break;
+        }
+
+        if(status == HLS_CANCELLED)
+        {
+            DEBUG(DBG_WARN, "range request stopped");
+            break;
+        }
+
+        if(pRun->writePart == pRun->numParts)
+        {
+            /* Everything we asked for arrived before the transfer failed */
+            status = HLS_OK;
+            break;
+        }
+
+        if((status == HLS_OK) || (status == HLS_DL_ERROR))
+        {
+            /* Network problem, or the response ended early -- resume */
+            status = HLS_OK;
+
+            DEBUG(DBG_WARN, "range request interrupted at byte %ld, will attempt to resume it",
+                  pRun->parts[pRun->writePart].byteOffset + pRun->parts[pRun->writePart].byteLength - dlHandle.splitRemaining);
+            hlsStats_recordSegmentRetry(&(pSession->stats));
+            error.errCode = SRC_PLUGIN_ERR_NETWORK;
+            snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p network error during segment download -- will retry", pSession));
+            hlsPlayer_pluginErrCallback(pSession->pHandle, &error);
+        }
+        else
+        {
+            ERROR("range request failed");
+            break;
+        }
+
+        /* Sleep for a bit, then try again */
+        hlsClock_sleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
+    }
+
+    if(bHaveRate)
+    {
+        recordDownloadRate(pSession, lastSegmentDldRate);
+    }
+
+    if(status != HLS_OK)
+    {
+        if((status != HLS_CANCELLED) && (status != HLS_UNSUPPORTED) && (pRun->writePart < pRun->numParts))
+        {
+            hlsStats_recordSegmentError(&(pSession->stats));
+            HLS_PROBE(segment_complete, pSession, pRun->parts[pRun->writePart].seqNum, 0, status);
+        }
+
+        /* Fail the segments we didn't finish */
+        for(ii = pRun->writePart; ii < pRun->numParts; ii++)
+        {
+            pRun->parts[ii].downloadStatus = status;
+        }
+    }
+
+    (void)pNextRunTime;
+
+    return HLS_TASK_DONE;
+}
+
+/**
+ * Starts downloading pSegment as byte ranges fetched in parallel
+ * over pSession->numConnections connections, if the segment is
+ * large enough to be worth it.
+ *
+ * The size of a segment without a byte range is estimated from
+ * its duration and the variant bitrate.  The last range of such a
+ * segment runs to the end of the resource, and ranges which start
+ * beyond it come back empty.
+ *
+ * Only called from the downloader thread, for main stream
+ * segments.
+ *
+ * @param pSession - session
+ * @param pSegment - segment to download
+ * @param bitrate - bitrate of the variant the segment belongs to
+ * @param filePath - segment file, which must exist
+ * @param pbKillThread - pointer to flag which will signal the
+ *                     download to stop when it is TRUE
+ * @param pParallel - set up with the ranges; numParts is the
+ *                  number of ranges scheduled, 0 if the segment is
+ *                  to be downloaded over one connection
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t startParallelDownload(hlsSession_t* pSession, hlsSegment_t* pSegment, int bitrate,
+                                         char* filePath, int* pbKillThread, parallelDl_t* pParallel)
+{
+    hlsStatus_t rval = HLS_OK;
+    parallelPart_t* pPart = NULL;
+    int numConnections = pSession->numConnections;
+    int numParts = 0;
+    long size = 0;
+    long partLength = 0;
+    int ii = 0;
+
+    pParallel->numParts = 0;
+
+    if(numConnections < 2)
+    {
+        return HLS_OK;
+    }
+
+    if(pSegment->byteLength > 0)
+    {
+        size = pSegment->byteLength;
+    }
+    else
+    {
+        size = (long)(pSegment->duration * bitrate / 8);
+    }
+
+    numParts = size / PARALLEL_MIN_PART_BYTES;
+    if(numParts > numConnections)
+    {
+        numParts = numConnections;
+    }
+
+    if(numParts < 2)
+    {
+        return HLS_OK;
+    }
+
+    partLength = size / numParts;
+
+    do
+    {
+        /* Part 0 uses the session's handle, the others one of our own each */
+        for(ii = 0; ii < numParts - 1; ii++)
+        {
+            if(pSession->pParallelCurl[ii] == NULL)
+            {
+                rval = curlInit(&(pSession->pParallelCurl[ii]));
+                if(rval != HLS_OK)
+                {
+                    ERROR("failed to initialize CURL handle for connection %d", ii + 1);
+                    break;
+                }
+            }
+        }
+        if(rval != HLS_OK)
+        {
+            break;
+        }
+
+        DEBUG(DBG_INFO, "downloading segment %d (%ld bytes%s) as %d ranges", pSegment->seqNum, size,
+              (pSegment->byteLength > 0) ? "" : " estimated", numParts);
+
+        HLS_PROBE(segment_start, pSession, pSegment->seqNum, bitrate);
+
+        for(ii = 0; ii < numParts; ii++)
+        {
+            pPart = &(pParallel->parts[ii]);
+            memset(pPart, 0, sizeof(parallelPart_t));
+
+            pPart->pSession = pSession;
+            pPart->pSegment = pSegment;
+            pPart->index = ii;
+            pPart->offset = ii * partLength;
+            pPart->filePath = filePath;
+
+            if(ii == 0)
+            {
+                pPart->pCurl = pSession->pCurl;
+                pPart->curlMutex = &(pSession->curlMutex);
+            }
+            else
+            {
+                pPart->pCurl = pSession->pParallelCurl[ii - 1];
+                pPart->curlMutex = NULL;
+            }
+
+            /* The last range takes whatever is left */
+            if(ii < numParts - 1)
+            {
+                pPart->length = partLength;
+            }
+            else if(pSegment->byteLength > 0)
+            {
+                pPart->length = size - pPart->offset;
+            }
+            else
+            {
+                pPart->length = 0;
+            }
+
+            pPart->dlHandle.pbAbortDownload = pbKillThread;
+            pPart->dlHandle.traceType = HLS_TRACE_SEGMENT;
+            pPart->dlHandle.pTraceSession = pSession;
+            pPart->dlHandle.traceBitrate = bitrate;
+            pPart->dlHandle.bRangeRequired = 1;
+
+            rval = hlsWorkerPool_schedule(&(pPart->task), asyncParallelPartTask, pPart);
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to schedule range download task");
+                break;
+            }
+            pParallel->numParts++;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Sums up the progress of a parallel download.
+ *
+ * @param pParallel - the download
+ * @param pStatus - set to the first error reported by a range,
+ *                HLS_OK if there is none
+ * @param pbComplete - set to TRUE once all of the ranges are
+ *                   complete
+ * @param pBytes - set to the number of bytes at the start of the
+ *               segment file that have been downloaded
+ */
+static void checkParallelDownload(parallelDl_t* pParallel, hlsStatus_t* pStatus, int* pbComplete, long* pBytes)
+{
+    parallelPart_t* pPart = NULL;
+    int bPartComplete = 0;
+    long bytesReceived = 0;
+    int bContiguous = 1;
+    int ii = 0;
+
+    *pStatus = HLS_OK;
+    *pbComplete = 1;
+    *pBytes = 0;
+
+    for(ii = 0; ii < pParallel->numParts; ii++)
+    {
+        pPart = &(pParallel->parts[ii]);
+
+        if(pPart->downloadStatus != HLS_OK)
+        {
+            *pStatus = pPart->downloadStatus;
+            *pbComplete = 0;
+            return;
+        }
+
+        /* Read the flag first; once it is set the byte count is final */
+        bPartComplete = pPart->bDownloadComplete;
+        bytesReceived = pPart->dlHandle.bytesReceived;
+
+        if(!bPartComplete)
+        {
+            *pbComplete = 0;
+        }
+
+        /* A range that is incomplete, or came back short because the
+           segment ends in it, is the last one the reader can go into */
+        if(bContiguous)
+        {
+            *pBytes += bytesReceived;
+
+            if(!bPartComplete || ((pPart->length > 0) && (bytesReceived < pPart->length)))
+            {
+                bContiguous = 0;
+            }
+        }
+    }
+}
+
+/**
+ * Stops the ranges of a parallel download which are still running
+ * and waits for all of them to finish.
+ *
+ * @param pParallel - the download
+ * @param pbKillThread - flag the ranges were started with
+ */
+static void stopParallelDownload(parallelDl_t* pParallel, int* pbKillThread)
+{
+    int ii = 0;
+
+    *pbKillThread = 1;
+
+    for(ii = 0; ii < pParallel->numParts; ii++)
+    {
+        hlsWorkerPool_wait(&(pParallel->parts[ii].task));
+    }
+}
+
+/**
+ * Feeds the aggregate throughput of a completed parallel download
+ * to the session's download rate average and stats.  The ranges
+ * run side by side, so the download took as long as the slowest
+ * of them.
+ *
+ * @param pSession - session
+ * @param pSegment - segment that was downloaded
+ * @param pParallel - the download, with all of its ranges finished
+ * @param bytes - size of the segment
+ */
+static void recordParallelRate(hlsSession_t* pSession, hlsSegment_t* pSegment, parallelDl_t* pParallel, long bytes)
+{
+    float downloadTime = 0.0f;
+    float lastSegmentDldRate = 0.0f;
+    int ii = 0;
+
+    for(ii = 0; ii < pParallel->numParts; ii++)
+    {
+        if(pParallel->parts[ii].downloadTime > downloadTime)
+        {
+            downloadTime = pParallel->parts[ii].downloadTime;
+        }
+    }
+
+    if(downloadTime <= 0)
+    {
+        return;
+    }
+
+    /* Same units as getCurlTransferInfo() */
+    lastSegmentDldRate = (bytes * 8) / downloadTime / hlsClock_getScale();
+
+    DEBUG(DBG_INFO, "segment %d: %ld bytes over %d connections in %f s -- %5.2f bps",
+          pSegment->seqNum, bytes, pParallel->numParts, downloadTime, lastSegmentDldRate);
+
+    hlsStats_recordSegment(&(pSession->stats), pParallel->parts[0].ttfb, downloadTime);
+
+    recordDownloadRate(pSession, lastSegmentDldRate);
+}
+
+/**
+ * Worker pool task which downloads one range of a parallel
+ * download into its place in the segment file.  Runs as a single
+ * step.
+ *
+ * Interrupted transfers are resumed from the first byte not yet
+ * received.  A server which answers with anything but 206 Partial
+ * Content fails the range with HLS_UNSUPPORTED before any data is
+ * written.
+ *
+ * @param pArg - pointer to the #parallelPart_t
+ * @param pNextRunTime - unused
+ *
+ * @return #hlsTaskResult_t
+ */
+static hlsTaskResult_t asyncParallelPartTask(void* pArg, struct timespec* pNextRunTime)
+{
+    parallelPart_t* pPart = (parallelPart_t*)pArg;
+    hlsSession_t* pSession = pPart->pSession;
+
+    hlsStatus_t status = HLS_OK;
+
+    FILE* fpWrite = NULL;
+    long dlOffset = 0l;
+    long dlLength = 0l;
+    long respondCode = 0;
+
+    srcPluginErr_t error;
+
+    do
+    {
+        /* The reader created the file; the ranges only write their own parts of it */
+        fpWrite = fopen(pPart->filePath, "r+b");
+        if(fpWrite == NULL)
+        {
+            ERROR("fopen() failed on file %s -- %s", pPart->filePath, strerror(errno));
+            status = HLS_FILE_ERROR;
+            break;
+        }
+
+        /* Unbuffered, so that the data is in the file by the time
+           dlHandle.bytesReceived counts it */
+        setvbuf(fpWrite, NULL, _IONBF, 0);
+
+        if(fseek(fpWrite, pPart->offset, SEEK_SET) != 0)
+        {
+            ERROR("fseek() failed on file %s -- %s", pPart->filePath, strerror(errno));
+            status = HLS_FILE_ERROR;
+            break;
+        }
+
+        pPart->dlHandle.fpTarget = fpWrite;
+
+        /* Retry the download indefinitely */
+        while(status == HLS_OK)
+        {
+            if(*(pPart->dlHandle.pbAbortDownload))
+            {
+                DEBUG(DBG_WARN, "range download task signalled to stop");
+                status = HLS_CANCELLED;
+                break;
+            }
+
+            /* Pick up from the first byte we don't have yet */
+            dlOffset = pPart->pSegment->byteOffset + pPart->offset + pPart->dlHandle.bytesReceived;
+            dlLength = 0;
+            if(pPart->length > 0)
+            {
+                dlLength = pPart->length - pPart->dlHandle.bytesReceived;
+                if(dlLength <= 0)
+                {
+                    /* Everything we asked for arrived before the transfer failed */
+                    break;
+                }
+            }
+
+            /* Lock cURL mutex */
+            if(pPart->curlMutex != NULL)
+            {
+                HLS_MUTEX_LOCK(pSession, SRC_LOCK_CURL, pPart->curlMutex);
+            }
+
+            status = curlDownloadFile(pPart->pCurl, pPart->pSegment->URL, &(pPart->dlHandle), dlOffset, dlLength);
+
+            respondCode = 0;
+            curl_easy_getinfo(pPart->pCurl, CURLINFO_RESPONSE_CODE, &respondCode);
+
+            if(status == HLS_OK)
+            {
+                getCurlTransferTimes(pPart->pCurl, &(pPart->ttfb), &(pPart->downloadTime));
+            }
+
+            /* Unlock cURL mutex */
+            if(pPart->curlMutex != NULL)
+            {
+                HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_CURL, pPart->curlMutex);
+            }
+
+            if(status == HLS_CANCELLED)
+            {
+                DEBUG(DBG_WARN, "range download stopped");
+                break;
+            }
+
+            if(((status == HLS_OK) || (status == HLS_DL_ERROR)) &&
+               (respondCode >= 200) && (respondCode < 300) && (respondCode != 206))
+            {
+                ERROR("server ignored range request for %s", pPart->pSegment->URL);
+                status = HLS_UNSUPPORTED;
+                break;
+            }
+
+            if(status == HLS_OK)
+            {
+                /* A short response means the segment ends in this range */
+                break;
+            }
+
+            if((respondCode == 416) && (pPart->index > 0))
+            {
+                /* The segment ends before this range, which happens when its
+                   size was an estimate */
+                DEBUG(DBG_INFO, "range %d of %s is past the end of the segment", pPart->index, pPart->pSegment->URL);
+                status = HLS_OK;
+                break;
+            }
+
+            if(status == HLS_DL_ERROR)
+            {
+                /* Network problem -- resume */
+                status = HLS_OK;
+
+                DEBUG(DBG_WARN, "range %d of %s interrupted after %ld bytes, will attempt to resume it",
+                      pPart->index, pPart->pSegment->URL, pPart->dlHandle.bytesReceived);
+                hlsStats_recordSegmentRetry(&(pSession->stats));
+                error.errCode = SRC_PLUGIN_ERR_NETWORK;
+                snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p network error during segment download -- will retry", pSession));
+                hlsPlayer_pluginErrCallback(pSession->pHandle, &error);
+            }
+            else
+            {
+                ERROR("range download failed");
+                break;
+            }
+
+            /* Sleep for a bit, then try again */
+            hlsClock_sleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
+        }
+
+    } while(0);
+
+    if(fpWrite != NULL)
+    {
+        fclose(fpWrite);
+        fpWrite = NULL;
+    }
+
+    if(status == HLS_OK)
+    {
+        pPart->bDownloadComplete = 1;
+    }
+    else
+    {
+        pPart->downloadStatus = status;
+    }
+
+    (void)pNextRunTime;
+
+    return HLS_TASK_DONE;
 }
 
 #ifdef __cplusplus
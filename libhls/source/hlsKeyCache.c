@@ -0,0 +1,601 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsKeyCache.c @date October 19, 2026
+ *
+ * Per-session cache of EXT-X-KEY decryption keys.
+ *
+ * The playlist parser calls hlsKeyCache_lookup() for every key it
+ * sees; keys that are not cached yet are queued for a fetch task on
+ * the worker pool, so that the key of a rotation is normally in hand
+ * before the first segment that needs it is downloaded.  The fetch
+ * task handles one key at a time on a CURL handle of its own, which
+ * keeps the connection to the key server alive between rotations.
+ * The downloader calls hlsKeyCache_get(), which only blocks if the
+ * prefetch has not completed yet and retries failed fetches.
+ *
+ * The least recently used key is evicted when the cache is full.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hlsKeyCache.h"
+#include "hlsWorkerPool.h"
+#include "hlsClock.h"
+#include "hlsStats.h"
+#include "curlUtils.h"
+
+#include "debug.h"
+
+/* Number of times hlsKeyCache_get() fetches a key before giving up */
+#define HLS_KEY_FETCH_ATTEMPTS 3
+
+/* How often hlsKeyCache_get() checks its abort flag while waiting */
+#define HLS_KEY_WAIT_MSECS 100
+
+/* How long the fetch task sleeps when there is nothing to fetch; it
+   is woken as soon as a key is queued */
+#define HLS_KEY_IDLE_SECS 60
+
+/* Key as received from the server */
+typedef struct {
+    char data[16];
+    size_t length;      /* Total bytes received, may exceed sizeof(data) */
+} keyData_t;
+
+static size_t keyWriteCallback(void* pContents, size_t size, size_t nmemb, void* pUserData)
+{
+    keyData_t* pData = (keyData_t*)pUserData;
+    size_t total = size * nmemb;
+    size_t copy = 0;
+
+    if(pData->length < sizeof(pData->data))
+    {
+        copy = sizeof(pData->data) - pData->length;
+        if(copy > total)
+        {
+            copy = total;
+        }
+        memcpy(pData->data + pData->length, pContents, copy);
+    }
+
+    pData->length += total;
+
+    return total;
+}
+
+/**
+ * Downloads a key.  Only called from the fetch task.
+ *
+ * @param pCache - key cache
+ * @param pKeyURI - absolute key URI
+ * @param pKey - receives the 16 byte key
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t fetchKey(hlsKeyCache_t* pCache, const char* pKeyURI, char* pKey)
+{
+    hlsStatus_t rval = HLS_OK;
+    CURLcode curlResult = CURLE_OK;
+    keyData_t keyData;
+
+    do
+    {
+        if(pCache->pCurl == NULL)
+        {
+            rval = curlInit(&(pCache->pCurl));
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to initialize CURL handle for key download");
+                pCache->pCurl = NULL;
+                break;
+            }
+        }
+
+        memset(&keyData, 0, sizeof(keyData));
+
+        if((curl_easy_setopt(pCache->pCurl, CURLOPT_URL, pKeyURI) != CURLE_OK) ||
+           (curl_easy_setopt(pCache->pCurl, CURLOPT_WRITEFUNCTION, keyWriteCallback) != CURLE_OK) ||
+           (curl_easy_setopt(pCache->pCurl, CURLOPT_WRITEDATA, (void*)&keyData) != CURLE_OK))
+        {
+            ERROR("failed to set up key download");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        curlResult = curl_easy_perform(pCache->pCurl);
+
+        traceCurlTransfer(pCache->pCurl, HLS_TRACE_KEY, pCache->pSession, 0,
+                          (curlResult == CURLE_OK) ? HLS_OK : HLS_DL_ERROR);
+
+        if(curlResult != CURLE_OK)
+        {
+            ERROR("key download from %s failed: %s", pKeyURI, curl_easy_strerror(curlResult));
+            rval = HLS_DL_ERROR;
+            break;
+        }
+
+        if(keyData.length != sizeof(keyData.data))
+        {
+            ERROR("key from %s is %d bytes, expected %d", pKeyURI, (int)keyData.length, (int)sizeof(keyData.data));
+            rval = HLS_ERROR;
+            break;
+        }
+
+        memcpy(pKey, keyData.data, sizeof(keyData.data));
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Fetch task: downloads pending keys one at a time.
+ *
+ * @param pArg - key cache
+ * @param pNextRunTime - see #hlsTaskFunc_t
+ *
+ * @return #hlsTaskResult_t
+ */
+static hlsTaskResult_t keyFetchTask(void* pArg, struct timespec* pNextRunTime)
+{
+    hlsKeyCache_t* pCache = (hlsKeyCache_t*)pArg;
+    hlsKeyCacheEntry_t* pEntry = NULL;
+    hlsStatus_t status = HLS_OK;
+    char key[16];
+    int ii = 0;
+
+    pthread_mutex_lock(&(pCache->mutex));
+
+    if(pCache->bStop)
+    {
+        pthread_mutex_unlock(&(pCache->mutex));
+        return HLS_TASK_DONE;
+    }
+
+    for(ii = 0; ii < HLS_KEY_CACHE_SIZE; ii++)
+    {
+        if(pCache->entries[ii].state == HLS_KEY_PENDING)
+        {
+            pEntry = &(pCache->entries[ii]);
+            pEntry->state = HLS_KEY_FETCHING;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&(pCache->mutex));
+
+    hlsClock_now(pNextRunTime);
+
+    if(pEntry == NULL)
+    {
+        pNextRunTime->tv_sec += HLS_KEY_IDLE_SECS;
+        return HLS_TASK_RESCHEDULE;
+    }
+
+    /* FETCHING entries are never evicted, so pEntry->keyURI stays
+       valid without the lock */
+    status = fetchKey(pCache, pEntry->keyURI, key);
+
+    pthread_mutex_lock(&(pCache->mutex));
+
+    if(status == HLS_OK)
+    {
+        DEBUG(DBG_INFO, "fetched key %s", pEntry->keyURI);
+        memcpy(pEntry->key, key, sizeof(pEntry->key));
+        pEntry->state = HLS_KEY_READY;
+    }
+    else
+    {
+        pEntry->state = HLS_KEY_FAILED;
+    }
+
+    pthread_cond_broadcast(&(pCache->fetchCond));
+
+    pthread_mutex_unlock(&(pCache->mutex));
+
+    if(status == HLS_OK)
+    {
+        hlsStats_markStartup(pCache->pStats, SRC_STARTUP_KEY, NULL);
+    }
+
+    /* Look for more work straight away */
+    hlsClock_now(pNextRunTime);
+
+    return HLS_TASK_RESCHEDULE;
+}
+
+/**
+ * Gets the fetch task to look at the pending keys, scheduling
+ * it on first use.  Must be called with the cache mutex held.
+ *
+ * @param pCache - key cache
+ */
+static void kickFetchTask(hlsKeyCache_t* pCache)
+{
+    if(!pCache->bTaskScheduled)
+    {
+        if(hlsWorkerPool_schedule(&(pCache->task), keyFetchTask, pCache) != HLS_OK)
+        {
+            ERROR("failed to schedule key fetch task");
+            return;
+        }
+        pCache->bTaskScheduled = 1;
+    }
+    else
+    {
+        hlsWorkerPool_wake(&(pCache->task));
+    }
+}
+
+static hlsKeyCacheEntry_t* findEntry(hlsKeyCache_t* pCache, const char* pKeyURI)
+{
+    int ii = 0;
+
+    for(ii = 0; ii < HLS_KEY_CACHE_SIZE; ii++)
+    {
+        if((pCache->entries[ii].keyURI != NULL) &&
+           (strcmp(pCache->entries[ii].keyURI, pKeyURI) == 0))
+        {
+            return &(pCache->entries[ii]);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Adds a pending entry for pKeyURI, evicting the least recently
+ * used entry that is not waiting for or being fetched.  Must be
+ * called with the cache mutex held.
+ *
+ * @param pCache - key cache
+ * @param pKeyURI - absolute key URI
+ *
+ * @return new entry, or NULL if every entry is busy
+ */
+static hlsKeyCacheEntry_t* addEntry(hlsKeyCache_t* pCache, const char* pKeyURI)
+{
+    hlsKeyCacheEntry_t* pEntry = NULL;
+    char* pCopy = NULL;
+    int ii = 0;
+
+    for(ii = 0; ii < HLS_KEY_CACHE_SIZE; ii++)
+    {
+        hlsKeyCacheEntry_t* pCandidate = &(pCache->entries[ii]);
+
+        if(pCandidate->state == HLS_KEY_EMPTY)
+        {
+            pEntry = pCandidate;
+            break;
+        }
+
+        if(((pCandidate->state == HLS_KEY_READY) || (pCandidate->state == HLS_KEY_FAILED)) &&
+           ((pEntry == NULL) || (pCandidate->lastUse < pEntry->lastUse)))
+        {
+            pEntry = pCandidate;
+        }
+    }
+
+    if(pEntry == NULL)
+    {
+        return NULL;
+    }
+
+    pCopy = strdup(pKeyURI);
+    if(pCopy == NULL)
+    {
+        ERROR("malloc error");
+        return NULL;
+    }
+
+    if(pEntry->keyURI != NULL)
+    {
+        DEBUG(DBG_INFO, "evicting key %s", pEntry->keyURI);
+        free(pEntry->keyURI);
+    }
+
+    memset(pEntry, 0, sizeof(hlsKeyCacheEntry_t));
+    pEntry->keyURI = pCopy;
+    pEntry->state = HLS_KEY_PENDING;
+    pEntry->lastUse = ++(pCache->useCount);
+
+    return pEntry;
+}
+
+/**
+ * Creates a session's key cache.  The fetch task and its CURL
+ * handle are only set up once the first key is looked up.
+ *
+ * @param pStats - session counters, for the SRC_STARTUP_KEY milestone
+ * @param pSession - session the key transfers are traced against
+ * @param ppCache - receives the new cache; *ppCache must be NULL
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsKeyCache_create(hlsSessionStats_t* pStats, void* pSession, hlsKeyCache_t** ppCache)
+{
+    hlsStatus_t rval = HLS_OK;
+    pthread_condattr_t condAttr;
+
+    if((pStats == NULL) || (ppCache == NULL) || (*ppCache != NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        *ppCache = malloc(sizeof(hlsKeyCache_t));
+        if(*ppCache == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        memset(*ppCache, 0, sizeof(hlsKeyCache_t));
+
+        (*ppCache)->pStats = pStats;
+        (*ppCache)->pSession = pSession;
+
+        if(pthread_condattr_init(&condAttr) != 0)
+        {
+            ERROR("failed to initialize condition attribute");
+            free(*ppCache);
+            *ppCache = NULL;
+            rval = HLS_ERROR;
+            break;
+        }
+
+/* Bionic C doesn't define this in pthread.h -- see definition of
+   PTHREAD_COND_TIMEDWAIT in hlsTypes.h for more info */
+#ifndef ANDROID
+        /* Set the clock to use for pthread conditions to CLOCK_MONOTONIC */
+        pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+#endif
+
+        if(pthread_cond_init(&((*ppCache)->fetchCond), &condAttr) != 0)
+        {
+            ERROR("failed to initialize key fetch condition");
+            pthread_condattr_destroy(&condAttr);
+            free(*ppCache);
+            *ppCache = NULL;
+            rval = HLS_ERROR;
+            break;
+        }
+
+        pthread_condattr_destroy(&condAttr);
+
+        if(pthread_mutex_init(&((*ppCache)->mutex), NULL) != 0)
+        {
+            ERROR("failed to initialize key cache mutex");
+            pthread_cond_destroy(&((*ppCache)->fetchCond));
+            free(*ppCache);
+            *ppCache = NULL;
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Stops the fetch task, waiting for a key download in progress to
+ * finish, and frees the cache.
+ *
+ * @param pCache - key cache; can be NULL
+ */
+void hlsKeyCache_destroy(hlsKeyCache_t* pCache)
+{
+    int ii = 0;
+
+    if(pCache == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pCache->mutex));
+    pCache->bStop = 1;
+    pthread_mutex_unlock(&(pCache->mutex));
+
+    if(pCache->bTaskScheduled)
+    {
+        hlsWorkerPool_wake(&(pCache->task));
+        hlsWorkerPool_wait(&(pCache->task));
+    }
+
+    if(pCache->pCurl != NULL)
+    {
+        curlTerm(pCache->pCurl);
+        pCache->pCurl = NULL;
+    }
+
+    for(ii = 0; ii < HLS_KEY_CACHE_SIZE; ii++)
+    {
+        free(pCache->entries[ii].keyURI);
+    }
+
+    pthread_cond_destroy(&(pCache->fetchCond));
+    pthread_mutex_destroy(&(pCache->mutex));
+
+    free(pCache);
+}
+
+/**
+ * Looks up a key without blocking.  If the key is not cached, or
+ * its last fetch failed, a fetch is queued so that a later lookup
+ * or hlsKeyCache_get() finds it.
+ *
+ * @param pCache - key cache
+ * @param pKeyURI - absolute key URI
+ * @param pKey - receives the 16 byte key if it is cached
+ *
+ * @return TRUE if pKey was filled in, FALSE otherwise
+ */
+int hlsKeyCache_lookup(hlsKeyCache_t* pCache, const char* pKeyURI, char* pKey)
+{
+    hlsKeyCacheEntry_t* pEntry = NULL;
+    int bFound = 0;
+
+    if((pCache == NULL) || (pKeyURI == NULL) || (pKey == NULL))
+    {
+        ERROR("invalid parameter");
+        return 0;
+    }
+
+    pthread_mutex_lock(&(pCache->mutex));
+
+    pEntry = findEntry(pCache, pKeyURI);
+    if(pEntry == NULL)
+    {
+        DEBUG(DBG_INFO, "prefetching key %s", pKeyURI);
+
+        pEntry = addEntry(pCache, pKeyURI);
+        if(pEntry != NULL)
+        {
+            kickFetchTask(pCache);
+        }
+    }
+    else
+    {
+        pEntry->lastUse = ++(pCache->useCount);
+
+        if(pEntry->state == HLS_KEY_READY)
+        {
+            memcpy(pKey, pEntry->key, sizeof(pEntry->key));
+            bFound = 1;
+        }
+        else if(pEntry->state == HLS_KEY_FAILED)
+        {
+            pEntry->state = HLS_KEY_PENDING;
+            kickFetchTask(pCache);
+        }
+    }
+
+    pthread_mutex_unlock(&(pCache->mutex));
+
+    return bFound;
+}
+
+/**
+ * Gets a key, waiting for it to be fetched if necessary.  A failed
+ * fetch is retried up to HLS_KEY_FETCH_ATTEMPTS times in all.
+ *
+ * @param pCache - key cache
+ * @param pKeyURI - absolute key URI
+ * @param pKey - receives the 16 byte key
+ * @param pbAbort - checked while waiting; the wait ends with
+ *                  #HLS_CANCELLED once it is TRUE
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsKeyCache_get(hlsKeyCache_t* pCache, const char* pKeyURI, char* pKey, int* pbAbort)
+{
+    hlsStatus_t rval = HLS_OK;
+    hlsKeyCacheEntry_t* pEntry = NULL;
+    struct timespec wakeTime;
+    int numFailures = 0;
+
+    if((pCache == NULL) || (pKeyURI == NULL) || (pKey == NULL) || (pbAbort == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(pCache->mutex));
+
+    while(1)
+    {
+        if(*pbAbort || pCache->bStop)
+        {
+            rval = HLS_CANCELLED;
+            break;
+        }
+
+        /* Look the entry up on every pass -- it may have been evicted
+           and re-added while we were waiting */
+        pEntry = findEntry(pCache, pKeyURI);
+        if(pEntry == NULL)
+        {
+            DEBUG(DBG_WARN, "key %s was not prefetched", pKeyURI);
+
+            /* NULL if every entry is busy; try again once a fetch completes */
+            pEntry = addEntry(pCache, pKeyURI);
+            if(pEntry != NULL)
+            {
+                kickFetchTask(pCache);
+            }
+        }
+        else
+        {
+            pEntry->lastUse = ++(pCache->useCount);
+
+            if(pEntry->state == HLS_KEY_READY)
+            {
+                memcpy(pKey, pEntry->key, sizeof(pEntry->key));
+                rval = HLS_OK;
+                break;
+            }
+
+            if(pEntry->state == HLS_KEY_FAILED)
+            {
+                numFailures++;
+                if(numFailures >= HLS_KEY_FETCH_ATTEMPTS)
+                {
+                    ERROR("giving up on key %s after %d attempts", pKeyURI, numFailures);
+                    rval = HLS_DL_ERROR;
+                    break;
+                }
+
+                pEntry->state = HLS_KEY_PENDING;
+                kickFetchTask(pCache);
+            }
+        }
+
+        hlsClock_now(&wakeTime);
+        wakeTime.tv_nsec += HLS_KEY_WAIT_MSECS * 1000000;
+        if(wakeTime.tv_nsec >= 1000000000)
+        {
+            wakeTime.tv_sec++;
+            wakeTime.tv_nsec -= 1000000000;
+        }
+
+        hlsClock_timedWait(&(pCache->fetchCond), &(pCache->mutex), &wakeTime);
+    }
+
+    pthread_mutex_unlock(&(pCache->mutex));
+
+    return rval;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,273 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsLockStats.c @date October 19, 2026
+ *
+ * Contention statistics for the session locks, see hlsLockStats.h.
+ *
+ * Each thread keeps a small table of the locks it holds so that a hold
+ * can be timed from the first acquisition to the matching release, for
+ * recursive mutexes and for shared playlist lock holders alike.  The
+ * counters themselves live in the session stats (hlsStats.c).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hlsLockStats.h"
+#include "hlsStats.h"
+
+#include "debug.h"
+
+#ifdef ENABLE_LOCK_STATS
+
+#define HLS_LOCK_STATS_MAX_HELD (16)   /*!< Locks a thread can hold at once and still have timed */
+
+/*! \struct heldLock_t
+ * Lock held by the current thread
+ */
+typedef struct {
+    void* pLock;                    /*!< Address of the lock */
+    int depth;                      /*!< Number of times the thread has taken it */
+    struct timespec acquireTime;    /*!< Time of the first acquisition */
+    const char* pSite;              /*!< Where the first acquisition was made */
+} heldLock_t;
+
+/*! \struct heldLocks_t
+ * Locks held by the current thread
+ */
+typedef struct {
+    int numHeld;
+    heldLock_t held[HLS_LOCK_STATS_MAX_HELD];
+} heldLocks_t;
+
+static pthread_key_t heldLocksKey;
+static pthread_once_t heldLocksOnce = PTHREAD_ONCE_INIT;
+static int bHeldLocksKeyValid = 0;
+
+static void heldLocksKeyCreate(void)
+{
+    if(pthread_key_create(&heldLocksKey, free) == 0)
+    {
+        bHeldLocksKeyValid = 1;
+    }
+    else
+    {
+        ERROR("failed to create held locks key, lock hold times will not be recorded");
+    }
+}
+
+/**
+ * Returns the table of locks held by the calling thread,
+ * allocating it on first use.
+ *
+ * @return heldLocks_t* - table, or NULL if none could be allocated
+ */
+static heldLocks_t* getHeldLocks(void)
+{
+    heldLocks_t* pHeldLocks = NULL;
+
+    pthread_once(&heldLocksOnce, heldLocksKeyCreate);
+
+    if(!bHeldLocksKeyValid)
+    {
+        return NULL;
+    }
+
+    pHeldLocks = pthread_getspecific(heldLocksKey);
+    if(pHeldLocks == NULL)
+    {
+        pHeldLocks = calloc(1, sizeof(heldLocks_t));
+        if((pHeldLocks != NULL) && (pthread_setspecific(heldLocksKey, pHeldLocks) != 0))
+        {
+            free(pHeldLocks);
+            pHeldLocks = NULL;
+        }
+    }
+
+    return pHeldLocks;
+}
+
+/**
+ * Accounts for a lock the calling thread has just taken.
+ *
+ * @param pStats - session counters
+ * @param lock - which of the session locks it is
+ * @param pLock - address of the lock
+ * @param bContended - TRUE if the thread had to wait for it
+ * @param waitTime - time spent waiting, in seconds
+ * @param pSite - "file:line" of the acquisition
+ */
+void hlsLockStats_acquired(hlsSessionStats_t* pStats, srcLockId_t lock, void* pLock,
+                           int bContended, float waitTime, const char* pSite)
+{
+    heldLocks_t* pHeldLocks = NULL;
+    int ii = 0;
+
+    hlsStats_recordLockAcquire(pStats, lock, bContended, waitTime);
+
+    pHeldLocks = getHeldLocks();
+    if(pHeldLocks == NULL)
+    {
+        return;
+    }
+
+    for(ii = 0; ii < pHeldLocks->numHeld; ii++)
+    {
+        if(pHeldLocks->held[ii].pLock == pLock)
+        {
+            pHeldLocks->held[ii].depth++;
+            return;
+        }
+    }
+
+    /* If the table is full this hold is simply not timed */
+    if(pHeldLocks->numHeld < HLS_LOCK_STATS_MAX_HELD)
+    {
+        pHeldLocks->held[ii].pLock = pLock;
+        pHeldLocks->held[ii].depth = 1;
+        pHeldLocks->held[ii].pSite = pSite;
+        clock_gettime(CLOCK_MONOTONIC, &(pHeldLocks->held[ii].acquireTime));
+        pHeldLocks->numHeld++;
+    }
+}
+
+/**
+ * Accounts for a lock the calling thread is about to release.
+ *
+ * @param pStats - session counters
+ * @param lock - which of the session locks it is
+ * @param pLock - address of the lock
+ */
+void hlsLockStats_releasing(hlsSessionStats_t* pStats, srcLockId_t lock, void* pLock)
+{
+    heldLocks_t* pHeldLocks = NULL;
+    heldLock_t* pHeld = NULL;
+    struct timespec now;
+    int ii = 0;
+
+    pHeldLocks = getHeldLocks();
+    if(pHeldLocks == NULL)
+    {
+        return;
+    }
+
+    for(ii = 0; ii < pHeldLocks->numHeld; ii++)
+    {
+        if(pHeldLocks->held[ii].pLock == pLock)
+        {
+            pHeld = &(pHeldLocks->held[ii]);
+            break;
+        }
+    }
+
+    if(pHeld == NULL)
+    {
+        return;
+    }
+
+    pHeld->depth--;
+    if(pHeld->depth > 0)
+    {
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    hlsStats_recordLockHold(pStats, lock,
+                            (now.tv_sec - pHeld->acquireTime.tv_sec) +
+                            ((now.tv_nsec - pHeld->acquireTime.tv_nsec) / 1000000000.0),
+                            pHeld->pSite);
+
+    pHeldLocks->numHeld--;
+    *pHeld = pHeldLocks->held[pHeldLocks->numHeld];
+}
+
+/**
+ * Locks one of the session mutexes, recording the acquisition.
+ * Use through HLS_MUTEX_LOCK().
+ *
+ * @param pStats - session counters
+ * @param lock - which of the session locks pMutex is
+ * @param pMutex - mutex to lock
+ * @param pSite - "file:line" of the caller
+ *
+ * @return int - pthread_mutex_lock() result
+ */
+int hlsLockStats_lock(hlsSessionStats_t* pStats, srcLockId_t lock, pthread_mutex_t* pMutex, const char* pSite)
+{
+    int rval = 0;
+    struct timespec start;
+    struct timespec end;
+
+    rval = pthread_mutex_trylock(pMutex);
+    if(rval == 0)
+    {
+        hlsLockStats_acquired(pStats, lock, pMutex, 0, 0, pSite);
+    }
+    else if(rval == EBUSY)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
+        rval = pthread_mutex_lock(pMutex);
+
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        if(rval == 0)
+        {
+            hlsLockStats_acquired(pStats, lock, pMutex, 1,
+                                  (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1000000000.0),
+                                  pSite);
+        }
+    }
+
+    return rval;
+}
+
+/**
+ * Unlocks a mutex locked with hlsLockStats_lock().
+ * Use through HLS_MUTEX_UNLOCK().
+ *
+ * @param pStats - session counters
+ * @param lock - which of the session locks pMutex is
+ * @param pMutex - mutex to unlock
+ *
+ * @return int - pthread_mutex_unlock() result
+ */
+int hlsLockStats_unlock(hlsSessionStats_t* pStats, srcLockId_t lock, pthread_mutex_t* pMutex)
+{
+    hlsLockStats_releasing(pStats, lock, pMutex);
+
+    return pthread_mutex_unlock(pMutex);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
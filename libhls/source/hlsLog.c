@@ -0,0 +1,414 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsLog.c @date October 19, 2026
+ *
+ * Asynchronous log output, see hlsLog.h.
+ *
+ * Each logging thread owns a single producer, single consumer ring of
+ * formatted messages.  The thread only ever advances the ring's head
+ * and the drain thread only ever advances its tail, so neither side
+ * locks.  Rings are allocated on a thread's first message, pushed onto
+ * a list with compare-and-swap, and freed by the drain thread once the
+ * owning thread has exited and the ring is empty.
+ *
+ * Messages are formatted when they are logged rather than when they
+ * are drained, since their %s arguments are often buffers that are
+ * freed soon after; the system call, and the locking syslog and stdio
+ * do internally, are what is deferred.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "hlsLog.h"
+
+#include "debug.h"
+
+#define HLS_LOG_RING_SLOTS (128)               /*!< Messages per thread ring, a power of 2 */
+#define HLS_LOG_MSG_SIZE (512)                 /*!< Longest message kept, including the '\0' */
+#define HLS_LOG_DRAIN_INTERVAL_NSECS (20000000) /*!< Time between drain passes */
+
+/*! \struct hlsLogRecord_t
+ * One formatted message
+ */
+typedef struct {
+    int level;                      /*!< Level to output the message at */
+    char msg[HLS_LOG_MSG_SIZE];
+} hlsLogRecord_t;
+
+/*! \struct hlsLogRing_t
+ * Messages logged by one thread
+ */
+typedef struct hlsLogRing_t_ {
+    unsigned int head;              /*!< Next slot to write; only advanced by the owning thread */
+    unsigned int tail;              /*!< Next slot to output; only advanced by the drain thread */
+    unsigned int numDropped;        /*!< Messages dropped because the ring was full */
+    unsigned int numReported;       /*!< numDropped at the last report; drain thread only */
+    int bOrphaned;                  /*!< TRUE once the owning thread has exited */
+    struct hlsLogRing_t_* pNext;
+    hlsLogRecord_t records[HLS_LOG_RING_SLOTS];
+} hlsLogRing_t;
+
+/*! TRUE while log output is asynchronous */
+static int hlsLog_bAsync = 0;
+
+static hlsLogRing_t* pRings = NULL;
+static pthread_key_t ringKey;
+static int numWriters = 0;
+
+static pthread_t drainThread;
+static int bDrainRunning = 0;
+static int bStopDrain = 0;
+
+/**
+ * Marks a thread's ring for freeing once it has been drained.
+ * Called by pthreads when the owning thread exits.  Once
+ * hlsLog_stopAsync() has cleared hlsLog_bAsync the ring is left
+ * alone, since hlsLog_stopAsync() frees it.
+ *
+ * @param pArg - the thread's hlsLogRing_t
+ */
+static void orphanRing(void* pArg)
+{
+    hlsLogRing_t* pRing = (hlsLogRing_t*)pArg;
+
+    __atomic_add_fetch(&numWriters, 1, __ATOMIC_SEQ_CST);
+
+    if(__atomic_load_n(&hlsLog_bAsync, __ATOMIC_SEQ_CST))
+    {
+        __atomic_store_n(&(pRing->bOrphaned), 1, __ATOMIC_RELEASE);
+    }
+
+    __atomic_sub_fetch(&numWriters, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Returns the calling thread's ring, allocating it on first use.
+ *
+ * @return hlsLogRing_t* - ring, or NULL if none could be allocated
+ */
+static hlsLogRing_t* getRing(void)
+{
+    hlsLogRing_t* pRing = NULL;
+
+    pRing = pthread_getspecific(ringKey);
+    if(pRing == NULL)
+    {
+        pRing = calloc(1, sizeof(hlsLogRing_t));
+        if(pRing == NULL)
+        {
+            return NULL;
+        }
+
+        if(pthread_setspecific(ringKey, pRing) != 0)
+        {
+            free(pRing);
+            return NULL;
+        }
+
+        pRing->pNext = __atomic_load_n(&pRings, __ATOMIC_RELAXED);
+        while(!__atomic_compare_exchange_n(&pRings, &(pRing->pNext), pRing, 0,
+                                           __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            /* pRing->pNext now holds the current list head, try again */
+        }
+    }
+
+    return pRing;
+}
+
+/**
+ * Logs a message.  Used by the debug.h macros.  While output is
+ * asynchronous the message goes through the calling thread's ring,
+ * and is dropped if the ring is full; otherwise it is output
+ * synchronously.
+ *
+ * @param level - level to output the message at
+ * @param format - printf() format of the message
+ */
+void hlsLog_write(int level, const char* format, ...)
+{
+    hlsLogRing_t* pRing = NULL;
+    hlsLogRecord_t* pRecord = NULL;
+    unsigned int head = 0;
+    va_list args;
+
+    if(!__atomic_load_n(&hlsLog_bAsync, __ATOMIC_RELAXED))
+    {
+        va_start(args, format);
+        HLS_LOG_VOUTPUT(level, format, args);
+        va_end(args);
+        return;
+    }
+
+    /* Announce ourselves before checking hlsLog_bAsync again, so that
+       hlsLog_stopAsync() either waits for this message or we see the
+       flag cleared and output it ourselves */
+    __atomic_add_fetch(&numWriters, 1, __ATOMIC_SEQ_CST);
+
+    if(__atomic_load_n(&hlsLog_bAsync, __ATOMIC_SEQ_CST))
+    {
+        pRing = getRing();
+    }
+
+    do
+    {
+        if(pRing == NULL)
+        {
+            /* No ring, so fall back to logging synchronously */
+            va_start(args, format);
+            HLS_LOG_VOUTPUT(level, format, args);
+            va_end(args);
+            break;
+        }
+
+        head = pRing->head;
+
+        if((head - __atomic_load_n(&(pRing->tail), __ATOMIC_ACQUIRE)) >= HLS_LOG_RING_SLOTS)
+        {
+            __atomic_store_n(&(pRing->numDropped), pRing->numDropped + 1, __ATOMIC_RELAXED);
+            break;
+        }
+
+        pRecord = &(pRing->records[head & (HLS_LOG_RING_SLOTS - 1)]);
+
+        pRecord->level = level;
+
+        va_start(args, format);
+        vsnprintf(pRecord->msg, sizeof(pRecord->msg), format, args);
+        va_end(args);
+
+        __atomic_store_n(&(pRing->head), head + 1, __ATOMIC_RELEASE);
+
+    } while(0);
+
+    __atomic_sub_fetch(&numWriters, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Outputs everything currently in a ring.  Drain thread only.
+ *
+ * @param pRing - ring to drain
+ */
+static void drainRing(hlsLogRing_t* pRing)
+{
+    unsigned int head = __atomic_load_n(&(pRing->head), __ATOMIC_ACQUIRE);
+    unsigned int tail = pRing->tail;
+    unsigned int numDropped = 0;
+    hlsLogRecord_t* pRecord = NULL;
+
+    while(tail != head)
+    {
+        pRecord = &(pRing->records[tail & (HLS_LOG_RING_SLOTS - 1)]);
+
+        HLS_LOG_OUTPUT(pRecord->level, "%s", pRecord->msg);
+
+        tail++;
+    }
+
+    __atomic_store_n(&(pRing->tail), tail, __ATOMIC_RELEASE);
+
+    numDropped = __atomic_load_n(&(pRing->numDropped), __ATOMIC_RELAXED);
+    if(numDropped != pRing->numReported)
+    {
+        HLS_LOG_OUTPUT(DBG_WARN, DEBUG_MSG("%u log messages dropped, ring full", numDropped - pRing->numReported));
+        pRing->numReported = numDropped;
+    }
+}
+
+/**
+ * Drains every ring, and frees the rings of threads that have
+ * exited.  Drain thread only, or after it has stopped.
+ */
+static void drainRings(void)
+{
+    hlsLogRing_t* pRing = NULL;
+    hlsLogRing_t* pPrev = NULL;
+    hlsLogRing_t* pNext = NULL;
+    hlsLogRing_t* pExpected = NULL;
+    int bOrphaned = 0;
+
+    pRing = __atomic_load_n(&pRings, __ATOMIC_ACQUIRE);
+
+    while(pRing != NULL)
+    {
+        /* Read the flag first: an orphaned ring gets no more messages */
+        bOrphaned = __atomic_load_n(&(pRing->bOrphaned), __ATOMIC_ACQUIRE);
+
+        drainRing(pRing);
+
+        pNext = pRing->pNext;
+
+        if(bOrphaned)
+        {
+            /* New rings are only ever pushed onto the front of the list, so if pRing is no
+               longer the head, its predecessor is found by walking from the new head */
+            pExpected = pRing;
+            if((pPrev == NULL) &&
+               !__atomic_compare_exchange_n(&pRings, &pExpected, pNext, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            {
+                pPrev = pExpected;
+                while(pPrev->pNext != pRing)
+                {
+                    pPrev = pPrev->pNext;
+                }
+            }
+
+            if(pPrev != NULL)
+            {
+                pPrev->pNext = pNext;
+            }
+
+            free(pRing);
+        }
+        else
+        {
+            pPrev = pRing;
+        }
+
+        pRing = pNext;
+    }
+}
+
+/**
+ * Drain thread body.
+ *
+ * @param pArg - unused
+ *
+ * @return void* - NULL
+ */
+static void* drainTask(void* pArg)
+{
+    struct timespec interval;
+
+    (void)pArg;
+
+    while(!__atomic_load_n(&bStopDrain, __ATOMIC_ACQUIRE))
+    {
+        drainRings();
+
+        interval.tv_sec = 0;
+        interval.tv_nsec = HLS_LOG_DRAIN_INTERVAL_NSECS;
+        while((nanosleep(&interval, &interval) != 0) && (errno == EINTR))
+        {
+        }
+    }
+
+    drainRings();
+
+    return NULL;
+}
+
+/**
+ * Switches log output to asynchronous.  Does nothing if it
+ * already is.
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsLog_startAsync(void)
+{
+    if(bDrainRunning)
+    {
+        return HLS_OK;
+    }
+
+    bStopDrain = 0;
+
+    if(pthread_key_create(&ringKey, orphanRing) != 0)
+    {
+        ERROR("failed to create log ring key");
+        return HLS_ERROR;
+    }
+
+    if(pthread_create(&drainThread, NULL, drainTask, NULL) != 0)
+    {
+        ERROR("failed to start log drain thread");
+        pthread_key_delete(ringKey);
+        return HLS_ERROR;
+    }
+
+    bDrainRunning = 1;
+    __atomic_store_n(&hlsLog_bAsync, 1, __ATOMIC_RELEASE);
+
+    return HLS_OK;
+}
+
+/**
+ * Switches log output back to synchronous, once everything logged
+ * so far has been output, and frees all rings.
+ */
+void hlsLog_stopAsync(void)
+{
+    hlsLogRing_t* pRing = NULL;
+    hlsLogRing_t* pNext = NULL;
+    struct timespec interval;
+
+    if(!bDrainRunning)
+    {
+        return;
+    }
+
+    __atomic_store_n(&hlsLog_bAsync, 0, __ATOMIC_SEQ_CST);
+
+    /* Wait for threads that saw hlsLog_bAsync set to finish writing
+       their message; any new ones now log synchronously */
+    while(__atomic_load_n(&numWriters, __ATOMIC_SEQ_CST) != 0)
+    {
+        interval.tv_sec = 0;
+        interval.tv_nsec = 1000000;
+        nanosleep(&interval, NULL);
+    }
+
+    __atomic_store_n(&bStopDrain, 1, __ATOMIC_RELEASE);
+
+    /* The drain thread drains every ring once more before exiting */
+    pthread_join(drainThread, NULL);
+
+    /* Nothing can reach the rings any more, so free those of threads
+       that are still alive, and of those that exited too late to be
+       freed by the drain thread */
+    pRing = __atomic_exchange_n(&pRings, NULL, __ATOMIC_ACQ_REL);
+    while(pRing != NULL)
+    {
+        pNext = pRing->pNext;
+        free(pRing);
+        pRing = pNext;
+    }
+
+    /* Deleting the key drops the stale ring pointers of live threads;
+       hlsLog_startAsync() creates a new one */
+    pthread_key_delete(ringKey);
+
+    bDrainRunning = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,554 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsNullSink.c @date October 19, 2026
+ *
+ * Built-in player stand-in used by headless sessions (see
+ * SRC_PLUGIN_SET_HEADLESS).
+ *
+ * Buffers are lent out of a small per-session set of scratch buffers
+ * and handed straight back on sendBuffer() without their contents
+ * being copied or inspected.  Playback is simulated by advancing a
+ * synthetic 90kHz PTS with the wall clock while the session is
+ * playing, and feeding it to the session as SRC_PLAYER_LAST_PTS
+ * events from the playback controller.  The clock never runs ahead of
+ * the buffered media; running dry before the end of the content is
+ * counted as a stall, and running dry at the end is reported to the
+ * session as an audio underrun, which is how a real player signals
+ * that it has played out everything it was given.  getBuffer()
+ * withholds buffers once NULL_SINK_MAX_BUFFER_SECS of media are
+ * buffered, the same back-pressure a real player's demux FIFO
+ * applies.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "hlsNullSink.h"
+#include "hlsSession.h"
+#include "hlsSessionUtils.h"
+#include "hlsStats.h"
+#include "hlsClock.h"
+
+#include "debug.h"
+
+/* Size of each scratch buffer lent out by hlsNullSink_getBuffer() */
+#define NULL_SINK_BUFFER_SIZE (64*1024)
+
+/* Buffer level (seconds) above which hlsNullSink_getBuffer() stops lending buffers */
+#define NULL_SINK_MAX_BUFFER_SECS 30
+
+/* Media left to play (seconds) under which running dry is end of content, not a stall */
+#define NULL_SINK_END_TOLERANCE_SECS 1.0
+
+/**
+ * Returns a - b in seconds
+ */
+static double elapsedSecs(struct timespec* a, struct timespec* b)
+{
+    return (double)(a->tv_sec - b->tv_sec) + ((double)(a->tv_nsec - b->tv_nsec) / 1000000000.0);
+}
+
+/**
+ * Allocates a new null sink.  *ppSink MUST be NULL, and the sink
+ * must be freed with hlsNullSink_destroy().
+ *
+ * @param ppSink - will point to the new sink
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsNullSink_create(hlsNullSink_t** ppSink)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if((ppSink == NULL) || (*ppSink != NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        *ppSink = malloc(sizeof(hlsNullSink_t));
+        if(*ppSink == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        memset(*ppSink, 0, sizeof(hlsNullSink_t));
+
+        (*ppSink)->mode = SRC_PLAYER_MODE_NORMAL;
+
+        if(pthread_mutex_init(&((*ppSink)->mutex), NULL) != 0)
+        {
+            ERROR("failed to initialize null sink mutex");
+            free(*ppSink);
+            *ppSink = NULL;
+            rval = HLS_ERROR;
+            break;
+        }
+
+    } while(0);
+
+    return rval;
+}
+
+/**
+ * Frees a null sink.  No buffers may be lent out.
+ *
+ * @param pSink - sink to free
+ */
+void hlsNullSink_destroy(hlsNullSink_t* pSink)
+{
+    int ii = 0;
+
+    if(pSink != NULL)
+    {
+        for(ii = 0; ii < NULL_SINK_NUM_BUFFERS; ii++)
+        {
+            free(pSink->pBuffers[ii]);
+            pSink->pBuffers[ii] = NULL;
+        }
+
+        pthread_mutex_destroy(&(pSink->mutex));
+
+        free(pSink);
+    }
+}
+
+/**
+ * Lends a scratch buffer to the downloader.  Returns a 0 byte
+ * buffer if enough media is already buffered or all scratch
+ * buffers are lent out.
+ *
+ * @param pSession - headless session
+ * @param buffer - will point to the lent buffer
+ * @param size - will contain the size of the lent buffer
+ * @param ppPrivate - will contain the buffer's index, to be
+ *                  passed back to hlsNullSink_sendBuffer()
+ *
+ * @return #srcStatus_t
+ */
+srcStatus_t hlsNullSink_getBuffer(hlsSession_t* pSession, char** buffer, int* size, void** ppPrivate)
+{
+    srcStatus_t rval = SRC_SUCCESS;
+    hlsNullSink_t* pSink = NULL;
+
+    int ii = 0;
+
+    if((pSession == NULL) || (pSession->pNullSink == NULL) ||
+       (buffer == NULL) || (size == NULL) || (ppPrivate == NULL))
+    {
+        ERROR("invalid parameter");
+        return SRC_ERROR;
+    }
+
+    pSink = pSession->pNullSink;
+
+    *buffer = NULL;
+    *size = 0;
+    *ppPrivate = NULL;
+
+    /* Apply back-pressure once we've buffered enough */
+    if(pSession->timeBuffered >= NULL_SINK_MAX_BUFFER_SECS)
+    {
+        return SRC_SUCCESS;
+    }
+
+    pthread_mutex_lock(&(pSink->mutex));
+
+    do
+    {
+        for(ii = 0; ii < NULL_SINK_NUM_BUFFERS; ii++)
+        {
+            if(!(pSink->bBufferInUse[ii]))
+            {
+                break;
+            }
+        }
+
+        /* All buffers are out -- return an empty buffer */
+        if(ii == NULL_SINK_NUM_BUFFERS)
+        {
+            break;
+        }
+
+        if(pSink->pBuffers[ii] == NULL)
+        {
+            pSink->pBuffers[ii] = malloc(NULL_SINK_BUFFER_SIZE);
+            if(pSink->pBuffers[ii] == NULL)
+            {
+                ERROR("malloc error");
+                rval = SRC_ERROR;
+                break;
+            }
+        }
+
+        pSink->bBufferInUse[ii] = 1;
+
+        *buffer = pSink->pBuffers[ii];
+        *size = NULL_SINK_BUFFER_SIZE;
+        *ppPrivate = (void*)(intptr_t)ii;
+
+    } while(0);
+
+    pthread_mutex_unlock(&(pSink->mutex));
+
+    return rval;
+}
+
+/**
+ * Consumes a buffer lent out by hlsNullSink_getBuffer().
+ *
+ * @param pSession - headless session
+ * @param buffer - the lent buffer
+ * @param size - amount of data in the buffer
+ * @param metadata - buffer metadata
+ * @param pPrivate - value returned in *ppPrivate by
+ *                 hlsNullSink_getBuffer()
+ *
+ * @return #srcStatus_t
+ */
+srcStatus_t hlsNullSink_sendBuffer(hlsSession_t* pSession, char* buffer, int size, srcBufferMetadata_t* metadata, void* pPrivate)
+{
+    hlsNullSink_t* pSink = NULL;
+
+    int index = (int)(intptr_t)pPrivate;
+
+    if((pSession == NULL) || (pSession->pNullSink == NULL) || (buffer == NULL) ||
+       (index < 0) || (index >= NULL_SINK_NUM_BUFFERS))
+    {
+        ERROR("invalid parameter");
+        return SRC_ERROR;
+    }
+
+    pSink = pSession->pNullSink;
+
+    pthread_mutex_lock(&(pSink->mutex));
+
+    if(size > 0)
+    {
+        pSink->bytesConsumed += size;
+
+        if((metadata != NULL) && (metadata->bFirstBufferInSegment) &&
+           (metadata->streamNum == SRC_STREAM_NUM_MAIN))
+        {
+            pSink->segmentsConsumed++;
+        }
+
+        hlsClock_now(&(pSink->lastDataTime));
+    }
+
+    pSink->bBufferInUse[index] = 0;
+
+    pthread_mutex_unlock(&(pSink->mutex));
+
+    return SRC_SUCCESS;
+}
+
+/**
+ * Handles player set requests for a headless session.
+ *
+ * @param pSession - headless session
+ * @param pSetData - setting to apply
+ *
+ * @return #srcStatus_t
+ */
+srcStatus_t hlsNullSink_set(hlsSession_t* pSession, srcPlayerSetData_t* pSetData)
+{
+    srcStatus_t rval = SRC_SUCCESS;
+    hlsNullSink_t* pSink = NULL;
+
+    if((pSession == NULL) || (pSession->pNullSink == NULL) || (pSetData == NULL))
+    {
+        ERROR("invalid parameter");
+        return SRC_ERROR;
+    }
+
+    pSink = pSession->pNullSink;
+
+    pthread_mutex_lock(&(pSink->mutex));
+
+    switch(pSetData->setCode)
+    {
+        case SRC_PLAYER_SET_BUFFER_FLUSH:
+            /* The session resets its PTS reference on flush, so
+               restart the clock once new data is playing */
+            pSink->bClockRunning = 0;
+            pSink->bStalled = 0;
+            pSink->bDrained = 0;
+            break;
+        case SRC_PLAYER_SET_DISABLE_MAIN_STREAM_AUDIO:
+            break;
+        case SRC_PLAYER_SET_MODE:
+            if(pSetData->pData == NULL)
+            {
+                ERROR("invalid parameter");
+                rval = SRC_ERROR;
+                break;
+            }
+            pSink->mode = *((srcPlayerMode_t*)(pSetData->pData));
+            break;
+        default:
+            ERROR("unknown srcPlayerSetCode_t value: %d", pSetData->setCode);
+            rval = SRC_ERROR;
+            break;
+    }
+
+    pthread_mutex_unlock(&(pSink->mutex));
+
+    return rval;
+}
+
+/**
+ * Handles player get requests for a headless session.
+ *
+ * @param pSession - headless session
+ * @param pGetData - setting to retrieve
+ *
+ * @return #srcStatus_t
+ */
+srcStatus_t hlsNullSink_get(hlsSession_t* pSession, srcPlayerGetData_t* pGetData)
+{
+    srcStatus_t rval = SRC_SUCCESS;
+    hlsNullSink_t* pSink = NULL;
+
+    float position = 0;
+    int ii = 0;
+
+    if((pSession == NULL) || (pSession->pNullSink == NULL) ||
+       (pGetData == NULL) || (pGetData->pData == NULL))
+    {
+        ERROR("invalid parameter");
+        return SRC_ERROR;
+    }
+
+    pSink = pSession->pNullSink;
+
+    switch(pGetData->getCode)
+    {
+        case SRC_PLAYER_GET_FIFO_DATA:
+            pthread_mutex_lock(&(pSink->mutex));
+            ((fifoData_t*)(pGetData->pData))->fifoSize = NULL_SINK_NUM_BUFFERS;
+            ((fifoData_t*)(pGetData->pData))->fifoDepth = 0;
+            for(ii = 0; ii < NULL_SINK_NUM_BUFFERS; ii++)
+            {
+                ((fifoData_t*)(pGetData->pData))->fifoDepth += pSink->bBufferInUse[ii];
+            }
+            pthread_mutex_unlock(&(pSink->mutex));
+            break;
+        case SRC_PLAYER_GET_LAST_PTS:
+            pthread_mutex_lock(&(pSink->mutex));
+            *((uint64_t*)(pGetData->pData)) = (uint64_t)(pSink->pts);
+            pthread_mutex_unlock(&(pSink->mutex));
+            break;
+        case SRC_PLAYER_GET_POSITION:
+            /* Our play position is exactly the one the session tracks from our PTS */
+            if(hlsSession_getCurrentPosition(pSession, &position) != HLS_OK)
+            {
+                ERROR("failed to get current position");
+                rval = SRC_ERROR;
+                break;
+            }
+            *((int*)(pGetData->pData)) = (int)position;
+            break;
+        default:
+            ERROR("unknown srcPlayerGetCode_t value: %d", pGetData->getCode);
+            rval = SRC_ERROR;
+            break;
+    }
+
+    return rval;
+}
+
+/**
+ * Advances the synthetic play clock of a headless session and
+ * reports the new PTS to the session.  Called periodically from
+ * the playback controller.
+ *
+ * @param pSession - headless session
+ */
+void hlsNullSink_tick(hlsSession_t* pSession)
+{
+    hlsNullSink_t* pSink = NULL;
+
+    struct timespec now;
+
+    srcPlayerEvt_t event;
+    long long pts = 0;
+
+    double timeLeft = 0;
+    double elapsed = 0;
+    double played = 0;
+
+    int bPlaying = 0;
+    int bNearEnd = 0;
+    int bReport = 0;
+    int bUnderrun = 0;
+
+    if((pSession == NULL) || (pSession->pNullSink == NULL))
+    {
+        return;
+    }
+
+    pSink = pSession->pNullSink;
+
+    if(hlsClock_now(&now) != 0)
+    {
+        ERROR("failed to get current time");
+        return;
+    }
+
+    /* Find out whether the media left to play is already all buffered,
+       in which case running dry is the end of the content, not a stall */
+    playlistReadLock(pSession);
+
+    if((pSession->pCurrentPlaylist != NULL) &&
+       (pSession->pCurrentPlaylist->type == PL_MEDIA) &&
+       (pSession->pCurrentPlaylist->pMediaData != NULL))
+    {
+        timeLeft = pSession->pCurrentPlaylist->pMediaData->positionFromEnd - pSession->timeBuffered;
+        bNearEnd = pSession->pCurrentPlaylist->pMediaData->bHaveCompletePlaylist &&
+                   (timeLeft < NULL_SINK_END_TOLERANCE_SECS);
+    }
+
+    playlistUnlock(pSession);
+
+    pthread_mutex_lock(&(pSink->mutex));
+
+    bPlaying = (pSession->state == HLS_PLAYING) &&
+               (pSink->mode == SRC_PLAYER_MODE_NORMAL) &&
+               (pSink->bytesConsumed > 0);
+
+    if(bPlaying && pSink->bClockRunning)
+    {
+        elapsed = elapsedSecs(&now, &(pSink->lastTick));
+
+        /* Never play out more than we have buffered */
+        played = elapsed;
+        if(played > pSession->timeBuffered)
+        {
+            played = (pSession->timeBuffered > 0) ? pSession->timeBuffered : 0;
+
+            if(bNearEnd)
+            {
+                /* Played out everything -- tell the session once */
+                if(!(pSink->bDrained))
+                {
+                    DEBUG(DBG_INFO, "session %p played out to the end of the media", pSession);
+                    pSink->bDrained = 1;
+                    bUnderrun = 1;
+                }
+            }
+            else
+            {
+                if(!(pSink->bStalled))
+                {
+                    DEBUG(DBG_WARN, "session %p stalled -- %5.2f seconds buffered", pSession, pSession->timeBuffered);
+                }
+
+                hlsStats_recordStall(&(pSession->stats), !(pSink->bStalled), elapsed - played);
+                pSink->bStalled = 1;
+            }
+        }
+        else
+        {
+            pSink->bStalled = 0;
+        }
+
+        pSink->pts = (pSink->pts + (long long)(played * 90000)) % PTS_LIMIT;
+
+        bReport = 1;
+    }
+    else if(bPlaying)
+    {
+        /* Starting (or restarting after a flush) -- once the first segment
+           is buffered, report our current PTS as the session's new reference
+           point.  Waiting for the initial fill is not a stall. */
+        if(pSession->timeBuffered > 0)
+        {
+            pSink->bClockRunning = 1;
+            bReport = 1;
+        }
+    }
+    else
+    {
+        pSink->bClockRunning = 0;
+    }
+
+    pSink->lastTick = now;
+    pts = pSink->pts;
+
+    pthread_mutex_unlock(&(pSink->mutex));
+
+    if(bReport)
+    {
+        event.evtCode = SRC_PLAYER_LAST_PTS;
+        event.pData = &pts;
+        hlsSession_playerEvtCallback(pSession, &event);
+    }
+
+    if(bUnderrun)
+    {
+        event.evtCode = SRC_PLAYER_AUDIO_FIFO_UNDERRUN;
+        event.pData = NULL;
+        hlsSession_playerEvtCallback(pSession, &event);
+    }
+}
+
+/**
+ * Fills in the sink-tracked members of a session health summary.
+ *
+ * @param pSink - null sink of a headless session
+ * @param pHealth - health summary to fill in
+ */
+void hlsNullSink_getHealth(hlsNullSink_t* pSink, srcPluginHealth_t* pHealth)
+{
+    struct timespec now;
+
+    if((pSink == NULL) || (pHealth == NULL))
+    {
+        return;
+    }
+
+    hlsClock_now(&now);
+
+    pthread_mutex_lock(&(pSink->mutex));
+
+    pHealth->bytesConsumed = pSink->bytesConsumed;
+    pHealth->segmentsConsumed = pSink->segmentsConsumed;
+    pHealth->timeSinceLastData = (pSink->bytesConsumed > 0) ? elapsedSecs(&now, &(pSink->lastDataTime)) : -1;
+
+    pthread_mutex_unlock(&(pSink->mutex));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -40,6 +40,9 @@ extern "C" {
 #include "hlsSession.h"
 #include "hlsSessionUtils.h"
 #include "hlsPlaybackController.h"
+#include "hlsNullSink.h"
+#include "hlsStats.h"
+#include "hlsClock.h"
 
 #include "debug.h"
 
@@ -47,22 +50,27 @@ extern "C" {
 #define PLAYBACK_CONTROL_LOOP_NSECS 500000000
 
 /**
+ * One step of the playback controller state machine.  Scheduled on
+ * the shared worker pool by hlsSession_prepare() and rescheduled
+ * every PLAYBACK_CONTROL_LOOP_NSECS until bKillPlaybackController
+ * is set or an error occurs.
  *
+ * @param pArg - pointer to pre-allocated hlsSession_t
+ * @param pNextRunTime - will contain the time at which to run
+ *                     the next step
  *
- * @param pSession - pointer to pre-allocated hlsSession_t
+ * @return #hlsTaskResult_t
  */
-void hlsPlaybackControllerThread(hlsSession_t* pSession)
+hlsTaskResult_t hlsPlaybackControllerTask(void* pArg, struct timespec* pNextRunTime)
 {
-    hlsStatus_t status = HLS_OK;
+    hlsSession_t* pSession = (hlsSession_t*)pArg;
 
-    int pthread_status = 0;
+    hlsStatus_t status = HLS_OK;
 
     struct timespec wakeTime;
 
     double playPosition = 0;
 
-    int bRestartPlayback = 0;
-
     srcPluginEvt_t event;
 
     playbackControllerSignal_t* pSignal = NULL;
@@ -71,19 +79,15 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
 
     llStatus_t llerror = LL_OK;
 
-    int bWaitForPlaybackCompletion = 0;
-
     srcPluginErr_t error;
 
-    if(pSession == NULL)
+    if((pSession == NULL) || (pNextRunTime == NULL))
     {
-        ERROR("pSession == NULL");
-        pthread_exit(NULL);
+        ERROR("invalid parameter");
+        return HLS_TASK_DONE;
     }
 
-    TIMESTAMP(DBG_INFO,"Starting %s", __FUNCTION__);
-
-    while(status == HLS_OK)
+    do
     {
         /* If the playback controller was signalled to exit, return HLS_CANCELLED */
         if(pSession->bKillPlaybackController)
@@ -93,14 +97,27 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
             break;
         }
 
-        /* Get loop start time */
-        if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+        /* Make sure we're still in a valid state */
+        if(pSession->state == HLS_INVALID_STATE)
+        {
+            status = HLS_STATE_ERROR;
+            break;
+        }
+
+        /* Get step start time */
+        if(hlsClock_now(&wakeTime) != 0)
         {
             ERROR("failed to get current time");
             status = HLS_ERROR;
             break;
         }
 
+        /* Headless sessions have no player reporting PTS -- advance our own play clock */
+        if(pSession->pNullSink != NULL)
+        {
+            hlsNullSink_tick(pSession);
+        }
+
         /* If we've started playback and are currently paused on a stream with a floating start point,
          * we need to monitor to ensure that the current pause position doesn't roll off the playlist.
          * When the pause position starts nearing the top of the playlist, we need to kick the
@@ -110,7 +127,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
         {
 
             /* Get playlist READ lock */
-            pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+            playlistReadLock(pSession);
 
             /* Validate current playlist */
             if((pSession->pCurrentPlaylist == NULL) ||
@@ -120,7 +137,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                 ERROR("current playlist invalid");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -134,7 +151,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                 {
                     ERROR("failed to get current position");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -147,15 +164,15 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                     event.pData = NULL;
                     hlsPlayer_pluginEvtCallback(pSession->pHandle, &event);
 
-                    bRestartPlayback = 1;
+                    pSession->bPbcRestartPlayback = 1;
                 }
 
             }
 
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
 
-            if(bRestartPlayback)
+            if(pSession->bPbcRestartPlayback)
             {
                 if(pSession->speed == 0)
                 {
@@ -168,7 +185,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                     }
                     else
                     {
-                        bRestartPlayback = 0;
+                        pSession->bPbcRestartPlayback = 0;
 
                         /* Send SRC_PLUGIN_FORCED_RESUME message to player */
                         event.eventCode = SRC_PLUGIN_FORCED_RESUME;
@@ -179,7 +196,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                 else
                 {
                     /* Someone changed the speed already, cancel speed change here. */
-                    bRestartPlayback = 0;
+                    pSession->bPbcRestartPlayback = 0;
                 }
             }
         }
@@ -223,7 +240,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                            to consume everything that it has buffered. Set this boolean and
                            wait for PBC_PLAYER_AUDIO_UNDERRUN event. */
 
-                        bWaitForPlaybackCompletion = 1;
+                        pSession->bPbcWaitForPlaybackCompletion = 1;
 #else
                         /* Hack: Using gstreamer player, we can send EOF right away
                         (i.e., we do no need to wait for the player to consume buffers) because
@@ -234,10 +251,19 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
 
                         if(pSession->eofCount >= pSession->currentGroupCount + 1)
                         {
-                           DEBUG(DBG_INFO, "sending SRC_PLUGIN_EOF to player");
-                           event.eventCode = SRC_PLUGIN_EOF;
-                           event.pData = NULL;
-                           hlsPlayer_pluginEvtCallback(pSession->pHandle, &event);
+                           if(pSession->pNullSink != NULL)
+                           {
+                              /* Headless sessions play in real time, so wait for the
+                                 null sink to report that it has played everything out */
+                              pSession->bPbcWaitForPlaybackCompletion = 1;
+                           }
+                           else
+                           {
+                              DEBUG(DBG_INFO, "sending SRC_PLUGIN_EOF to player");
+                              event.eventCode = SRC_PLUGIN_EOF;
+                              event.pData = NULL;
+                              hlsPlayer_pluginEvtCallback(pSession->pHandle, &event);
+                           }
                            pSession->eofCount = 0;
                         }
 #endif
@@ -245,7 +271,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                     else /* Trickplay */
                     {
                         /* Get playlist READ lock */
-                        pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+                        playlistReadLock(pSession);
 
                         /* Validate current playlist */
                         if((pSession->pCurrentPlaylist == NULL) ||
@@ -255,7 +281,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                             ERROR("current playlist invalid");
                             status = HLS_ERROR;
                             /* Release playlist lock */
-                            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                            playlistUnlock(pSession);
                             break;
                         }
 
@@ -294,7 +320,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                         }
 
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
 
                         event.pData = NULL;
 
@@ -322,7 +348,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                     /* We have received a PBC_DOWNLOAD_COMPLETE message during 1x PLAY
                        and are waiting for the player to play through everything
                        that it has buffered before sending an EOF signal */
-                    if(bWaitForPlaybackCompletion)
+                    if(pSession->bPbcWaitForPlaybackCompletion)
                     {
                         /* Pause the player */
                         // TODO: should we quit if we fail, or just roll with it?
@@ -337,7 +363,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                         event.pData = NULL;
                         hlsPlayer_pluginEvtCallback(pSession->pHandle, &event);
 
-                        bWaitForPlaybackCompletion = 0;
+                        pSession->bPbcWaitForPlaybackCompletion = 0;
                     }
                     else
                     {
@@ -345,6 +371,7 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                           then the player is starving.  Not really anything we can do about this,
                           since the bitrate logic should already have us at the lowest bitrate...
                           Send a network error to the player */
+                          hlsStats_recordStall(&(pSession->stats), 1, 0);
                           error.errCode = SRC_PLUGIN_ERR_NETWORK;
                           snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p - player starving even @ lowest bitrate", pSession));
                           hlsPlayer_pluginErrCallback(pSession->pHandle, &error);
@@ -367,8 +394,8 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
                        3) seek() has been called
 
                        In all three cases we no longer need to wait for a PBC_PLAYER_AUDIO_UNDERRUN
-                       to signify EOF, so reset the bWaitForPlaybackCompletion flag */
-                    bWaitForPlaybackCompletion = 0;
+                       to signify EOF, so reset the pSession->bPbcWaitForPlaybackCompletion flag */
+                    pSession->bPbcWaitForPlaybackCompletion = 0;
 
                     break;
                 default:
@@ -382,17 +409,12 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
             pSignal = NULL;
         }
 
-        /* Sleep for the rest of the loop */
-
-        /* Lock the playback controller wake mutex */
-        if(pthread_mutex_lock(&(pSession->playbackControllerWakeMutex)) != 0)
+        if(status != HLS_OK)
         {
-            ERROR("failed to lock playback controller wake mutex");
-            status = HLS_ERROR;
             break;
         }
 
-        /* Wait for PLAYBACK_CONTROL_LOOP_NSECS before going again */
+        /* Run again in PLAYBACK_CONTROL_LOOP_NSECS */
         wakeTime.tv_nsec += PLAYBACK_CONTROL_LOOP_NSECS;
 
         /* Handle a rollover of the nanosecond portion of wakeTime */
@@ -402,44 +424,23 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
             wakeTime.tv_nsec -= 1000000000;
         }
 
-        DEBUG(DBG_NOISE,"sleeping until: %f", ((wakeTime.tv_sec)*1.0) + (wakeTime.tv_nsec/1000000000.0));
+        DEBUG(DBG_NOISE,"next step at: %f", ((wakeTime.tv_sec)*1.0) + (wakeTime.tv_nsec/1000000000.0));
 
-        /* Wait until wakeTime */
-        pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->playbackControllerWakeCond), &(pSession->playbackControllerWakeMutex), &wakeTime);
+        *pNextRunTime = wakeTime;
 
-        /* Unlock the playback controller wake mutex */
-        if(pthread_mutex_unlock(&(pSession->playbackControllerWakeMutex)) != 0)
-        {
-            ERROR("failed to unlock playback controller wake mutex");
-            status = HLS_ERROR;
-            break;
-        }
-
-        /* If the timedwait call failed we need to bail */
-        if((pthread_status != ETIMEDOUT) && (pthread_status != 0))
-        {
-            ERROR("failed to timedwait on the playback controller wake condition");
-            status = HLS_ERROR;
-            break;
-        }
+        return HLS_TASK_RESCHEDULE;
 
-        /* Make sure we're still in a valid state */
-        if(pSession->state == HLS_INVALID_STATE)
-        {
-            status = HLS_STATE_ERROR;
-            break;
-        }
-    }
+    } while(0);
 
     if((status != HLS_OK) && (status != HLS_CANCELLED))
     {
         /* Send asynchronous error message to the player */
         srcPluginErr_t error;
         error.errCode = SRC_PLUGIN_ERR_SESSION_RESOURCE_FAILED;
-        snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p playback controller thread quit with status: %d", pSession, status));
+        snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p playback controller quit with status: %d", pSession, status));
         hlsPlayer_pluginErrCallback(pSession->pHandle, &error);
 
-        ERROR("session %p playback controller thread quit with status: %d", pSession, status);
+        ERROR("session %p playback controller quit with status: %d", pSession, status);
 
         /* Put session in INVALID state */
 
@@ -454,8 +455,8 @@ void hlsPlaybackControllerThread(hlsSession_t* pSession)
 
     pSession->playbackControllerStatus = status;
 
-    DEBUG(DBG_INFO,"session %p playback controller thread exiting with status %d", pSession, status);
-    pthread_exit(NULL);
+    DEBUG(DBG_INFO,"session %p playback controller exiting with status %d", pSession, status);
+    return HLS_TASK_DONE;
 }
 
 #ifdef __cplusplus
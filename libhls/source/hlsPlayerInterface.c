@@ -31,6 +31,9 @@
  * srcPluginLoad() and the callbacks registered via
  * hlsPlugin_registerCB().
  *
+ * Data path calls made on behalf of a headless session are served by
+ * the session's built-in null sink instead (see hlsNullSink.c).
+ *
  * @addtogroup hlsPlayerInterface HLS Player Interface
  * @{
  *
@@ -43,6 +46,9 @@ extern "C" {
 #include "debug.h"
 
 #include "hlsTypes.h"
+#include "hlsNullSink.h"
+#include "hlsStats.h"
+#include "hlsProbes.h"
 
 /** The global plugin instance defined in hlsPlugin.c */
 extern hlsPlugin_t thePlugin;
@@ -91,7 +97,7 @@ void hlsPlayer_pluginErrCallback(void* pHandle, srcPluginErr_t* pErr)
  */
 srcStatus_t hlsPlayer_registerCB(void* pHandle, playerEvtCallback_t evtCb)
 {
-    if(thePlugin.pHlsPlayerFuncTable->registerCB == NULL)
+    if((thePlugin.pHlsPlayerFuncTable == NULL) || (thePlugin.pHlsPlayerFuncTable->registerCB == NULL))
     {
         ERROR("pHlsPlayerFuncTable->registerCB is NULL");
         return SRC_ERROR;
@@ -103,8 +109,7 @@ srcStatus_t hlsPlayer_registerCB(void* pHandle, playerEvtCallback_t evtCb)
 /**
  * Passes session buffer request to external player
  *
- * @param pHandle - unique session handle passed by player in
- *                hlsPlugin_open() call
+ * @param pSession - session making the request
  * @param buffer - pointer which will be set to the beginning of
  *               the returned buffer
  * @param size - pointer to integer which will be set to the
@@ -118,22 +123,33 @@ srcStatus_t hlsPlayer_registerCB(void* pHandle, playerEvtCallback_t evtCb)
  *
  * @return #srcStatus_t
  */
-srcStatus_t hlsPlayer_getBuffer(void* pHandle, char** buffer, int* size, void **ppPrivate)
+srcStatus_t hlsPlayer_getBuffer(hlsSession_t* pSession, char** buffer, int* size, void **ppPrivate)
 {
-    if(thePlugin.pHlsPlayerFuncTable->getBuffer == NULL)
+    srcStatus_t rval = SRC_SUCCESS;
+
+    if(pSession->pNullSink != NULL)
+    {
+        rval = hlsNullSink_getBuffer(pSession, buffer, size, ppPrivate);
+    }
+    else if((thePlugin.pHlsPlayerFuncTable == NULL) || (thePlugin.pHlsPlayerFuncTable->getBuffer == NULL))
     {
         ERROR("pHlsPlayerFuncTable->getBuffer is NULL");
         return SRC_ERROR;
     }
+    else
+    {
+        rval = thePlugin.pHlsPlayerFuncTable->getBuffer(pSession->pHandle, buffer, size, ppPrivate);
+    }
 
-    return thePlugin.pHlsPlayerFuncTable->getBuffer(pHandle, buffer, size, ppPrivate);
+    HLS_PROBE(player_get_buffer, pSession, *size, rval);
+
+    return rval;
 }
 
 /**
  * Sends full session buffer to external player
  *
- * @param pHandle - unique session handle passed by player in
- *                hlsPlugin_open() call
+ * @param pSession - session sending the buffer
  * @param buffer - the data buffer to send
  * @param size - amount of data written into buffer (can be
  *             smaller than the actual size of the buffer)
@@ -151,22 +167,99 @@ srcStatus_t hlsPlayer_getBuffer(void* pHandle, char** buffer, int* size, void **
  *
  * @return #srcStatus_t
  */
-srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBufferMetadata_t* metadata, void *pPrivate)
+srcStatus_t hlsPlayer_sendBuffer(hlsSession_t* pSession, char* buffer, int size, srcBufferMetadata_t* metadata, void *pPrivate)
 {
-    if(thePlugin.pHlsPlayerFuncTable->sendBuffer == NULL)
+    srcStatus_t rval = SRC_SUCCESS;
+
+    if(pSession->pNullSink != NULL)
+    {
+        rval = hlsNullSink_sendBuffer(pSession, buffer, size, metadata, pPrivate);
+    }
+    else if((thePlugin.pHlsPlayerFuncTable == NULL) || (thePlugin.pHlsPlayerFuncTable->sendBuffer == NULL))
     {
         ERROR("pHlsPlayerFuncTable->sendBuffer is NULL");
         return SRC_ERROR;
     }
+    else
+    {
+        rval = thePlugin.pHlsPlayerFuncTable->sendBuffer(pSession->pHandle, buffer, size, metadata, pPrivate);
+    }
 
-    return thePlugin.pHlsPlayerFuncTable->sendBuffer(pHandle, buffer, size, metadata, pPrivate);
+    HLS_PROBE(player_send_buffer, pSession, size, (metadata != NULL) ? metadata->streamNum : SRC_STREAM_NUM_MAIN);
+
+    if(rval == SRC_SUCCESS)
+    {
+        hlsStats_recordBuffer(&(pSession->stats), (metadata != NULL) ? metadata->streamNum : SRC_STREAM_NUM_MAIN, size);
+    }
+
+    return rval;
+}
+
+/**
+ * Tells whether session data can be lent to the external player
+ * with hlsPlayer_lendBuffer() instead of being copied into
+ * buffers from hlsPlayer_getBuffer()
+ *
+ * @param pSession - session asking
+ *
+ * @return TRUE if the player registered a #srcPlayerLendBuffer_t
+ *         on the session
+ */
+int hlsPlayer_canLend(hlsSession_t* pSession)
+{
+    return (pSession->pNullSink == NULL) && (pSession->lendBuffer != NULL);
+}
+
+/**
+ * Lends session data to external player
+ *
+ * @param pSession - session lending the data
+ * @param buffer - the data to lend
+ * @param size - pointer to the amount of data in buffer, set to
+ *             0 if the player has no room for it
+ * @param metadata - pointer to #srcBufferMetadata_t providing
+ *                 various information related to this chunk of
+ *                 data
+ * @param release - called by the player once it is done with
+ *                the data
+ * @param pReleaseData - argument to release()
+ *
+ * @pre
+ *       - session has been created via hlsPlugin_open()
+ *       - hlsPlayer_canLend() returns TRUE
+ *
+ * @post
+ *       - see #srcPlayerLendBuffer_t for who owns the data
+ *
+ * @return #srcStatus_t
+ */
+srcStatus_t hlsPlayer_lendBuffer(hlsSession_t* pSession, char* buffer, int* size, srcBufferMetadata_t* metadata,
+                                 srcBufferRelease_t release, void* pReleaseData)
+{
+    srcStatus_t rval = SRC_SUCCESS;
+
+    if(!hlsPlayer_canLend(pSession))
+    {
+        ERROR("session has no lendBuffer function");
+        return SRC_ERROR;
+    }
+
+    rval = pSession->lendBuffer(pSession->pHandle, buffer, size, metadata, release, pReleaseData);
+
+    HLS_PROBE(player_send_buffer, pSession, *size, (metadata != NULL) ? metadata->streamNum : SRC_STREAM_NUM_MAIN);
+
+    if((rval == SRC_SUCCESS) && (*size != 0))
+    {
+        hlsStats_recordBuffer(&(pSession->stats), (metadata != NULL) ? metadata->streamNum : SRC_STREAM_NUM_MAIN, *size);
+    }
+
+    return rval;
 }
 
 /**
  * Passes session set request to external player
  *
- * @param pHandle - unique session handle passed by player in
- *                hlsPlugin_open() call
+ * @param pSession - session making the request
  * @param pSetData - pointer to #srcPlayerSetData_t containing
  *                 the setting to set on the player
  *
@@ -178,22 +271,26 @@ srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBuffe
  *
  * @return #srcStatus_t
  */
-srcStatus_t hlsPlayer_set(void *pHandle, srcPlayerSetData_t *pSetData)
+srcStatus_t hlsPlayer_set(hlsSession_t* pSession, srcPlayerSetData_t *pSetData)
 {
-    if(thePlugin.pHlsPlayerFuncTable->set == NULL)
+    if(pSession->pNullSink != NULL)
+    {
+        return hlsNullSink_set(pSession, pSetData);
+    }
+
+    if((thePlugin.pHlsPlayerFuncTable == NULL) || (thePlugin.pHlsPlayerFuncTable->set == NULL))
     {
         ERROR("pHlsPlayerFuncTable->set is NULL");
         return SRC_ERROR;
     }
 
-    return thePlugin.pHlsPlayerFuncTable->set(pHandle, pSetData);
+    return thePlugin.pHlsPlayerFuncTable->set(pSession->pHandle, pSetData);
 }
 
 /**
  * Passes session get request to external player
  *
- * @param pHandle - unique session handle passed by player in
- *                hlsPlugin_open() call
+ * @param pSession - session making the request
  * @param pGetData - pointer to #srcPlayerGetData_t containing
  *                 the setting to get from the player
  *
@@ -205,15 +302,20 @@ srcStatus_t hlsPlayer_set(void *pHandle, srcPlayerSetData_t *pSetData)
  *
  * @return #srcStatus_t
  */
-srcStatus_t hlsPlayer_getOption(void *pHandle, srcPlayerGetData_t *pGetData)
+srcStatus_t hlsPlayer_getOption(hlsSession_t* pSession, srcPlayerGetData_t *pGetData)
 {
-    if(thePlugin.pHlsPlayerFuncTable->get == NULL)
+    if(pSession->pNullSink != NULL)
+    {
+        return hlsNullSink_get(pSession, pGetData);
+    }
+
+    if((thePlugin.pHlsPlayerFuncTable == NULL) || (thePlugin.pHlsPlayerFuncTable->get == NULL))
     {
         ERROR("pHlsPlayerFuncTable->get is NULL");
         return SRC_ERROR;
     }
 
-    return thePlugin.pHlsPlayerFuncTable->get(pHandle, pGetData);
+    return thePlugin.pHlsPlayerFuncTable->get(pSession->pHandle, pGetData);
 }
 
 #ifdef __cplusplus
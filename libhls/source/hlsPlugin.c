@@ -44,6 +44,7 @@ extern "C" {
 #include <dirent.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
 
 #include "sourcePlugin.h"
 
@@ -58,9 +59,213 @@ extern "C" {
 
 #include "curlUtils.h"
 
+#include "hlsWorkerPool.h"
+#include "hlsTrace.h"
+#include "hlsClock.h"
+#include "hlsLog.h"
+
 /*! Global plugin instance */
 hlsPlugin_t thePlugin;
 
+/**
+ * Reads a positive integer tunable from the environment.
+ *
+ * @param name - environment variable name
+ * @param defaultValue - value to use if the variable is unset
+ *                     or invalid
+ *
+ * @return int - configured value
+ */
+static int getEnvTunable(const char* name, int defaultValue)
+{
+    char* pValue = getenv(name);
+    char* pEnd = NULL;
+    long value = 0;
+
+    if(pValue == NULL)
+    {
+        return defaultValue;
+    }
+
+    value = strtol(pValue, &pEnd, 10);
+    if((pEnd == pValue) || (*pEnd != '\0') || (value <= 0) || (value > 65536))
+    {
+        DEBUG(DBG_WARN, "ignoring invalid %s=\"%s\", using %d", name, pValue, defaultValue);
+        return defaultValue;
+    }
+
+    return (int)value;
+}
+
+/* A srcSessionId_t is (generation << SESSION_INDEX_BITS) | (slot index + 1),
+   so it is never NULL and decodes to its table slot without a search */
+#define SESSION_INDEX_BITS 16
+#define SESSION_INDEX_MASK ((uintptr_t)((1u << SESSION_INDEX_BITS) - 1))
+#define SESSION_GENERATION_MASK ((unsigned int)(UINTPTR_MAX >> SESSION_INDEX_BITS))
+
+/**
+ * Builds the player visible session handle for a table slot.
+ *
+ * @param index - slot index
+ * @param generation - current generation of the slot
+ *
+ * @return #srcSessionId_t
+ */
+static srcSessionId_t makeSessionId(int index, unsigned int generation)
+{
+    return (srcSessionId_t)((((uintptr_t)generation) << SESSION_INDEX_BITS) | (uintptr_t)(index + 1));
+}
+
+/**
+ * Translates a srcSessionId_t into its slot in the session table
+ * and pins the session so that it cannot be closed until
+ * releaseSession() is called.
+ *
+ * @param sessionId - the desired session Id
+ * @param pIndex - will contain the slot index to pass to
+ *               releaseSession()
+ *
+ * @return hlsSession_t* - the session, or NULL if sessionId is
+ *         unknown, stale or being closed
+ */
+static hlsSession_t* acquireSession(srcSessionId_t sessionId, int* pIndex)
+{
+    hlsSession_t* pSession = NULL;
+    hlsSessionSlot_t* pSlot = NULL;
+
+    int index = (int)(((uintptr_t)sessionId) & SESSION_INDEX_MASK) - 1;
+    unsigned int generation = (unsigned int)(((uintptr_t)sessionId) >> SESSION_INDEX_BITS);
+
+    if((index < 0) || (index >= thePlugin.maxSessions) || (thePlugin.sessionSlots == NULL))
+    {
+        return NULL;
+    }
+
+    pSlot = &(thePlugin.sessionSlots[index]);
+
+    pthread_mutex_lock(&(pSlot->mutex));
+
+    if((pSlot->pSession != NULL) && (pSlot->generation == generation) && !(pSlot->bClosing))
+    {
+        pSlot->inUse++;
+        pSession = pSlot->pSession;
+    }
+
+    pthread_mutex_unlock(&(pSlot->mutex));
+
+    *pIndex = index;
+
+    return pSession;
+}
+
+/**
+ * Unpins a session obtained with acquireSession().
+ *
+ * @param index - slot index returned by acquireSession()
+ */
+static void releaseSession(int index)
+{
+    hlsSessionSlot_t* pSlot = &(thePlugin.sessionSlots[index]);
+
+    pthread_mutex_lock(&(pSlot->mutex));
+
+    pSlot->inUse--;
+    if((pSlot->inUse == 0) && pSlot->bClosing)
+    {
+        pthread_cond_broadcast(&(pSlot->idleCond));
+    }
+
+    pthread_mutex_unlock(&(pSlot->mutex));
+}
+
+/**
+ * Frees the session table.  All slots MUST be empty.
+ */
+static void freeSessionTable(void)
+{
+    int i = 0;
+
+    if(thePlugin.sessionSlots != NULL)
+    {
+        for(i = 0; i < thePlugin.maxSessions; i++)
+        {
+            pthread_cond_destroy(&(thePlugin.sessionSlots[i].idleCond));
+            pthread_mutex_destroy(&(thePlugin.sessionSlots[i].mutex));
+        }
+
+        pthread_mutex_destroy(&(thePlugin.sessionTableMutex));
+
+        free(thePlugin.sessionSlots);
+        thePlugin.sessionSlots = NULL;
+    }
+
+    thePlugin.maxSessions = 0;
+    thePlugin.freeSlotHead = -1;
+}
+
+/**
+ * Allocates the session table and puts every slot on the free
+ * list.
+ *
+ * @param maxSessions - number of slots
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t allocSessionTable(int maxSessions)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    int i = 0;
+
+    do
+    {
+        thePlugin.sessionSlots = calloc(maxSessions, sizeof(hlsSessionSlot_t));
+        if(thePlugin.sessionSlots == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        if(pthread_mutex_init(&(thePlugin.sessionTableMutex), NULL) != 0)
+        {
+            ERROR("failed to initialize session table mutex");
+            free(thePlugin.sessionSlots);
+            thePlugin.sessionSlots = NULL;
+            rval = HLS_ERROR;
+            break;
+        }
+
+        for(i = 0; i < maxSessions; i++)
+        {
+            if((pthread_mutex_init(&(thePlugin.sessionSlots[i].mutex), NULL) != 0) ||
+               (pthread_cond_init(&(thePlugin.sessionSlots[i].idleCond), NULL) != 0))
+            {
+                ERROR("failed to initialize session slot %d", i);
+                rval = HLS_ERROR;
+                break;
+            }
+
+            thePlugin.sessionSlots[i].generation = 1;
+            thePlugin.sessionSlots[i].nextFree = (i + 1 < maxSessions) ? (i + 1) : -1;
+        }
+
+        /* Only tear down what we initialized */
+        thePlugin.maxSessions = i;
+
+        if(rval != HLS_OK)
+        {
+            freeSessionTable();
+            break;
+        }
+
+        thePlugin.freeSlotHead = 0;
+
+    } while(0);
+
+    return rval;
+}
+
 /**
  * Load the source plugin
  *
@@ -73,7 +278,9 @@ hlsPlugin_t thePlugin;
  *                    functions
  * @param playerTable - pointer to #srcPlayerFunc_t populated
  *                    with function pointers to valid player
- *                    functions
+ *                    functions.  May be NULL if there is no
+ *                    player, in which case every session is
+ *                    headless (see SRC_PLUGIN_SET_HEADLESS).
  * @param pErr - Pointer to #srcPluginErr_t error structure if
  *             applicable.  May be NULL.
  *
@@ -99,7 +306,13 @@ srcStatus_t srcPluginLoad(srcPluginFunc_t* pluginTable, srcPlayerFunc_t* playerT
     /* Open the logging module/file */
     OPEN_LOG;
 
-    if((pluginTable == NULL) || (playerTable == NULL))
+    /* Move log output off the calling threads if asked to (see hlsLog.h) */
+    if((getEnvTunable("HLS_LOG_ASYNC", 0) == 1) && (hlsLog_startAsync() != HLS_OK))
+    {
+        DEBUG(DBG_WARN, "failed to start asynchronous logging -- logging synchronously");
+    }
+
+    if(pluginTable == NULL)
     {
         ERROR("invalid paramater");
 
@@ -163,6 +376,13 @@ srcStatus_t srcPluginLoad(srcPluginFunc_t* pluginTable, srcPlayerFunc_t* playerT
         pluginTable->set = hlsPlugin_set;
         pluginTable->get = hlsPlugin_get;
 
+        /* No player -- sessions will run headless */
+        if(playerTable == NULL)
+        {
+            DEBUG(DBG_INFO,"no player function table -- all sessions will be headless");
+            break;
+        }
+
         /* Save off player function table */
         thePlugin.pHlsPlayerFuncTable = malloc(sizeof(*playerTable));
         if(thePlugin.pHlsPlayerFuncTable == NULL)
@@ -208,6 +428,9 @@ srcStatus_t srcPluginUnload( srcPluginErr_t* pErr )
     free(thePlugin.pHlsPlayerFuncTable);
     thePlugin.pHlsPlayerFuncTable = NULL;
 
+    /* Output anything still queued before closing the log */
+    hlsLog_stopAsync();
+
     /* Close the logging module/file */
     CLOSE_LOG;
 
@@ -235,6 +458,11 @@ srcStatus_t hlsPlugin_initialize(srcPluginErr_t* pErr)
 {
     srcStatus_t rval = SRC_SUCCESS;
 
+    int maxSessions = 0;
+    int minWorkers = 0;
+    int maxWorkers = 0;
+    int clockScale = 0;
+
     do
     {
         DEBUG(DBG_INFO,"initializing HLS plugin");
@@ -252,6 +480,61 @@ srcStatus_t hlsPlugin_initialize(srcPluginErr_t* pErr)
             break;
         }
 
+        /* Size the session table */
+        maxSessions = getEnvTunable("HLS_MAX_SESSIONS", MAX_SESSIONS);
+        if(maxSessions > (int)SESSION_INDEX_MASK)
+        {
+            maxSessions = (int)SESSION_INDEX_MASK;
+        }
+
+        if(allocSessionTable(maxSessions) != HLS_OK)
+        {
+            ERROR("failed to allocate session table");
+            if(pErr != NULL)
+            {
+                pErr->errCode = SRC_PLUGIN_ERR_INITIALIZE_FAILED;
+                snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("failed to allocate session table"));
+            }
+            rval = SRC_ERROR;
+            break;
+        }
+
+        /* Run sessions in accelerated virtual time if asked to (see hlsClock.h) */
+        clockScale = getEnvTunable("HLS_CLOCK_SCALE", 0);
+        if((clockScale > 0) && (hlsClock_setScale(clockScale) != HLS_OK))
+        {
+            DEBUG(DBG_WARN, "ignoring HLS_CLOCK_SCALE=%d", clockScale);
+        }
+
+        /* Start the worker pool shared by all sessions */
+        minWorkers = getEnvTunable("HLS_WORKER_THREADS", HLS_MIN_WORKER_THREADS);
+        maxWorkers = getEnvTunable("HLS_MAX_WORKER_THREADS", HLS_MAX_WORKER_THREADS);
+        if(maxWorkers < minWorkers)
+        {
+            maxWorkers = minWorkers;
+        }
+
+        if(hlsWorkerPool_init(minWorkers, maxWorkers) != HLS_OK)
+        {
+            ERROR("failed to start worker pool");
+            if(pErr != NULL)
+            {
+                pErr->errCode = SRC_PLUGIN_ERR_INITIALIZE_FAILED;
+                snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("failed to start worker pool"));
+            }
+            freeSessionTable();
+            rval = SRC_ERROR;
+            break;
+        }
+
+        /* Transfer tracing is diagnostic only, so carry on without it if we can't get the memory */
+        if(hlsTrace_init(getEnvTunable("HLS_TRACE_RECORDS", HLS_TRACE_DEFAULT_RECORDS)) != HLS_OK)
+        {
+            DEBUG(DBG_WARN, "failed to allocate transfer trace -- tracing disabled");
+        }
+
+        DEBUG(DBG_INFO,"max sessions: %d, worker threads: %d-%d", thePlugin.maxSessions, minWorkers, maxWorkers);
+
         /* Set initialized flag */
         thePlugin.bInitialized = 1;
 
@@ -282,6 +565,9 @@ srcStatus_t hlsPlugin_finalize(srcPluginErr_t* pErr)
 {
     srcStatus_t rval = SRC_SUCCESS;
     int i;
+    srcSessionId_t sessionId = NULL;
+    char* pTraceFile = NULL;
+    char* pTraceFormat = NULL;
 
     DEBUG(DBG_INFO,"finalizing HLS plugin");
 
@@ -301,11 +587,20 @@ srcStatus_t hlsPlugin_finalize(srcPluginErr_t* pErr)
         }
 
         /* Close any active sessions */
-        for(i = 0; i < MAX_SESSIONS; i++)
+        for(i = 0; i < thePlugin.maxSessions; i++)
         {
-            if(thePlugin.hlsSessions[i] != NULL)
+            sessionId = NULL;
+
+            pthread_mutex_lock(&(thePlugin.sessionSlots[i].mutex));
+            if(thePlugin.sessionSlots[i].pSession != NULL)
             {
-                rval = hlsPlugin_close(thePlugin.hlsSessions[i], pErr);
+                sessionId = makeSessionId(i, thePlugin.sessionSlots[i].generation);
+            }
+            pthread_mutex_unlock(&(thePlugin.sessionSlots[i].mutex));
+
+            if(sessionId != NULL)
+            {
+                rval = hlsPlugin_close(sessionId, pErr);
                 if(rval != SRC_SUCCESS)
                 {
                     break;
@@ -334,6 +629,22 @@ srcStatus_t hlsPlugin_finalize(srcPluginErr_t* pErr)
             break;
         }
 
+        /* All sessions are gone, so nothing is left on the worker pool */
+        hlsWorkerPool_term();
+
+        /* Leave the transfer trace behind if asked to */
+        pTraceFile = getenv("HLS_TRACE_FILE");
+        if(pTraceFile != NULL)
+        {
+            pTraceFormat = getenv("HLS_TRACE_FORMAT");
+            hlsTrace_dump(pTraceFile,
+                          ((pTraceFormat != NULL) && (strcmp(pTraceFormat, "json") == 0)) ? SRC_TRACE_FORMAT_JSON : SRC_TRACE_FORMAT_BINARY,
+                          NULL);
+        }
+        hlsTrace_term();
+
+        freeSessionTable();
+
         thePlugin.activeSessions = 0;
         thePlugin.pluginErrCallback = NULL;
         thePlugin.pluginEvtCallback = NULL;
@@ -434,6 +745,7 @@ srcStatus_t hlsPlugin_open(srcSessionId_t *pSessionId, void* pHandle, srcPluginE
     hlsStatus_t status = HLS_OK;
 
     int sessionIndex = 0;
+    hlsSession_t* pSession = NULL;
 
     if(pHandle == NULL)
     {
@@ -462,7 +774,17 @@ srcStatus_t hlsPlugin_open(srcSessionId_t *pSessionId, void* pHandle, srcPluginE
         }
 
         /* Get an open session slot */
-        sessionIndex = getSessionIndex(NULL);
+        pthread_mutex_lock(&(thePlugin.sessionTableMutex));
+
+        sessionIndex = thePlugin.freeSlotHead;
+        if(sessionIndex != -1)
+        {
+            thePlugin.freeSlotHead = thePlugin.sessionSlots[sessionIndex].nextFree;
+            thePlugin.sessionSlots[sessionIndex].nextFree = -1;
+            thePlugin.activeSessions++;
+        }
+
+        pthread_mutex_unlock(&(thePlugin.sessionTableMutex));
 
         /* Make sure we can support another session */
         if(sessionIndex == -1)
@@ -477,7 +799,7 @@ srcStatus_t hlsPlugin_open(srcSessionId_t *pSessionId, void* pHandle, srcPluginE
             break;
         }
 
-        status = hlsSession_init(&(thePlugin.hlsSessions[sessionIndex]), pHandle);
+        status = hlsSession_init(&pSession, pHandle);
         if(status != HLS_OK)
         {
             ERROR("hlsSession_init failed with status: %d", status);
@@ -486,16 +808,57 @@ srcStatus_t hlsPlugin_open(srcSessionId_t *pSessionId, void* pHandle, srcPluginE
                 pErr->errCode = SRC_PLUGIN_ERR_SESSION_RESOURCE_FAILED;
                 snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_init failed with status: %d", status));
             }
+
+            /* Give the slot back */
+            pthread_mutex_lock(&(thePlugin.sessionTableMutex));
+            thePlugin.sessionSlots[sessionIndex].nextFree = thePlugin.freeSlotHead;
+            thePlugin.freeSlotHead = sessionIndex;
+            thePlugin.activeSessions--;
+            pthread_mutex_unlock(&(thePlugin.sessionTableMutex));
+
             rval = SRC_ERROR;
             break;
         }
 
-        thePlugin.activeSessions++;
+        /* Without a player, consume the data ourselves */
+        if(thePlugin.pHlsPlayerFuncTable == NULL)
+        {
+            status = hlsSession_setHeadless(pSession, 1);
+            if(status != HLS_OK)
+            {
+                ERROR("hlsSession_setHeadless failed with status: %d", status);
+                if(pErr != NULL)
+                {
+                    pErr->errCode = SRC_PLUGIN_ERR_SESSION_RESOURCE_FAILED;
+                    snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setHeadless failed with status: %d", status));
+                }
+
+                hlsSession_term(pSession);
+
+                /* Give the slot back */
+                pthread_mutex_lock(&(thePlugin.sessionTableMutex));
+                thePlugin.sessionSlots[sessionIndex].nextFree = thePlugin.freeSlotHead;
+                thePlugin.freeSlotHead = sessionIndex;
+                thePlugin.activeSessions--;
+                pthread_mutex_unlock(&(thePlugin.sessionTableMutex));
+
+                rval = SRC_ERROR;
+                break;
+            }
+        }
 
-        *pSessionId = (srcSessionId_t)(thePlugin.hlsSessions[sessionIndex]);
+        /* Publish the session in its slot */
+        pthread_mutex_lock(&(thePlugin.sessionSlots[sessionIndex].mutex));
+        thePlugin.sessionSlots[sessionIndex].pSession = pSession;
+        *pSessionId = makeSessionId(sessionIndex, thePlugin.sessionSlots[sessionIndex].generation);
+        pSession->sessionId = *pSessionId;
+        pthread_mutex_unlock(&(thePlugin.sessionSlots[sessionIndex].mutex));
 
         /* Register session callback with player */
-        status = hlsPlayer_registerCB(pHandle, hlsPlugin_playerEvtCallback);
+        if(thePlugin.pHlsPlayerFuncTable != NULL)
+        {
+            status = hlsPlayer_registerCB(pHandle, hlsPlugin_playerEvtCallback);
+        }
         if(status != HLS_OK)
         {
             ERROR("registerCB failed with status: %d", status);
@@ -539,6 +902,8 @@ srcStatus_t hlsPlugin_close(srcSessionId_t sessionId, srcPluginErr_t* pErr)
     srcStatus_t rval = SRC_SUCCESS;
 
     int sessionIndex = 0;
+    hlsSession_t* pSession = NULL;
+    hlsSessionSlot_t* pSlot = NULL;
 
     if(sessionId == NULL)
     {
@@ -566,10 +931,11 @@ srcStatus_t hlsPlugin_close(srcSessionId_t sessionId, srcPluginErr_t* pErr)
             break;
         }
 
-        sessionIndex = getSessionIndex(sessionId);
+        /* Pin the session, then wait for any other API calls on it to finish */
+        pSession = acquireSession(sessionId, &sessionIndex);
 
         /* Make sure we were called on a valid session */
-        if(sessionIndex == -1)
+        if(pSession == NULL)
         {
             ERROR("invalid session: %p", (void*)sessionId);
             if(pErr != NULL)
@@ -581,13 +947,40 @@ srcStatus_t hlsPlugin_close(srcSessionId_t sessionId, srcPluginErr_t* pErr)
             break;
         }
 
+        pSlot = &(thePlugin.sessionSlots[sessionIndex]);
+
+        pthread_mutex_lock(&(pSlot->mutex));
+
+        /* Turn away new lookups while we drain */
+        pSlot->bClosing = 1;
+        pSlot->inUse--;
+        while(pSlot->inUse > 0)
+        {
+            pthread_cond_wait(&(pSlot->idleCond), &(pSlot->mutex));
+        }
+
+        /* Unpublish the session and invalidate its handle */
+        pSlot->pSession = NULL;
+        pSlot->generation = (pSlot->generation + 1) & SESSION_GENERATION_MASK;
+        if(pSlot->generation == 0)
+        {
+            pSlot->generation = 1;
+        }
+        pSlot->bClosing = 0;
+
+        pthread_mutex_unlock(&(pSlot->mutex));
+
         /* Terminate the session */
-        hlsSession_term(thePlugin.hlsSessions[sessionIndex]);
+        hlsSession_term(pSession);
 
         DEBUG(DBG_INFO,"closed session %p", (void*)sessionId);
 
-        thePlugin.hlsSessions[sessionIndex] = NULL;
+        /* Return the slot to the free list */
+        pthread_mutex_lock(&(thePlugin.sessionTableMutex));
+        pSlot->nextFree = thePlugin.freeSlotHead;
+        thePlugin.freeSlotHead = sessionIndex;
         thePlugin.activeSessions--;
+        pthread_mutex_unlock(&(thePlugin.sessionTableMutex));
 
     } while(0);
 
@@ -622,6 +1015,7 @@ srcStatus_t hlsPlugin_prepare( srcSessionId_t sessionId, srcPluginErr_t* pErr )
     hlsStatus_t status = HLS_OK;
 
     int sessionIndex = 0;
+    hlsSession_t* pSession = NULL;
 
     if(sessionId == NULL)
     {
@@ -649,10 +1043,10 @@ srcStatus_t hlsPlugin_prepare( srcSessionId_t sessionId, srcPluginErr_t* pErr )
             break;
         }
 
-        sessionIndex = getSessionIndex(sessionId);
+        pSession = acquireSession(sessionId, &sessionIndex);
 
         /* Make sure we were called on a valid session */
-        if(sessionIndex == -1)
+        if(pSession == NULL)
         {
             ERROR("invalid session: %p", (void*)sessionId);
             if(pErr != NULL)
@@ -667,7 +1061,7 @@ srcStatus_t hlsPlugin_prepare( srcSessionId_t sessionId, srcPluginErr_t* pErr )
         DEBUG(DBG_INFO,"%s on session %p", __FUNCTION__, (void*)sessionId);
 
         /* prepare on the session */
-        status = hlsSession_prepare(thePlugin.hlsSessions[sessionIndex]);
+        status = hlsSession_prepare(pSession);
         if(status != HLS_OK)
         {
             ERROR("hlsSession_prepare failed on session %p with status: %d", (void*)sessionId, status);
@@ -682,6 +1076,11 @@ srcStatus_t hlsPlugin_prepare( srcSessionId_t sessionId, srcPluginErr_t* pErr )
 
     } while(0);
 
+    if(pSession != NULL)
+    {
+        releaseSession(sessionIndex);
+    }
+
     return rval;
 }
 
@@ -734,6 +1133,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
     hlsStatus_t status = HLS_OK;
 
     int sessionIndex = 0;
+    hlsSession_t* pSession = NULL;
 
     if((sessionId == NULL) || (pSetData == NULL) || (pSetData->pData == NULL))
     {
@@ -761,10 +1161,10 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
             break;
         }
 
-        sessionIndex = getSessionIndex(sessionId);
+        pSession = acquireSession(sessionId, &sessionIndex);
 
         /* Make sure we were called on a valid session */
-        if(sessionIndex == -1)
+        if(pSession == NULL)
         {
             ERROR("invalid session: %p", (void*)sessionId);
             if(pErr != NULL)
@@ -782,7 +1182,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                 DEBUG(DBG_INFO,"setting URL = %s for session %p", (char*)(pSetData->pData), (void *)sessionId);
 
                 /* setDataSource on the session */
-                status = hlsSession_setDataSource(thePlugin.hlsSessions[sessionIndex], (char*)(pSetData->pData));
+                status = hlsSession_setDataSource(pSession, (char*)(pSetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_setDataSource failed on session %p with status: %d", (void*)sessionId, status);
@@ -799,7 +1199,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                 DEBUG(DBG_INFO,"setting speed = %f on session %p", *(float*)(pSetData->pData), (void*)sessionId);
 
 		        /* Call the session setSpeed function */
-        		status = hlsSession_setSpeed(thePlugin.hlsSessions[sessionIndex], *(float*)(pSetData->pData));
+        		status = hlsSession_setSpeed(pSession, *(float*)(pSetData->pData));
                 if(status == HLS_UNSUPPORTED)
                 {
                     ERROR("setting speed %f on session %p not supported by this stream at this time", *(float*)(pSetData->pData), (void*)sessionId);
@@ -827,7 +1227,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                DEBUG(DBG_INFO,"seeking to position = %f on session %p", *(float*)(pSetData->pData), (void*)sessionId);
 
                /* Call the session seek function */
-               status = hlsSession_seek(thePlugin.hlsSessions[sessionIndex], *(float*)(pSetData->pData));
+               status = hlsSession_seek(pSession, *(float*)(pSetData->pData));
                if(status == HLS_UNSUPPORTED)
                {
                   ERROR("setting position %f on session %p not supported by this stream at this time", *(float*)(pSetData->pData), (void*)sessionId);
@@ -853,14 +1253,14 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                else
                {
                   DEBUG(DBG_INFO, "resetting EOF count");
-                  thePlugin.hlsSessions[sessionIndex]->eofCount = 0;
+                  pSession->eofCount = 0;
                }
                break;
             case SRC_PLUGIN_SET_MAX_BITRATE:
                 DEBUG(DBG_INFO,"setting max bitrate = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
 
                 /* setBitrateRange on the session */
-                status = hlsSession_setBitrateLimit(thePlugin.hlsSessions[sessionIndex], BR_LIMIT_MAX, *(int*)(pSetData->pData));
+                status = hlsSession_setBitrateLimit(pSession, BR_LIMIT_MAX, *(int*)(pSetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_setBitrateLimit failed on session %p with status: %d", (void*)sessionId, status);
@@ -877,7 +1277,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                 DEBUG(DBG_INFO,"setting min bitrate = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
 
                 /* setBitrateRange on the session */
-                status = hlsSession_setBitrateLimit(thePlugin.hlsSessions[sessionIndex], BR_LIMIT_MIN, *(int*)(pSetData->pData));
+                status = hlsSession_setBitrateLimit(pSession, BR_LIMIT_MIN, *(int*)(pSetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_setBitrateLimit failed on session %p with status: %d", (void*)sessionId, status);
@@ -894,7 +1294,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                 DEBUG(DBG_INFO,"setting target bitrate = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
 
                 /* setBitrateRange on the session */
-                status = hlsSession_setBitrateLimit(thePlugin.hlsSessions[sessionIndex], BR_LIMIT_TARGET, *(int*)(pSetData->pData));
+                status = hlsSession_setBitrateLimit(pSession, BR_LIMIT_TARGET, *(int*)(pSetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_setBitrateLimit failed on session %p with status: %d", (void*)sessionId, status);
@@ -911,7 +1311,7 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                 DEBUG(DBG_INFO,"setting audio language: %s on session %p", (char*)(pSetData->pData), (void*)sessionId);
 
                 /* setAudioLanguage on the session */
-                status = hlsSession_setAudioLanguage(thePlugin.hlsSessions[sessionIndex], (char*)(pSetData->pData));
+                status = hlsSession_setAudioLanguage(pSession, (char*)(pSetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_setAudioLanguage failed on session %p with status: %d", (void*)sessionId, status);
@@ -924,6 +1324,122 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
                     break;
                 }
                 break;
+            case SRC_PLUGIN_SET_HEADLESS:
+                DEBUG(DBG_INFO,"setting headless = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
+
+                /* Without a player there is no way back from headless */
+                if(!(*(int*)(pSetData->pData)) && (thePlugin.pHlsPlayerFuncTable == NULL))
+                {
+                    ERROR("no player to send data to on session %p", (void*)sessionId);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_UNSUPPORTED;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("no player to send data to on session %p", (void*)sessionId));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+
+                /* setHeadless on the session */
+                status = hlsSession_setHeadless(pSession, *(int*)(pSetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_setHeadless failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setHeadless failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_SET_PID_FILTER:
+                DEBUG(DBG_INFO,"setting PID filter = 0x%x on session %p", *(int*)(pSetData->pData), (void*)sessionId);
+
+                /* setPidFilter on the session */
+                status = hlsSession_setPidFilter(pSession, *(int*)(pSetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_setPidFilter failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_INVALID_PARAM;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setPidFilter failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_SET_DECRYPTION:
+                DEBUG(DBG_INFO,"setting decryption = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
+
+                /* setDecryption on the session */
+                status = hlsSession_setDecryption(pSession, *(int*)(pSetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_setDecryption failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = (status == HLS_UNSUPPORTED) ? SRC_PLUGIN_ERR_UNSUPPORTED : SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setDecryption failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_SET_PARALLEL_CONNECTIONS:
+                DEBUG(DBG_INFO,"setting parallel connections = %d on session %p", *(int*)(pSetData->pData), (void*)sessionId);
+
+                /* setParallelConnections on the session */
+                status = hlsSession_setParallelConnections(pSession, *(int*)(pSetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_setParallelConnections failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_INVALID_PARAM;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setParallelConnections failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_SET_LEND_BUFFER:
+                DEBUG(DBG_INFO,"setting lend buffer function on session %p", (void*)sessionId);
+
+                /* setLendBuffer on the session */
+                status = hlsSession_setLendBuffer(pSession, *(srcPlayerLendBuffer_t*)(pSetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_setLendBuffer failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_setLendBuffer failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_SET_TRACE_DUMP:
+                DEBUG(DBG_INFO,"dumping transfer trace of session %p to %s", (void*)sessionId, ((srcPluginTraceDump_t*)(pSetData->pData))->filePath);
+
+                status = hlsTrace_dump(((srcPluginTraceDump_t*)(pSetData->pData))->filePath,
+                                       ((srcPluginTraceDump_t*)(pSetData->pData))->format,
+                                       sessionId);
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsTrace_dump failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsTrace_dump failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
             default:
                 ERROR("unknown srcPlayerSetCode_t value: %d", pSetData->setCode);
                 if(pErr != NULL)
@@ -941,6 +1457,11 @@ srcStatus_t hlsPlugin_set(srcSessionId_t sessionId, srcPluginSetData_t* pSetData
 
     } while(0);
 
+    if(pSession != NULL)
+    {
+        releaseSession(sessionIndex);
+    }
+
     return rval;
 }
 
@@ -976,6 +1497,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
     hlsStatus_t status = HLS_OK;
 
     int sessionIndex = 0;
+    hlsSession_t* pSession = NULL;
 
     if((sessionId == NULL) || (pGetData == NULL) || (pGetData->pData == NULL))
     {
@@ -1003,10 +1525,10 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
             break;
         }
 
-        sessionIndex = getSessionIndex(sessionId);
+        pSession = acquireSession(sessionId, &sessionIndex);
 
         /* Make sure we were called on a valid session */
-        if(sessionIndex == -1)
+        if(pSession == NULL)
         {
             ERROR("invalid session: %p", (void*)sessionId);
             if(pErr != NULL)
@@ -1024,7 +1546,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 DEBUG(DBG_INFO,"getting number of bitrates for session %p", (void*)sessionId);
 
                 /* getNumBitrates on the session */
-                status = hlsSession_getNumBitrates(thePlugin.hlsSessions[sessionIndex], (int*)(pGetData->pData));
+                status = hlsSession_getNumBitrates(pSession, (int*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getNumBitrates failed on session %p with status: %d", (void*)sessionId, status);
@@ -1041,7 +1563,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 DEBUG(DBG_INFO,"getting bitrates for session %p", (void*)sessionId);
 
                 /* getBitrates on the session */
-                status = hlsSession_getBitrates(thePlugin.hlsSessions[sessionIndex], *(int*)(pGetData->pData), (int*)(pGetData->pData));
+                status = hlsSession_getBitrates(pSession, *(int*)(pGetData->pData), (int*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getBitrates failed on session %p with status: %d", (void*)sessionId, status);
@@ -1058,7 +1580,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 DEBUG(DBG_INFO,"getting current bitrate for session %p", (void*)sessionId);
 
                 /* getBitrates on the session */
-                status = hlsSession_getCurrentBitrate(thePlugin.hlsSessions[sessionIndex], (int*)(pGetData->pData));
+                status = hlsSession_getCurrentBitrate(pSession, (int*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getCurrentBitrate failed on session %p with status: %d", (void*)sessionId, status);
@@ -1075,7 +1597,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 DEBUG(DBG_INFO,"getting duration for session %p", (void*)sessionId);
 
                 /* getDuration on the session */
-                status = hlsSession_getDuration(thePlugin.hlsSessions[sessionIndex], (float*)(pGetData->pData));
+                status = hlsSession_getDuration(pSession, (float*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getDuration failed on session %p with status: %d", (void*)sessionId, status);
@@ -1092,7 +1614,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 DEBUG(DBG_INFO,"getting current position for session %p", (void*)sessionId);
 
                 /* getCurrentPosition on the session */
-                status = hlsSession_getCurrentPosition(thePlugin.hlsSessions[sessionIndex], (float*)(pGetData->pData));
+                status = hlsSession_getCurrentPosition(pSession, (float*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getCurrentPosition failed on session %p with status: %d", (void*)sessionId, status);
@@ -1108,7 +1630,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
             case SRC_PLUGIN_GET_SPEED:
                 DEBUG(DBG_INFO,"getting current speed for session %p", (void*)sessionId);
 
-                status = hlsSession_getSpeed(thePlugin.hlsSessions[sessionIndex], (float*)(pGetData->pData));
+                status = hlsSession_getSpeed(pSession, (float*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getSpeed failed on session %p with status: %d", (void*)sessionId, status);
@@ -1124,7 +1646,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
             case SRC_PLUGIN_GET_TRICK_SUPPORTED:
                 DEBUG(DBG_INFO,"getting trick supported for session %p", (void*)sessionId);
 
-                status = hlsSession_getTrickSupported(thePlugin.hlsSessions[sessionIndex], (int*)(pGetData->pData));
+                status = hlsSession_getTrickSupported(pSession, (int*)(pGetData->pData));
                 if(status != HLS_OK)
                 {
                     ERROR("hlsSession_getTrickSupported failed on session %p with status: %d", (void*)sessionId, status);
@@ -1142,7 +1664,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                    hlsContentType_t contentType = HLS_UNSPECIFIED;
                    DEBUG(DBG_INFO,"getting content type for session %p", (void*)sessionId);
 
-                   status = hlsSession_getContentType(thePlugin.hlsSessions[sessionIndex], &contentType);
+                   status = hlsSession_getContentType(pSession, &contentType);
                    if(status != HLS_OK)
                    {
                       ERROR("hlsSession_getContentType failed on session %p with status: %d", (void*)sessionId, status);
@@ -1173,7 +1695,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                 {
                    DEBUG(DBG_INFO,"getting numAudioLanguages for session %p", (void*)sessionId);
 
-                   status = hlsSession_getNumAudioLanguages(thePlugin.hlsSessions[sessionIndex], (int *)pGetData->pData);
+                   status = hlsSession_getNumAudioLanguages(pSession, (int *)pGetData->pData);
                    if(status != HLS_OK)
                    {
                       ERROR("hlsSession_getNumAudioLanguages failed on session %p with status: %d", (void*)sessionId, status);
@@ -1192,7 +1714,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
             case SRC_PLUGIN_GET_AUDIO_LANGUAGES_INFO:
                 {
                    DEBUG(DBG_INFO,"getting audio languages info for session %p", (void*)sessionId);
-                   status = hlsSession_getAudioLanguagesInfo(thePlugin.hlsSessions[sessionIndex],
+                   status = hlsSession_getAudioLanguagesInfo(pSession,
                                                              ((srcPluginAudioLanguages_t *)pGetData->pData)->audioLangInfoArr,
                                                              &((srcPluginAudioLanguages_t *)pGetData->pData)->numAudioLanguages);
 
@@ -1214,7 +1736,7 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
             case SRC_PLUGIN_GET_AUDIO_LANGUAGE:
                 {
                    DEBUG(DBG_INFO,"getting current audio language for session %p", (void*)sessionId);
-                   status = hlsSession_getAudioLanguage(thePlugin.hlsSessions[sessionIndex],
+                   status = hlsSession_getAudioLanguage(pSession,
                                                              (char *)pGetData->pData);
 
                    if(status != HLS_OK)
@@ -1232,6 +1754,57 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
                    }
                 }
                 break;
+            case SRC_PLUGIN_GET_HEALTH:
+                DEBUG(DBG_NOISE,"getting health summary for session %p", (void*)sessionId);
+
+                /* getHealth on the session */
+                status = hlsSession_getHealth(pSession, (srcPluginHealth_t*)(pGetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_getHealth failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_getHealth failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_GET_STATS:
+                DEBUG(DBG_NOISE,"getting stats for session %p", (void*)sessionId);
+
+                /* getStats on the session */
+                status = hlsSession_getStats(pSession, (srcPluginStats_t*)(pGetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_getStats failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_getStats failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
+            case SRC_PLUGIN_GET_LOCK_STATS:
+                DEBUG(DBG_NOISE,"getting lock stats for session %p", (void*)sessionId);
+
+                /* getLockStats on the session */
+                status = hlsSession_getLockStats(pSession, (srcPluginLockStats_t*)(pGetData->pData));
+                if(status != HLS_OK)
+                {
+                    ERROR("hlsSession_getLockStats failed on session %p with status: %d", (void*)sessionId, status);
+                    if(pErr != NULL)
+                    {
+                        pErr->errCode = SRC_PLUGIN_ERR_GENERAL;
+                        snprintf(pErr->errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("hlsSession_getLockStats failed on session %p with status: %d", (void*)sessionId, status));
+                    }
+                    rval = SRC_ERROR;
+                    break;
+                }
+                break;
             default:
                 ERROR("unknown srcPlayerGetCode_t value: %d", pGetData->getCode);
                 if(pErr != NULL)
@@ -1249,6 +1822,11 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
 
     } while(0);
 
+    if(pSession != NULL)
+    {
+        releaseSession(sessionIndex);
+    }
+
     return rval;
 }
 
@@ -1270,48 +1848,21 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
 void hlsPlugin_playerEvtCallback(srcSessionId_t sessionId, srcPlayerEvt_t* pEvt)
 {
     int sessionIndex = -1;
+    hlsSession_t* pSession = NULL;
 
     /* Make sure we've been initialized */
     if(thePlugin.bInitialized)
     {
-        sessionIndex = getSessionIndex(sessionId);
+        pSession = acquireSession(sessionId, &sessionIndex);
 
         /* Make sure we were called on a valid session */
-        if(sessionIndex != -1)
+        if(pSession != NULL)
         {
-            hlsSession_playerEvtCallback((hlsSession_t*)sessionId, pEvt);
-        }
-    }
-}
-
-/**
- * Helper function which translates a srcSessionId_t into an
- * index in the plugin structure's hlsPlugin_t::hlsSessions
- * array.
- *
- * @param sessionId - the desired session Id
- *
- * @return int - the index in the hlsPlugin_t::hlsSessions array
- *         that sessionId is located at; -1 on failure
- */
-int getSessionIndex(srcSessionId_t sessionId)
-{
-    int rval = -1;
-
-    int i = 0;
-
-    for(i = 0; i < MAX_SESSIONS; i++)
-    {
-        DEBUG(DBG_NOISE,"Looking for sessionId %p, found %p", (void *)sessionId, (void *)(thePlugin.hlsSessions[i]));
+            hlsSession_playerEvtCallback(pSession, pEvt);
 
-        if(sessionId == (srcSessionId_t)(thePlugin.hlsSessions[i]))
-        {
-            rval = i;
-            break;
+            releaseSession(sessionIndex);
         }
     }
-
-    return rval;
 }
 
 #ifdef __cplusplus
@@ -49,6 +49,13 @@ extern "C" {
 #include "hlsPlaybackController.h"
 
 #include "curlUtils.h"
+#include "hlsWorkerPool.h"
+#include "hlsClock.h"
+#include "hlsLockStats.h"
+#include "hlsNullSink.h"
+#include "hlsKeyCache.h"
+#include "hlsStats.h"
+#include "hlsDecrypt.h"
 
 #include "debug.h"
 
@@ -100,6 +107,7 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle)
 
         (*ppSession)->maxBitrate = INT_MAX;
         (*ppSession)->lastPTS = -1ll;
+        (*ppSession)->lastSegmentPts = -1ll;
 
         (*ppSession)->playbackControllerMsgQueue = newMsgQueue();
         if((*ppSession)->playbackControllerMsgQueue == NULL)
@@ -125,6 +133,14 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle)
         /* Save parameters */
         (*ppSession)->pHandle = pHandle;
 
+        /* Initialize performance counters */
+        rval = hlsStats_init(&((*ppSession)->stats));
+        if(rval != HLS_OK)
+        {
+            ERROR("failed to initialize session stats");
+            break;
+        }
+
         /* Initialize player event mutex */
         if(pthread_mutex_init(&((*ppSession)->playerEvtMutex), NULL) != 0)
         {
@@ -235,7 +251,7 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle)
         }
 #endif
 
-        /* Initialize parser thread wake mutex/condition */
+        /* Initialize parser wake mutex/condition */
         if(pthread_mutex_init(&((*ppSession)->parserWakeMutex), NULL) != 0)
         {
             ERROR("failed to initialize parser wake mutex");
@@ -263,20 +279,6 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle)
             break;
         }
 
-        /* Initialize playback controller thread wake mutex/condition */
-        if(pthread_mutex_init(&((*ppSession)->playbackControllerWakeMutex), NULL) != 0)
-        {
-            ERROR("failed to initialize playback controller wake mutex");
-            rval = HLS_ERROR;
-            break;
-        }
-        if(pthread_cond_init(&((*ppSession)->playbackControllerWakeCond), &condAttr) != 0)
-        {
-            ERROR("failed to initialize playback controller wake condition");
-            rval = HLS_ERROR;
-            break;
-        }
-
         /* Initialize our CURL handle */
         rval = curlInit(&((*ppSession)->pCurl));
         if(rval != HLS_OK)
@@ -301,6 +303,13 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle)
            break;
         }
 
+        rval = hlsKeyCache_create(&((*ppSession)->stats), *ppSession, &((*ppSession)->pKeyCache));
+        if(rval != HLS_OK)
+        {
+            ERROR("failed to create key cache");
+            break;
+        }
+
     } while(0);
 
     pthread_condattr_destroy(&condAttr);
@@ -347,16 +356,7 @@ void hlsSession_term(hlsSession_t* pSession)
             }
         }
 
-        /* Wake up playback controller thread if it is sleeping */
-        if(pthread_mutex_lock(&(pSession->playbackControllerWakeMutex)) == 0)
-        {
-            if(pthread_cond_signal(&(pSession->playbackControllerWakeCond)) == 0)
-            {
-                pthread_mutex_unlock(&(pSession->playbackControllerWakeMutex));
-            }
-        }
-
-        /* Wake up parser thread if it is sleeping */
+        /* Wake up parser if it is waiting to retry a playlist download */
         if(pthread_mutex_lock(&(pSession->parserWakeMutex)) == 0)
         {
             if(pthread_cond_signal(&(pSession->parserWakeCond)) == 0)
@@ -365,6 +365,10 @@ void hlsSession_term(hlsSession_t* pSession)
             }
         }
 
+        /* Run the playback controller and parser tasks now so they see the kill signal */
+        hlsWorkerPool_wake(&(pSession->playbackControllerTask));
+        hlsWorkerPool_wake(&(pSession->parserTask));
+
         if(pSession->downloader != 0)
         {
             pthread_join(pSession->downloader, NULL);
@@ -381,36 +385,25 @@ void hlsSession_term(hlsSession_t* pSession)
            }
         }
 
-        if(pSession->playbackController != 0)
-        {
-            pthread_join(pSession->playbackController, NULL);
-            pSession->playbackController= 0;
-        }
-
-        if(pSession->parser != 0)
-        {
-            pthread_join(pSession->parser, NULL);
-            pSession->parser= 0;
-        }
+        /* Wait for the playback controller and parser tasks to finish */
+        hlsWorkerPool_wait(&(pSession->playbackControllerTask));
+        hlsWorkerPool_wait(&(pSession->parserTask));
 
         pthread_cond_destroy(&(pSession->parserWakeCond));
         pthread_mutex_destroy(&(pSession->parserWakeMutex));
 
-        pthread_cond_destroy(&(pSession->playbackControllerWakeCond));
-        pthread_mutex_destroy(&(pSession->playbackControllerWakeMutex));
-
         pthread_cond_destroy(&(pSession->downloaderWakeCond));
         pthread_mutex_destroy(&(pSession->downloaderWakeMutex));
 
         /* Put session in INVALID state */
 
         /* Block state changes */
-        pthread_mutex_lock(&(pSession->stateMutex));
+        HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
         pSession->state = HLS_INVALID_STATE;
 
         /* Leave critical section */
-        pthread_mutex_unlock(&(pSession->stateMutex));
+        HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
         pthread_mutex_destroy(&(pSession->stateMutex));
         pthread_mutex_destroy(&(pSession->playerEvtMutex));
@@ -418,7 +411,7 @@ void hlsSession_term(hlsSession_t* pSession)
         pthread_mutex_destroy(&(pSession->curlMutex));
         pthread_mutex_destroy(&(pSession->dldRateMutex));
 
-        pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+        playlistWriteLock(pSession);
 
         pSession->pCurrentPlaylist = NULL;
         pSession->pCurrentProgram = NULL;
@@ -446,9 +439,12 @@ void hlsSession_term(hlsSession_t* pSession)
         free(pSession->sessionName);
         pSession->sessionName = NULL;
 
-        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        playlistUnlock(pSession);
         pthread_rwlock_destroy(&(pSession->playlistRWLock));
 
+        hlsKeyCache_destroy(pSession->pKeyCache);
+        pSession->pKeyCache = NULL;
+
         if(pSession->pCurl != NULL)
         {
             curlTerm(pSession->pCurl);
@@ -464,6 +460,27 @@ void hlsSession_term(hlsSession_t* pSession)
            }
         }
 
+        for(ii = 0; ii < SRC_MAX_PARALLEL_CONNECTIONS - 1; ii++)
+        {
+            if(pSession->pParallelCurl[ii] != NULL)
+            {
+                curlTerm(pSession->pParallelCurl[ii]);
+                pSession->pParallelCurl[ii] = NULL;
+            }
+        }
+
+        if(pSession->pRangeRunCurl != NULL)
+        {
+            curlTerm(pSession->pRangeRunCurl);
+            pSession->pRangeRunCurl = NULL;
+        }
+
+        hlsNullSink_destroy(pSession->pNullSink);
+        pSession->pNullSink = NULL;
+
+        hlsStats_logLocks(&(pSession->stats), pSession);
+        hlsStats_term(&(pSession->stats));
+
         free(pSession);
     }
 }
@@ -491,7 +508,7 @@ hlsStatus_t hlsSession_setDataSource(hlsSession_t* pSession, char* playlistURL)
     TIMESTAMP(DBG_INFO,"%s: playlistURL = %s", __FUNCTION__, playlistURL);
 
     /* Get playlist WRITE lock */
-    pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+    playlistWriteLock(pSession);
 
     do
     {
@@ -545,15 +562,206 @@ hlsStatus_t hlsSession_setDataSource(hlsSession_t* pSession, char* playlistURL)
     }
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
+
+    if(rval == HLS_OK)
+    {
+        /* Start timing the startup phases from here */
+        hlsStats_markDataSource(&(pSession->stats));
+    }
 
     return rval;
 }
 
+/**
+ * Switches the session between sending its data to the player
+ * and consuming it internally with a null sink (headless mode).
+ *
+ * @param pSession - handle to streamer object
+ * @param bHeadless - 1 to make the session headless, 0 to use
+ *                  the player
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_setHeadless(hlsSession_t* pSession, int bHeadless)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if(pSession == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    /* Block state changes */
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
+
+    do
+    {
+        /* The data path is fixed once the session has been prepared */
+        if(pSession->state != HLS_INITIALIZED)
+        {
+            ERROR("%s invalid in state %d", __FUNCTION__, pSession->state);
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        if(bHeadless && (pSession->pNullSink == NULL))
+        {
+            rval = hlsNullSink_create(&(pSession->pNullSink));
+            if(rval != HLS_OK)
+            {
+                ERROR("failed to create null sink");
+                break;
+            }
+        }
+        else if(!bHeadless && (pSession->pNullSink != NULL))
+        {
+            hlsNullSink_destroy(pSession->pNullSink);
+            pSession->pNullSink = NULL;
+        }
+
+    } while(0);
+
+    /* Leave critical section */
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
+
+    return rval;
+}
+
+/**
+ * Sets the function the session lends its data to the player
+ * with, instead of copying it into buffers from the player.
+ *
+ * @param pSession - handle to streamer object
+ * @param lendBuffer - player function to lend data with, NULL to
+ *                   copy the data
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_setLendBuffer(hlsSession_t* pSession, srcPlayerLendBuffer_t lendBuffer)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if(pSession == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    /* Block state changes */
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
+
+    /* The data path is fixed once the session has been prepared */
+    if(pSession->state != HLS_INITIALIZED)
+    {
+        ERROR("%s invalid in state %d", __FUNCTION__, pSession->state);
+        rval = HLS_STATE_ERROR;
+    }
+    else
+    {
+        pSession->lendBuffer = lendBuffer;
+    }
+
+    /* Leave critical section */
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
+
+    return rval;
+}
+
+/**
+ * Selects the elementary streams dropped from main stream
+ * segments before they are sent to the player.  The downloader
+ * picks the new flags up at the start of the next segment.
+ *
+ * @param pSession - handle to streamer object
+ * @param flags - OR of srcPidFilter_t flags
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_setPidFilter(hlsSession_t* pSession, int flags)
+{
+    if(pSession == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    if(flags & ~(SRC_PID_FILTER_MUXED_AUDIO | SRC_PID_FILTER_LANGUAGES | SRC_PID_FILTER_DATA))
+    {
+        ERROR("unknown PID filter flags 0x%x", flags);
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pSession->pidFilter = flags;
+
+    return HLS_OK;
+}
+
+/**
+ * Turns in-library decryption of AES-128-CBC segments on or off.
+ * The downloader picks the setting up at the start of the next
+ * segment.
+ *
+ * @param pSession - handle to streamer object
+ * @param bDecrypt - 1 to send the player clear data, 0 to send it
+ *                 encrypted data and the key in the buffer metadata
+ *
+ * @return #hlsStatus_t - HLS_UNSUPPORTED if the library was built
+ *         without decryption support
+ */
+hlsStatus_t hlsSession_setDecryption(hlsSession_t* pSession, int bDecrypt)
+{
+    if(pSession == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    if(bDecrypt && !hlsDecrypt_isSupported())
+    {
+        ERROR("library built without decryption support");
+        return HLS_UNSUPPORTED;
+    }
+
+    pSession->bDecrypt = bDecrypt;
+
+    return HLS_OK;
+}
+
+/**
+ * Sets the number of connections a large main stream segment
+ * is downloaded over.  The downloader picks the setting up at
+ * the start of the next segment.
+ *
+ * @param pSession - handle to streamer object
+ * @param numConnections - 1 to SRC_MAX_PARALLEL_CONNECTIONS
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_setParallelConnections(hlsSession_t* pSession, int numConnections)
+{
+    if(pSession == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    if((numConnections < 1) || (numConnections > SRC_MAX_PARALLEL_CONNECTIONS))
+    {
+        ERROR("invalid number of connections %d", numConnections);
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pSession->numConnections = numConnections;
+
+    return HLS_OK;
+}
+
 /**
  * Prepares initialized streamer for playback.  This will kick
- * off the parser thread and return once the parser has parsed
- * the top level manifest.
+ * off the parser and playback controller tasks and return once
+ * the parser has parsed the top level manifest.
  *
  * playlistRWLock MUST NOT be held by the calling thread
  *
@@ -576,7 +784,7 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
     TIMESTAMP(DBG_INFO,"%s", __FUNCTION__);
 
     /* Block state changes */
-    pthread_mutex_lock(&(pSession->stateMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     do
     {
@@ -597,29 +805,35 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
         /* Re-initialize */
         pSession->bKillPlaybackController = 0;
         pSession->playbackControllerStatus = HLS_OK;
+        pSession->bPbcRestartPlayback = 0;
+        pSession->bPbcWaitForPlaybackCompletion = 0;
 
-        /* Start playback controller thread */
-        if(pthread_create(&(pSession->playbackController), NULL, (void*)hlsPlaybackControllerThread, pSession))
+        /* Start timing the session startup */
+        hlsStats_markPrepare(&(pSession->stats));
+
+        /* Schedule the playback controller on the worker pool */
+        rval = hlsWorkerPool_schedule(&(pSession->playbackControllerTask), hlsPlaybackControllerTask, pSession);
+        if(rval != HLS_OK)
         {
-            ERROR("failed to create playback controller thread");
-            rval = HLS_ERROR;
+            ERROR("failed to schedule playback controller task");
             break;
         }
 
         /* Re-initialize */
         pSession->bKillParser = 0;
         pSession->parserStatus = HLS_OK;
+        pSession->bInitialParseDone = 0;
 
-        /* Start parsing thread */
-        if(pthread_create(&(pSession->parser), NULL, (void*)m3u8ParserThread, pSession))
+        /* Schedule the parser on the worker pool */
+        rval = hlsWorkerPool_schedule(&(pSession->parserTask), m3u8ParserTask, pSession);
+        if(rval != HLS_OK)
         {
-            ERROR("failed to create parser thread");
-            rval = HLS_ERROR;
+            ERROR("failed to schedule parser task");
             break;
         }
 
         /* Get current time */
-        if(clock_gettime(CLOCK_MONOTONIC, &timeoutTime) != 0)
+        if(hlsClock_now(&timeoutTime) != 0)
         {
             ERROR("failed to get current time");
             rval = HLS_ERROR;
@@ -633,7 +847,7 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
         while(pSession->state != HLS_PREPARED)
         {
             /* Get current time */
-            if(clock_gettime(CLOCK_MONOTONIC, &currTime) != 0)
+            if(hlsClock_now(&currTime) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -651,7 +865,7 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
             /* If parser was told to stop, return error (since we never went to HLS_PREPARED) */
             if(pSession->bKillParser)
             {
-                ERROR("parser thread was killed");
+                ERROR("parser task was killed");
                 rval = HLS_ERROR;
                 break;
             }
@@ -668,9 +882,9 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->stateMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
-    /* If we failed to become prepared, kill the threads, if they were started */
+    /* If we failed to become prepared, stop the tasks, if they were scheduled */
     if(rval != HLS_OK)
     {
         /* Kill the parser */
@@ -679,7 +893,7 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
         /* Kill the playback controller */
         pSession->bKillPlaybackController = 1;
 
-        /* Wake up parser thread if it is sleeping */
+        /* Wake up parser if it is waiting to retry a playlist download */
         if(pthread_mutex_lock(&(pSession->parserWakeMutex)) == 0)
         {
             if(pthread_cond_signal(&(pSession->parserWakeCond)) == 0)
@@ -688,39 +902,26 @@ hlsStatus_t hlsSession_prepare(hlsSession_t* pSession)
             }
         }
 
-        /* Wake up playback controller thread if it is sleeping */
-        if(pthread_mutex_lock(&(pSession->playbackControllerWakeMutex)) == 0)
-        {
-            if(pthread_cond_signal(&(pSession->playbackControllerWakeCond)) == 0)
-            {
-                pthread_mutex_unlock(&(pSession->playbackControllerWakeMutex));
-            }
-        }
+        /* Run both tasks now so they see the kill signal */
+        hlsWorkerPool_wake(&(pSession->parserTask));
+        hlsWorkerPool_wake(&(pSession->playbackControllerTask));
 
-        /* Wait for parser thread to exit */
-        if(pSession->parser != 0)
-        {
-            pthread_join(pSession->parser, NULL);
-            pSession->parser = 0;
-        }
+        /* Wait for parser task to finish */
+        hlsWorkerPool_wait(&(pSession->parserTask));
 
-        /* Wait for playback controller thread to exit */
-        if(pSession->playbackController != 0)
-        {
-            pthread_join(pSession->playbackController, NULL);
-            pSession->playbackController= 0;
-        }
+        /* Wait for playback controller task to finish */
+        hlsWorkerPool_wait(&(pSession->playbackControllerTask));
 
         /* Make sure we end up back in INITIALIZED state if we didn't
            make it to PREPARED */
 
         /* Block state changes */
-        pthread_mutex_lock(&(pSession->stateMutex));
+        HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
         pSession->state = HLS_INITIALIZED;
 
         /* Leave critical section */
-        pthread_mutex_unlock(&(pSession->stateMutex));
+        HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
     }
 
     return rval;
@@ -754,7 +955,7 @@ hlsStatus_t hlsSession_play(hlsSession_t* pSession)
     TIMESTAMP(DBG_INFO,"%s", __FUNCTION__);
 
     /* Block state changes */
-    pthread_mutex_lock(&(pSession->stateMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     do
     {
@@ -829,7 +1030,7 @@ hlsStatus_t hlsSession_play(hlsSession_t* pSession)
         pSignal = NULL;
 
         /* Get current time */
-        if(clock_gettime(CLOCK_MONOTONIC, &timeoutTime) != 0)
+        if(hlsClock_now(&timeoutTime) != 0)
         {
             ERROR("failed to get current time");
             rval = HLS_ERROR;
@@ -843,7 +1044,7 @@ hlsStatus_t hlsSession_play(hlsSession_t* pSession)
         while(pSession->state != HLS_PLAYING)
         {
             /* Get current time */
-            if(clock_gettime(CLOCK_MONOTONIC, &currTime) != 0)
+            if(hlsClock_now(&currTime) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -874,13 +1075,13 @@ hlsStatus_t hlsSession_play(hlsSession_t* pSession)
                 break;
             }
 
-            usleep(100000);
+            hlsClock_sleep(100000);
         }
 
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->stateMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     /* If we failed to start playing, kill the downloader thread, if it was started */
     if(rval != HLS_OK)
@@ -918,12 +1119,12 @@ hlsStatus_t hlsSession_play(hlsSession_t* pSession)
            make it to PLAYING */
 
         /* Block state changes */
-        pthread_mutex_lock(&(pSession->stateMutex));
+        HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
         pSession->state = HLS_PREPARED;
 
         /* Leave critical section */
-        pthread_mutex_unlock(&(pSession->stateMutex));
+        HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
     }
 
     return rval;
@@ -948,7 +1149,7 @@ hlsStatus_t hlsSession_getNumBitrates(hlsSession_t* pSession, int* numBitrates)
     }
 
     /* Get playlist READ lock */
-    pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    playlistReadLock(pSession);
 
     do
     {
@@ -995,7 +1196,7 @@ hlsStatus_t hlsSession_getNumBitrates(hlsSession_t* pSession, int* numBitrates)
     } while(0);
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
 
     return rval;
 }
@@ -1022,7 +1223,7 @@ hlsStatus_t hlsSession_getBitrates(hlsSession_t* pSession, int numBitrates, int*
     }
 
     /* Get playlist READ lock */
-    pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    playlistReadLock(pSession);
 
     do
     {
@@ -1082,7 +1283,7 @@ hlsStatus_t hlsSession_getBitrates(hlsSession_t* pSession, int numBitrates, int*
     } while(0);
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
 
     return rval;
 }
@@ -1105,7 +1306,7 @@ hlsStatus_t hlsSession_getCurrentBitrate(hlsSession_t* pSession, int* pBitrate)
     }
 
     /* Get playlist READ lock */
-    pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    playlistReadLock(pSession);
 
     do
     {
@@ -1131,7 +1332,7 @@ hlsStatus_t hlsSession_getCurrentBitrate(hlsSession_t* pSession, int* pBitrate)
     } while(0);
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
 
     return rval;
 }
@@ -1158,7 +1359,7 @@ hlsStatus_t hlsSession_setBitrateLimit(hlsSession_t* pSession, hlsBitrateLimit_t
     }
 
     /* Block setting changes */
-    pthread_mutex_lock(&(pSession->setMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     do
     {
@@ -1197,7 +1398,7 @@ hlsStatus_t hlsSession_setBitrateLimit(hlsSession_t* pSession, hlsBitrateLimit_t
         if(pSession->state == HLS_PREPARED)
         {
             /* Get playlist WRITE lock */
-            pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+            playlistWriteLock(pSession);
 
             if((pSession->pCurrentPlaylist == NULL) ||
                (pSession->pCurrentPlaylist->type != PL_MEDIA) ||
@@ -1206,7 +1407,7 @@ hlsStatus_t hlsSession_setBitrateLimit(hlsSession_t* pSession, hlsBitrateLimit_t
                 ERROR("invalid current playlist");
                 rval = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -1216,7 +1417,7 @@ hlsStatus_t hlsSession_setBitrateLimit(hlsSession_t* pSession, hlsBitrateLimit_t
             {
                 ERROR("problem getting initial bitrate");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -1228,19 +1429,19 @@ hlsStatus_t hlsSession_setBitrateLimit(hlsSession_t* pSession, hlsBitrateLimit_t
                 {
                     ERROR("problem changing bitrate");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
             }
 
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
         }
 
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->setMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     return rval;
 }
@@ -1276,10 +1477,10 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
     }
 
     /* Block setting changes */
-    pthread_mutex_lock(&(pSession->setMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     /* Block state changes */
-    pthread_mutex_lock(&(pSession->stateMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     do
     {
@@ -1305,7 +1506,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
         // TODO: should the player be in SRC_PLAYER_MODE_PAUSE by default???  Do we need to set this???
 
         /* Get playlist READ lock */
-        pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+        playlistReadLock(pSession);
 
         /* Validate current playlist */
         if((pSession->pCurrentPlaylist == NULL) ||
@@ -1315,7 +1516,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
             ERROR("invalid current playlist");
             rval = HLS_ERROR;
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
         }
 
@@ -1330,7 +1531,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                 ERROR("no I-frame streams -- can't trickplay");
                 rval = HLS_UNSUPPORTED;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -1340,7 +1541,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
             {
                 ERROR("failed to get exernal position");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -1353,7 +1554,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                 {
                     ERROR("failed to get exernal duration");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -1362,7 +1563,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     ERROR("cannot FF -- already at end of playlist");
                     rval = HLS_UNSUPPORTED;
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
             }
@@ -1375,14 +1576,14 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     ERROR("cannot REW -- already at start of playlist");
                     rval = HLS_UNSUPPORTED;
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
             }
         }
 
         /* Release playlist lock */
-        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        playlistUnlock(pSession);
 
         /* Slow trick speeds are treated as 1x play by the plugin */
         if((speed > 0) && (speed < 1))
@@ -1412,7 +1613,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     playerSetData.setCode = SRC_PLAYER_SET_MODE;
                     playerMode = SRC_PLAYER_MODE_NORMAL;
                     playerSetData.pData = &playerMode;
-                    status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+                    status = hlsPlayer_set(pSession, &playerSetData);
                     if(status != SRC_SUCCESS)
                     {
                         ERROR("failed to set player mode SRC_PLAYER_MODE_NORMAL");
@@ -1428,7 +1629,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                 playerSetData.setCode = SRC_PLAYER_SET_MODE;
                 playerMode = SRC_PLAYER_MODE_PAUSE;
                 playerSetData.pData = &playerMode;
-                status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+                status = hlsPlayer_set(pSession, &playerSetData);
                 if(status != SRC_SUCCESS)
                 {
                     ERROR("failed to set player mode SRC_PLAYER_MODE_PAUSE");
@@ -1443,7 +1644,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                 /* Flush the decoder cache */
                 playerSetData.setCode = SRC_PLAYER_SET_BUFFER_FLUSH;
                 playerSetData.pData = NULL;
-                status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+                status = hlsPlayer_set(pSession, &playerSetData);
                 if(status != SRC_SUCCESS)
                 {
                    ERROR("failed to flush player buffers");
@@ -1466,7 +1667,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                 if((pSession->speed == 1) || (pSession->speed == 0)) /* ((1x PLAY || PAUSE) -> TRICKPLAY) */
                 {
                     /* Get playlist WRITE lock */
-                    pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+                    playlistWriteLock(pSession);
 
                     /* Flush current playlist */
                     rval = flushPlaylist(pSession->pCurrentPlaylist);
@@ -1474,7 +1675,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     {
                         ERROR("problem flushing playlist");
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
@@ -1484,17 +1685,17 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     {
                         ERROR("problem switching to I-frame playlists");
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                 }
                 else /* (TRICKPLAY -> (1x PLAY || PAUSE)) */
                 {
                     /* Get playlist WRITE lock */
-                    pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+                    playlistWriteLock(pSession);
 
                     /* Flush current playlist */
                     rval = flushPlaylist(pSession->pCurrentPlaylist);
@@ -1502,7 +1703,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     {
                         ERROR("problem flushing playlist");
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
@@ -1512,7 +1713,7 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     {
                         ERROR("problem switching to normal playlists");
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
@@ -1531,12 +1732,12 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
                     if(HLS_OK != rval)
                     {
                         /* Release playlist lock */
-                        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                        playlistUnlock(pSession);
                         break;
                     }
 
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                 }
             }
 
@@ -1561,10 +1762,10 @@ hlsStatus_t hlsSession_setSpeed(hlsSession_t* pSession, float speed)
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->stateMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->setMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     return rval;
 }
@@ -1602,7 +1803,7 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
     TIMESTAMP(DBG_INFO,"%s", __FUNCTION__);
 
     /* Block state changes */
-    pthread_mutex_lock(&(pSession->stateMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     do
     {
@@ -1623,7 +1824,7 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
               /* Flush the decoder cache */
               playerSetData.setCode = SRC_PLAYER_SET_BUFFER_FLUSH;
               playerSetData.pData = NULL;
-              status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+              status = hlsPlayer_set(pSession, &playerSetData);
               if(status != SRC_SUCCESS)
               {
                  ERROR("failed to flush player buffers");
@@ -1664,7 +1865,7 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
         playerSetData.setCode = SRC_PLAYER_SET_MODE;
         playerMode = SRC_PLAYER_MODE_PAUSE;
         playerSetData.pData = &playerMode;
-        status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+        status = hlsPlayer_set(pSession, &playerSetData);
         if(status != SRC_SUCCESS)
         {
             ERROR("failed to set player mode SRC_PLAYER_MODE_PAUSE");
@@ -1682,7 +1883,7 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
            /* Flush the decoder cache */
            playerSetData.setCode = SRC_PLAYER_SET_BUFFER_FLUSH;
            playerSetData.pData = NULL;
-           status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+           status = hlsPlayer_set(pSession, &playerSetData);
            if(status != SRC_SUCCESS)
            {
               ERROR("failed to flush player buffers");
@@ -1742,7 +1943,7 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
            /* Flush the decoder cache */
            playerSetData.setCode = SRC_PLAYER_SET_BUFFER_FLUSH;
            playerSetData.pData = NULL;
-           status = hlsPlayer_set(pSession->pHandle, &playerSetData);
+           status = hlsPlayer_set(pSession, &playerSetData);
            if(status != SRC_SUCCESS)
            {
               ERROR("failed to flush player buffers");
@@ -1755,19 +1956,20 @@ hlsStatus_t hlsSession_stop(hlsSession_t* pSession, int bFlush)
         pSession->state = HLS_PREPARED;
 
         /* Block PTS events */
-        pthread_mutex_lock(&(pSession->playerEvtMutex));
+        HLS_MUTEX_LOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 
         /* Reset our buffer length and lastPTS */
         pSession->timeBuffered = 0;
         pSession->lastPTS = -1ll;
+        pSession->lastSegmentPts = -1ll;
 
         /* Unblock player events */
-        pthread_mutex_unlock(&(pSession->playerEvtMutex));
+        HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->stateMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     return rval;
 }
@@ -1801,10 +2003,10 @@ hlsStatus_t hlsSession_seek(hlsSession_t* pSession, float position)
     }
 
     /* Block setting changes */
-    pthread_mutex_lock(&(pSession->setMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     /* Block state changes */
-    pthread_mutex_lock(&(pSession->stateMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     do
     {
@@ -1843,14 +2045,14 @@ hlsStatus_t hlsSession_seek(hlsSession_t* pSession, float position)
         }
 
         /* Get playlist WRITE lock */
-        pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+        playlistWriteLock(pSession);
 
         rval = playlistSeek(pSession->pCurrentPlaylist, position, &seqNum);
         if(rval != HLS_OK)
         {
             ERROR("failed to seek in playlist");
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
         }
 
@@ -1870,7 +2072,7 @@ hlsStatus_t hlsSession_seek(hlsSession_t* pSession, float position)
         }
 
         /* Release playlist lock */
-        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        playlistUnlock(pSession);
 
         if(HLS_OK != rval)
         {
@@ -1889,10 +2091,10 @@ hlsStatus_t hlsSession_seek(hlsSession_t* pSession, float position)
     } while(0);
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->stateMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->setMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
     return rval;
 }
@@ -1920,9 +2122,9 @@ hlsStatus_t hlsSession_setAudioLanguage(hlsSession_t* pSession, char audioLangIS
    }
 
    /* Block setting changes */
-   pthread_mutex_lock(&(pSession->setMutex));
+   HLS_MUTEX_LOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
    /* Block state changes */
-   pthread_mutex_lock(&(pSession->stateMutex));
+   HLS_MUTEX_LOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
 
    do
    {
@@ -1981,7 +2183,7 @@ hlsStatus_t hlsSession_setAudioLanguage(hlsSession_t* pSession, char audioLangIS
          getData.getCode = SRC_PLAYER_GET_POSITION;
          getData.pData = &position;
 
-         if(SRC_SUCCESS != hlsPlayer_getOption(pSession->pHandle, &getData))
+         if(SRC_SUCCESS != hlsPlayer_getOption(pSession, &getData))
          {
             ERROR("Failed to get current position from player\n");
             rval = HLS_ERROR;
@@ -2020,9 +2222,9 @@ hlsStatus_t hlsSession_setAudioLanguage(hlsSession_t* pSession, char audioLangIS
    }
 
    /* Leave critical section */
-   pthread_mutex_unlock(&(pSession->stateMutex));
+   HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_STATE, &(pSession->stateMutex));
    /* Leave critical section */
-   pthread_mutex_unlock(&(pSession->setMutex));
+   HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_SET, &(pSession->setMutex));
 
    return rval;
 }
@@ -2048,7 +2250,7 @@ hlsStatus_t hlsSession_getDuration(hlsSession_t* pSession, float* pDuration)
     }
 
     /* Get playlist READ lock */
-    pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    playlistReadLock(pSession);
 
     do
     {
@@ -2085,7 +2287,7 @@ hlsStatus_t hlsSession_getDuration(hlsSession_t* pSession, float* pDuration)
     } while(0);
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
 
     return rval;
 }
@@ -2111,7 +2313,7 @@ hlsStatus_t hlsSession_getCurrentPosition(hlsSession_t* pSession, float* pPositi
     }
 
     /* Get playlist READ lock */
-    pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    playlistReadLock(pSession);
 
     do
     {
@@ -2165,7 +2367,7 @@ hlsStatus_t hlsSession_getCurrentPosition(hlsSession_t* pSession, float* pPositi
     } while(0);
 
     /* Release playlist lock */
-    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+    playlistUnlock(pSession);
 
     return rval;
 }
@@ -2231,7 +2433,7 @@ hlsStatus_t hlsSession_getTrickSupported(hlsSession_t* pSession, int *bTrickSupp
       }
 
       /* Get playlist READ lock */
-      pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+      playlistReadLock(pSession);
 
       /* If we don't have any I-frame playlists, we can't do trickmodes */
       if((pSession->pCurrentProgram == NULL) ||
@@ -2243,7 +2445,7 @@ hlsStatus_t hlsSession_getTrickSupported(hlsSession_t* pSession, int *bTrickSupp
       }
 
       /* Release playlist lock */
-      pthread_rwlock_unlock(&(pSession->playlistRWLock));
+      playlistUnlock(pSession);
 
       DEBUG(DBG_INFO,"bTrickSupported = %d\n", *bTrickSupported);
 
@@ -2282,7 +2484,7 @@ hlsStatus_t hlsSession_getContentType(hlsSession_t* pSession, hlsContentType_t *
       }
 
       /* Get playlist READ lock */
-      pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+      playlistReadLock(pSession);
 
       /* TODO - check mutability? */
       if(0 == pSession->pCurrentPlaylist->pMediaData->bHaveCompletePlaylist)
@@ -2295,7 +2497,7 @@ hlsStatus_t hlsSession_getContentType(hlsSession_t* pSession, hlsContentType_t *
       }
 
       /* Release playlist lock */
-      pthread_rwlock_unlock(&(pSession->playlistRWLock));
+      playlistUnlock(pSession);
 
       DEBUG(DBG_INFO, "Content type = %d\n", *contentType);
 
@@ -2338,11 +2540,11 @@ hlsStatus_t hlsSession_getNumAudioLanguages(hlsSession_t* pSession, int *pNumAud
       }
 
       /* Get playlist READ lock */
-      pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+      playlistReadLock(pSession);
       if(NULL == pSession->pPlaylist)
       {
          ERROR("%s Main playlist pointer is NULL", __FUNCTION__);
-         pthread_rwlock_unlock(&(pSession->playlistRWLock));
+         playlistUnlock(pSession);
          rval = HLS_ERROR;
          break;
       }
@@ -2350,7 +2552,7 @@ hlsStatus_t hlsSession_getNumAudioLanguages(hlsSession_t* pSession, int *pNumAud
       if(NULL == pSession->pPlaylist->pGroupList)
       {
          DEBUG(DBG_WARN, "%s No EXT-X-MEDIA tags in playlist", __FUNCTION__);
-         pthread_rwlock_unlock(&(pSession->playlistRWLock));
+         playlistUnlock(pSession);
          break;
       }
 
@@ -2366,7 +2568,7 @@ hlsStatus_t hlsSession_getNumAudioLanguages(hlsSession_t* pSession, int *pNumAud
       }
 
       /* Release playlist lock */
-      pthread_rwlock_unlock(&(pSession->playlistRWLock));
+      playlistUnlock(pSession);
 
       DEBUG(DBG_INFO,"numAudioLanguages = %d\n", *pNumAudioLanguages);
    }while(0);
@@ -2411,11 +2613,11 @@ hlsStatus_t hlsSession_getAudioLanguagesInfo(hlsSession_t* pSession,
       }
 
       /* Get playlist READ lock */
-      pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+      playlistReadLock(pSession);
       if(NULL == pSession->pPlaylist)
       {
          ERROR("%s Main playlist pointer is NULL", __FUNCTION__);
-         pthread_rwlock_unlock(&(pSession->playlistRWLock));
+         playlistUnlock(pSession);
          rval = HLS_ERROR;
          break;
       }
@@ -2423,7 +2625,7 @@ hlsStatus_t hlsSession_getAudioLanguagesInfo(hlsSession_t* pSession,
       if(NULL == pSession->pPlaylist->pGroupList)
       {
          DEBUG(DBG_WARN, "%s No EXT-X-MEDIA tags in playlist", __FUNCTION__);
-         pthread_rwlock_unlock(&(pSession->playlistRWLock));
+         playlistUnlock(pSession);
          break;
       }
 
@@ -2453,7 +2655,7 @@ hlsStatus_t hlsSession_getAudioLanguagesInfo(hlsSession_t* pSession,
       }
 
       /* Release playlist lock */
-      pthread_rwlock_unlock(&(pSession->playlistRWLock));
+      playlistUnlock(pSession);
    }while(0);
 
    *pAudioLangInfoArrSize = numAudioLanguages;
@@ -2505,6 +2707,116 @@ hlsStatus_t hlsSession_getAudioLanguage(hlsSession_t* pSession,
    return rval;
 }
 
+/**
+ * Fills in a health summary for the session.  Valid in any
+ * state; members that don't apply yet are left at 0.
+ *
+ * @param pSession - handle to streamer object
+ * @param pHealth - health summary to fill in
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_getHealth(hlsSession_t* pSession, srcPluginHealth_t* pHealth)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    double position = 0;
+
+    srcPluginStats_t stats;
+
+    if((pSession == NULL) || (pHealth == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    memset(pHealth, 0, sizeof(srcPluginHealth_t));
+
+    pHealth->bHeadless = (pSession->pNullSink != NULL);
+    pHealth->bPlaying = (pSession->state == HLS_PLAYING);
+    pHealth->bufferLevel = pSession->timeBuffered;
+    pHealth->timeSinceLastData = -1;
+
+    /* Get playlist READ lock */
+    playlistReadLock(pSession);
+
+    if((pSession->state >= HLS_PREPARED) &&
+       (pSession->pCurrentPlaylist != NULL) &&
+       (pSession->pCurrentPlaylist->type == PL_MEDIA) &&
+       (pSession->pCurrentPlaylist->pMediaData != NULL))
+    {
+        pHealth->currentBitrate = pSession->pCurrentPlaylist->pMediaData->bitrate;
+
+        if(getExternalPosition(pSession->pCurrentPlaylist, &position) == HLS_OK)
+        {
+            pHealth->position = position*1000;
+        }
+    }
+
+    /* Release playlist lock */
+    playlistUnlock(pSession);
+
+    hlsStats_get(&(pSession->stats), &stats);
+
+    pHealth->numBitrateSwitches = stats.numBitrateSwitches;
+    pHealth->numStalls = stats.numStalls;
+    pHealth->stallTime = stats.stallTime;
+
+    if(pSession->pNullSink != NULL)
+    {
+        hlsNullSink_getHealth(pSession->pNullSink, pHealth);
+    }
+
+    return rval;
+}
+
+/**
+ * Takes a snapshot of the session performance counters.
+ *
+ * @param pSession - handle to streamer object
+ * @param pStats - will contain the counters
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_getStats(hlsSession_t* pSession, srcPluginStats_t* pStats)
+{
+    if((pSession == NULL) || (pStats == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    hlsStats_get(&(pSession->stats), pStats);
+
+    pthread_mutex_lock(&(pSession->dldRateMutex));
+    pStats->lastSegmentDldRate = pSession->lastSegmentDldRate;
+    pStats->avgSegmentDldRate = pSession->avgSegmentDldRate;
+    pthread_mutex_unlock(&(pSession->dldRateMutex));
+
+    return HLS_OK;
+}
+
+/**
+ * Takes a snapshot of the session lock contention counters.
+ *
+ * @param pSession - handle to streamer object
+ * @param pLocks - will contain the counters
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsSession_getLockStats(hlsSession_t* pSession, srcPluginLockStats_t* pLocks)
+{
+    if((pSession == NULL) || (pLocks == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    hlsStats_getLocks(&(pSession->stats), pLocks);
+
+    return HLS_OK;
+}
+
 /**
  *
  *
@@ -2534,7 +2846,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
     }
 
     /* Block player events until this one is processed */
-    pthread_mutex_lock(&(pSession->playerEvtMutex));
+    HLS_MUTEX_LOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 
     switch(pEvt->evtCode)
     {
@@ -2554,7 +2866,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                else
                {
                   /* Get playlist WRITE lock */
-                  pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+                  playlistWriteLock(pSession);
 
                   if((pSession->pCurrentPlaylist == NULL) ||
                         (pSession->pCurrentPlaylist->type != PL_MEDIA) ||
@@ -2563,7 +2875,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                      // TODO: do something more drastic??
                      ERROR("current playlist is not a valid media playlist");
                      /* Release playlist lock */
-                     pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                     playlistUnlock(pSession);
                      break;
                   }
 
@@ -2591,7 +2903,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                            /* If we don't roll-over, assume this is a spurious PTS from the past, and just ignore it. */
                            DEBUG(DBG_WARN, "Got a PTS %lld from the past while playing forwards -- ignoring", tempPTS);
                            /* Release playlist lock */
-                           pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                           playlistUnlock(pSession);
                            break;
                         }
                      }
@@ -2617,7 +2929,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                            /* If we don't roll-over, assume this is a spurious PTS from the future, and just ignore it. */
                            DEBUG(DBG_WARN, "Got a PTS %lld from the future while playing backwards -- ignoring", tempPTS);
                            /* Release playlist lock */
-                           pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                           playlistUnlock(pSession);
                            break;
                         }
                      }
@@ -2643,7 +2955,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                         pSession->pCurrentPlaylist->pMediaData->duration - pSession->pCurrentPlaylist->pMediaData->positionFromEnd - pSession->pCurrentPlaylist->pMediaData->startOffset);
 
                   /* Release playlist lock */
-                  pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                  playlistUnlock(pSession);
                }
 
                DEBUG(DBG_INFO,"%f seconds left in buffer", pSession->timeBuffered);
@@ -2654,7 +2966,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
             if((pSession->state == HLS_PLAYING) && (pSession->speed >= 0) && (pSession->speed <=1))
             {
                /* Get playlist WRITE lock */
-              pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+              playlistWriteLock(pSession);
 
              /* Verify currentPlaylist */
                if((pSession->pCurrentPlaylist == NULL) ||
@@ -2664,7 +2976,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                  // TODO: do something more drastic??
                    ERROR("current playlist is not a media playlist");
                   /* Release playlist lock */
-                   pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                   playlistUnlock(pSession);
                   break;
              }
 
@@ -2679,7 +2991,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                    // TODO: do something more drastic??
                   ERROR("failed to find segment in playlist");
                    /* Release playlist lock */
-                  pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                  playlistUnlock(pSession);
                  break;
                }
 
@@ -2693,7 +3005,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
                     // TODO: do something more drastic??
                     ERROR("segment has no parent node");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
 
@@ -2733,7 +3045,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
              {
                    // TODO: do something more drastic??
                   /* Release playlist lock */
-                   pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                   playlistUnlock(pSession);
                   break;
                }
 
@@ -2741,7 +3053,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
               pSession->pCurrentPlaylist->pMediaData->positionFromEnd = time;
 
              /* Release playlist lock */
-              pthread_rwlock_unlock(&(pSession->playlistRWLock));
+              playlistUnlock(pSession);
 
                // TODO: need to update buffer length...how? -- above: positionFromEnd - time???
 
@@ -2782,7 +3094,7 @@ void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt)
     }
 
     /* Leave critical section */
-    pthread_mutex_unlock(&(pSession->playerEvtMutex));
+    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_PLAYER_EVT, &(pSession->playerEvtMutex));
 }
 
 /**
@@ -2798,7 +3110,7 @@ void hlsSession_printInfo(hlsSession_t* pSession)
     if(pSession != NULL)
     {
         /* Get playlist READ lock */
-        pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+        playlistReadLock(pSession);
 
         printf("------------------------\n");
         printf("**** Streamer Info  ****\n");
@@ -2846,7 +3158,7 @@ void hlsSession_printInfo(hlsSession_t* pSession)
         printPlaylist(pSession->pPlaylist);
 
         /* Release playlist lock */
-        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        playlistUnlock(pSession);
     }
 }
 
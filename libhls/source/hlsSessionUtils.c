@@ -41,6 +41,9 @@ extern "C" {
 #include "hlsSessionUtils.h"
 
 #include "hlsDownloaderUtils.h"
+#include "hlsStats.h"
+#include "hlsProbes.h"
+#include "hlsLockStats.h"
 
 #include "adaptech.h"
 
@@ -1038,6 +1041,99 @@ double ptsToSeconds(long long PTS)
     return PTS/90000.0;
 }
 
+/**
+ * Takes the playlist lock of a session for reading or writing.
+ * If the lock is already held, the time spent waiting for it
+ * is added to the session stats; uncontended acquisitions cost
+ * no more than a plain lock.
+ *
+ * @param pSession - session whose playlistRWLock to take
+ * @param bWrite - TRUE to take the lock for writing
+ * @param pSite - "file:line" of the caller, see HLS_LOCK_SITE
+ */
+static void playlistLock(hlsSession_t* pSession, int bWrite, const char* pSite)
+{
+    struct timespec start;
+    struct timespec end;
+    float waitTime = 0;
+
+#ifndef ENABLE_LOCK_STATS
+    (void)pSite;
+#endif
+
+    if((bWrite ? pthread_rwlock_trywrlock(&(pSession->playlistRWLock)) :
+                 pthread_rwlock_tryrdlock(&(pSession->playlistRWLock))) == 0)
+    {
+        HLS_PROBE(playlist_lock, pSession, bWrite, 0);
+#ifdef ENABLE_LOCK_STATS
+        hlsLockStats_acquired(&(pSession->stats), SRC_LOCK_PLAYLIST, &(pSession->playlistRWLock), 0, 0, pSite);
+#endif
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    if(bWrite)
+    {
+        pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+    }
+    else
+    {
+        pthread_rwlock_rdlock(&(pSession->playlistRWLock));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    waitTime = (end.tv_sec - start.tv_sec) + ((end.tv_nsec - start.tv_nsec) / 1000000000.0);
+
+    hlsStats_recordPlaylistLockWait(&(pSession->stats), waitTime);
+
+    HLS_PROBE(playlist_lock, pSession, bWrite, 1);
+#ifdef ENABLE_LOCK_STATS
+    hlsLockStats_acquired(&(pSession->stats), SRC_LOCK_PLAYLIST, &(pSession->playlistRWLock), 1, waitTime, pSite);
+#endif
+}
+
+/**
+ * Takes the playlist READ lock of a session.
+ * Use through playlistReadLock().
+ *
+ * @param pSession - session to lock
+ * @param pSite - "file:line" of the caller
+ */
+void playlistReadLockAt(hlsSession_t* pSession, const char* pSite)
+{
+    playlistLock(pSession, 0, pSite);
+}
+
+/**
+ * Takes the playlist WRITE lock of a session.
+ * Use through playlistWriteLock().
+ *
+ * @param pSession - session to lock
+ * @param pSite - "file:line" of the caller
+ */
+void playlistWriteLockAt(hlsSession_t* pSession, const char* pSite)
+{
+    playlistLock(pSession, 1, pSite);
+}
+
+/**
+ * Releases the playlist lock of a session, taken with
+ * playlistReadLock() or playlistWriteLock().
+ *
+ * @param pSession - session to unlock
+ */
+void playlistUnlock(hlsSession_t* pSession)
+{
+    HLS_PROBE(playlist_unlock, pSession);
+#ifdef ENABLE_LOCK_STATS
+    hlsLockStats_releasing(&(pSession->stats), SRC_LOCK_PLAYLIST, &(pSession->playlistRWLock));
+#endif
+
+    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+}
+
 /**
  * Allocates a new hlsPlaylist_t structure and sets entire
  * strucuture to 0.
@@ -1651,7 +1747,7 @@ hlsStatus_t updateCurrentGroup(hlsSession_t *pSession, char groupID[], hlsGroup_
       if((NULL != pNewGroup) && (NULL != pNewGroup->pPlaylist) &&
          (NULL == pNewGroup->pPlaylist->pList))
       {
-         pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+         playlistWriteLock(pSession);
 
          rval = m3u8ParsePlaylist(pNewGroup->pPlaylist, pSession);
          if(rval != HLS_OK)
@@ -1659,18 +1755,18 @@ hlsStatus_t updateCurrentGroup(hlsSession_t *pSession, char groupID[], hlsGroup_
             if(rval == HLS_CANCELLED)
             {
                DEBUG(DBG_WARN, "parser signalled to stop");
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
             else
             {
                ERROR("problem parsing alternative playlist");
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
          }
 
-         pthread_rwlock_unlock(&(pSession->playlistRWLock));
+         playlistUnlock(pSession);
       }
 
       /* TODO - Send event to player for Muxed <-> Discrete */
@@ -0,0 +1,514 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsStats.c @date October 19, 2026
+ *
+ * Per-session performance counters and latency histograms, returned
+ * to the player through SRC_PLUGIN_GET_STATS.
+ *
+ * Every update is a short critical section on a per-session mutex
+ * with no allocation or logging, so the counters can stay enabled in
+ * production builds.  Histograms use the fixed power-of-two buckets
+ * described in #srcStatsHistogram_t.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "hlsStats.h"
+#include "hlsClock.h"
+#include "hlsLockStats.h"
+
+#include "debug.h"
+
+/**
+ * Adds a sample to a histogram.
+ *
+ * @param pHist - histogram to update
+ * @param ms - sample, in milliseconds
+ */
+static void histogramAdd(srcStatsHistogram_t* pHist, float ms)
+{
+    int bucket = 0;
+
+    if(ms < 0)
+    {
+        ms = 0;
+    }
+
+    while((bucket < SRC_STATS_HISTOGRAM_BUCKETS - 1) &&
+          (ms >= (float)(SRC_STATS_HISTOGRAM_BASE_MS << bucket)))
+    {
+        bucket++;
+    }
+
+    pHist->count[bucket]++;
+    pHist->numSamples++;
+    pHist->sum += ms;
+
+    if(ms > pHist->max)
+    {
+        pHist->max = ms;
+    }
+}
+
+/**
+ * Clears a startup timeline.  Caller holds the stats mutex.
+ *
+ * @param pStartup - timeline to clear
+ */
+static void resetStartup(srcPluginStartup_t* pStartup)
+{
+    int ii = 0;
+
+    pStartup->startTime = 0;
+    for(ii = 0; ii < SRC_STARTUP_PHASE_COUNT; ii++)
+    {
+        pStartup->phaseTime[ii] = -1;
+    }
+}
+
+/**
+ * Records a startup milestone unless it has already been reached,
+ * or no data source has been set yet.  Caller holds the stats mutex.
+ *
+ * @param pStats - session counters
+ * @param phase - milestone reached
+ * @param pWhen - session clock time it was reached
+ *
+ * @return int - TRUE if the milestone was recorded
+ */
+static int markStartup(hlsSessionStats_t* pStats, srcStartupPhase_t phase, struct timespec* pWhen)
+{
+    srcPluginStartup_t* pStartup = &(pStats->counters.startup);
+
+    if((pStartup->startTime == 0) || (pStartup->phaseTime[phase] >= 0))
+    {
+        return 0;
+    }
+
+    pStartup->phaseTime[phase] = ((pWhen->tv_sec - pStats->startupBase.tv_sec) * 1000.0) +
+                                 ((pWhen->tv_nsec - pStats->startupBase.tv_nsec) / 1000000.0);
+    if(pStartup->phaseTime[phase] < 0)
+    {
+        pStartup->phaseTime[phase] = 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Initializes a session's counters.
+ *
+ * @param pStats - counters to initialize
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsStats_init(hlsSessionStats_t* pStats)
+{
+    if(pStats == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    memset(pStats, 0, sizeof(hlsSessionStats_t));
+
+    pStats->counters.timeToFirstBuffer = -1;
+    resetStartup(&(pStats->counters.startup));
+
+    if(pthread_mutex_init(&(pStats->mutex), NULL) != 0)
+    {
+        ERROR("failed to initialize stats mutex");
+        return HLS_ERROR;
+    }
+
+    return HLS_OK;
+}
+
+/**
+ * Releases the resources held by a session's counters.
+ *
+ * @param pStats - counters initialized with hlsStats_init()
+ */
+void hlsStats_term(hlsSessionStats_t* pStats)
+{
+    if(pStats != NULL)
+    {
+        pthread_mutex_destroy(&(pStats->mutex));
+    }
+}
+
+/**
+ * Starts the time to first buffer measurement.  Called when the
+ * session is prepared.
+ *
+ * @param pStats - session counters
+ */
+void hlsStats_markPrepare(hlsSessionStats_t* pStats)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+
+    hlsClock_now(&(pStats->prepareTime));
+    pStats->bWaitingForFirstBuffer = 1;
+
+    markStartup(pStats, SRC_STARTUP_PREPARE, &(pStats->prepareTime));
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a buffer delivered to the player.
+ *
+ * @param pStats - session counters
+ * @param streamNum - srcBufferMetadata_t::streamNum of the buffer
+ * @param size - bytes in the buffer
+ */
+void hlsStats_recordBuffer(hlsSessionStats_t* pStats, int streamNum, int size)
+{
+    struct timespec now;
+
+    if(size <= 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(pStats->mutex));
+
+    if((streamNum >= 0) && (streamNum < SRC_STATS_MAX_STREAMS))
+    {
+        pStats->counters.bytesPerStream[streamNum] += size;
+    }
+
+    if(pStats->bWaitingForFirstBuffer)
+    {
+        hlsClock_now(&now);
+
+        markStartup(pStats, SRC_STARTUP_FIRST_BUFFER, &now);
+
+        pStats->counters.timeToFirstBuffer = ((now.tv_sec - pStats->prepareTime.tv_sec) * 1000.0) +
+                                             ((now.tv_nsec - pStats->prepareTime.tv_nsec) / 1000000.0);
+        pStats->bWaitingForFirstBuffer = 0;
+    }
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a completed segment download.
+ *
+ * @param pStats - session counters
+ * @param ttfb - time to first byte, in seconds
+ * @param downloadTime - total transfer time, in seconds
+ */
+void hlsStats_recordSegment(hlsSessionStats_t* pStats, float ttfb, float downloadTime)
+{
+    struct timespec now;
+    srcPluginStartup_t* pStartup = &(pStats->counters.startup);
+
+    hlsClock_now(&now);
+
+    pthread_mutex_lock(&(pStats->mutex));
+
+    if(markStartup(pStats, SRC_STARTUP_FIRST_BYTE, &now))
+    {
+        /* The first byte arrived (downloadTime - ttfb) seconds before now */
+        pStartup->phaseTime[SRC_STARTUP_FIRST_BYTE] -= (downloadTime - ttfb) * 1000;
+        if(pStartup->phaseTime[SRC_STARTUP_FIRST_BYTE] < 0)
+        {
+            pStartup->phaseTime[SRC_STARTUP_FIRST_BYTE] = 0;
+        }
+    }
+
+    pStats->counters.numSegments++;
+    histogramAdd(&(pStats->counters.segmentTTFB), ttfb * 1000);
+    histogramAdd(&(pStats->counters.segmentDownloadTime), downloadTime * 1000);
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Starts a new startup timeline.  Called when the session's data
+ * source is set.
+ *
+ * @param pStats - session counters
+ */
+void hlsStats_markDataSource(hlsSessionStats_t* pStats)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+
+    resetStartup(&(pStats->counters.startup));
+
+    hlsClock_now(&(pStats->startupBase));
+    pStats->counters.startup.startTime = pStats->startupBase.tv_sec + (pStats->startupBase.tv_nsec / 1000000000.0);
+    pStats->counters.startup.phaseTime[SRC_STARTUP_DATA_SOURCE] = 0;
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Records a startup milestone, see #srcStartupPhase_t.  Only the
+ * first time each milestone is reached after the data source is
+ * set is kept.
+ *
+ * @param pStats - session counters
+ * @param phase - milestone reached
+ * @param pStartup - if not NULL and the milestone was recorded,
+ *                 receives a snapshot of the timeline
+ *
+ * @return int - TRUE if the milestone was recorded by this call
+ */
+int hlsStats_markStartup(hlsSessionStats_t* pStats, srcStartupPhase_t phase, srcPluginStartup_t* pStartup)
+{
+    struct timespec now;
+    int bMarked = 0;
+
+    hlsClock_now(&now);
+
+    pthread_mutex_lock(&(pStats->mutex));
+
+    bMarked = markStartup(pStats, phase, &now);
+    if(bMarked && (pStartup != NULL))
+    {
+        memcpy(pStartup, &(pStats->counters.startup), sizeof(srcPluginStartup_t));
+    }
+
+    pthread_mutex_unlock(&(pStats->mutex));
+
+    return bMarked;
+}
+
+/**
+ * Accounts for a segment download resumed after a network error.
+ *
+ * @param pStats - session counters
+ */
+void hlsStats_recordSegmentRetry(hlsSessionStats_t* pStats)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    pStats->counters.numSegmentRetries++;
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a failed segment download.
+ *
+ * @param pStats - session counters
+ */
+void hlsStats_recordSegmentError(hlsSessionStats_t* pStats)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    pStats->counters.numSegmentErrors++;
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a live playlist reload.
+ *
+ * @param pStats - session counters
+ * @param reloadTime - time taken to download and parse the
+ *                   playlist, in seconds
+ */
+void hlsStats_recordPlaylistReload(hlsSessionStats_t* pStats, float reloadTime)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+
+    pStats->counters.numPlaylistReloads++;
+    histogramAdd(&(pStats->counters.playlistReloadTime), reloadTime * 1000);
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a wait on a contended playlist lock.
+ *
+ * @param pStats - session counters
+ * @param waitTime - time spent waiting, in seconds
+ */
+void hlsStats_recordPlaylistLockWait(hlsSessionStats_t* pStats, float waitTime)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    histogramAdd(&(pStats->counters.playlistLockWait), waitTime * 1000);
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for a bitrate switch.
+ *
+ * @param pStats - session counters
+ */
+void hlsStats_recordBitrateSwitch(hlsSessionStats_t* pStats)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    pStats->counters.numBitrateSwitches++;
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for time spent stalled.
+ *
+ * @param pStats - session counters
+ * @param bNewStall - TRUE if playback has just run out of data
+ * @param stallTime - additional time spent stalled, in seconds
+ */
+void hlsStats_recordStall(hlsSessionStats_t* pStats, int bNewStall, float stallTime)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+
+    if(bNewStall)
+    {
+        pStats->counters.numStalls++;
+    }
+    pStats->counters.stallTime += stallTime;
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Takes a consistent snapshot of a session's counters.
+ *
+ * @param pStats - session counters
+ * @param pCounters - will contain the snapshot
+ */
+void hlsStats_get(hlsSessionStats_t* pStats, srcPluginStats_t* pCounters)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    memcpy(pCounters, &(pStats->counters), sizeof(srcPluginStats_t));
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for an acquisition of one of the session locks.
+ * Only called in --enable-lock-stats builds, see hlsLockStats.c.
+ *
+ * @param pStats - session counters
+ * @param lock - lock that was taken
+ * @param bContended - TRUE if the lock was already held
+ * @param waitTime - time spent waiting for it, in seconds
+ */
+void hlsStats_recordLockAcquire(hlsSessionStats_t* pStats, srcLockId_t lock, int bContended, float waitTime)
+{
+    srcLockStats_t* pLock = &(pStats->locks.locks[lock]);
+
+    pthread_mutex_lock(&(pStats->mutex));
+
+    pLock->numAcquired++;
+    if(bContended)
+    {
+        pLock->numContended++;
+        histogramAdd(&(pLock->waitTime), waitTime * 1000);
+    }
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Accounts for the release of one of the session locks.
+ * Only called in --enable-lock-stats builds, see hlsLockStats.c.
+ *
+ * @param pStats - session counters
+ * @param lock - lock that is being released
+ * @param holdTime - time it was held, in seconds
+ * @param pSite - "file:line" that took it
+ */
+void hlsStats_recordLockHold(hlsSessionStats_t* pStats, srcLockId_t lock, float holdTime, const char* pSite)
+{
+    srcLockStats_t* pLock = &(pStats->locks.locks[lock]);
+    size_t siteLen = 0;
+
+    pthread_mutex_lock(&(pStats->mutex));
+
+    if((holdTime * 1000) > pLock->holdTime.max)
+    {
+        /* Keep the end of the site if it is too long, the line number matters most */
+        siteLen = strlen(pSite);
+        if(siteLen >= SRC_LOCK_SITE_LEN)
+        {
+            pSite += siteLen - (SRC_LOCK_SITE_LEN - 1);
+        }
+        strcpy(pLock->longestHoldSite, pSite);
+    }
+    histogramAdd(&(pLock->holdTime), holdTime * 1000);
+
+    pthread_mutex_unlock(&(pStats->mutex));
+}
+
+/**
+ * Takes a consistent snapshot of a session's lock counters.
+ *
+ * @param pStats - session counters
+ * @param pLocks - will contain the snapshot
+ */
+void hlsStats_getLocks(hlsSessionStats_t* pStats, srcPluginLockStats_t* pLocks)
+{
+    pthread_mutex_lock(&(pStats->mutex));
+    memcpy(pLocks, &(pStats->locks), sizeof(srcPluginLockStats_t));
+    pthread_mutex_unlock(&(pStats->mutex));
+
+#ifdef ENABLE_LOCK_STATS
+    pLocks->bEnabled = 1;
+#endif
+}
+
+/**
+ * Logs the lock counters of a session, one line per lock that
+ * has been taken.  Called when the session is closed.
+ *
+ * @param pStats - session counters
+ * @param pSession - session the counters belong to, for the log
+ */
+void hlsStats_logLocks(hlsSessionStats_t* pStats, hlsSession_t* pSession)
+{
+    static const char* lockNames[SRC_LOCK_COUNT] = { "playlist", "curl", "mediaGroupCurl",
+                                                     "playerEvt", "state", "set" };
+    srcPluginLockStats_t locks;
+    srcLockStats_t* pLock = NULL;
+    int ii = 0;
+
+    hlsStats_getLocks(pStats, &locks);
+
+    for(ii = 0; ii < SRC_LOCK_COUNT; ii++)
+    {
+        pLock = &(locks.locks[ii]);
+
+        if(pLock->numAcquired == 0)
+        {
+            continue;
+        }
+
+        DEBUG(DBG_INFO, "session %p lock %s: %u acquired, %u contended, wait avg %.3f max %.3f ms, "
+              "hold avg %.3f max %.3f ms at %s", pSession, lockNames[ii],
+              pLock->numAcquired, pLock->numContended,
+              pLock->waitTime.numSamples ? pLock->waitTime.sum / pLock->waitTime.numSamples : 0.0,
+              pLock->waitTime.max,
+              pLock->holdTime.numSamples ? pLock->holdTime.sum / pLock->holdTime.numSamples : 0.0,
+              pLock->holdTime.max, pLock->longestHoldSite);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
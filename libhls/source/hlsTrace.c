@@ -0,0 +1,301 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsTrace.c @date October 19, 2026
+ *
+ * Process-wide transfer trace.
+ *
+ * Records are appended to a fixed-size ring allocated when the plugin
+ * is initialized, so tracing costs one short critical section per
+ * transfer and never grows memory.  Dumps snapshot the ring under
+ * the lock and do the file I/O outside of it.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#include "hlsTrace.h"
+
+#include "debug.h"
+
+/*! Transfer trace ring */
+static struct {
+    pthread_mutex_t mutex;          /*!< Protects the fields below */
+    hlsTraceRecord_t* pRecords;     /*!< Ring storage; NULL while tracing is off */
+    int capacity;                   /*!< Number of records in pRecords */
+    int next;                       /*!< Slot the next record goes into */
+    int count;                      /*!< Number of valid records */
+} traceRing = { PTHREAD_MUTEX_INITIALIZER, NULL, 0, 0, 0 };
+
+/**
+ * Returns the name used for a transfer type in JSON traces.
+ *
+ * @param type - #hlsTraceType_t
+ *
+ * @return const char*
+ */
+static const char* traceTypeName(uint32_t type)
+{
+    switch(type)
+    {
+        case HLS_TRACE_PLAYLIST:
+            return "playlist";
+        case HLS_TRACE_KEY:
+            return "key";
+        case HLS_TRACE_SEGMENT:
+            return "segment";
+        default:
+            return "unknown";
+    }
+}
+
+/**
+ * Allocates the trace ring.
+ *
+ * @param numRecords - number of records to keep
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsTrace_init(int numRecords)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if(numRecords <= 0)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(traceRing.mutex));
+
+    do
+    {
+        if(traceRing.pRecords != NULL)
+        {
+            ERROR("transfer trace already initialized");
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        traceRing.pRecords = malloc(numRecords * sizeof(hlsTraceRecord_t));
+        if(traceRing.pRecords == NULL)
+        {
+            ERROR("malloc error");
+            rval = HLS_MEMORY_ERROR;
+            break;
+        }
+
+        traceRing.capacity = numRecords;
+        traceRing.next = 0;
+        traceRing.count = 0;
+
+    } while(0);
+
+    pthread_mutex_unlock(&(traceRing.mutex));
+
+    return rval;
+}
+
+/**
+ * Frees the trace ring.  Records added afterwards are dropped.
+ */
+void hlsTrace_term(void)
+{
+    pthread_mutex_lock(&(traceRing.mutex));
+
+    free(traceRing.pRecords);
+    traceRing.pRecords = NULL;
+    traceRing.capacity = 0;
+    traceRing.next = 0;
+    traceRing.count = 0;
+
+    pthread_mutex_unlock(&(traceRing.mutex));
+}
+
+/**
+ * Appends a record to the ring, overwriting the oldest one if
+ * the ring is full.
+ *
+ * @param pRecord - record to copy into the ring
+ */
+void hlsTrace_add(hlsTraceRecord_t* pRecord)
+{
+    if(pRecord == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&(traceRing.mutex));
+
+    if(traceRing.pRecords != NULL)
+    {
+        traceRing.pRecords[traceRing.next] = *pRecord;
+        traceRing.next = (traceRing.next + 1) % traceRing.capacity;
+        if(traceRing.count < traceRing.capacity)
+        {
+            traceRing.count++;
+        }
+    }
+
+    pthread_mutex_unlock(&(traceRing.mutex));
+}
+
+/**
+ * Writes the records currently in the ring to a file, oldest
+ * first.
+ *
+ * @param filePath - file to write; overwritten if it exists
+ * @param format - #srcTraceFormat_t to write the file in
+ * @param sessionId - if non-NULL, only the transfers of this
+ *                  session are written
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsTrace_dump(const char* filePath, srcTraceFormat_t format, srcSessionId_t sessionId)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    hlsTraceRecord_t* pSnapshot = NULL;
+    hlsTraceFileHeader_t header;
+    FILE* fpTrace = NULL;
+    uint64_t session = (uint64_t)(uintptr_t)sessionId;
+    int numRecords = 0;
+    int first = 0;
+    int i = 0;
+    hlsTraceRecord_t* pRecord = NULL;
+
+    if((filePath == NULL) ||
+       ((format != SRC_TRACE_FORMAT_BINARY) && (format != SRC_TRACE_FORMAT_JSON)))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    do
+    {
+        /* Copy the matching records out so we don't hold the lock during I/O */
+        pthread_mutex_lock(&(traceRing.mutex));
+
+        if(traceRing.count > 0)
+        {
+            pSnapshot = malloc(traceRing.count * sizeof(hlsTraceRecord_t));
+            if(pSnapshot == NULL)
+            {
+                pthread_mutex_unlock(&(traceRing.mutex));
+                ERROR("malloc error");
+                rval = HLS_MEMORY_ERROR;
+                break;
+            }
+
+            first = (traceRing.next + traceRing.capacity - traceRing.count) % traceRing.capacity;
+            for(i = 0; i < traceRing.count; i++)
+            {
+                pRecord = &(traceRing.pRecords[(first + i) % traceRing.capacity]);
+                if((sessionId == NULL) || (pRecord->session == session))
+                {
+                    pSnapshot[numRecords] = *pRecord;
+                    numRecords++;
+                }
+            }
+        }
+
+        pthread_mutex_unlock(&(traceRing.mutex));
+
+        fpTrace = fopen(filePath, "wb");
+        if(fpTrace == NULL)
+        {
+            ERROR("fopen() failed on file %s -- %s", filePath, strerror(errno));
+            rval = HLS_FILE_ERROR;
+            break;
+        }
+
+        if(format == SRC_TRACE_FORMAT_BINARY)
+        {
+            memset(&header, 0, sizeof(header));
+            memcpy(header.magic, HLS_TRACE_FILE_MAGIC, sizeof(header.magic));
+            header.version = HLS_TRACE_FILE_VERSION;
+            header.recordSize = sizeof(hlsTraceRecord_t);
+            header.numRecords = numRecords;
+
+            if((fwrite(&header, sizeof(header), 1, fpTrace) != 1) ||
+               ((numRecords > 0) && (fwrite(pSnapshot, sizeof(hlsTraceRecord_t), numRecords, fpTrace) != (size_t)numRecords)))
+            {
+                ERROR("fwrite() failed on file %s -- %s", filePath, strerror(errno));
+                rval = HLS_FILE_ERROR;
+                break;
+            }
+        }
+        else
+        {
+            for(i = 0; i < numRecords; i++)
+            {
+                pRecord = &(pSnapshot[i]);
+                if(fprintf(fpTrace,
+                           "{\"start_us\":%" PRIu64 ",\"session\":\"0x%" PRIx64 "\",\"type\":\"%s\",\"bitrate\":%" PRId32
+                           ",\"http_status\":%" PRId32 ",\"result\":%" PRId32 ",\"bytes\":%" PRId64
+                           ",\"dns_us\":%" PRIu32 ",\"connect_us\":%" PRIu32 ",\"tls_us\":%" PRIu32
+                           ",\"pretransfer_us\":%" PRIu32 ",\"ttfb_us\":%" PRIu32 ",\"total_us\":%" PRIu32 "}\n",
+                           pRecord->startTime, pRecord->session, traceTypeName(pRecord->type), pRecord->bitrate,
+                           pRecord->httpStatus, pRecord->result, pRecord->bytes,
+                           pRecord->nameLookupTime, pRecord->connectTime, pRecord->appConnectTime,
+                           pRecord->preTransferTime, pRecord->startTransferTime, pRecord->totalTime) < 0)
+                {
+                    ERROR("fprintf() failed on file %s -- %s", filePath, strerror(errno));
+                    rval = HLS_FILE_ERROR;
+                    break;
+                }
+            }
+            if(rval != HLS_OK)
+            {
+                break;
+            }
+        }
+
+        DEBUG(DBG_INFO, "wrote %d transfer records to %s", numRecords, filePath);
+
+    } while(0);
+
+    if(fpTrace != NULL)
+    {
+        if((fclose(fpTrace) != 0) && (rval == HLS_OK))
+        {
+            ERROR("fclose() failed on file %s -- %s", filePath, strerror(errno));
+            rval = HLS_FILE_ERROR;
+        }
+    }
+
+    free(pSnapshot);
+
+    return rval;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,462 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsTsFilter.c @date October 19, 2026
+ *
+ * In-place MPEG-TS PID filter (see hlsTsFilter.h).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+
+#include "hlsTsFilter.h"
+
+#include "debug.h"
+
+#define TS_TABLE_PAT 0x00
+#define TS_TABLE_PMT 0x02
+
+/*! Elementary stream listed in a PMT */
+typedef struct {
+    const unsigned char* pEntry;    /*!< Start of the ES loop entry */
+    int length;                     /*!< Length of the entry, descriptors included */
+    int streamType;
+    int pid;
+    int bAudio;
+    int bData;
+    char language[ISO_LANG_CODE_LEN + 1];
+} pmtStream_t;
+
+/**
+ * MPEG-2 CRC32 used by PSI sections.
+ */
+static uint32_t crc32Mpeg(const unsigned char* pData, int length)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    int i = 0;
+    int bit = 0;
+
+    for(i = 0; i < length; i++)
+    {
+        crc ^= ((uint32_t)pData[i]) << 24;
+        for(bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000) ? ((crc << 1) ^ 0x04C11DB7) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * Finds the PSI section starting in a packet.
+ *
+ * @param pPacket - TS packet with payload_unit_start_indicator set
+ * @param tableId - expected table_id
+ * @param ppSection - will point to the section on success
+ * @param pLength - will contain the section length, from
+ *                table_id up to and including the CRC
+ *
+ * @return 1 if the packet holds a complete section, 0 otherwise
+ */
+static int findSection(const unsigned char* pPacket, int tableId, const unsigned char** ppSection, int* pLength)
+{
+    int offset = 4;
+    const unsigned char* pSection = NULL;
+
+    if(!(pPacket[1] & 0x40) || !(pPacket[3] & 0x10))
+    {
+        return 0;
+    }
+
+    if(pPacket[3] & 0x20)
+    {
+        offset += 1 + pPacket[4];
+    }
+
+    /* pointer_field */
+    if(offset >= HLS_TS_PACKET_SIZE)
+    {
+        return 0;
+    }
+    offset += 1 + pPacket[offset];
+
+    if(offset + 3 > HLS_TS_PACKET_SIZE)
+    {
+        return 0;
+    }
+
+    pSection = pPacket + offset;
+    if(pSection[0] != tableId)
+    {
+        return 0;
+    }
+
+    *pLength = 3 + (((pSection[1] & 0x0f) << 8) | pSection[2]);
+    if((*pLength < 16) || (offset + *pLength > HLS_TS_PACKET_SIZE))
+    {
+        return 0;
+    }
+
+    *ppSection = pSection;
+    return 1;
+}
+
+/**
+ * Reads the PMT PID of the first program from a PAT packet.
+ */
+static void parsePat(hlsTsFilter_t* pFilter, const unsigned char* pPacket)
+{
+    const unsigned char* pSection = NULL;
+    int length = 0;
+    int i = 0;
+
+    if(!findSection(pPacket, TS_TABLE_PAT, &pSection, &length))
+    {
+        return;
+    }
+
+    for(i = 8; i + 4 <= length - 4; i += 4)
+    {
+        /* Program 0 is the network PID */
+        if((pSection[i] != 0) || (pSection[i + 1] != 0))
+        {
+            pFilter->pmtPid = ((pSection[i + 2] & 0x1f) << 8) | pSection[i + 3];
+            DEBUG(DBG_NOISE, "PMT on PID 0x%x", pFilter->pmtPid);
+            break;
+        }
+    }
+}
+
+/**
+ * Classifies an elementary stream from its stream_type and
+ * descriptors.
+ */
+static void classifyStream(pmtStream_t* pStream, const unsigned char* pDesc, int descLength)
+{
+    int i = 0;
+
+    switch(pStream->streamType)
+    {
+        case 0x03: /* MPEG-1 audio */
+        case 0x04: /* MPEG-2 audio */
+        case 0x0f: /* AAC ADTS */
+        case 0x11: /* AAC LATM */
+        case 0x81: /* AC-3 */
+        case 0x82: /* DTS */
+        case 0x87: /* E-AC-3 */
+            pStream->bAudio = 1;
+            break;
+        case 0x05: /* private sections */
+        case 0x0b: /* DSM-CC */
+        case 0x0c:
+        case 0x0d:
+            pStream->bData = 1;
+            break;
+        default:
+            break;
+    }
+
+    for(i = 0; i + 2 <= descLength; i += 2 + pDesc[i + 1])
+    {
+        switch(pDesc[i])
+        {
+            case 0x0a: /* ISO_639_language_descriptor */
+                if((pDesc[i + 1] >= ISO_LANG_CODE_LEN) && (i + 2 + ISO_LANG_CODE_LEN <= descLength))
+                {
+                    memcpy(pStream->language, pDesc + i + 2, ISO_LANG_CODE_LEN);
+                    pStream->language[ISO_LANG_CODE_LEN] = '\0';
+                }
+                break;
+            case 0x6a: /* DVB AC-3 */
+            case 0x7a: /* DVB E-AC-3 */
+            case 0x7b: /* DVB DTS */
+            case 0x7c: /* DVB AAC */
+                if(pStream->streamType == 0x06)
+                {
+                    pStream->bAudio = 1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Picks the streams to drop from a PMT packet and builds the
+ * packet without them in pmtOut.
+ *
+ * @param pFilter - filter state
+ * @param pPacket - PMT packet
+ *
+ * @return 1 on success, 0 if the PMT can't be filtered
+ */
+static int rewritePmt(hlsTsFilter_t* pFilter, const unsigned char* pPacket)
+{
+    const unsigned char* pSection = NULL;
+    const unsigned char* pLoopStart = NULL;
+    const unsigned char* pLoop = NULL;
+    const unsigned char* pLoopEnd = NULL;
+    unsigned char* pOut = NULL;
+    pmtStream_t streams[HLS_TS_FILTER_MAX_PIDS];
+    int numStreams = 0;
+    int length = 0;
+    int pcrPid = 0;
+    int keepAudio = -1;
+    int bDropAudio = 0;
+    int descLength = 0;
+    int i = 0;
+    uint32_t crc = 0;
+
+    if(!findSection(pPacket, TS_TABLE_PMT, &pSection, &length))
+    {
+        return 0;
+    }
+
+    pcrPid = ((pSection[8] & 0x1f) << 8) | pSection[9];
+    pLoopStart = pSection + 12 + (((pSection[10] & 0x0f) << 8) | pSection[11]);
+    pLoopEnd = pSection + length - 4;
+    if(pLoopStart > pLoopEnd)
+    {
+        return 0;
+    }
+    pLoop = pLoopStart;
+
+    /* List the elementary streams */
+    while(pLoop + 5 <= pLoopEnd)
+    {
+        if(numStreams == HLS_TS_FILTER_MAX_PIDS)
+        {
+            return 0;
+        }
+
+        descLength = ((pLoop[3] & 0x0f) << 8) | pLoop[4];
+        if(pLoop + 5 + descLength > pLoopEnd)
+        {
+            return 0;
+        }
+
+        memset(&streams[numStreams], 0, sizeof(pmtStream_t));
+        streams[numStreams].pEntry = pLoop;
+        streams[numStreams].length = 5 + descLength;
+        streams[numStreams].streamType = pLoop[0];
+        streams[numStreams].pid = ((pLoop[1] & 0x1f) << 8) | pLoop[2];
+        classifyStream(&streams[numStreams], pLoop + 5, descLength);
+
+        numStreams++;
+        pLoop += 5 + descLength;
+    }
+
+    /* Keep the audio stream in the session language, or the first one */
+    for(i = 0; i < numStreams; i++)
+    {
+        if(streams[i].bAudio)
+        {
+            if(keepAudio == -1)
+            {
+                keepAudio = i;
+            }
+            if((pFilter->language[0] != '\0') &&
+               (strncasecmp(streams[i].language, pFilter->language, ISO_LANG_CODE_LEN) == 0))
+            {
+                keepAudio = i;
+                break;
+            }
+        }
+    }
+
+    bDropAudio = (pFilter->flags & SRC_PID_FILTER_MUXED_AUDIO) && pFilter->bAlternateAudio;
+
+    /* Build the packet with only the streams we keep */
+    memcpy(pFilter->pmtOut, pPacket, HLS_TS_PACKET_SIZE);
+    pOut = pFilter->pmtOut + (pLoopStart - pPacket);
+    pFilter->numDropPids = 0;
+
+    for(i = 0; i < numStreams; i++)
+    {
+        /* Never drop the PCR */
+        if((streams[i].pid != pcrPid) &&
+           ((streams[i].bAudio && bDropAudio) ||
+            (streams[i].bAudio && (pFilter->flags & SRC_PID_FILTER_LANGUAGES) && (i != keepAudio)) ||
+            (streams[i].bData && (pFilter->flags & SRC_PID_FILTER_DATA))))
+        {
+            DEBUG(DBG_INFO, "dropping PID 0x%x (stream type 0x%x, language '%s')",
+                  streams[i].pid, streams[i].streamType, streams[i].language);
+            pFilter->dropPids[pFilter->numDropPids++] = streams[i].pid;
+            continue;
+        }
+
+        memcpy(pOut, streams[i].pEntry, streams[i].length);
+        pOut += streams[i].length;
+    }
+
+    /* New section_length, CRC and stuffing */
+    length = pOut + 4 - (pFilter->pmtOut + (pSection - pPacket));
+    pFilter->pmtOut[(pSection - pPacket) + 1] = (pSection[1] & 0xf0) | (((length - 3) >> 8) & 0x0f);
+    pFilter->pmtOut[(pSection - pPacket) + 2] = (length - 3) & 0xff;
+
+    crc = crc32Mpeg(pFilter->pmtOut + (pSection - pPacket), length - 4);
+    pOut[0] = (crc >> 24) & 0xff;
+    pOut[1] = (crc >> 16) & 0xff;
+    pOut[2] = (crc >> 8) & 0xff;
+    pOut[3] = crc & 0xff;
+    pOut += 4;
+
+    memset(pOut, 0xff, pFilter->pmtOut + HLS_TS_PACKET_SIZE - pOut);
+
+    memcpy(pFilter->pmtIn, pPacket, HLS_TS_PACKET_SIZE);
+    pFilter->bHavePmt = 1;
+
+    return 1;
+}
+
+/**
+ * Resets a filter for a new segment.
+ *
+ * @param pFilter - filter to reset
+ * @param flags - SRC_PID_FILTER_* flags to apply
+ * @param bAlternateAudio - TRUE if the player gets its audio from
+ *                        an alternate rendition
+ * @param pLanguage - ISO 639 code of the audio language to keep,
+ *                  NULL or "" for the first audio stream
+ */
+void hlsTsFilter_init(hlsTsFilter_t* pFilter, int flags, int bAlternateAudio, const char* pLanguage)
+{
+    if(pFilter == NULL)
+    {
+        return;
+    }
+
+    memset(pFilter, 0, sizeof(*pFilter));
+    pFilter->flags = flags;
+    pFilter->bAlternateAudio = bAlternateAudio;
+    pFilter->pmtPid = -1;
+
+    if(pLanguage != NULL)
+    {
+        strncpy(pFilter->language, pLanguage, ISO_LANG_CODE_LEN);
+        pFilter->language[ISO_LANG_CODE_LEN] = '\0';
+    }
+}
+
+/**
+ * Squeezes the packets of dropped PIDs out of a buffer and
+ * rewrites its PMT packets.  Buffers must be fed in order and
+ * hold whole packets; anything else is passed through unchanged.
+ *
+ * @param pFilter - filter state
+ * @param pData - packets to filter, modified in place
+ * @param size - number of bytes at pData
+ *
+ * @return number of bytes left at pData
+ */
+long hlsTsFilter_apply(hlsTsFilter_t* pFilter, unsigned char* pData, long size)
+{
+    unsigned char* pIn = pData;
+    unsigned char* pOut = pData;
+    unsigned char* pEnd = pData + size;
+    int pid = 0;
+    int bDrop = 0;
+    int i = 0;
+
+    if((pFilter == NULL) || (pData == NULL) || (pFilter->flags == SRC_PID_FILTER_NONE) ||
+       pFilter->bDisabled || ((size % HLS_TS_PACKET_SIZE) != 0))
+    {
+        return size;
+    }
+
+    for(; pIn < pEnd; pIn += HLS_TS_PACKET_SIZE)
+    {
+        if(pIn[0] != HLS_TS_SYNC_BYTE)
+        {
+            DEBUG(DBG_WARN, "lost TS sync, not filtering the rest of the segment");
+            pFilter->bDisabled = 1;
+            memmove(pOut, pIn, pEnd - pIn);
+            pOut += pEnd - pIn;
+            break;
+        }
+
+        pid = ((pIn[1] & 0x1f) << 8) | pIn[2];
+
+        bDrop = 0;
+        for(i = 0; i < pFilter->numDropPids; i++)
+        {
+            if(pFilter->dropPids[i] == pid)
+            {
+                bDrop = 1;
+                break;
+            }
+        }
+
+        if(bDrop)
+        {
+            pFilter->bytesDropped += HLS_TS_PACKET_SIZE;
+            continue;
+        }
+
+        if(pOut != pIn)
+        {
+            memmove(pOut, pIn, HLS_TS_PACKET_SIZE);
+        }
+
+        if((pid == 0) && (pFilter->pmtPid == -1))
+        {
+            parsePat(pFilter, pOut);
+        }
+        else if((pid == pFilter->pmtPid) && (pOut[1] & 0x40))
+        {
+            /* PMTs repeat unchanged apart from the continuity counter */
+            if(!pFilter->bHavePmt ||
+               (memcmp(pOut + 4, pFilter->pmtIn + 4, HLS_TS_PACKET_SIZE - 4) != 0))
+            {
+                if(!rewritePmt(pFilter, pOut))
+                {
+                    DEBUG(DBG_WARN, "can't filter PMT on PID 0x%x, not filtering the rest of the segment", pid);
+                    pFilter->bDisabled = 1;
+                    pFilter->numDropPids = 0;
+                    pOut += HLS_TS_PACKET_SIZE;
+                    pIn += HLS_TS_PACKET_SIZE;
+                    memmove(pOut, pIn, pEnd - pIn);
+                    pOut += pEnd - pIn;
+                    break;
+                }
+            }
+
+            memcpy(pOut + 4, pFilter->pmtOut + 4, HLS_TS_PACKET_SIZE - 4);
+        }
+
+        pOut += HLS_TS_PACKET_SIZE;
+    }
+
+    return pOut - pData;
+}
+
+#ifdef __cplusplus
+}
+#endif
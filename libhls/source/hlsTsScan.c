@@ -0,0 +1,323 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsTsScan.c @date October 19, 2026
+ *
+ * Streaming MPEG-TS header scanner (see hlsTsScan.h).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "hlsTsScan.h"
+
+#include "debug.h"
+
+#define TS_PID_NULL 0x1fff
+
+/**
+ * Reads a 33 bit PTS or DTS from the 5 byte PES header field at pField.
+ */
+static long long readTimestamp(const unsigned char* pField)
+{
+    return (((long long)(pField[0] & 0x0e)) << 29) |
+           (((long long)pField[1]) << 22) |
+           (((long long)(pField[2] & 0xfe)) << 14) |
+           (((long long)pField[3]) << 7) |
+           (((long long)pField[4]) >> 1);
+}
+
+/**
+ * Checks the continuity counter of a packet that carries a payload.
+ * Repeated packets and packets flagged as discontinuous are not errors.
+ *
+ * @param pScan - scan state
+ * @param pid - PID of the packet
+ * @param cc - continuity counter of the packet
+ * @param bDiscontinuity - TRUE if the packet has the discontinuity indicator set
+ */
+static void checkContinuity(hlsTsScan_t* pScan, int pid, int cc, int bDiscontinuity)
+{
+    int i = 0;
+
+    for(i = 0; i < pScan->numPids; i++)
+    {
+        if(pScan->pids[i].pid == pid)
+        {
+            break;
+        }
+    }
+
+    if(i == pScan->numPids)
+    {
+        /* Streams with more PIDs than we track just go unchecked */
+        if(pScan->numPids == HLS_TS_SCAN_MAX_PIDS)
+        {
+            return;
+        }
+
+        pScan->pids[i].pid = pid;
+        pScan->numPids++;
+    }
+    else if(!bDiscontinuity &&
+            (cc != pScan->pids[i].lastCC) &&
+            (cc != ((pScan->pids[i].lastCC + 1) & 0x0f)))
+    {
+        pScan->numCCErrors++;
+    }
+
+    pScan->pids[i].lastCC = cc;
+}
+
+/**
+ * Scans the headers of one complete packet.
+ *
+ * @param pScan - scan state
+ * @param pPacket - HLS_TS_PACKET_SIZE bytes beginning with HLS_TS_SYNC_BYTE
+ */
+static void scanPacket(hlsTsScan_t* pScan, const unsigned char* pPacket)
+{
+    int pid = 0;
+    int afc = 0;
+    int offset = 4;
+    int afLength = 0;
+    int bDiscontinuity = 0;
+    const unsigned char* pPes = NULL;
+
+    pScan->numPackets++;
+
+    /* Skip packets flagged with a transport error */
+    if(pPacket[1] & 0x80)
+    {
+        return;
+    }
+
+    pid = ((pPacket[1] & 0x1f) << 8) | pPacket[2];
+    afc = (pPacket[3] >> 4) & 0x03;
+
+    if(pid == TS_PID_NULL)
+    {
+        return;
+    }
+
+    /* Adaptation field */
+    if(afc & 0x02)
+    {
+        afLength = pPacket[4];
+        offset = 5 + afLength;
+        if(offset > HLS_TS_PACKET_SIZE)
+        {
+            return;
+        }
+
+        if(afLength > 0)
+        {
+            if(pPacket[5] & 0x80)
+            {
+                bDiscontinuity = 1;
+                pScan->numDiscontinuities++;
+            }
+
+            if((pPacket[5] & 0x10) && (afLength >= 7) && (pScan->firstPcr == INVALID_PTS))
+            {
+                pScan->firstPcr = (((long long)pPacket[6]) << 25) |
+                                  (((long long)pPacket[7]) << 17) |
+                                  (((long long)pPacket[8]) << 9) |
+                                  (((long long)pPacket[9]) << 1) |
+                                  (((long long)pPacket[10]) >> 7);
+            }
+        }
+    }
+
+    /* No payload */
+    if(!(afc & 0x01))
+    {
+        return;
+    }
+
+    checkContinuity(pScan, pid, pPacket[3] & 0x0f, bDiscontinuity);
+
+    /* A PES header with a PTS needs 14 bytes: start code, stream id,
+       length, two flag bytes, header length and the PTS itself */
+    if(!(pPacket[1] & 0x40) || (offset + 14 > HLS_TS_PACKET_SIZE))
+    {
+        return;
+    }
+
+    pPes = &pPacket[offset];
+    if((pPes[0] != 0x00) || (pPes[1] != 0x00) || (pPes[2] != 0x01))
+    {
+        /* PSI section or scrambled payload */
+        return;
+    }
+
+    /* Stream ids whose PES packets have no optional header */
+    switch(pPes[3])
+    {
+        case 0xbc: /* program_stream_map */
+        case 0xbe: /* padding_stream */
+        case 0xbf: /* private_stream_2 */
+        case 0xf0: /* ECM */
+        case 0xf1: /* EMM */
+        case 0xf2: /* DSMCC */
+        case 0xf8: /* H.222.1 type E */
+        case 0xff: /* program_stream_directory */
+            return;
+        default:
+            break;
+    }
+
+    if(pPes[7] & 0x80)
+    {
+        pScan->lastPts = readTimestamp(&pPes[9]);
+        if(pScan->firstPts == INVALID_PTS)
+        {
+            pScan->firstPts = pScan->lastPts;
+        }
+    }
+}
+
+/**
+ * Resets a scanner for a new segment.
+ *
+ * @param pScan - scan state to reset
+ */
+void hlsTsScan_init(hlsTsScan_t* pScan)
+{
+    if(pScan == NULL)
+    {
+        return;
+    }
+
+    memset(pScan, 0, sizeof(*pScan));
+    pScan->firstPts = INVALID_PTS;
+    pScan->lastPts = INVALID_PTS;
+    pScan->firstPcr = INVALID_PTS;
+}
+
+/**
+ * Scans the next piece of a segment.  Pieces must be fed in order
+ * and exactly once.
+ *
+ * @param pScan - scan state
+ * @param pData - next bytes of the segment
+ * @param size - number of bytes at pData
+ */
+void hlsTsScan_feed(hlsTsScan_t* pScan, const unsigned char* pData, long size)
+{
+    const unsigned char* pSync = NULL;
+    long need = 0;
+
+    if((pScan == NULL) || (pData == NULL))
+    {
+        return;
+    }
+
+    while((size > 0) && !pScan->bNotTs)
+    {
+        if(!pScan->bSynced)
+        {
+            /* Take a sync byte followed by another one a packet later,
+               or one too near the end of the piece to tell */
+            pSync = pData;
+            while((pSync = memchr(pSync, HLS_TS_SYNC_BYTE, size - (pSync - pData))) != NULL)
+            {
+                if((pSync + HLS_TS_PACKET_SIZE >= pData + size) ||
+                   (pSync[HLS_TS_PACKET_SIZE] == HLS_TS_SYNC_BYTE))
+                {
+                    break;
+                }
+                pSync++;
+            }
+
+            if(pSync == NULL)
+            {
+                pScan->skipped += size;
+                size = 0;
+            }
+            else
+            {
+                pScan->skipped += pSync - pData;
+                size -= pSync - pData;
+                pData = pSync;
+                pScan->bSynced = 1;
+            }
+
+            /* Only give up on data that never looked like a transport stream */
+            if((pScan->numPackets == 0) && (pScan->skipped > HLS_TS_SCAN_SYNC_LIMIT))
+            {
+                DEBUG(DBG_NOISE, "no TS sync byte in %ld bytes, not scanning", pScan->skipped);
+                pScan->bNotTs = 1;
+            }
+            continue;
+        }
+
+        /* Finish a packet split across pieces */
+        if(pScan->carryLength > 0)
+        {
+            need = HLS_TS_PACKET_SIZE - pScan->carryLength;
+            if(need > size)
+            {
+                need = size;
+            }
+
+            memcpy(pScan->carry + pScan->carryLength, pData, need);
+            pScan->carryLength += need;
+            pData += need;
+            size -= need;
+
+            if(pScan->carryLength == HLS_TS_PACKET_SIZE)
+            {
+                scanPacket(pScan, pScan->carry);
+                pScan->carryLength = 0;
+            }
+            continue;
+        }
+
+        if(pData[0] != HLS_TS_SYNC_BYTE)
+        {
+            /* Lost sync -- look for the next sync byte */
+            pScan->bSynced = 0;
+            continue;
+        }
+
+        if(size < HLS_TS_PACKET_SIZE)
+        {
+            memcpy(pScan->carry, pData, size);
+            pScan->carryLength = size;
+            size = 0;
+            continue;
+        }
+
+        scanPacket(pScan, pData);
+        pData += HLS_TS_PACKET_SIZE;
+        size -= HLS_TS_PACKET_SIZE;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
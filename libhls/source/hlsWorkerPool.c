@@ -0,0 +1,637 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+/**
+ * @file hlsWorkerPool.c @date October 19, 2026
+ *
+ * A process-wide pool of worker threads shared by all sessions.
+ *
+ * Work is expressed as #hlsTask_t step functions.  Each step does a
+ * bounded amount of work and then either asks to be run again at some
+ * absolute hlsClock_now() time or reports that it is done.  The run
+ * queue is kept sorted by due time, so a handful of workers can drive
+ * the periodic parser and playback controller state machines of many
+ * sessions.
+ *
+ * Segment downloads are also run as (single step) tasks.  Because those
+ * block inside cURL for the duration of the transfer, the pool grows
+ * beyond its minimum size when every worker is busy and work is due,
+ * up to the configured maximum, and idle workers above the minimum
+ * exit after WORKER_IDLE_SECS.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+#include <errno.h>
+
+#include "hlsWorkerPool.h"
+#include "hlsClock.h"
+
+#include "debug.h"
+
+/* Seconds a worker above the minimum pool size may sit idle before exiting */
+#define WORKER_IDLE_SECS 30
+
+/* Stack size for worker threads */
+#define WORKER_STACK_SIZE (512*1024)
+
+/*! \struct hlsWorkerPool_t
+ * State of the shared worker pool.  All members are protected by mutex.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex;      /*!< Protects the pool and all queued tasks */
+    pthread_cond_t workCond;    /*!< Signalled when the run queue changes or on shutdown */
+    pthread_cond_t doneCond;    /*!< Broadcast when a task finishes or a worker exits */
+    int bInitialized;           /*!< TRUE between hlsWorkerPool_init() and hlsWorkerPool_term() */
+    int bShutdown;              /*!< Tells the workers to exit */
+    int minWorkers;             /*!< Number of workers kept alive while idle */
+    int maxWorkers;             /*!< Upper bound on the number of workers */
+    int numWorkers;             /*!< Number of live workers */
+    int numIdle;                /*!< Number of workers waiting for work */
+    hlsTask_t* pRunQueue;       /*!< Scheduled tasks, sorted by hlsTask_t::runTime */
+} hlsWorkerPool_t;
+
+static hlsWorkerPool_t thePool = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static void hlsWorkerThread(void* pArg);
+
+/* Returns TRUE if time a is before time b */
+static int timeBefore(struct timespec* a, struct timespec* b)
+{
+    return (a->tv_sec < b->tv_sec) ||
+           ((a->tv_sec == b->tv_sec) && (a->tv_nsec < b->tv_nsec));
+}
+
+/* Inserts pTask into the run queue after any task due at the same time.
+   Pool mutex MUST be held. */
+static void insertTask(hlsTask_t* pTask)
+{
+    hlsTask_t** ppNext = &(thePool.pRunQueue);
+
+    while((*ppNext != NULL) && !timeBefore(&(pTask->runTime), &((*ppNext)->runTime)))
+    {
+        ppNext = &((*ppNext)->pNext);
+    }
+
+    pTask->pNext = *ppNext;
+    *ppNext = pTask;
+    pTask->bScheduled = 1;
+}
+
+/* Removes pTask from the run queue.  Pool mutex MUST be held. */
+static void removeTask(hlsTask_t* pTask)
+{
+    hlsTask_t** ppNext = &(thePool.pRunQueue);
+
+    while((*ppNext != NULL) && (*ppNext != pTask))
+    {
+        ppNext = &((*ppNext)->pNext);
+    }
+
+    if(*ppNext != NULL)
+    {
+        *ppNext = pTask->pNext;
+    }
+
+    pTask->pNext = NULL;
+    pTask->bScheduled = 0;
+}
+
+/* Starts one more worker thread.  Pool mutex MUST be held. */
+static hlsStatus_t spawnWorker(void)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    pthread_attr_t attr;
+    pthread_t worker;
+
+    if(pthread_attr_init(&attr) != 0)
+    {
+        ERROR("failed to initialize thread attribute");
+        return HLS_ERROR;
+    }
+
+    do
+    {
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        pthread_attr_setstacksize(&attr, WORKER_STACK_SIZE);
+
+        if(pthread_create(&worker, &attr, (void*)hlsWorkerThread, NULL))
+        {
+            ERROR("failed to create worker thread");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        thePool.numWorkers++;
+
+        DEBUG(DBG_INFO, "worker pool now has %d threads", thePool.numWorkers);
+
+    } while(0);
+
+    pthread_attr_destroy(&attr);
+
+    return rval;
+}
+
+/* Grows the pool if work is due and no worker is free to pick it up.
+   Pool mutex MUST be held. */
+static void growIfNeeded(void)
+{
+    if((thePool.pRunQueue != NULL) &&
+       (thePool.numIdle == 0) &&
+       (thePool.numWorkers < thePool.maxWorkers))
+    {
+        spawnWorker();
+    }
+}
+
+/**
+ * Starts the shared worker pool.
+ *
+ * @param minWorkers - number of worker threads kept alive while
+ *                   idle
+ * @param maxWorkers - upper bound on the number of worker
+ *                   threads
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsWorkerPool_init(int minWorkers, int maxWorkers)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    pthread_condattr_t condAttr;
+
+    int ii = 0;
+
+    if((minWorkers <= 0) || (maxWorkers < minWorkers))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    do
+    {
+        if(thePool.bInitialized)
+        {
+            ERROR("worker pool already initialized");
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        /* Initialize pthread condition attribute */
+        if(pthread_condattr_init(&condAttr) != 0)
+        {
+            ERROR("failed to initialize condition attribute");
+            rval = HLS_ERROR;
+            break;
+        }
+
+/* Bionic C doesn't define this in pthread.h -- see definition of
+   PTHREAD_COND_TIMEDWAIT in hlsTypes.h for more info */
+#ifndef ANDROID
+        /* Set the clock to use for pthread conditions to CLOCK_MONOTONIC */
+        if(pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC) != 0)
+        {
+            ERROR("failed to set clock on condition attribute");
+            pthread_condattr_destroy(&condAttr);
+            rval = HLS_ERROR;
+            break;
+        }
+#endif
+
+        if(pthread_cond_init(&(thePool.workCond), &condAttr) != 0)
+        {
+            ERROR("failed to initialize worker pool work condition");
+            pthread_condattr_destroy(&condAttr);
+            rval = HLS_ERROR;
+            break;
+        }
+
+        if(pthread_cond_init(&(thePool.doneCond), &condAttr) != 0)
+        {
+            ERROR("failed to initialize worker pool done condition");
+            pthread_cond_destroy(&(thePool.workCond));
+            pthread_condattr_destroy(&condAttr);
+            rval = HLS_ERROR;
+            break;
+        }
+
+        pthread_condattr_destroy(&condAttr);
+
+        thePool.bShutdown = 0;
+        thePool.minWorkers = minWorkers;
+        thePool.maxWorkers = maxWorkers;
+        thePool.numWorkers = 0;
+        thePool.numIdle = 0;
+        thePool.pRunQueue = NULL;
+        thePool.bInitialized = 1;
+
+        for(ii = 0; ii < minWorkers; ii++)
+        {
+            rval = spawnWorker();
+            if(rval != HLS_OK)
+            {
+                break;
+            }
+        }
+
+        DEBUG(DBG_INFO, "worker pool started with %d threads (max %d)", thePool.numWorkers, maxWorkers);
+
+    } while(0);
+
+    pthread_mutex_unlock(&(thePool.mutex));
+
+    if((rval != HLS_OK) && thePool.bInitialized)
+    {
+        hlsWorkerPool_term();
+    }
+
+    return rval;
+}
+
+/**
+ * Stops all worker threads.  Any task still in the run queue is
+ * dropped; callers should have stopped and waited on their tasks
+ * before calling this.
+ */
+void hlsWorkerPool_term(void)
+{
+    hlsTask_t* pTask = NULL;
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    if(thePool.bInitialized)
+    {
+        thePool.bShutdown = 1;
+        pthread_cond_broadcast(&(thePool.workCond));
+
+        /* Wait for the workers to finish their current step and exit */
+        while(thePool.numWorkers > 0)
+        {
+            pthread_cond_wait(&(thePool.doneCond), &(thePool.mutex));
+        }
+
+        /* Drop anything left in the queue */
+        while(thePool.pRunQueue != NULL)
+        {
+            pTask = thePool.pRunQueue;
+            DEBUG(DBG_WARN, "dropping task %p still scheduled at shutdown", pTask);
+            removeTask(pTask);
+        }
+        pthread_cond_broadcast(&(thePool.doneCond));
+
+        pthread_cond_destroy(&(thePool.workCond));
+        pthread_cond_destroy(&(thePool.doneCond));
+
+        thePool.bInitialized = 0;
+
+        DEBUG(DBG_INFO, "worker pool stopped");
+    }
+
+    pthread_mutex_unlock(&(thePool.mutex));
+}
+
+/**
+ * Schedules a task to run as soon as a worker is available.
+ *
+ * The task is run until pFunc returns #HLS_TASK_DONE.  pTask
+ * MUST remain valid until then; use hlsWorkerPool_wait() to
+ * find out when it is safe to release it.
+ *
+ * @param pTask - caller owned task structure
+ * @param pFunc - step function
+ * @param pArg - argument passed to pFunc
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsWorkerPool_schedule(hlsTask_t* pTask, hlsTaskFunc_t pFunc, void* pArg)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if((pTask == NULL) || (pFunc == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    do
+    {
+        if(!(thePool.bInitialized) || thePool.bShutdown)
+        {
+            ERROR("worker pool not running");
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        if(pTask->bScheduled || pTask->bRunning)
+        {
+            ERROR("task %p already scheduled", pTask);
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        pTask->pFunc = pFunc;
+        pTask->pArg = pArg;
+        pTask->bWakePending = 0;
+        pTask->pNext = NULL;
+
+        if(hlsClock_now(&(pTask->runTime)) != 0)
+        {
+            ERROR("failed to get current time");
+            rval = HLS_ERROR;
+            break;
+        }
+
+        insertTask(pTask);
+
+        growIfNeeded();
+
+        pthread_cond_broadcast(&(thePool.workCond));
+
+    } while(0);
+
+    pthread_mutex_unlock(&(thePool.mutex));
+
+    return rval;
+}
+
+/**
+ * Makes a scheduled task due immediately.  If the task is
+ * currently running it will be run again as soon as the current
+ * step returns, provided it asks to be rescheduled.
+ *
+ * @param pTask - task to wake
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsWorkerPool_wake(hlsTask_t* pTask)
+{
+    if(pTask == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    if(pTask->bScheduled)
+    {
+        removeTask(pTask);
+        hlsClock_now(&(pTask->runTime));
+        insertTask(pTask);
+        growIfNeeded();
+        pthread_cond_broadcast(&(thePool.workCond));
+    }
+    else if(pTask->bRunning)
+    {
+        pTask->bWakePending = 1;
+    }
+
+    pthread_mutex_unlock(&(thePool.mutex));
+
+    return HLS_OK;
+}
+
+/**
+ * Blocks until a task is neither scheduled nor running.  The
+ * caller is responsible for getting the task to return
+ * #HLS_TASK_DONE (typically by setting a kill flag and calling
+ * hlsWorkerPool_wake()).
+ *
+ * MUST NOT be called from pTask itself.
+ *
+ * @param pTask - task to wait for
+ *
+ * @return #hlsStatus_t
+ */
+hlsStatus_t hlsWorkerPool_wait(hlsTask_t* pTask)
+{
+    hlsStatus_t rval = HLS_OK;
+
+    if(pTask == NULL)
+    {
+        ERROR("invalid parameter");
+        return HLS_INVALID_PARAMETER;
+    }
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    do
+    {
+        if(pTask->bRunning && pthread_equal(pTask->runner, pthread_self()))
+        {
+            ERROR("task %p waiting on itself", pTask);
+            rval = HLS_STATE_ERROR;
+            break;
+        }
+
+        while(pTask->bScheduled || pTask->bRunning)
+        {
+            pthread_cond_wait(&(thePool.doneCond), &(thePool.mutex));
+        }
+
+    } while(0);
+
+    pthread_mutex_unlock(&(thePool.mutex));
+
+    return rval;
+}
+
+/**
+ * Checks whether the calling thread is the worker currently
+ * running pTask.
+ *
+ * @param pTask - task to check
+ *
+ * @return int - TRUE if called from within pTask, FALSE
+ *         otherwise
+ */
+int hlsWorkerPool_isCurrent(hlsTask_t* pTask)
+{
+    int bCurrent = 0;
+
+    if(pTask != NULL)
+    {
+        pthread_mutex_lock(&(thePool.mutex));
+        bCurrent = pTask->bRunning && pthread_equal(pTask->runner, pthread_self());
+        pthread_mutex_unlock(&(thePool.mutex));
+    }
+
+    return bCurrent;
+}
+
+/**
+ * Returns the current number of worker threads and how many of
+ * them are idle.
+ *
+ * @param pNumWorkers - will contain the number of live workers
+ * @param pNumIdle - will contain the number of idle workers
+ */
+void hlsWorkerPool_getCounts(int* pNumWorkers, int* pNumIdle)
+{
+    pthread_mutex_lock(&(thePool.mutex));
+
+    if(pNumWorkers != NULL)
+    {
+        *pNumWorkers = thePool.numWorkers;
+    }
+
+    if(pNumIdle != NULL)
+    {
+        *pNumIdle = thePool.numIdle;
+    }
+
+    pthread_mutex_unlock(&(thePool.mutex));
+}
+
+/**
+ * Worker thread body.  Runs due tasks in run queue order until
+ * the pool is shut down, or until it has been idle for
+ * WORKER_IDLE_SECS while the pool is above its minimum size.
+ *
+ * @param pArg - unused
+ */
+static void hlsWorkerThread(void* pArg)
+{
+    hlsTask_t* pTask = NULL;
+    hlsTaskResult_t result = HLS_TASK_DONE;
+
+    struct timespec now;
+    struct timespec idleSince;
+    struct timespec deadline;
+    struct timespec nextRunTime;
+
+    int bHaveDeadline = 0;
+
+    (void)pArg;
+
+    hlsClock_now(&idleSince);
+
+    pthread_mutex_lock(&(thePool.mutex));
+
+    while(!(thePool.bShutdown))
+    {
+        hlsClock_now(&now);
+
+        pTask = thePool.pRunQueue;
+
+        /* Nothing due yet -- sleep until the next task is, or until it is time to retire */
+        if((pTask == NULL) || timeBefore(&now, &(pTask->runTime)))
+        {
+            bHaveDeadline = 0;
+
+            if(thePool.numWorkers > thePool.minWorkers)
+            {
+                if((now.tv_sec - idleSince.tv_sec) >= WORKER_IDLE_SECS)
+                {
+                    DEBUG(DBG_INFO, "retiring idle worker, %d remaining", thePool.numWorkers - 1);
+                    break;
+                }
+
+                deadline = idleSince;
+                deadline.tv_sec += WORKER_IDLE_SECS;
+                bHaveDeadline = 1;
+            }
+
+            if((pTask != NULL) && (!bHaveDeadline || timeBefore(&(pTask->runTime), &deadline)))
+            {
+                deadline = pTask->runTime;
+                bHaveDeadline = 1;
+            }
+
+            thePool.numIdle++;
+
+            if(bHaveDeadline)
+            {
+                hlsClock_timedWait(&(thePool.workCond), &(thePool.mutex), &deadline);
+            }
+            else
+            {
+                pthread_cond_wait(&(thePool.workCond), &(thePool.mutex));
+            }
+
+            thePool.numIdle--;
+
+            continue;
+        }
+
+        /* Claim the task */
+        removeTask(pTask);
+        pTask->bRunning = 1;
+        pTask->runner = pthread_self();
+
+        /* If more work is already due, make sure someone is around to do it */
+        if((thePool.pRunQueue != NULL) && !timeBefore(&now, &(thePool.pRunQueue->runTime)))
+        {
+            growIfNeeded();
+        }
+
+        pthread_mutex_unlock(&(thePool.mutex));
+
+        nextRunTime = now;
+        result = pTask->pFunc(pTask->pArg, &nextRunTime);
+
+        pthread_mutex_lock(&(thePool.mutex));
+
+        pTask->bRunning = 0;
+
+        if((result == HLS_TASK_RESCHEDULE) && !(thePool.bShutdown))
+        {
+            if(pTask->bWakePending)
+            {
+                hlsClock_now(&nextRunTime);
+            }
+
+            pTask->bWakePending = 0;
+            pTask->runTime = nextRunTime;
+            insertTask(pTask);
+            pthread_cond_broadcast(&(thePool.workCond));
+        }
+        else
+        {
+            pTask->bWakePending = 0;
+        }
+
+        /* Let anyone in hlsWorkerPool_wait() re-check their task */
+        pthread_cond_broadcast(&(thePool.doneCond));
+
+        hlsClock_now(&idleSince);
+    }
+
+    thePool.numWorkers--;
+    pthread_cond_broadcast(&(thePool.doneCond));
+
+    pthread_mutex_unlock(&(thePool.mutex));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -34,6 +34,25 @@
 extern "C" {
 #endif
 
+#include <time.h>
+
+/*! Returns the current time, CLOCK_MONOTONIC style; 0 on success */
+typedef int (*abrClientClockFunc_t)(struct timespec* pNow);
+
+/*! Adaptech algorithm tuning (see adaptech.c for what each one means) */
+typedef struct {
+    float slackFactor;          /*!< "c" -- fraction of the measured throughput we plan to use */
+    float avgWeight;            /*!< "delta" -- weight of the old average in the throughput average */
+    int lowBufferLevel;         /*!< "theta1" -- below this many seconds buffered we panic */
+    int normalBufferLevel;      /*!< "theta2" -- above this many seconds buffered we are in steady state */
+    int canSwitchUpThreshold;   /*!< "T" -- seconds between switch-ups in steady state */
+    int rampUpThreshold;        /*!< Seconds after playback start during which "T" is ignored */
+} abrClientParams_t;
+
+void abrClientSetClock(abrClientClockFunc_t pClockFunc);
+void abrClientGetParams(abrClientParams_t* pParams);
+void abrClientSetParams(const abrClientParams_t* pParams);
+
 float abrClientAddThroughputToAvg(float lastSegmentDldRate, float avgSegmentDldRate);
 int abrClientGetBitrateIndex(float bandwidth, int rateMin, int rateMax, int bitratesSize, int* uiBitrates);
 int abrClientGetAboveMinBitrate(int rateMin, int rateMax, int bitratesSize, int* uiBitrates);
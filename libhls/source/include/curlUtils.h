@@ -40,21 +40,44 @@ extern "C" {
 #include <curl/easy.h>
 
 #include "hlsTypes.h"
+#include "hlsTrace.h"
+#include "hlsDecrypt.h"
+
+typedef struct downloadHandle_t_ downloadHandle_t;
+
+/*! Called by curlDownloadFile() when the part of a transfer going to
+    downloadHandle_t::fpTarget is complete; points fpTarget and
+    splitRemaining at the next part (fpTarget NULL after the last) */
+typedef hlsStatus_t (*downloadSplitFunc_t)(void* pSplitArg, downloadHandle_t* pHandle);
 
 /*! \struct downloadHandle_t
  * Structure for curlDownloadFile() function
  */
-typedef struct {
+struct downloadHandle_t_ {
     FILE* fpTarget;                 /*!< File descriptor where downloaded data is sent */
     pthread_mutex_t* pFileMutex;    /*!< Mutex to lock before performing any operations on fpTarget; can be NULL */
     int* pbAbortDownload;           /*!< Pointer to a flag which will terminate the download when TRUE; can be NULL */
-} downloadHandle_t;
+    hlsTraceType_t traceType;       /*!< Kind of transfer to record in the transfer trace; HLS_TRACE_NONE to skip it */
+    void* pTraceSession;            /*!< Session to attribute the transfer to in the transfer trace; can be NULL */
+    int traceBitrate;               /*!< Variant bitrate to record in the transfer trace; 0 if not applicable */
+    int bGotFirstByte;              /*!< Set by curlDownloadFile() once the first byte of the body arrives */
+    hlsDecrypt_t* pDecrypt;         /*!< If non-NULL, data is decrypted with it before being written; can be NULL */
+    downloadSplitFunc_t pSplit;     /*!< If non-NULL, the transfer is split across several targets; can't be combined with pDecrypt */
+    void* pSplitArg;                /*!< Passed to pSplit */
+    long splitRemaining;            /*!< Bytes fpTarget still takes before pSplit is called */
+    long bytesReceived;             /*!< Body bytes written so far; set by the caller, curlDownloadFile() adds to it */
+    int bRangeRequired;             /*!< If TRUE, the transfer fails before any data is written unless the server
+                                         answers with 206 Partial Content */
+    CURL* pCurl;                    /*!< Set by curlDownloadFile() to the handle performing the transfer */
+};
 
 hlsStatus_t curlInit(CURL** ppCurl);
 hlsStatus_t curlTerm(CURL* pCurl);
 
 hlsStatus_t curlDownloadFile(CURL* pCurl, char* URL, downloadHandle_t* pHandle, long byteOffset, long byteLength);
 hlsStatus_t getCurlTransferInfo(CURL* pCurl, char** ppRedirectURL, float* pThroughput, long* pDownloadSize);
+hlsStatus_t getCurlTransferTimes(CURL* pCurl, float* pStartTransferTime, float* pTotalTime);
+void traceCurlTransfer(CURL* pCurl, hlsTraceType_t type, void* pSession, int bitrate, hlsStatus_t result);
 
 hlsStatus_t getBaseURL(char* URL, char** pBaseURL);
 hlsStatus_t getFileName(char* URL, char** pFileName, char* prefix);
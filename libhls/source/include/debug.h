@@ -42,12 +42,20 @@ extern "C" {
 #include <config.h>
 #endif
 
+#include "hlsLog.h"
+
 #define DEBUG_MSG(x, ...) "[%s:%d] " x "\n", __FUNCTION__, __LINE__, ##__VA_ARGS__
 #define TS_MSG(ts, x, ...) "[TS:%10f]:" x "\n", ((ts.tv_sec)*1.0) + (ts.tv_nsec/1000000000.0), ##__VA_ARGS__
 #define DEBUG_TS_MSG(ts, x, ...) TS_MSG(ts, "[%s:%d] " x, __FUNCTION__, __LINE__, ##__VA_ARGS__)
 
 #define GLOBAL_TIMESTAMPS 0
 
+/* Output a message from the calling thread, or hand it to the drain thread if
+ * asynchronous logging is on (see hlsLog.h).  HLS_LOG_OUTPUT() and
+ * HLS_LOG_VOUTPUT() are the synchronous output of the platform, defined
+ * below. */
+#define HLS_LOG_WRITE(lvl, ...) hlsLog_write((lvl), __VA_ARGS__)
+
 #ifdef ANDROID
 #include <android/log.h>
 
@@ -66,7 +74,10 @@ extern "C" {
 #define OPEN_LOG
 #define CLOSE_LOG
 
-#define ERROR(x, ...) __android_log_print(ANDROID_LOG_ERROR, "hls","!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__));
+#define HLS_LOG_OUTPUT(lvl, ...) __android_log_print((lvl), "hls", __VA_ARGS__)
+#define HLS_LOG_VOUTPUT(lvl, fmt, args) __android_log_vprint((lvl), "hls", (fmt), (args))
+
+#define ERROR(x, ...) HLS_LOG_WRITE(ANDROID_LOG_ERROR, "!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__))
 
 #define TIMESTAMP(lvl, x, ...)                                                  \
     do                                                                          \
@@ -76,7 +87,7 @@ extern "C" {
             struct timespec ts;                                                 \
             if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)                        \
             {                                                                   \
-                __android_log_print(lvl, "hls", DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));  \
+                HLS_LOG_WRITE(lvl, DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));         \
             }                                                                   \
         }                                                                       \
     } while (0)
@@ -88,7 +99,7 @@ extern "C" {
     do                                                                          \
     {                                                                           \
         if(lvl >= DBG_LEVEL)                                                    \
-            __android_log_print(lvl, "hls", DEBUG_MSG(x, ##__VA_ARGS__));       \
+            HLS_LOG_WRITE(lvl, DEBUG_MSG(x, ##__VA_ARGS__));                    \
     } while (0)
 #endif
 
@@ -122,7 +133,10 @@ extern "C" {
       /* closelog(); */                                                         \
    } while(0);
 
-#define ERROR(x, ...) syslog(LOG_ERR, "!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__));
+#define HLS_LOG_OUTPUT(lvl, ...) syslog((lvl), __VA_ARGS__)
+#define HLS_LOG_VOUTPUT(lvl, fmt, args) vsyslog((lvl), (fmt), (args))
+
+#define ERROR(x, ...) HLS_LOG_WRITE(LOG_ERR, "!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__))
 
 #define TIMESTAMP(lvl, x, ...)                                                  \
     do                                                                          \
@@ -132,7 +146,7 @@ extern "C" {
             struct timespec ts;                                                 \
             if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)                        \
             {                                                                   \
-                syslog(lvl, DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));                \
+                HLS_LOG_WRITE(lvl, DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));         \
             }                                                                   \
         }                                                                       \
     } while (0)
@@ -144,7 +158,7 @@ extern "C" {
     do                                                                          \
     {                                                                           \
         if((lvl <= DBG_LEVEL) && (lvl != DBG_OFF))                              \
-            syslog(lvl, DEBUG_MSG(x, ##__VA_ARGS__));                           \
+            HLS_LOG_WRITE(lvl, DEBUG_MSG(x, ##__VA_ARGS__));                    \
     } while (0)
 #endif
 
@@ -167,7 +181,10 @@ extern "C" {
  * #define DBG_LEVEL <new level>
  */
 
-#define ERROR(x, ...) printf("!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__))
+#define HLS_LOG_OUTPUT(lvl, ...) printf(__VA_ARGS__)
+#define HLS_LOG_VOUTPUT(lvl, fmt, args) vprintf((fmt), (args))
+
+#define ERROR(x, ...) HLS_LOG_WRITE(DBG_WARN, "!!ERROR!! " DEBUG_MSG(x, ##__VA_ARGS__))
 
 #define TIMESTAMP(lvl, x, ...)                                                  \
     do                                                                          \
@@ -177,7 +194,7 @@ extern "C" {
             struct timespec ts;                                                 \
             if(clock_gettime(CLOCK_MONOTONIC, &ts) == 0)                        \
             {                                                                   \
-                printf(DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));                     \
+                HLS_LOG_WRITE(lvl, DEBUG_TS_MSG(ts, x, ##__VA_ARGS__));         \
             }                                                                   \
         }                                                                       \
     } while (0)
@@ -189,7 +206,7 @@ extern "C" {
     do                                                                          \
     {                                                                           \
         if((lvl <= DBG_LEVEL) && (lvl != DBG_OFF))                              \
-            printf(DEBUG_MSG(x, ##__VA_ARGS__));                                \
+            HLS_LOG_WRITE(lvl, DEBUG_MSG(x, ##__VA_ARGS__));                    \
     } while (0)
 #endif
 
@@ -0,0 +1,65 @@
+#ifndef HLSCLOCK_H
+#define HLSCLOCK_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsClock.h @date October 19, 2026
+ *
+ * Clock used for every timed wait, reload deadline and playback timer
+ * in the library.
+ *
+ * By default it is CLOCK_MONOTONIC.  When a scale other than 1 is set
+ * it becomes a virtual clock that runs scale times faster than
+ * CLOCK_MONOTONIC, so that long live sessions (playlist reloads, ABR
+ * timers, DVR window roll-off, forced resumes) can be replayed against
+ * a local origin in a fraction of the wall-clock time.  Players can set
+ * the scale with the HLS_CLOCK_SCALE environment variable, which
+ * hlsPlugin_initialize() applies.
+ *
+ * Times handed to hlsClock_timedWait() and hlsClock_sleep() are in
+ * virtual time and are converted to CLOCK_MONOTONIC before blocking,
+ * so condition variables keep using the CLOCK_MONOTONIC attribute set
+ * in hlsSession_init().
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+#define HLS_CLOCK_MAX_SCALE 1000.0      /*!< Largest supported speed-up */
+
+hlsStatus_t hlsClock_setScale(double scale);
+double hlsClock_getScale(void);
+
+int hlsClock_now(struct timespec* pNow);
+int hlsClock_timedWait(pthread_cond_t* pCond, pthread_mutex_t* pMutex, const struct timespec* pWakeTime);
+void hlsClock_sleep(long usecs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HLSDECRYPT_H
+#define HLSDECRYPT_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsDecrypt.h @date October 19, 2026
+ *
+ * In-library AES-128-CBC segment decryption.
+ *
+ * When a player turns it on with SRC_PLUGIN_SET_DECRYPTION, segments
+ * are decrypted as they come off the network, in the cURL write
+ * callback of the segment download, so the data written to the local
+ * segment file and sent to the player is already clear.  The PKCS#7
+ * padding is checked and stripped when the download completes.
+ *
+ * Built with --enable-decryption the cipher is OpenSSL's EVP AES-128-CBC,
+ * which uses AES-NI or the ARMv8 crypto extensions when the CPU has
+ * them.  Otherwise hlsDecrypt_isSupported() is FALSE and the other
+ * functions return HLS_UNSUPPORTED.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+
+#include "hlsTypes.h"
+
+#define HLS_DECRYPT_KEY_SIZE 16             /*!< AES-128 key and IV size */
+#define HLS_DECRYPT_CHUNK_SIZE (16*1024)    /*!< Bytes decrypted per cipher call */
+
+/*! \struct hlsDecrypt_t
+ * Decryption state of one segment download
+ */
+typedef struct {
+    void* pCtx;                 /*!< Cipher context */
+    unsigned char* pOut;        /*!< HLS_DECRYPT_CHUNK_SIZE + one block of clear data */
+    long bytesIn;               /*!< Encrypted bytes consumed so far */
+} hlsDecrypt_t;
+
+int hlsDecrypt_isSupported(void);
+
+hlsStatus_t hlsDecrypt_init(hlsDecrypt_t* pDecrypt, const char* pKey, const char* pIV);
+hlsStatus_t hlsDecrypt_write(hlsDecrypt_t* pDecrypt, const char* pData, size_t size, FILE* fpTarget);
+hlsStatus_t hlsDecrypt_finish(hlsDecrypt_t* pDecrypt, FILE* fpTarget);
+void hlsDecrypt_term(hlsDecrypt_t* pDecrypt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -57,6 +57,8 @@ hlsStatus_t downloadAndPushSegment(hlsSession_t* pSession,
                                    srcPlayerMode_t playerMode,
                                    int streamNum);
 
+void cancelRangeRun(hlsSession_t* pSession);
+
 #ifdef __cplusplus
 }
 #endif
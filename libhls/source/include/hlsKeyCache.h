@@ -0,0 +1,48 @@
+#ifndef HLSKEYCACHE_H
+#define HLSKEYCACHE_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsKeyCache.h @date October 19, 2026
+ *
+ * Per-session cache and prefetcher of EXT-X-KEY decryption keys.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+hlsStatus_t hlsKeyCache_create(hlsSessionStats_t* pStats, void* pSession, hlsKeyCache_t** ppCache);
+void hlsKeyCache_destroy(hlsKeyCache_t* pCache);
+
+int hlsKeyCache_lookup(hlsKeyCache_t* pCache, const char* pKeyURI, char* pKey);
+hlsStatus_t hlsKeyCache_get(hlsKeyCache_t* pCache, const char* pKeyURI, char* pKey, int* pbAbort);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef HLSLOCKSTATS_H
+#define HLSLOCKSTATS_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsLockStats.h @date October 19, 2026
+ *
+ * Optional contention statistics for the session locks.
+ *
+ * Configure with --enable-lock-stats to route the playlistRWLock,
+ * curlMutex, mediaGroupCurlMutex[], playerEvtMutex, stateMutex and
+ * setMutex acquisitions through hlsLockStats_lock() and friends, which
+ * count acquisitions and record per lock the time spent waiting, the
+ * time the lock was held and the "file:line" of the longest hold.  The
+ * counters are returned through SRC_PLUGIN_GET_LOCK_STATS and logged
+ * when the session is closed.
+ *
+ * Without the option HLS_MUTEX_LOCK() and HLS_MUTEX_UNLOCK() are plain
+ * pthread calls.
+ *
+ * Wait and hold times are measured on the real monotonic clock, not
+ * the session clock, since they are about the host and not the media.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pthread.h>
+
+#include "hlsTypes.h"
+
+#define HLS_LOCK_STRINGIFY_(x) #x
+#define HLS_LOCK_STRINGIFY(x) HLS_LOCK_STRINGIFY_(x)
+
+#ifdef ENABLE_LOCK_STATS
+
+/*! "file:line" of the code taking a lock */
+#define HLS_LOCK_SITE (__FILE__ ":" HLS_LOCK_STRINGIFY(__LINE__))
+
+/*! Locks one of the session mutexes listed in #srcLockId_t */
+#define HLS_MUTEX_LOCK(pSession, lock, pMutex) \
+    hlsLockStats_lock(&((pSession)->stats), (lock), (pMutex), HLS_LOCK_SITE)
+
+/*! Unlocks a mutex locked with HLS_MUTEX_LOCK() */
+#define HLS_MUTEX_UNLOCK(pSession, lock, pMutex) \
+    hlsLockStats_unlock(&((pSession)->stats), (lock), (pMutex))
+
+#else
+
+#define HLS_LOCK_SITE (NULL)
+
+#define HLS_MUTEX_LOCK(pSession, lock, pMutex) pthread_mutex_lock(pMutex)
+#define HLS_MUTEX_UNLOCK(pSession, lock, pMutex) pthread_mutex_unlock(pMutex)
+
+#endif
+
+int hlsLockStats_lock(hlsSessionStats_t* pStats, srcLockId_t lock, pthread_mutex_t* pMutex, const char* pSite);
+int hlsLockStats_unlock(hlsSessionStats_t* pStats, srcLockId_t lock, pthread_mutex_t* pMutex);
+
+void hlsLockStats_acquired(hlsSessionStats_t* pStats, srcLockId_t lock, void* pLock,
+                           int bContended, float waitTime, const char* pSite);
+void hlsLockStats_releasing(hlsSessionStats_t* pStats, srcLockId_t lock, void* pLock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
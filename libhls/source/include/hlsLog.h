@@ -0,0 +1,67 @@
+#ifndef HLSLOG_H
+#define HLSLOG_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsLog.h @date October 19, 2026
+ *
+ * Asynchronous log output.
+ *
+ * By default DEBUG(), ERROR() and TIMESTAMP() (debug.h) write to
+ * syslog, logcat or stdout from the calling thread.  Once
+ * hlsLog_startAsync() has been called they instead format the message
+ * into a ring owned by the calling thread and return; a background
+ * thread drains the rings every few milliseconds and does the actual
+ * output.  Writing to a ring takes no locks and makes no system calls,
+ * so logging no longer slows the download and push loops.
+ *
+ * The plugin switches to asynchronous output at load time if the
+ * HLS_LOG_ASYNC environment variable is set to 1.
+ *
+ * Messages from one thread keep their order; messages from different
+ * threads may be interleaved differently than they were logged.  If a
+ * thread logs faster than the rings are drained, its excess messages
+ * are dropped and the number dropped is logged.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+hlsStatus_t hlsLog_startAsync(void);
+void hlsLog_stopAsync(void);
+
+#ifdef __GNUC__
+void hlsLog_write(int level, const char* format, ...) __attribute__((format(printf, 2, 3)));
+#else
+void hlsLog_write(int level, const char* format, ...);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
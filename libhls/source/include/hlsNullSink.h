@@ -0,0 +1,53 @@
+#ifndef HLSNULLSINK_H
+#define HLSNULLSINK_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsNullSink.h @date October 19, 2026
+ *
+ * Built-in player stand-in used by headless sessions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+hlsStatus_t hlsNullSink_create(hlsNullSink_t** ppSink);
+void hlsNullSink_destroy(hlsNullSink_t* pSink);
+
+srcStatus_t hlsNullSink_getBuffer(hlsSession_t* pSession, char** buffer, int* size, void** ppPrivate);
+srcStatus_t hlsNullSink_sendBuffer(hlsSession_t* pSession, char* buffer, int size, srcBufferMetadata_t* metadata, void* pPrivate);
+srcStatus_t hlsNullSink_set(hlsSession_t* pSession, srcPlayerSetData_t* pSetData);
+srcStatus_t hlsNullSink_get(hlsSession_t* pSession, srcPlayerGetData_t* pGetData);
+
+void hlsNullSink_tick(hlsSession_t* pSession);
+void hlsNullSink_getHealth(hlsNullSink_t* pSink, srcPluginHealth_t* pHealth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -37,7 +37,7 @@ extern "C" {
 
 #include "hlsTypes.h"
 
-void hlsPlaybackControllerThread(hlsSession_t* pSession);
+hlsTaskResult_t hlsPlaybackControllerTask(void* pArg, struct timespec* pNextRunTime);
 
 #ifdef __cplusplus
 }
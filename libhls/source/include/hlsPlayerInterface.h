@@ -40,10 +40,13 @@ extern "C" {
 void hlsPlayer_pluginEvtCallback(void* pHandle, srcPluginEvt_t* pEvt);
 void hlsPlayer_pluginErrCallback(void* pHandle, srcPluginErr_t* pErr);
 srcStatus_t hlsPlayer_registerCB(void* pHandle, playerEvtCallback_t evtCb);
-srcStatus_t hlsPlayer_getBuffer(void* pHandle, char** buffer, int* size, void **ppPrivate);
-srcStatus_t hlsPlayer_sendBuffer(void* pHandle, char* buffer, int size, srcBufferMetadata_t* metadata, void *pPrivate);
-srcStatus_t hlsPlayer_set(void *pHandle, srcPlayerSetData_t *pSetData);
-srcStatus_t hlsPlayer_get(void *pHandle, srcPlayerGetData_t *pGetData);
+srcStatus_t hlsPlayer_getBuffer(hlsSession_t* pSession, char** buffer, int* size, void **ppPrivate);
+srcStatus_t hlsPlayer_sendBuffer(hlsSession_t* pSession, char* buffer, int size, srcBufferMetadata_t* metadata, void *pPrivate);
+int hlsPlayer_canLend(hlsSession_t* pSession);
+srcStatus_t hlsPlayer_lendBuffer(hlsSession_t* pSession, char* buffer, int* size, srcBufferMetadata_t* metadata,
+                                 srcBufferRelease_t release, void* pReleaseData);
+srcStatus_t hlsPlayer_set(hlsSession_t* pSession, srcPlayerSetData_t *pSetData);
+srcStatus_t hlsPlayer_getOption(hlsSession_t* pSession, srcPlayerGetData_t *pGetData);
 
 #ifdef __cplusplus
 }
@@ -55,8 +55,6 @@ srcStatus_t hlsPlugin_get(srcSessionId_t sessionId, srcPluginGetData_t* pGetData
 
 void hlsPlugin_playerEvtCallback(srcSessionId_t sessionId, srcPlayerEvt_t* pEvt);
 
-int getSessionIndex(srcSessionId_t sessionId);
-
 #ifdef __cplusplus
 }
 #endif
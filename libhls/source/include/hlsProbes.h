@@ -0,0 +1,92 @@
+#ifndef HLSPROBES_H
+#define HLSPROBES_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsProbes.h @date October 19, 2026
+ *
+ * Static tracepoints on the segment, playlist and player hot paths.
+ *
+ * Configure with --enable-usdt to compile them as USDT probes
+ * (systemtap's sys/sdt.h), which perf, bpftrace and systemtap can
+ * attach to at run time, e.g.
+ *
+ *   perf probe -x libHls-1.0.so sdt_libhls:segment_complete
+ *   bpftrace -e 'usdt:libHls-1.0.so:libhls:segment_start { ... }'
+ *
+ * or with --enable-lttng to compile them as LTTng-UST tracepoints
+ * (provider "libhls", see hlsProbesLttng.h).  A disabled USDT probe is
+ * a single nop; a disabled LTTng tracepoint is a predicted branch.
+ * Without either option the probes compile to nothing.
+ *
+ * Probes and their arguments:
+ *
+ *   segment_start         session, seqNum, bitrate
+ *   first_byte            session, #hlsTraceType_t, bitrate
+ *   segment_complete      session, seqNum, bytes, #hlsStatus_t
+ *   segment_push          session, seqNum, bytes
+ *   playlist_reload_start session, URL
+ *   playlist_reload_end   session, #hlsStatus_t
+ *   playlist_lock         session, bWrite, bContended
+ *   playlist_unlock       session
+ *   abr_decision          session, from bps, to bps, buffered msecs,
+ *                         last kbit/s, average kbit/s
+ *   player_get_buffer     session, size, #srcStatus_t
+ *   player_send_buffer    session, size, streamNum
+ *
+ * Arguments are plain integers and pointers so that they cost nothing
+ * to marshal; "session" is the hlsSession_t pointer.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#if defined(ENABLE_USDT_PROBES)
+
+#include <sys/sdt.h>
+
+#define HLS_PROBE(name, ...) STAP_PROBEV(libhls, name, ##__VA_ARGS__)
+
+#elif defined(ENABLE_LTTNG_PROBES)
+
+#include "hlsProbesLttng.h"
+
+#define HLS_PROBE(name, ...) tracepoint(libhls, name, ##__VA_ARGS__)
+
+#else
+
+#define HLS_PROBE(name, ...) do { } while(0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
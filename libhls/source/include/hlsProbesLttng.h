@@ -0,0 +1,147 @@
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsProbesLttng.h @date October 19, 2026
+ *
+ * LTTng-UST tracepoint provider for the probes listed in hlsProbes.h.
+ * Only used when configured with --enable-lttng; hlsProbes.c
+ * instantiates it.  Enable with e.g.
+ *
+ *   lttng enable-event --userspace 'libhls:*'
+ */
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER libhls
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "hlsProbesLttng.h"
+
+#if !defined(HLSPROBESLTTNG_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define HLSPROBESLTTNG_H
+
+#include <stdint.h>
+#include <lttng/tracepoint.h>
+
+TRACEPOINT_EVENT(libhls, segment_start,
+    TP_ARGS(const void*, session, int, seqNum, int, bitrate),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, seq_num, seqNum)
+        ctf_integer(int, bitrate, bitrate)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, first_byte,
+    TP_ARGS(const void*, session, int, type, int, bitrate),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, type, type)
+        ctf_integer(int, bitrate, bitrate)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, segment_complete,
+    TP_ARGS(const void*, session, int, seqNum, long, bytes, int, status),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, seq_num, seqNum)
+        ctf_integer(long, bytes, bytes)
+        ctf_integer(int, status, status)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, segment_push,
+    TP_ARGS(const void*, session, int, seqNum, long, bytes),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, seq_num, seqNum)
+        ctf_integer(long, bytes, bytes)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, playlist_reload_start,
+    TP_ARGS(const void*, session, const char*, url),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_string(url, url)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, playlist_reload_end,
+    TP_ARGS(const void*, session, int, status),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, status, status)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, playlist_lock,
+    TP_ARGS(const void*, session, int, bWrite, int, bContended),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, write, bWrite)
+        ctf_integer(int, contended, bContended)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, playlist_unlock,
+    TP_ARGS(const void*, session),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, abr_decision,
+    TP_ARGS(const void*, session, int, fromBitrate, int, toBitrate, int, bufferedMsecs, int, lastKbps, int, avgKbps),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, from_bitrate, fromBitrate)
+        ctf_integer(int, to_bitrate, toBitrate)
+        ctf_integer(int, buffered_msecs, bufferedMsecs)
+        ctf_integer(int, last_kbps, lastKbps)
+        ctf_integer(int, avg_kbps, avgKbps)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, player_get_buffer,
+    TP_ARGS(const void*, session, int, size, int, status),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, size, size)
+        ctf_integer(int, status, status)
+    )
+)
+
+TRACEPOINT_EVENT(libhls, player_send_buffer,
+    TP_ARGS(const void*, session, int, size, int, streamNum),
+    TP_FIELDS(
+        ctf_integer_hex(uintptr_t, session, (uintptr_t)session)
+        ctf_integer(int, size, size)
+        ctf_integer(int, stream_num, streamNum)
+    )
+)
+
+#endif
+
+#include <lttng/tracepoint-event.h>
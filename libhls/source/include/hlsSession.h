@@ -41,6 +41,11 @@ hlsStatus_t hlsSession_init(hlsSession_t** ppSession, void* pHandle);
 void hlsSession_term(hlsSession_t* pSession);
 
 hlsStatus_t hlsSession_setDataSource(hlsSession_t* pSession, char* playlistURL);
+hlsStatus_t hlsSession_setHeadless(hlsSession_t* pSession, int bHeadless);
+hlsStatus_t hlsSession_setPidFilter(hlsSession_t* pSession, int flags);
+hlsStatus_t hlsSession_setDecryption(hlsSession_t* pSession, int bDecrypt);
+hlsStatus_t hlsSession_setParallelConnections(hlsSession_t* pSession, int numConnections);
+hlsStatus_t hlsSession_setLendBuffer(hlsSession_t* pSession, srcPlayerLendBuffer_t lendBuffer);
 hlsStatus_t hlsSession_prepare(hlsSession_t* pSession);
 
 hlsStatus_t hlsSession_play(hlsSession_t* pSession);
@@ -63,6 +68,9 @@ hlsStatus_t hlsSession_getAudioLanguagesInfo(hlsSession_t* pSession,
                                              srcPluginAudioLangInfo_t audioLangInfoArr[],
                                              int *pAudioLangInfoArrSize);
 hlsStatus_t hlsSession_getAudioLanguage(hlsSession_t* pSession, char audioLanguage[]);
+hlsStatus_t hlsSession_getHealth(hlsSession_t* pSession, srcPluginHealth_t* pHealth);
+hlsStatus_t hlsSession_getStats(hlsSession_t* pSession, srcPluginStats_t* pStats);
+hlsStatus_t hlsSession_getLockStats(hlsSession_t* pSession, srcPluginLockStats_t* pLocks);
 void hlsSession_playerEvtCallback(hlsSession_t* pSession, srcPlayerEvt_t* pEvt);
 
 void hlsSession_printInfo(hlsSession_t* pSession);
@@ -36,6 +36,7 @@ extern "C" {
 #endif
 
 #include "hlsTypes.h"
+#include "hlsLockStats.h"
 
 hlsStatus_t getBestBitrate(hlsSession_t* pSession, int* pBitrate);
 
@@ -57,6 +58,12 @@ hlsStatus_t switchToNormalPlaylists(hlsSession_t* pSession);
 
 double ptsToSeconds(long long PTS);
 
+void playlistReadLockAt(hlsSession_t* pSession, const char* pSite);
+void playlistWriteLockAt(hlsSession_t* pSession, const char* pSite);
+#define playlistReadLock(pSession) playlistReadLockAt((pSession), HLS_LOCK_SITE)
+#define playlistWriteLock(pSession) playlistWriteLockAt((pSession), HLS_LOCK_SITE)
+void playlistUnlock(hlsSession_t* pSession);
+
 hlsPlaylist_t* newHlsPlaylist();
 hlsPlaylist_t* newHlsMediaPlaylist();
 void freePlaylist(hlsPlaylist_t* pPlaylist);
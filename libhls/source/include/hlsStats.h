@@ -0,0 +1,64 @@
+#ifndef HLSSTATS_H
+#define HLSSTATS_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsStats.h @date October 19, 2026
+ *
+ * Per-session performance counters and latency histograms.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+hlsStatus_t hlsStats_init(hlsSessionStats_t* pStats);
+void hlsStats_term(hlsSessionStats_t* pStats);
+
+void hlsStats_markDataSource(hlsSessionStats_t* pStats);
+void hlsStats_markPrepare(hlsSessionStats_t* pStats);
+int hlsStats_markStartup(hlsSessionStats_t* pStats, srcStartupPhase_t phase, srcPluginStartup_t* pStartup);
+void hlsStats_recordBuffer(hlsSessionStats_t* pStats, int streamNum, int size);
+void hlsStats_recordSegment(hlsSessionStats_t* pStats, float ttfb, float downloadTime);
+void hlsStats_recordSegmentRetry(hlsSessionStats_t* pStats);
+void hlsStats_recordSegmentError(hlsSessionStats_t* pStats);
+void hlsStats_recordPlaylistReload(hlsSessionStats_t* pStats, float reloadTime);
+void hlsStats_recordBitrateSwitch(hlsSessionStats_t* pStats);
+void hlsStats_recordPlaylistLockWait(hlsSessionStats_t* pStats, float waitTime);
+void hlsStats_recordStall(hlsSessionStats_t* pStats, int bNewStall, float stallTime);
+
+void hlsStats_recordLockAcquire(hlsSessionStats_t* pStats, srcLockId_t lock, int bContended, float waitTime);
+void hlsStats_recordLockHold(hlsSessionStats_t* pStats, srcLockId_t lock, float holdTime, const char* pSite);
+
+void hlsStats_get(hlsSessionStats_t* pStats, srcPluginStats_t* pCounters);
+void hlsStats_getLocks(hlsSessionStats_t* pStats, srcPluginLockStats_t* pLocks);
+void hlsStats_logLocks(hlsSessionStats_t* pStats, hlsSession_t* pSession);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
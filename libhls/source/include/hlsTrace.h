@@ -0,0 +1,107 @@
+#ifndef HLSTRACE_H
+#define HLSTRACE_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsTrace.h @date October 19, 2026
+ *
+ * Process-wide ring of per-transfer timing records.
+ *
+ * Every playlist, key and segment transfer appends one
+ * #hlsTraceRecord_t.  Once the ring is full the oldest records are
+ * overwritten.  The ring can be written out as JSON lines or in the
+ * following binary layout (native byte order):
+ *
+ *   #hlsTraceFileHeader_t
+ *   hlsTraceFileHeader_t::numRecords x #hlsTraceRecord_t, oldest first
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "hlsTypes.h"
+#include "sourcePlugin.h"
+
+#define HLS_TRACE_DEFAULT_RECORDS 1024          /*!< Default ring capacity */
+
+#define HLS_TRACE_FILE_MAGIC "HLSTRACE"         /*!< hlsTraceFileHeader_t::magic */
+#define HLS_TRACE_FILE_VERSION 1                /*!< hlsTraceFileHeader_t::version */
+
+/*! \enum hlsTraceType_t
+ * Kind of transfer a trace record describes
+ */
+typedef enum {
+    HLS_TRACE_NONE = 0,     /*!< Transfer is not traced */
+    HLS_TRACE_PLAYLIST,     /*!< Playlist download */
+    HLS_TRACE_KEY,          /*!< Key download */
+    HLS_TRACE_SEGMENT       /*!< Segment download */
+} hlsTraceType_t;
+
+/*! \struct hlsTraceRecord_t
+ * One transfer.  All times are in microseconds; apart from
+ * startTime they are measured from the start of the transfer, so
+ * each phase ends where the next begins (see CURLINFO_*_TIME).
+ * This is the on-disk record layout, so keep it fixed-size.
+ */
+typedef struct {
+    uint64_t startTime;         /*!< Wall clock time at which the transfer started (since the epoch) */
+    uint64_t session;           /*!< srcSessionId_t of the session the transfer belongs to; 0 if none */
+    int64_t  bytes;             /*!< Number of bytes received */
+    uint32_t type;              /*!< #hlsTraceType_t */
+    int32_t  bitrate;           /*!< Variant bitrate in bps; 0 if not applicable */
+    int32_t  httpStatus;        /*!< HTTP response code; 0 if none was received */
+    int32_t  result;            /*!< #hlsStatus_t of the transfer */
+    uint32_t nameLookupTime;    /*!< Time until DNS resolution completed */
+    uint32_t connectTime;       /*!< Time until the TCP connection was established */
+    uint32_t appConnectTime;    /*!< Time until the TLS handshake completed; 0 for plain HTTP */
+    uint32_t preTransferTime;   /*!< Time until the request was about to be sent */
+    uint32_t startTransferTime; /*!< Time until the first response byte was received */
+    uint32_t totalTime;         /*!< Total transfer time */
+} hlsTraceRecord_t;
+
+/*! \struct hlsTraceFileHeader_t
+ * Header of a binary trace file
+ */
+typedef struct {
+    char     magic[8];          /*!< HLS_TRACE_FILE_MAGIC, not NUL terminated */
+    uint32_t version;           /*!< HLS_TRACE_FILE_VERSION */
+    uint32_t recordSize;        /*!< sizeof(hlsTraceRecord_t) */
+    uint32_t numRecords;        /*!< Number of records that follow */
+    uint32_t reserved;
+} hlsTraceFileHeader_t;
+
+hlsStatus_t hlsTrace_init(int numRecords);
+void hlsTrace_term(void);
+
+void hlsTrace_add(hlsTraceRecord_t* pRecord);
+hlsStatus_t hlsTrace_dump(const char* filePath, srcTraceFormat_t format, srcSessionId_t sessionId);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
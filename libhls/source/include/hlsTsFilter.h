@@ -0,0 +1,80 @@
+#ifndef HLSTSFILTER_H
+#define HLSTSFILTER_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsTsFilter.h @date October 19, 2026
+ *
+ * In-place MPEG-TS PID filter for the main stream push path.
+ *
+ * The filter reads the PAT and PMT at the start of each segment and
+ * picks the elementary streams to drop according to the
+ * SRC_PID_FILTER_* flags of the session (see SRC_PLUGIN_SET_PID_FILTER).
+ * Packets of dropped PIDs are squeezed out of the buffer before it is
+ * sent, and the PMT is rewritten without them so that the demuxer
+ * downstream never expects them.
+ *
+ * Buffers must hold whole packets.  The filter passes data through
+ * unchanged if it loses packet sync or finds a PMT it can't rewrite
+ * (one spanning several packets).
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+#include "hlsTsScan.h"
+
+#define HLS_TS_FILTER_MAX_PIDS 16       /*!< Elementary streams that can be dropped */
+
+/*! \struct hlsTsFilter_t
+ * State of the filter over one segment
+ */
+typedef struct {
+    int flags;                  /*!< SRC_PID_FILTER_* flags in effect */
+    int bAlternateAudio;        /*!< TRUE if audio is coming from an alternate rendition */
+    char language[ISO_LANG_CODE_LEN + 1];   /*!< Audio language to keep, "" for any */
+
+    int bDisabled;              /*!< TRUE once the data can't be filtered */
+    int pmtPid;                 /*!< PID of the PMT, -1 until the PAT has been read */
+
+    int numDropPids;
+    int dropPids[HLS_TS_FILTER_MAX_PIDS];   /*!< PIDs squeezed out of the stream */
+
+    int bHavePmt;                               /*!< TRUE once pmtIn/pmtOut are valid */
+    unsigned char pmtIn[HLS_TS_PACKET_SIZE];    /*!< Last PMT packet as received */
+    unsigned char pmtOut[HLS_TS_PACKET_SIZE];   /*!< The same packet with the dropped streams removed */
+
+    long bytesDropped;          /*!< Bytes squeezed out so far */
+} hlsTsFilter_t;
+
+void hlsTsFilter_init(hlsTsFilter_t* pFilter, int flags, int bAlternateAudio, const char* pLanguage);
+long hlsTsFilter_apply(hlsTsFilter_t* pFilter, unsigned char* pData, long size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef HLSTSSCAN_H
+#define HLSTSSCAN_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsTsScan.h @date October 19, 2026
+ *
+ * Streaming MPEG-TS header scanner.
+ *
+ * Segments are fed to the scanner in whatever pieces they are handed
+ * to the player.  Only TS and PES headers are looked at: the scanner
+ * records the first and last PES PTS, the first PCR, adaptation field
+ * discontinuity indicators and continuity counter errors.  Data is
+ * read in place; the only copy is of a packet split across two pieces.
+ *
+ * Content that is not a transport stream (e.g. packed audio) is
+ * detected within HLS_TS_SCAN_SYNC_LIMIT bytes, after which the rest of
+ * the segment is ignored.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+#define HLS_TS_PACKET_SIZE 188          /*!< Size of a transport stream packet */
+#define HLS_TS_SYNC_BYTE 0x47           /*!< First byte of every TS packet */
+#define HLS_TS_SCAN_SYNC_LIMIT 1024     /*!< Bytes skipped looking for sync before giving up */
+#define HLS_TS_SCAN_MAX_PIDS 16         /*!< PIDs tracked for continuity counter errors */
+
+/*! \struct hlsTsScanPid_t
+ * Continuity counter state of one PID
+ */
+typedef struct {
+    int pid;
+    int lastCC;         /*!< Last continuity counter seen on this PID */
+} hlsTsScanPid_t;
+
+/*! \struct hlsTsScan_t
+ * State of a scan over one segment
+ */
+typedef struct {
+    unsigned char carry[HLS_TS_PACKET_SIZE];  /*!< Start of a packet split across two pieces */
+    int carryLength;                            /*!< Bytes held in carry */
+
+    int bSynced;            /*!< TRUE while the data lines up on packet boundaries */
+    int bNotTs;             /*!< TRUE once the data is known not to be a transport stream */
+    long skipped;           /*!< Bytes skipped looking for a sync byte */
+
+    int numPids;
+    hlsTsScanPid_t pids[HLS_TS_SCAN_MAX_PIDS];
+
+    /*! PTS of the first PES header in the segment (90kHz), INVALID_PTS
+        until one has been seen.  Like #hlsSession_t::lastPTS this MUST be
+        64 bits */
+    long long firstPts;
+    long long lastPts;      /*!< PTS of the most recent PES header, INVALID_PTS if none */
+    long long firstPcr;     /*!< First PCR base (90kHz), INVALID_PTS if none */
+
+    unsigned int numPackets;        /*!< Packets scanned */
+    unsigned int numDiscontinuities;/*!< Packets with the discontinuity indicator set */
+    unsigned int numCCErrors;       /*!< Unexpected continuity counter values */
+} hlsTsScan_t;
+
+void hlsTsScan_init(hlsTsScan_t* pScan);
+void hlsTsScan_feed(hlsTsScan_t* pScan, const unsigned char* pData, long size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -102,8 +102,26 @@ extern "C" {
 /*! Maximum supported HLS playlist version */
 #define MAX_SUPPORTED_PL_VERSION 4
 
-/*! Maximum number of simultaneous HLS sessions */
+/*! Default maximum number of simultaneous HLS sessions.  Can be
+    overridden at runtime via the HLS_MAX_SESSIONS environment variable,
+    which is read in hlsPlugin_initialize() */
+#ifndef MAX_SESSIONS
 #define MAX_SESSIONS 3
+#endif
+
+/*! Default number of worker pool threads kept alive for the life of the
+    plugin.  Can be overridden via the HLS_WORKER_THREADS environment variable */
+#ifndef HLS_MIN_WORKER_THREADS
+#define HLS_MIN_WORKER_THREADS 4
+#endif
+
+/*! Upper bound on worker pool threads.  The pool grows past
+    HLS_MIN_WORKER_THREADS only while every worker is busy with a blocking
+    transfer.  Can be overridden via the HLS_MAX_WORKER_THREADS environment
+    variable */
+#ifndef HLS_MAX_WORKER_THREADS
+#define HLS_MAX_WORKER_THREADS 64
+#endif
 
 /*! Local storage path */
 #define LOCAL_PATH "/tmp/HLS/"
@@ -337,6 +355,11 @@ typedef struct {
     long byteLength;     /*!< Byte length of segment (from EXT-X-BYTERANGE) */
     long byteOffset;     /*!< Byte offset of segment (from EXT-X-BYTERANGE) */
 
+    /*! PTS of the first PES header in the segment data (90kHz), set by
+        downloadAndPushSegment().  INVALID_PTS if the segment was encrypted
+        or not a transport stream. */
+    long long firstPts;
+
     /*! Pointer to the parent node when this structure is contained in the
         llNode_t::pData field */
     llNode_t* pParentNode;
@@ -398,6 +421,160 @@ typedef enum {
     PBC_NUM_SIGNALS
 } playbackControllerSignal_t;
 
+/*! \enum hlsTaskResult_t
+ * Return value of a #hlsTaskFunc_t step function
+ */
+typedef enum {
+    HLS_TASK_RESCHEDULE,    /*!< Run the task again at the time written to pNextRunTime */
+    HLS_TASK_DONE           /*!< Task has finished and will not be run again */
+} hlsTaskResult_t;
+
+/*! Step function run by a worker pool thread.  Performs one unit of
+    work for pArg and either asks to be rescheduled at the absolute
+    hlsClock_now() time in *pNextRunTime or reports that it is done. */
+typedef hlsTaskResult_t (*hlsTaskFunc_t)(void* pArg, struct timespec* pNextRunTime);
+
+/*! \struct hlsTask_t
+ * A unit of work scheduled on the shared worker pool (see hlsWorkerPool.h).
+ * All members other than pFunc/pArg are owned by the pool and protected
+ * by the pool mutex.
+ */
+typedef struct hlsTask_t_
+{
+    hlsTaskFunc_t pFunc;        /*!< Step function */
+    void* pArg;                 /*!< Argument passed to pFunc */
+    struct timespec runTime;    /*!< Absolute time at which the task is next due */
+    int bScheduled;             /*!< TRUE while the task is in the run queue */
+    int bRunning;               /*!< TRUE while a worker is executing pFunc */
+    int bWakePending;           /*!< Task was woken while running; rerun immediately */
+    pthread_t runner;           /*!< Worker thread executing pFunc, valid while bRunning */
+    struct hlsTask_t_* pNext;   /*!< Next task in the run queue */
+} hlsTask_t;
+
+/*! Number of buffers a null sink can lend out at once (main stream + media groups) */
+#define NULL_SINK_NUM_BUFFERS (MAX_NUM_MEDIA_GROUPS + 1)
+
+/*! \struct hlsNullSink_t
+ * Built-in player stand-in used by headless sessions.  Consumes
+ * buffers without touching their contents and generates PTS
+ * progress from the wall clock, so that the buffer level and ABR
+ * logic behave as if the content were being played in real time.
+ */
+typedef struct {
+    /*! Protects all other members */
+    pthread_mutex_t mutex;
+
+    /*! Scratch buffers lent out by getBuffer(), allocated on first use */
+    char* pBuffers[NULL_SINK_NUM_BUFFERS];
+
+    /*! TRUE while the matching entry of pBuffers is lent out */
+    int bBufferInUse[NULL_SINK_NUM_BUFFERS];
+
+    /*! Mode last set via SRC_PLAYER_SET_MODE */
+    srcPlayerMode_t mode;
+
+    /*! TRUE while synthetic PTS is advancing */
+    int bClockRunning;
+
+    /*! Time of the last clock update */
+    struct timespec lastTick;
+
+    /*! Synthetic 90kHz PTS, wraps at PTS_LIMIT */
+    long long pts;
+
+    /*! TRUE while playback is starved of data */
+    int bStalled;
+
+    /*! TRUE once playback has run through the end of the media */
+    int bDrained;
+
+    unsigned long long bytesConsumed;   /*!< Bytes consumed across all streams */
+    unsigned int segmentsConsumed;      /*!< Main stream segments consumed */
+
+    /*! Time at which data was last consumed, valid once bytesConsumed > 0 */
+    struct timespec lastDataTime;
+} hlsNullSink_t;
+
+/*! \struct hlsSessionStats_t
+ * Per-session performance counters, see hlsStats.c
+ */
+typedef struct {
+    /*! Protects all other members */
+    pthread_mutex_t mutex;
+
+    /*! Counters and histograms in the form returned to the player */
+    srcPluginStats_t counters;
+
+    /*! Time of the last hlsSession_prepare() */
+    struct timespec prepareTime;
+
+    /*! TRUE from prepare until the first buffer is delivered */
+    int bWaitingForFirstBuffer;
+
+    /*! Time of the last hlsSession_setDataSource(), counters.startup is relative to it */
+    struct timespec startupBase;
+
+    /*! Lock contention counters, see hlsLockStats.h */
+    srcPluginLockStats_t locks;
+} hlsSessionStats_t;
+
+/*! Number of decryption keys a session remembers */
+#define HLS_KEY_CACHE_SIZE 16
+
+/*! State of a #hlsKeyCacheEntry_t */
+typedef enum {
+    HLS_KEY_EMPTY,          /*!< Entry is unused */
+    HLS_KEY_PENDING,        /*!< Key is waiting to be fetched */
+    HLS_KEY_FETCHING,       /*!< Key is being fetched */
+    HLS_KEY_READY,          /*!< Key is available */
+    HLS_KEY_FAILED          /*!< Last fetch of the key failed */
+} hlsKeyState_t;
+
+/*! \struct hlsKeyCacheEntry_t
+ * One EXT-X-KEY URI and its key
+ */
+typedef struct {
+    char* keyURI;               /*!< Absolute key URI, NULL if the entry is empty */
+    char key[16];               /*!< Key, valid in HLS_KEY_READY */
+    hlsKeyState_t state;
+    unsigned int lastUse;       /*!< Cache use count at the last lookup, for LRU eviction */
+} hlsKeyCacheEntry_t;
+
+/*! \struct hlsKeyCache_t
+ * Per-session cache of AES-128 keys.  Keys are fetched ahead of
+ * the segments that need them by a single worker pool task which
+ * keeps its own CURL handle, and so its connection, across
+ * fetches.  See hlsKeyCache.c.
+ */
+typedef struct {
+    /*! Protects all other members except pCurl, which only the fetch task uses */
+    pthread_mutex_t mutex;
+
+    /*! Broadcast whenever a fetch completes */
+    pthread_cond_t fetchCond;
+
+    /*! Fetch task, scheduled on first use */
+    hlsTask_t task;
+    int bTaskScheduled;
+
+    /*! Tells the fetch task to exit */
+    int bStop;
+
+    /*! Handle used for all key fetches, created by the fetch task */
+    CURL* pCurl;
+
+    /*! Session counters and trace owner */
+    hlsSessionStats_t* pStats;
+    void* pSession;
+
+    unsigned int useCount;      /*!< Number of lookups so far */
+    hlsKeyCacheEntry_t entries[HLS_KEY_CACHE_SIZE];
+} hlsKeyCache_t;
+
+/*! Consecutive EXT-X-BYTERANGE segments fetched with one request,
+    see hlsDownloaderUtils.c */
+typedef struct hlsRangeRun_t_ hlsRangeRun_t;
+
 /*! \struct hlsGrpDwnldData_t
  * Data passed to the media group downloader threads
  */
@@ -414,6 +591,9 @@ typedef struct {
     /*! Unique session handle passed by player in session open() call */
     void* pHandle;
 
+    /*! Handle hlsPlugin_open() gave the player for this session */
+    srcSessionId_t sessionId;
+
     char* sessionName;  /*!< Human-readable unique session name */
 
     /*! Handle to a CURL object which will be used for all CURL operations. */
@@ -429,6 +609,14 @@ typedef struct {
     /*! Mutex to protect the mediagroup curl object */
     pthread_mutex_t mediaGroupCurlMutex[MAX_NUM_MEDIA_GROUPS];
 
+    /*! Extra curl objects for parallel segment downloads, created on
+        first use; only used by the main stream downloader thread */
+    CURL* pParallelCurl[SRC_MAX_PARALLEL_CONNECTIONS - 1];
+
+    /*! Curl object for coalesced byte range requests, created on first
+        use; only used by the range request task */
+    CURL* pRangeRunCurl;
+
     //TODO: clarify the below...
 
     /* Read/write lock to protect access to:
@@ -494,12 +682,19 @@ typedef struct {
 
     double timeBuffered; /*!< Current buffer level for this session (seconds) */
 
-    /* Parser thread */
-    pthread_t parser;                   /*!< Parser thread handle */
-    hlsStatus_t parserStatus;           /*!< Parser thread status */
-    int bKillParser;                    /*!< Parser thread kill signal*/
-    pthread_mutex_t parserWakeMutex;    /*!< Parser thread wake mutex */
-    pthread_cond_t parserWakeCond;      /*!< Parser thread wake condition */
+    /*! First PTS and EXTINF duration of the last main stream segment pushed
+        to the player.  Used to correct #timeBuffered by the real PTS span of
+        that segment once the next one is pushed.  -1 if unknown. */
+    long long lastSegmentPts;
+    double lastSegmentDuration;
+
+    /* Parser task */
+    hlsTask_t parserTask;               /*!< Parser task scheduled on the worker pool */
+    hlsStatus_t parserStatus;           /*!< Parser task status */
+    int bKillParser;                    /*!< Parser task kill signal*/
+    int bInitialParseDone;              /*!< TRUE once the parser task has moved us to HLS_PREPARED */
+    pthread_mutex_t parserWakeMutex;    /*!< Parser wake mutex (interrupts playlist download retries) */
+    pthread_cond_t parserWakeCond;      /*!< Parser wake condition (interrupts playlist download retries) */
 
     /* Downloader thread */
     pthread_t downloader;                   /*!< Downloader thread handle */
@@ -513,20 +708,79 @@ typedef struct {
     hlsStatus_t groupDownloaderStatus[MAX_NUM_MEDIA_GROUPS];  /*!< Media group downloader thread status */
     hlsGrpDwnldData_t grpThreadData[MAX_NUM_MEDIA_GROUPS];    /*!< Media group downloader thread param */
 
-    /* Playback Controller thread */
-    pthread_t playbackController;                   /*!< Playback controller thread handle */
-    hlsStatus_t playbackControllerStatus;           /*!< Playback controller thread status */
-    int bKillPlaybackController;                    /*!< Playback controller thread kill signal */
-    pthread_mutex_t playbackControllerWakeMutex;    /*!< Playback controller thread wake mutex */
-    pthread_cond_t playbackControllerWakeCond;      /*!< Playback controller thread wake condition */
+    /* Playback Controller task */
+    hlsTask_t playbackControllerTask;               /*!< Playback controller task scheduled on the worker pool */
+    hlsStatus_t playbackControllerStatus;           /*!< Playback controller task status */
+    int bKillPlaybackController;                    /*!< Playback controller task kill signal */
+    int bPbcRestartPlayback;                        /*!< Playback controller is trying to force a resume from pause */
+    int bPbcWaitForPlaybackCompletion;              /*!< Playback controller is waiting for the player to drain before EOF */
+
+    msgQueue_t* playbackControllerMsgQueue; /*!< Playback controller task message queue */
+
+    /*! Built-in player stand-in; non-NULL if the session is headless */
+    hlsNullSink_t* pNullSink;
+
+    /*! Player function to lend data with; NULL to copy it (see SRC_PLUGIN_SET_LEND_BUFFER) */
+    srcPlayerLendBuffer_t lendBuffer;
+
+    /*! srcPidFilter_t flags applied to main stream segments (see SRC_PLUGIN_SET_PID_FILTER) */
+    int pidFilter;
+
+    /*! TRUE to decrypt AES-128-CBC segments in the library (see SRC_PLUGIN_SET_DECRYPTION) */
+    int bDecrypt;
 
-    msgQueue_t* playbackControllerMsgQueue; /*!< Playback controller thread message queue */
+    /*! Keys of encrypted segments */
+    hlsKeyCache_t* pKeyCache;
+
+    /*! Main stream range request in progress; only used by the downloader thread */
+    hlsRangeRun_t* pRangeRun;
+
+    /*! TRUE once the server ignored a range request; byte ranges are then
+        downloaded one segment at a time.  Only used by the downloader thread */
+    int bNoRangeRuns;
+
+    /*! Connections to download a main stream segment over (see SRC_PLUGIN_SET_PARALLEL_CONNECTIONS) */
+    int numConnections;
+
+    /*! Performance counters */
+    hlsSessionStats_t stats;
 
     int eofCount; /*!< count of eof recieved from the downloader thread(s) */
     char audioLanguageISOCode[ISO_LANG_CODE_LEN + 1];
 
 } hlsSession_t;
 
+/*! \struct hlsSessionSlot_t
+ * One entry of the plugin session table.  The srcSessionId_t handed to
+ * the player encodes the slot index and generation (see hlsPlugin.c),
+ * so lookups are O(1) and handles of closed sessions are rejected once
+ * the generation moves on.
+ *
+ * @ingroup hlsPlugin
+ */
+typedef struct {
+    /*! Protects all other members of this slot */
+    pthread_mutex_t mutex;
+
+    /*! Signalled when inUse drops to zero while bClosing is set */
+    pthread_cond_t idleCond;
+
+    /*! Session occupying this slot, NULL if free */
+    hlsSession_t* pSession;
+
+    /*! Incremented every time the slot is released */
+    unsigned int generation;
+
+    /*! Number of plugin API calls currently using pSession */
+    int inUse;
+
+    /*! TRUE while hlsPlugin_close() is waiting for inUse to drain */
+    int bClosing;
+
+    /*! Next free slot when on the free list; -1 terminates the list */
+    int nextFree;
+} hlsSessionSlot_t;
+
 /*! \struct hlsPlugin_t
  * Describes an instance of the HLS plugin
  *
@@ -546,8 +800,17 @@ typedef struct {
     /*! Callback function for plugin errors registered via hlsPlugin_registerCB() */
     pluginErrCallback_t pluginErrCallback;
 
-    /*! Array of session handles */
-    hlsSession_t* hlsSessions[MAX_SESSIONS];
+    /*! Session table, maxSessions entries long */
+    hlsSessionSlot_t* sessionSlots;
+
+    /*! Maximum number of simultaneous sessions, fixed at hlsPlugin_initialize() */
+    int maxSessions;
+
+    /*! Mutex protecting freeSlotHead, the free list links and activeSessions */
+    pthread_mutex_t sessionTableMutex;
+
+    /*! Index of the first free entry in sessionSlots; -1 if the table is full */
+    int freeSlotHead;
 
     /*! Number of active sessions*/
     int activeSessions;
@@ -0,0 +1,53 @@
+#ifndef HLSWORKERPOOL_H
+#define HLSWORKERPOOL_H
+/*
+    LIBBHLS
+    Copyright (C) {2015}  {Cisco System}
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+    USA
+
+    Contributing Authors: Saravanakumar Periyaswamy, Patryk Prus, Tankut Akgul
+
+*/
+
+/**
+ * @file hlsWorkerPool.h @date October 19, 2026
+ *
+ * Shared worker pool on which the per-session parser, playback
+ * controller and segment download tasks are scheduled.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "hlsTypes.h"
+
+hlsStatus_t hlsWorkerPool_init(int minWorkers, int maxWorkers);
+void hlsWorkerPool_term(void);
+
+hlsStatus_t hlsWorkerPool_schedule(hlsTask_t* pTask, hlsTaskFunc_t pFunc, void* pArg);
+hlsStatus_t hlsWorkerPool_wake(hlsTask_t* pTask);
+hlsStatus_t hlsWorkerPool_wait(hlsTask_t* pTask);
+int hlsWorkerPool_isCurrent(hlsTask_t* pTask);
+
+void hlsWorkerPool_getCounts(int* pNumWorkers, int* pNumIdle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
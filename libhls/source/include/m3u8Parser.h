@@ -47,7 +47,7 @@ typedef enum
    ATTRIB_AUTOSELECT
 }mediaAttrib_t;
 
-void m3u8ParserThread(hlsSession_t* pSession);
+hlsTaskResult_t m3u8ParserTask(void* pArg, struct timespec* pNextRunTime);
 
 hlsStatus_t findAudioGroup(hlsSession_t *pSession, hlsGroup_t **ppGroupOut);
 
@@ -49,6 +49,8 @@ extern "C" {
 
 #define ISO_LANG_CODE_LEN (3)
 
+#define SRC_MAX_PARALLEL_CONNECTIONS (8) /*!< Maximum value of SRC_PLUGIN_SET_PARALLEL_CONNECTIONS */
+
 /*!
 * Unique souce plugin session identifier
 */
@@ -124,6 +126,184 @@ typedef struct
    srcPluginAudioLangInfo_t *audioLangInfoArr; /*!< Input - empty array. Output - Info about available audio languages */
 }srcPluginAudioLanguages_t;
 
+/*! \struct srcPluginHealth_t
+ * Session health summary returned by SRC_PLUGIN_GET_HEALTH.  The
+ * consumption figures and stallTime are only tracked for headless
+ * sessions and are 0 otherwise.
+ */
+typedef struct
+{
+   int                bHeadless;           /*!< 1 - session is headless (see SRC_PLUGIN_SET_HEADLESS) */
+   int                bPlaying;            /*!< 1 - session is currently playing */
+   int                currentBitrate;      /*!< Bitrate currently being downloaded, in bps; 0 if not yet prepared */
+   unsigned int       numBitrateSwitches;  /*!< Bitrate switches since the session was opened */
+   float              bufferLevel;         /*!< Media buffered ahead of the play position, in seconds */
+   float              position;            /*!< Current position, in ms */
+   unsigned long long bytesConsumed;       /*!< Bytes consumed across all streams */
+   unsigned int       segmentsConsumed;    /*!< Main stream segments consumed */
+   unsigned int       numStalls;           /*!< Number of times playback ran out of data */
+   float              stallTime;           /*!< Total time spent stalled, in seconds */
+   float              timeSinceLastData;   /*!< Seconds since data was last consumed; -1 if none yet */
+
+} srcPluginHealth_t;
+
+#define SRC_STATS_MAX_STREAMS (4)          /*!< Number of streams bytesPerStream[] is kept for */
+#define SRC_STATS_HISTOGRAM_BUCKETS (12)   /*!< Number of buckets in a #srcStatsHistogram_t */
+#define SRC_STATS_HISTOGRAM_BASE_MS (8)    /*!< Upper bound of the first histogram bucket, in ms */
+
+/*! \struct srcStatsHistogram_t
+ * Fixed-bucket latency histogram.  Bucket i counts samples below
+ * (SRC_STATS_HISTOGRAM_BASE_MS << i) ms that did not fit in bucket
+ * i-1; the last bucket counts everything above that.
+ */
+typedef struct
+{
+   unsigned int count[SRC_STATS_HISTOGRAM_BUCKETS];  /*!< Samples per bucket */
+   unsigned int numSamples;                          /*!< Total number of samples */
+   float        sum;                                 /*!< Sum of all samples, in ms */
+   float        max;                                 /*!< Largest sample, in ms */
+
+} srcStatsHistogram_t;
+
+/*! \enum srcStartupPhase_t
+ * Milestones between SRC_PLUGIN_SET_DATA_SOURCE and the start of
+ * playback, see #srcPluginStartup_t
+ */
+typedef enum
+{
+   SRC_STARTUP_DATA_SOURCE,        /*!< Data source set; always at 0 */
+   SRC_STARTUP_PREPARE,            /*!< prepare() called */
+   SRC_STARTUP_VARIANT_PLAYLIST,   /*!< Variant playlist downloaded and parsed; not reached if the data source is a media playlist */
+   SRC_STARTUP_MEDIA_PLAYLIST,     /*!< First media playlist downloaded and parsed */
+   SRC_STARTUP_AUDIO_PLAYLIST,     /*!< Alternate audio playlist downloaded and parsed; not reached without an audio group */
+   SRC_STARTUP_KEY,                /*!< First decryption key downloaded; not reached for clear content */
+   SRC_STARTUP_FIRST_BYTE,         /*!< First byte of the first segment received */
+   SRC_STARTUP_FIRST_BUFFER,       /*!< First buffer sent to the player */
+   SRC_STARTUP_PLAYING,            /*!< Session started playing */
+
+   SRC_STARTUP_PHASE_COUNT
+
+} srcStartupPhase_t;
+
+/*! \struct srcPluginStartup_t
+ * Startup timeline of a session, from the last SRC_PLUGIN_SET_DATA_SOURCE.
+ * Each milestone is recorded the first time it is reached.
+ */
+typedef struct
+{
+   double             startTime;   /*!< hlsClock time (CLOCK_MONOTONIC, sped up by HLS_CLOCK_SCALE if set) the data
+                                        source was set, in seconds; 0 if it has not been */
+   float              phaseTime[SRC_STARTUP_PHASE_COUNT];  /*!< hlsClock time of each milestone after startTime, in ms,
+                                                                indexed by #srcStartupPhase_t; -1 if not reached */
+
+} srcPluginStartup_t;
+
+/*! \struct srcPluginStats_t
+ * Session performance counters returned by SRC_PLUGIN_GET_STATS.
+ * Counters accumulate from the time the session is opened.
+ */
+typedef struct
+{
+   unsigned int        numSegments;          /*!< Segments downloaded */
+   unsigned int        numSegmentRetries;    /*!< Segment downloads resumed after a network error */
+   unsigned int        numSegmentErrors;     /*!< Segment downloads that failed */
+   unsigned long long  bytesPerStream[SRC_STATS_MAX_STREAMS]; /*!< Bytes delivered, indexed by srcBufferMetadata_t::streamNum */
+   unsigned int        numPlaylistReloads;   /*!< Live playlist reloads */
+   unsigned int        numBitrateSwitches;   /*!< Bitrate switches */
+   unsigned int        numStalls;            /*!< Times playback ran out of data */
+   float               stallTime;            /*!< Total time spent stalled, in seconds (headless sessions only) */
+   float               timeToFirstBuffer;    /*!< Time from the last prepare() to the first buffer delivered, in ms; -1 if none yet */
+   float               lastSegmentDldRate;   /*!< Throughput of the last segment download, in bps */
+   float               avgSegmentDldRate;    /*!< Weighted average segment throughput, in bps */
+   srcStatsHistogram_t segmentTTFB;          /*!< Segment time to first byte */
+   srcStatsHistogram_t segmentDownloadTime;  /*!< Segment total download time */
+   srcStatsHistogram_t playlistReloadTime;   /*!< Live playlist reload (download and parse) time */
+   srcStatsHistogram_t playlistLockWait;     /*!< Time spent waiting for the playlist lock when it was already held */
+   srcPluginStartup_t  startup;              /*!< Startup timeline; also sent with SRC_PLUGIN_STARTUP_COMPLETE */
+
+} srcPluginStats_t;
+
+/*! \enum srcLockId_t
+ * Session locks reported by SRC_PLUGIN_GET_LOCK_STATS
+ */
+typedef enum
+{
+   SRC_LOCK_PLAYLIST,          /*!< Playlist read/write lock */
+   SRC_LOCK_CURL,              /*!< Main curl handle */
+   SRC_LOCK_MEDIA_GROUP_CURL,  /*!< Media group curl handles, all groups together */
+   SRC_LOCK_PLAYER_EVT,        /*!< Player event callback */
+   SRC_LOCK_STATE,             /*!< Session state */
+   SRC_LOCK_SET,               /*!< srcPluginSet() operations */
+
+   SRC_LOCK_COUNT
+
+} srcLockId_t;
+
+#define SRC_LOCK_SITE_LEN (48)   /*!< Size of srcLockStats_t::longestHoldSite, including the '\0' */
+
+/*! \struct srcLockStats_t
+ * Contention counters for one session lock.  A recursive or shared
+ * acquisition is timed from the first acquisition by the thread to
+ * its last release.
+ */
+typedef struct
+{
+   unsigned int        numAcquired;      /*!< Acquisitions */
+   unsigned int        numContended;     /*!< Acquisitions that had to wait because the lock was held */
+   srcStatsHistogram_t waitTime;         /*!< Time spent waiting, contended acquisitions only */
+   srcStatsHistogram_t holdTime;         /*!< Time the lock was held */
+   char                longestHoldSite[SRC_LOCK_SITE_LEN]; /*!< "file:line" that took the lock for holdTime.max */
+
+} srcLockStats_t;
+
+/*! \struct srcPluginLockStats_t
+ * Session lock contention counters returned by SRC_PLUGIN_GET_LOCK_STATS.
+ * They are only kept if the library was configured with
+ * --enable-lock-stats; otherwise bEnabled is 0 and everything else is 0.
+ */
+typedef struct
+{
+   int                 bEnabled;                /*!< 1 - the library keeps lock statistics */
+   srcLockStats_t      locks[SRC_LOCK_COUNT];   /*!< Indexed by #srcLockId_t */
+
+} srcPluginLockStats_t;
+
+/*! \enum srcTraceFormat_t
+ * File formats for SRC_PLUGIN_SET_TRACE_DUMP
+ */
+typedef enum
+{
+   SRC_TRACE_FORMAT_BINARY,    /*!< Header followed by fixed-size records, see hlsTrace.h */
+   SRC_TRACE_FORMAT_JSON       /*!< One JSON object per line */
+
+} srcTraceFormat_t;
+
+/*! \struct srcPluginTraceDump_t
+ * Parameters for SRC_PLUGIN_SET_TRACE_DUMP
+ */
+typedef struct
+{
+   char*              filePath;  /*!< File to write the trace to; overwritten if it exists */
+   srcTraceFormat_t   format;    /*!< Format to write the trace in */
+
+} srcPluginTraceDump_t;
+
+/*! \enum srcPidFilter_t
+ * Flags for SRC_PLUGIN_SET_PID_FILTER.  They select elementary streams
+ * the plugin drops from clear MPEG-TS main stream segments before
+ * sending them to the player.
+ */
+typedef enum
+{
+   SRC_PID_FILTER_NONE        = 0,      /*!< Send the main stream unchanged */
+   SRC_PID_FILTER_MUXED_AUDIO = 1 << 0, /*!< Drop muxed audio while an alternate audio rendition is playing
+                                             (see SRC_PLAYER_SET_DISABLE_MAIN_STREAM_AUDIO) */
+   SRC_PID_FILTER_LANGUAGES   = 1 << 1, /*!< Of several muxed audio streams, keep only the one in the current
+                                             audio language, or the first one */
+   SRC_PID_FILTER_DATA        = 1 << 2  /*!< Drop private section and DSM-CC streams */
+
+} srcPidFilter_t;
+
 /*
  *
  * GET/SET OPERATIONS ON PLUGIN
@@ -142,6 +322,24 @@ typedef enum
     SRC_PLUGIN_SET_MIN_BITRATE,     /*!< pData -> int* containg the minimum bitrate, in bps */
     SRC_PLUGIN_SET_TARGET_BITRATE,  /*!< pData -> int* containg the target bitrate, in bps */
     SRC_PLUGIN_SET_AUDIO_LANGUAGE,  /*!< pData -> char* containg the audio language ISO code */
+    SRC_PLUGIN_SET_HEADLESS,        /*!< pData -> int* ; 1 - consume data internally instead of sending it to the
+                                                         player, 0 - use the player. Only valid before prepare() */
+    SRC_PLUGIN_SET_TRACE_DUMP,      /*!< pData -> srcPluginTraceDump_t* ; writes the transfer trace of the session
+                                                         (playlist, key and segment download timings) to a file */
+    SRC_PLUGIN_SET_PID_FILTER,      /*!< pData -> int* ; OR of srcPidFilter_t flags, SRC_PID_FILTER_NONE by default.
+                                                         Takes effect from the next segment */
+    SRC_PLUGIN_SET_DECRYPTION,      /*!< pData -> int* ; 1 - decrypt AES-128-CBC segments in the plugin and send the
+                                                         player clear data, 0 - leave decryption to the player (default).
+                                                         Fails with SRC_PLUGIN_ERR_UNSUPPORTED if the plugin was built
+                                                         without decryption support. Takes effect from the next segment */
+    SRC_PLUGIN_SET_PARALLEL_CONNECTIONS, /*!< pData -> int* ; 1 to SRC_MAX_PARALLEL_CONNECTIONS. Large main stream
+                                                         segments are split into that many byte ranges, downloaded in
+                                                         parallel over separate connections. 1 (default) downloads each
+                                                         segment over a single connection. Takes effect from the next
+                                                         segment */
+    SRC_PLUGIN_SET_LEND_BUFFER,     /*!< pData -> srcPlayerLendBuffer_t* ; function to lend the player data with
+                                                         instead of copying it into getBuffer() buffers, NULL (default)
+                                                         to copy. Only valid before prepare() */
     SRC_PLUGIN_SET_END
 
 } srcPluginSetCode_t;
@@ -174,6 +372,9 @@ typedef enum
     SRC_PLUGIN_GET_NUM_AUDIO_LANGUAGES, /*!< pData -> int* ; will contain number of available audio languages */
     SRC_PLUGIN_GET_AUDIO_LANGUAGES_INFO, /*!< pData -> srcPluginAudioLangInfo_t*; will contain info about audio languages */
     SRC_PLUGIN_GET_AUDIO_LANGUAGE,  /*!< pData -> char*; containing the current audio language ISO code */
+    SRC_PLUGIN_GET_HEALTH,          /*!< pData -> srcPluginHealth_t* ; will contain the session health summary */
+    SRC_PLUGIN_GET_STATS,           /*!< pData -> srcPluginStats_t* ; will contain the session performance counters */
+    SRC_PLUGIN_GET_LOCK_STATS,      /*!< pData -> srcPluginLockStats_t* ; will contain the session lock contention counters */
 
     SRC_PLUGIN_GET_END
 
@@ -300,7 +501,9 @@ typedef struct
    int          streamNum;         /*!< stream number */
    int          totalNumStreams;   /*!< main stream + discrete streams */
    int          bFirstBufferInSegment; /*!< first buffer in a HLS segment? */
-   long long    pts;                   /*!< pts from ID3 tag for audio elementary streams */
+   long long    pts;                   /*!< pts (90kHz) from the ID3 tag of an audio elementary stream, or of
+                                            the first PES header in a clear TS segment (set on the
+                                            buffer holding that header only); INVALID_PTS if none */
 
 } srcBufferMetadata_t;
 
@@ -317,6 +520,7 @@ typedef enum
    SRC_PLUGIN_BOS,               /*!< Indicates plugin has paused at beginning of stream (floating start position); pData not used */
    SRC_PLUGIN_EOF,               /*!< Indicates plugin has paused at end of file (fixed end position); pData not used */
    SRC_PLUGIN_EOS,               /*!< Indicates plugin has paused at end of stream (floating end position); pData not used */
+   SRC_PLUGIN_STARTUP_COMPLETE,  /*!< Indicates the session has started playing; pData returned as srcPluginStartup_t* */
 } srcPluginEvtCode_t;
 
 /*! \struct srcPluginEvt_t
@@ -624,6 +828,54 @@ typedef struct
    size_t size;           /*!< Size of the memory block pointed by pMem */
 }srcPlayerMem_t;
 
+/**
+ * Returns a buffer lent with a #srcPlayerLendBuffer_t to the
+ * plugin.
+ *
+ * @param pReleaseData - the pReleaseData passed to the
+ *                     #srcPlayerLendBuffer_t
+ */
+typedef void (*srcBufferRelease_t)( void* pReleaseData );
+
+/**
+ * Lend a filled buffer to the player
+ *
+ * Called by the plugin to hand the player data that lives in the
+ * plugin's own memory, instead of copying it into a buffer
+ * obtained with srcPlayerFunc_t::getBuffer().  A player that
+ * supports lending registers its function of this type on each
+ * session with SRC_PLUGIN_SET_LEND_BUFFER; sessions without one
+ * use getBuffer() and sendBuffer().
+ *
+ * @param pHandle - session identifier passed into the plugin in
+ *                the srcPluginFunc_t::open() call
+ * @param buffer - the data to lend, which the player MUST NOT
+ *               modify
+ * @param size - pointer to the amount of data in buffer; the
+ *             player sets it to 0 if it has no room for the data
+ *             right now, the same as getBuffer() returning a size
+ *             of 0
+ * @param metadata - pointer to #srcBufferMetadata_t providing
+ *                 various information related to this chunk of
+ *                 data
+ * @param release - function the player MUST call exactly once,
+ *                from any thread, when it is done with buffer
+ * @param pReleaseData - argument to pass to release()
+ *
+ * @pre
+ *       - session has been created via srcPluginFunc_t::open()
+ *
+ * @post
+ *       - if the player set *size to 0 the plugin keeps the data
+ *         and release() is never called
+ *       - otherwise, SRC_ERROR included, the player owns the
+ *         data until it calls release()
+ *
+ * @return #srcStatus_t
+ */
+typedef srcStatus_t (*srcPlayerLendBuffer_t)( void* pHandle, char* buffer, int* size, srcBufferMetadata_t* metadata,
+                                              srcBufferRelease_t release, void* pReleaseData );
+
 /*! \struct srcPlayerFunc_t
  * Structure that contains pointers to functions that a plugin may call on the player.
 */
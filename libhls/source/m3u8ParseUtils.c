@@ -50,6 +50,12 @@ extern "C" {
 
 #include "m3u8ParseUtils.h"
 #include "curlUtils.h"
+#include "hlsWorkerPool.h"
+#include "hlsProbes.h"
+#include "hlsClock.h"
+#include "hlsLockStats.h"
+#include "hlsStats.h"
+#include "hlsKeyCache.h"
 
 #include "debug.h"
 
@@ -79,14 +85,14 @@ const char *m3u8TagStrings[NUM_SUPPORTED_TAGS] =
 /* Local function prototypes */
 hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession);
 
-static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedirectURL, hlsSession_t* pSession);
+static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedirectURL, int bitrate, hlsSession_t* pSession);
 static hlsStatus_t m3u8PreprocessPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist, hlsSession_t* pSession);
 
 static hlsStatus_t m3u8ProcessVariantPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist);
-static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist);
+static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist, hlsSession_t* pSession);
 
 static hlsStatus_t m3u8UpdatePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession);
-static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist);
+static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pPlaylist, hlsSession_t* pSession);
 
 static hlsStatus_t m3u8GetLine(FILE* fpPlaylist, char* dest, int length);
 static void m3u8NormalizeString(char *pString);
@@ -102,15 +108,10 @@ static hlsStatus_t m3u8ParseProtHeader(char* tagLine, hlsSession_t* pSession);
 static hlsStatus_t m3u8ParseIFrameStreamInf(char *tagLine, char* baseURL, llist_t* pProgramList);
 static hlsStatus_t m3u8ParseMedia(char *tagLine, char* baseURL, llist_t* pGroupList);
 
-static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encType, char* iv, char* keyURI);
+static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encType, char* iv, char* keyURI, hlsSession_t* pSession);
 static hlsStatus_t incCtrIv(char ** pIV);
 static hlsStatus_t decCtrIv(char ** pIV);
 
-typedef struct
-{
-   char key[16];
-}tmemkey;
-
 
 /*
 ** The string returned is a copy of the quoted string value linked to the requested field (quotes are removed).
@@ -298,82 +299,6 @@ static void strToHex( const char *pString,  char *pHex, int arraySize )
    }
    return;
 }
-#ifdef ENABLE_KEY_RETRIEVAL
-// This function does one simple thing, it pulls down the key that is 16 bytes long
-// that is it.
-static size_t WriteMemoryCallback( void *contents, size_t size, size_t nmemb, void *userp)
-{
-   //size_t realsize = size *nmemb;
-   tmemkey  *pkey = (tmemkey*)userp;
-
-
-   memcpy(pkey->key, contents, sizeof(tmemkey));
-   return sizeof(tmemkey);
-
-}
-#if 0
-static void hexdump(void *ptr, int buflen)
-{
-   ptr = ptr;
-   buflen = buflen;
-   unsigned char *buf = (unsigned char*)ptr;
-   int i, j;
-   for (i=0; i<buflen; i+=16) {
-      printf("%06x: ", i);
-      for (j=0; j<16; j++)
-         if (i+j < buflen)
-            printf("%02x ", buf[i+j]);
-         else
-            printf("   ");
-      printf(" ");
-      for (j=0; j<16; j++)
-         if (i+j < buflen)
-            printf("%c", isprint(buf[i+j]) ? buf[i+j] : '.');
-      printf("\n");
-   }
-}
-#endif
-
-
-
-static int dwnld_parse_keyURI(char *pOutKey, const char *pInURI)
-{
-   int      status =0;
-   CURL     *curl_h;
-   tmemkey  chunk;
-   // do some error checking
-   //
-   do
-   {
-      if (pInURI == NULL){status = 1; break;}
-      if (pOutKey == NULL){status = 1; break;}
-      memset(pOutKey, 0, 16);
-      memset(chunk.key, 0, 16);
-
-      curl_h = curl_easy_init();
-      curl_easy_setopt(curl_h, CURLOPT_URL, pInURI);
-      /* send all data to this function*/
-      curl_easy_setopt(curl_h, CURLOPT_WRITEFUNCTION, WriteMemoryCallback);
-
-      curl_easy_setopt(curl_h, CURLOPT_WRITEDATA, (void*)&chunk);
-      curl_easy_setopt(curl_h, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-      // now get the key file.
-      curl_easy_perform(curl_h);
-
-      // we now have the key file
-      // TODO: HANDLE ERROR CASE
-
-      curl_easy_cleanup(curl_h);
-
-      // chunk now holds the key
-      memcpy(pOutKey, chunk.key, 16);
-   }while(0);
-
-   return status;
-}
-
-#endif // ENABLE_KEY_RETRIEVAL
 /**
  * Downloads and parses playlist file pointed to by URL in
  * pPlaylist->playlistURL.
@@ -410,7 +335,10 @@ hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession)
     /* If this playlist has been parsed before, call m3u8UpdatePlaylist() instead */
     if((pPlaylist->nextReloadTime.tv_sec != 0) && (pPlaylist->nextReloadTime.tv_nsec != 0))
     {
-        return m3u8UpdatePlaylist(pPlaylist, pSession);
+        HLS_PROBE(playlist_reload_start, pSession, pPlaylist->playlistURL);
+        rval = m3u8UpdatePlaylist(pPlaylist, pSession);
+        HLS_PROBE(playlist_reload_end, pSession, rval);
+        return rval;
     }
 
 
@@ -428,7 +356,9 @@ hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession)
         do
         {
             /* Download the playlist */
-            rval = m3u8DownloadPlaylist(pPlaylist->playlistURL, filePath, &(pPlaylist->redirectURL), pSession);
+            rval = m3u8DownloadPlaylist(pPlaylist->playlistURL, filePath, &(pPlaylist->redirectURL),
+                                        ((pPlaylist->type == PL_MEDIA) && (pPlaylist->pMediaData != NULL)) ? pPlaylist->pMediaData->bitrate : 0,
+                                        pSession);
             if(rval != HLS_OK)
             {
                 ERROR("error downloading playlist");
@@ -436,7 +366,7 @@ hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession)
             }
 
             /* Store the current download time (we will add the wait offset later) */
-            if(clock_gettime(CLOCK_MONOTONIC, &(pPlaylist->nextReloadTime)) != 0)
+            if(hlsClock_now(&(pPlaylist->nextReloadTime)) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -521,7 +451,7 @@ hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession)
                 break;
             case PL_MEDIA:
                 DEBUG(DBG_INFO,"got version %d media playlist", pPlaylist->version);
-                rval = m3u8ProcessMediaPlaylist(fpPlaylist, pPlaylist);
+                rval = m3u8ProcessMediaPlaylist(fpPlaylist, pPlaylist, pSession);
                 if(rval == HLS_OK)
                 {
                     /* Set the time until the next reload of the playlist */
@@ -582,11 +512,13 @@ hlsStatus_t m3u8ParsePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pSession)
  * @param URL - URL of the playlist to download
  * @param filePath - location to store the downloaded playlist
  * @param pRedirectURL -
+ * @param bitrate - variant bitrate of the playlist, or 0 if
+ *                unknown; recorded in the transfer trace
  * @param pSession - HLS session handle
  *
  * @return #hlsStatus_t
  */
-static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedirectURL, hlsSession_t* pSession)
+static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedirectURL, int bitrate, hlsSession_t* pSession)
 {
     hlsStatus_t rval = HLS_OK;
 
@@ -625,9 +557,9 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
             pDownloadWakeCond = &(pSession->downloaderWakeCond);
             pDownloadWakeMutex = &(pSession->downloaderWakeMutex);
         }
-        else if(pthread_equal(pthread_self(), pSession->parser))
+        else if(hlsWorkerPool_isCurrent(&(pSession->parserTask)))
         {
-            DEBUG(DBG_NOISE, "called from parser thread");
+            DEBUG(DBG_NOISE, "called from parser task");
 
             pbStopDownload = &(pSession->bKillParser);
             pDownloadWakeCond = &(pSession->parserWakeCond);
@@ -637,7 +569,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
         while(rval == HLS_OK)
         {
             /* Get loop start time */
-            if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
+            if(hlsClock_now(&wakeTime) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -657,9 +589,16 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
             dlHandle.fpTarget = fpPlaylist;
             dlHandle.pFileMutex = NULL;
             dlHandle.pbAbortDownload = pbStopDownload;
+            dlHandle.traceType = HLS_TRACE_PLAYLIST;
+            dlHandle.pTraceSession = pSession;
+            dlHandle.traceBitrate = bitrate;
+            dlHandle.pDecrypt = NULL;
+            dlHandle.pSplit = NULL;
+            dlHandle.bytesReceived = 0;
+            dlHandle.bRangeRequired = 0;
 
             /* Lock cURL mutex */
-            pthread_mutex_lock(&(pSession->curlMutex));
+            HLS_MUTEX_LOCK(pSession, SRC_LOCK_CURL, &(pSession->curlMutex));
 
             /* Download playlist file */
             rval = curlDownloadFile(pSession->pCurl, URL, &dlHandle, 0, 0);
@@ -673,7 +612,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
                     {
                         ERROR("failed to get segment download rate");
                         /* Unlock cURL mutex */
-                        pthread_mutex_unlock(&(pSession->curlMutex));
+                        HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_CURL, &(pSession->curlMutex));
                         break;
                     }
                 }
@@ -682,7 +621,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
                 if(downloadSize > 0)
                 {
                     /* Unlock cURL mutex */
-                    pthread_mutex_unlock(&(pSession->curlMutex));
+                    HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_CURL, &(pSession->curlMutex));
 
                     /* Break out of the loop */
                     break;
@@ -702,7 +641,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
                    HLS_CANCELLED) */
 
                 /* Unlock cURL mutex */
-                pthread_mutex_unlock(&(pSession->curlMutex));
+                HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_CURL, &(pSession->curlMutex));
 
                 if(rval == HLS_CANCELLED)
                 {
@@ -717,7 +656,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
             }
 
             /* Unlock cURL mutex */
-            pthread_mutex_unlock(&(pSession->curlMutex));
+            HLS_MUTEX_UNLOCK(pSession, SRC_LOCK_CURL, &(pSession->curlMutex));
 
             if(++attempts > MAX_PL_DL_RETRIES)
             {
@@ -767,7 +706,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
                 DEBUG(DBG_NOISE,"sleeping until: %f", ((wakeTime.tv_sec)*1.0) + (wakeTime.tv_nsec/1000000000.0));
 
                 /* Wait until wakeTime */
-                pthread_status = PTHREAD_COND_TIMEDWAIT(pDownloadWakeCond, pDownloadWakeMutex, &wakeTime);
+                pthread_status = hlsClock_timedWait(pDownloadWakeCond, pDownloadWakeMutex, &wakeTime);
 
                 /* Unlock the playback controller wake mutex */
                 if(pthread_mutex_unlock(pDownloadWakeMutex) != 0)
@@ -789,7 +728,7 @@ static hlsStatus_t m3u8DownloadPlaylist(char* URL, char* filePath, char** pRedir
             {
                 /* Sleep for a bit, then try again */
 
-                usleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
+                hlsClock_sleep(DOWNLOAD_RETRY_WAIT_NSECS/1000);
             }
 
             /* If we were told to stop trying, return HLS_CANCELLED */
@@ -1205,10 +1144,11 @@ static hlsStatus_t m3u8ProcessVariantPlaylist(FILE* fpPlaylist, hlsPlaylist_t* p
  * @param fpPlaylist - pointer to playlist file to parse
  * @param pPlaylist - pointer to pre-allocated hlsPlaylist
  *                  structure to datafill
+ * @param pSession - session the playlist belongs to
  *
  * @return #hlsStatus_t
  */
-static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMediaPlaylist)
+static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMediaPlaylist, hlsSession_t* pSession)
 {
     hlsStatus_t rval = HLS_OK;
     char parseLine[PL_LINE_LENGTH];
@@ -1372,7 +1312,7 @@ static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMe
                                         }
                                     }
 
-                                    rval = addSegmentEncInfo(pSegment, encType, iv, keyURI);
+                                    rval = addSegmentEncInfo(pSegment, encType, iv, keyURI, pSession);
                                     if(rval != HLS_OK)
                                     {
                                         ERROR("failed to add key info to segment");
@@ -1599,7 +1539,7 @@ static hlsStatus_t m3u8ProcessMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMe
                             {
                                 /* The first segment this applies to was already added to the playlist,
                                    so add key info to it */
-                                rval = addSegmentEncInfo(pSegment, encType, iv, keyURI);
+                                rval = addSegmentEncInfo(pSegment, encType, iv, keyURI, pSession);
                                 if(rval != HLS_OK)
                                 {
                                     ERROR("failed to add key info to segment");
@@ -1792,7 +1732,9 @@ static hlsStatus_t m3u8UpdatePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pS
         do
         {
             /* Download the playlist */
-            rval = m3u8DownloadPlaylist(pPlaylist->playlistURL, filePath, &tempRedirectURL, pSession);
+            rval = m3u8DownloadPlaylist(pPlaylist->playlistURL, filePath, &tempRedirectURL,
+                                        ((pPlaylist->type == PL_MEDIA) && (pPlaylist->pMediaData != NULL)) ? pPlaylist->pMediaData->bitrate : 0,
+                                        pSession);
             if(rval != HLS_OK)
             {
                 ERROR("error downloading playlist");
@@ -1800,7 +1742,7 @@ static hlsStatus_t m3u8UpdatePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pS
             }
 
             /* Store the current download time (we will add the wait offset later) */
-            if(clock_gettime(CLOCK_MONOTONIC, &(pPlaylist->nextReloadTime)) != 0)
+            if(hlsClock_now(&(pPlaylist->nextReloadTime)) != 0)
             {
                 ERROR("failed to get current time");
                 rval = HLS_ERROR;
@@ -1948,7 +1890,7 @@ static hlsStatus_t m3u8UpdatePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pS
                 break;
             case PL_MEDIA:
                 DEBUG(DBG_INFO,"updating media playlist");
-                rval = m3u8UpdateMediaPlaylist(fpPlaylist, pPlaylist);
+                rval = m3u8UpdateMediaPlaylist(fpPlaylist, pPlaylist, pSession);
                 if(rval == HLS_OK)
                 {
                     /* Set the time until the next reload of the playlist */
@@ -2039,10 +1981,11 @@ static hlsStatus_t m3u8UpdatePlaylist(hlsPlaylist_t* pPlaylist, hlsSession_t* pS
  * @param fpPlaylist - file pointer to new playlist file
  * @param pMediaPlaylist - pointer to hlsPlaylist structure to
  *                       update
+ * @param pSession - session the playlist belongs to
  *
  * @return #hlsStatus_t
  */
-static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMediaPlaylist)
+static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMediaPlaylist, hlsSession_t* pSession)
 {
     hlsStatus_t rval = HLS_OK;
     int seqNum = 0;
@@ -2125,6 +2068,14 @@ static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMed
 
                     if(pSegment->seqNum < pMediaPlaylist->pMediaData->startingSequenceNumber)
                     {
+                        /* If the downloader has fallen out of the window, its position goes
+                           with the segment; getNextSegment() will rejoin at the live point */
+                        if(pSegmentNode == pMediaPlaylist->pMediaData->pLastDownloadedSegmentNode)
+                        {
+                            DEBUG(DBG_WARN,"last downloaded segment %d dropped from window", pSegment->seqNum);
+                            pMediaPlaylist->pMediaData->pLastDownloadedSegmentNode = NULL;
+                        }
+
                         pSegment = NULL;
 
                         /* Drop the segment */
@@ -2190,11 +2141,12 @@ static hlsStatus_t m3u8UpdateMediaPlaylist(FILE* fpPlaylist, hlsPlaylist_t* pMed
 
                 freeLinkedList(pMediaPlaylist->pList);
                 pMediaPlaylist->pList = NULL;
+                pMediaPlaylist->pMediaData->pLastDownloadedSegmentNode = NULL;
             }
         }
 
         /* Parse the new list, appending new segments to our existing segment list */
-        rval = m3u8ProcessMediaPlaylist(fpPlaylist, pMediaPlaylist);
+        rval = m3u8ProcessMediaPlaylist(fpPlaylist, pMediaPlaylist, pSession);
 
     } while (0);
 
@@ -3266,10 +3218,11 @@ static hlsStatus_t m3u8ParseMedia(char *tagLine, char* baseURL, llist_t* pGroupL
  * @param encType
  * @param iv
  * @param keyURI
+ * @param pSession - session the segment belongs to
  *
  * @return #hlsStatus_t
  */
-static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encType, char* iv, char* keyURI)
+static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encType, char* iv, char* keyURI, hlsSession_t* pSession)
 {
     hlsStatus_t rval = HLS_OK;
 
@@ -3311,10 +3264,14 @@ static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encTyp
                 }
                 memset(pSegment->keyURI, 0, strlen(keyURI)+1);
                 strcpy(pSegment->keyURI, keyURI);
-                // Download and get the key
 
 #ifdef ENABLE_KEY_RETRIEVAL
-                dwnld_parse_keyURI(pSegment->key, keyURI);
+                /* Use the key if we already have it; otherwise start
+                   fetching it now so that it is ready by the time the
+                   downloader gets to this segment */
+                hlsKeyCache_lookup(pSession->pKeyCache, keyURI, pSegment->key);
+#else
+                (void)pSession;
 #endif
             }
 
@@ -3324,10 +3281,18 @@ static hlsStatus_t addSegmentEncInfo(hlsSegment_t* pSegment, srcEncType_t encTyp
             }
 
             /* If we are encrypted but no IV is specified,
-               we need to use the sequence number */
+               we need to use the sequence number (big-endian,
+               padded to 16 bytes) */
             if((encType != SRC_ENC_NONE) && (iv == NULL))
             {
                memset(pSegment->iv, 0, 16);
+               if(encType == SRC_ENC_AES128_CBC)
+               {
+                  pSegment->iv[12] = (pSegment->seqNum >> 24) & 0xFF;
+                  pSegment->iv[13] = (pSegment->seqNum >> 16) & 0xFF;
+                  pSegment->iv[14] = (pSegment->seqNum >> 8) & 0xFF;
+                  pSegment->iv[15] = pSegment->seqNum & 0xFF;
+               }
             }
 
             DEBUG(DBG_INFO,"encType = %s", (pSegment->encType == SRC_ENC_AES128_CBC ? "AES-128-CBC" :
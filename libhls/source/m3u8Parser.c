@@ -42,6 +42,8 @@ extern "C" {
 
 #include "m3u8Parser.h"
 #include "m3u8ParseUtils.h"
+#include "hlsStats.h"
+#include "hlsClock.h"
 
 #include "debug.h"
 
@@ -51,52 +53,41 @@ extern "C" {
 #define PARSER_LOOP_SECS 1
 
 /**
- * Thread body responsible for playlist parsing.  Kicked off by
- * hlsSession_prepare().
+ * Does the initial parse of the session's playlists and moves the
+ * session to HLS_PREPARED.
  *
  * Order of operations:
  *
  * 1) Parse playlist pointed to by pSession->pPlaylist
  *
- * 2)
+ * 2) If it is a variant playlist, pick the initial program and
+ *    bitrate and parse that media playlist
  *
- * .
- * .
- * .
+ * 3) Parse the playlist of any alternative audio group
  *
  * @param pSession - pointer to pre-allocated hlsSession
  *                  structure
+ *
+ * @return #hlsStatus_t
  */
-void m3u8ParserThread(hlsSession_t* pSession)
+static hlsStatus_t m3u8ParserPrepare(hlsSession_t* pSession)
 {
     hlsStatus_t status = HLS_OK;
 
-    int pthread_status = 0;
-
     llNode_t* pProgramNode;
 
     int bitrate = 0;
 
-    struct timespec wakeTime;
-
     int ii = 0;
 
     hlsGroup_t *pGroup = NULL;
     srcPlayerSetData_t playerSetData = {};
     srcStatus_t rval = SRC_ERROR;
 
-    if(pSession == NULL)
-    {
-        ERROR("pSession == NULL");
-        pthread_exit(NULL);
-    }
-
-    TIMESTAMP(DBG_INFO, "Starting %s", __FUNCTION__);
-
     do
     {
         /* Get playlist WRITE lock */
-        pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+        playlistWriteLock(pSession);
 
         /* Parse top level playlist */
         status = m3u8ParsePlaylist(pSession->pPlaylist, pSession);
@@ -106,14 +97,14 @@ void m3u8ParserThread(hlsSession_t* pSession)
             {
                 DEBUG(DBG_WARN, "parser signalled to stop");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
             else
             {
                 ERROR("problem parsing playlist");
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
         }
@@ -133,7 +124,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
             ERROR("NULL playlist");
             status = HLS_ERROR;
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
         }
 
@@ -141,9 +132,13 @@ void m3u8ParserThread(hlsSession_t* pSession)
         {
             /* This is the only playlist */
             pSession->pCurrentPlaylist = pSession->pPlaylist;
+
+            hlsStats_markStartup(&(pSession->stats), SRC_STARTUP_MEDIA_PLAYLIST, NULL);
         }
         else if(pSession->pPlaylist->type == PL_VARIANT)
         {
+            hlsStats_markStartup(&(pSession->stats), SRC_STARTUP_VARIANT_PLAYLIST, NULL);
+
             if((pSession->pPlaylist->pList == NULL) ||
                (pSession->pPlaylist->pList->pHead == NULL) ||
                (pSession->pPlaylist->pList->pHead->pData ==NULL))
@@ -151,7 +146,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                 ERROR("malformed variant playlist");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -164,7 +159,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                 ERROR("malformed variant playlist");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -175,7 +170,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                 ERROR("problem getting initial bitrate");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -187,7 +182,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                 ERROR("problem setting initial playlist");
                 status = HLS_ERROR;
                 /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                playlistUnlock(pSession);
                 break;
             }
 
@@ -201,18 +196,20 @@ void m3u8ParserThread(hlsSession_t* pSession)
                 {
                     DEBUG(DBG_WARN, "parser signalled to stop");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
                 else
                 {
                     ERROR("problem parsing playlist");
                     /* Release playlist lock */
-                    pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                    playlistUnlock(pSession);
                     break;
                 }
             }
 
+            hlsStats_markStartup(&(pSession->stats), SRC_STARTUP_MEDIA_PLAYLIST, NULL);
+
             if(NULL != pSession->pCurrentPlaylist->pMediaData->audio)
             {
                DEBUG(DBG_INFO, "Current program has audio: %s",
@@ -224,7 +221,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                   DEBUG(DBG_WARN, "Failed to find audio group: %s",
                         pSession->pCurrentPlaylist->pMediaData->audio);
                   /* Release playlist lock */
-                  pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                  playlistUnlock(pSession);
                   break;
                }
 
@@ -237,7 +234,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                   pSession->pCurrentGroup[pSession->currentGroupCount++] = pGroup;
 
                   playerSetData.setCode = SRC_PLAYER_SET_DISABLE_MAIN_STREAM_AUDIO;
-                  rval = hlsPlayer_set(pSession->pHandle, &playerSetData);
+                  rval = hlsPlayer_set(pSession, &playerSetData);
                   if(rval != SRC_SUCCESS)
                   {
                      ERROR("failed to set SRC_PLAYER_SET_DISABLE_MAIN_STREAM_AUDIO");
@@ -254,7 +251,7 @@ void m3u8ParserThread(hlsSession_t* pSession)
                ERROR("currentGroupCount(%u) > MAX_NUM_MEDIA_GROUPS(%d)",
                      pSession->currentGroupCount, MAX_NUM_MEDIA_GROUPS);
                /* Release playlist lock */
-               pthread_rwlock_unlock(&(pSession->playlistRWLock));
+               playlistUnlock(pSession);
                break;
             }
 
@@ -267,14 +264,14 @@ void m3u8ParserThread(hlsSession_t* pSession)
                   {
                      DEBUG(DBG_WARN, "parser signalled to stop");
                      /* Release playlist lock */
-                     pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                     playlistUnlock(pSession);
                      break;
                   }
                   else
                   {
                      ERROR("problem parsing alternative playlist");
                      /* Release playlist lock */
-                     pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                     playlistUnlock(pSession);
                      break;
                   }
                }
@@ -284,146 +281,216 @@ void m3u8ParserThread(hlsSession_t* pSession)
                   ERROR("Only media playlist type is supported for media groups");
                   status = HLS_ERROR;
                   /* Release playlist lock */
-                  pthread_rwlock_unlock(&(pSession->playlistRWLock));
+                  playlistUnlock(pSession);
                   break;
                }
             }
+
+            if((status == HLS_OK) && (pSession->currentGroupCount > 0))
+            {
+               hlsStats_markStartup(&(pSession->stats), SRC_STARTUP_AUDIO_PLAYLIST, NULL);
+            }
         }
         else
         {
             ERROR("unsupported playlist type");
             status = HLS_ERROR;
             /* Release playlist lock */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+            playlistUnlock(pSession);
             break;
         }
 
         /* Release playlist lock */
-        pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        playlistUnlock(pSession);
 
         /* At this point we've done an initial pass on our current playlist -- we are PREPARED */
         pSession->state = HLS_PREPARED;
 
+        pSession->bInitialParseDone = 1;
+
         TIMESTAMP(DBG_INFO, "PREPARED");
 
-        /* Loop and update the current playlist */
-        while(status == HLS_OK)
-        {
-             /* If the parser was signalled to exit, return HLS_CANCELLED */
-            if(pSession->bKillParser)
-            {
-                DEBUG(DBG_WARN, "parser signalled to stop");
-                status = HLS_CANCELLED;
-                break;
-            }
+    } while(0);
 
-            /* Get current time */
-            if(clock_gettime(CLOCK_MONOTONIC, &wakeTime) != 0)
-            {
-                ERROR("failed to get current time");
-                status = HLS_ERROR;
-                break;
-            }
+    return status;
+}
 
-            /* Get playlist WRITE lock */
-            pthread_rwlock_wrlock(&(pSession->playlistRWLock));
+/**
+ * Reloads the current media playlist if it is not complete and
+ * its reload time has passed.
+ *
+ * @param pSession - pointer to pre-allocated hlsSession
+ *                  structure
+ *
+ * @return #hlsStatus_t
+ */
+static hlsStatus_t m3u8ParserReload(hlsSession_t* pSession)
+{
+    hlsStatus_t status = HLS_OK;
 
-            /* Check playlist validity */
-            if((pSession->pCurrentPlaylist == NULL) ||
-               (pSession->pCurrentPlaylist->type != PL_MEDIA) ||
-               (pSession->pCurrentPlaylist->pMediaData == NULL))
-            {
-                ERROR("invalid current playlist");
-                status = HLS_ERROR;
-                /* Release playlist lock */
-                pthread_rwlock_unlock(&(pSession->playlistRWLock));
-                break;
-            }
+    struct timespec wakeTime;
+    struct timespec doneTime;
+
+    do
+    {
+        /* Get current time */
+        if(hlsClock_now(&wakeTime) != 0)
+        {
+            ERROR("failed to get current time");
+            status = HLS_ERROR;
+            break;
+        }
+
+        /* Get playlist WRITE lock */
+        playlistWriteLock(pSession);
 
-            /* Reload the current playlist if we don't have all the data */
-            if(!(pSession->pCurrentPlaylist->pMediaData->bHaveCompletePlaylist))
+        /* Check playlist validity */
+        if((pSession->pCurrentPlaylist == NULL) ||
+           (pSession->pCurrentPlaylist->type != PL_MEDIA) ||
+           (pSession->pCurrentPlaylist->pMediaData == NULL))
+        {
+            ERROR("invalid current playlist");
+            status = HLS_ERROR;
+            /* Release playlist lock */
+            playlistUnlock(pSession);
+            break;
+        }
+
+        /* Reload the current playlist if we don't have all the data */
+        if(!(pSession->pCurrentPlaylist->pMediaData->bHaveCompletePlaylist))
+        {
+            /* Check to make sure it is time for an update */
+            if(wakeTime.tv_sec > pSession->pCurrentPlaylist->nextReloadTime.tv_sec)
             {
-                /* Check to make sure it is time for an update */
-                if(wakeTime.tv_sec > pSession->pCurrentPlaylist->nextReloadTime.tv_sec)
+                /* Update our current playlist */
+                status = m3u8ParsePlaylist(pSession->pCurrentPlaylist, pSession);
+                if(status)
                 {
-                    /* Update our current playlist */
-                    status = m3u8ParsePlaylist(pSession->pCurrentPlaylist, pSession);
-                    if(status)
+                    if(status == HLS_CANCELLED)
                     {
-                        if(status == HLS_CANCELLED)
-                        {
-                            /* If the playlist download was cancelled, exit */
-                            DEBUG(DBG_WARN, "parser signalled to stop");
-                            /* Release playlist lock */
-                            pthread_rwlock_unlock(&(pSession->playlistRWLock));
-                            break;
-                        }
-                        else if (status == HLS_DL_ERROR)
-                        {
-                            /* If we encountered a download error, but we might have enough
-                               buffer to get over whatever network issue, so pretent everything
-                               is OK and try again later */
-
-                            DEBUG(DBG_WARN, "problem downloading playlist, will retry");
-                            status = HLS_OK;
-                        }
-                        else
-                        {
-                            ERROR("problem updating playlist");
-                            /* Release playlist lock */
-                            pthread_rwlock_unlock(&(pSession->playlistRWLock));
-                            break;
-                        }
+                        /* If the playlist download was cancelled, exit */
+                        DEBUG(DBG_WARN, "parser signalled to stop");
+                        /* Release playlist lock */
+                        playlistUnlock(pSession);
+                        break;
+                    }
+                    else if (status == HLS_DL_ERROR)
+                    {
+                        /* If we encountered a download error, but we might have enough
+                           buffer to get over whatever network issue, so pretent everything
+                           is OK and try again later */
+
+                        DEBUG(DBG_WARN, "problem downloading playlist, will retry");
+                        status = HLS_OK;
                     }
+                    else
+                    {
+                        ERROR("problem updating playlist");
+                        /* Release playlist lock */
+                        playlistUnlock(pSession);
+                        break;
+                    }
+                }
+                else if(hlsClock_now(&doneTime) == 0)
+                {
+                    hlsStats_recordPlaylistReload(&(pSession->stats),
+                                                  (doneTime.tv_sec - wakeTime.tv_sec) + ((doneTime.tv_nsec - wakeTime.tv_nsec) / 1000000000.0));
                 }
             }
+        }
 
-            /* Release playlist lock (WRITE) */
-            pthread_rwlock_unlock(&(pSession->playlistRWLock));
+        /* Release playlist lock (WRITE) */
+        playlistUnlock(pSession);
 
-            /* Lock the parser wake mutex */
-            if(pthread_mutex_lock(&(pSession->parserWakeMutex)) != 0)
-            {
-                ERROR("failed to lock parser wake mutex");
-                status = HLS_ERROR;
-                break;
-            }
+    } while(0);
+
+    return status;
+}
+
+/**
+ * One step of the playlist parser state machine.  Scheduled on the
+ * shared worker pool by hlsSession_prepare().
+ *
+ * The first step does the initial parse and moves the session to
+ * HLS_PREPARED (see m3u8ParserPrepare()).  Every following step
+ * reloads the current playlist if needed and reschedules itself
+ * PARSER_LOOP_SECS later, until bKillParser is set or an error
+ * occurs.
+ *
+ * @param pArg - pointer to pre-allocated hlsSession structure
+ * @param pNextRunTime - will contain the time at which to run
+ *                     the next step
+ *
+ * @return #hlsTaskResult_t
+ */
+hlsTaskResult_t m3u8ParserTask(void* pArg, struct timespec* pNextRunTime)
+{
+    hlsSession_t* pSession = (hlsSession_t*)pArg;
 
-            /* Wait for LOOP_SECS before going again */
-            wakeTime.tv_sec += PARSER_LOOP_SECS;
+    hlsStatus_t status = HLS_OK;
 
-            DEBUG(DBG_NOISE,"sleeping %d seconds until %d", (int)PARSER_LOOP_SECS, (int)wakeTime.tv_sec);
+    struct timespec stepTime;
 
-            /* Wait until wakeTime */
-            pthread_status = PTHREAD_COND_TIMEDWAIT(&(pSession->parserWakeCond), &(pSession->parserWakeMutex), &wakeTime);
+    if((pSession == NULL) || (pNextRunTime == NULL))
+    {
+        ERROR("invalid parameter");
+        return HLS_TASK_DONE;
+    }
 
-            /* Unlock the parser wake mutex */
-            if(pthread_mutex_unlock(&(pSession->parserWakeMutex)) != 0)
-            {
-                ERROR("failed to unlock parser wake mutex");
-                status = HLS_ERROR;
-                break;
-            }
+    do
+    {
+        /* If the parser was signalled to exit, return HLS_CANCELLED */
+        if(pSession->bKillParser)
+        {
+            DEBUG(DBG_WARN, "parser signalled to stop");
+            status = HLS_CANCELLED;
+            break;
+        }
+
+        /* Get step start time */
+        if(hlsClock_now(&stepTime) != 0)
+        {
+            ERROR("failed to get current time");
+            status = HLS_ERROR;
+            break;
+        }
+
+        if(!(pSession->bInitialParseDone))
+        {
+            TIMESTAMP(DBG_INFO, "Starting %s", __FUNCTION__);
 
-            /* If the timedwait call failed we need to bail */
-            if((pthread_status != ETIMEDOUT) && (pthread_status != 0))
+            status = m3u8ParserPrepare(pSession);
+
+            /* If we didn't make it to PREPARED, we're done */
+            if((status != HLS_OK) || !(pSession->bInitialParseDone))
             {
-                ERROR("failed to timedwait on the parser wake condition");
-                status = HLS_ERROR;
                 break;
             }
-
+        }
+        else
+        {
             /* Make sure we're still in a valid state */
             if(pSession->state == HLS_INVALID_STATE)
             {
                 status = HLS_STATE_ERROR;
                 break;
             }
+
+            status = m3u8ParserReload(pSession);
+            if(status != HLS_OK)
+            {
+                break;
+            }
         }
-        if(status != HLS_OK)
-        {
-            break;
-        }
+
+        /* Run again in PARSER_LOOP_SECS */
+        stepTime.tv_sec += PARSER_LOOP_SECS;
+
+        DEBUG(DBG_NOISE,"next step in %d seconds at %d", (int)PARSER_LOOP_SECS, (int)stepTime.tv_sec);
+
+        *pNextRunTime = stepTime;
+
+        return HLS_TASK_RESCHEDULE;
 
     } while(0);
 
@@ -434,24 +501,14 @@ void m3u8ParserThread(hlsSession_t* pSession)
         /* Send asynchronous error message to the player */
         srcPluginErr_t error;
         error.errCode = SRC_PLUGIN_ERR_SESSION_RESOURCE_FAILED;
-        snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p parser thread quit with status: %d", pSession, status));
+        snprintf(error.errMsg, SRC_ERR_MSG_LEN, DEBUG_MSG("session %p parser quit with status: %d", pSession, status));
         hlsPlayer_pluginErrCallback(pSession->pHandle, &error);
 
-        ERROR("session %p parser thread quit with status: %d", pSession, status);
-
-        /* Put session in INVALID state */
-
-        /* Block state changes */
-        /*pthread_mutex_lock(&(pSession->stateMutex));*/
-
-        /*pSession->state = HLS_INVALID_STATE;*/
-
-        /* Leave critical section */
-        /*pthread_mutex_unlock(&(pSession->stateMutex));*/
+        ERROR("session %p parser quit with status: %d", pSession, status);
     }
 
     DEBUG(DBG_INFO,"session %p parser exiting with status %d", pSession, status);
-    pthread_exit(NULL);
+    return HLS_TASK_DONE;
 }
 
 /**